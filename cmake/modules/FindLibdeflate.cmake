@@ -0,0 +1,38 @@
+# - Find Libdeflate
+# Find the native libdeflate includes and library
+#
+#  Libdeflate_INCLUDE_DIR - where to find libdeflate.h
+#  Libdeflate_LIBRARIES   - List of libraries when using libdeflate.
+#  Libdeflate_FOUND       - True if libdeflate found.
+
+if (Libdeflate_INCLUDE_DIR)
+  # Already in cache, be silent
+  set(Libdeflate_FIND_QUIETLY TRUE)
+endif ()
+
+find_path(Libdeflate_INCLUDE_DIR libdeflate.h)
+
+set(Libdeflate_LIBRARY_NAMES_RELEASE ${Libdeflate_LIBRARY_NAMES_RELEASE} ${Libdeflate_LIBRARY_NAMES} deflate libdeflate)
+find_library(Libdeflate_LIBRARY_RELEASE NAMES ${Libdeflate_LIBRARY_NAMES_RELEASE})
+
+# Find a debug library if one exists and use that for debug builds.
+# This really only does anything for win32, but does no harm on other
+# platforms.
+set(Libdeflate_LIBRARY_NAMES_DEBUG ${Libdeflate_LIBRARY_NAMES_DEBUG} deflated libdeflated)
+find_library(Libdeflate_LIBRARY_DEBUG NAMES ${Libdeflate_LIBRARY_NAMES_DEBUG})
+
+include(LibraryDebugAndRelease)
+set_library_from_debug_and_release(Libdeflate)
+
+# handle the QUIETLY and REQUIRED arguments and set Libdeflate_FOUND to TRUE if
+# all listed variables are TRUE
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Libdeflate DEFAULT_MSG Libdeflate_LIBRARY Libdeflate_INCLUDE_DIR)
+
+if(Libdeflate_FOUND)
+  set(Libdeflate_LIBRARIES ${Libdeflate_LIBRARY})
+else()
+  set(Libdeflate_LIBRARIES)
+endif()
+
+mark_as_advanced(Libdeflate_LIBRARY Libdeflate_INCLUDE_DIR)
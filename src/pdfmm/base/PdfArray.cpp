@@ -237,8 +237,19 @@ PdfObject& PdfArray::add(PdfObject&& obj)
 
 PdfArray::iterator PdfArray::insertAt(const iterator& pos, PdfObject&& obj)
 {
+    size_t capacity = m_Objects.capacity();
     auto ret = m_Objects.emplace(pos, std::move(obj));
-    ret->SetParent(*this);
+    if (m_Objects.capacity() != capacity)
+    {
+        // The objects have been moved to a new
+        // storage, which detached them
+        setChildrenParent();
+    }
+    else
+    {
+        ret->SetParent(*this);
+    }
+
     return ret;
 }
 
@@ -298,11 +309,19 @@ void PdfArray::erase(const iterator& first, const iterator& last)
 void PdfArray::Resize(unsigned count, const PdfObject& val)
 {
     size_t currentSize = m_Objects.size();
+    size_t capacity = m_Objects.capacity();
     m_Objects.resize(count, val);
-    for (size_t i = currentSize; i < count; i++)
+    if (m_Objects.capacity() != capacity)
     {
-        auto& obj = m_Objects[i];
-        obj.SetParent(*this);
+        setChildrenParent();
+    }
+    else
+    {
+        for (size_t i = currentSize; i < count; i++)
+        {
+            auto& obj = m_Objects[i];
+            obj.SetParent(*this);
+        }
     }
 
     if (currentSize != count)
@@ -311,7 +330,10 @@ void PdfArray::Resize(unsigned count, const PdfObject& val)
 
 void PdfArray::Reserve(unsigned n)
 {
+    size_t capacity = m_Objects.capacity();
     m_Objects.reserve(n);
+    if (m_Objects.capacity() != capacity)
+        setChildrenParent();
 }
 
 PdfObject& PdfArray::operator[](size_type idx)
@@ -371,6 +393,7 @@ void PdfArray::resize(size_t size)
         throw length_error("Too big size");
 #endif
     m_Objects.resize(size);
+    setChildrenParent();
 }
 
 void PdfArray::reserve(size_t size)
@@ -379,7 +402,7 @@ void PdfArray::reserve(size_t size)
     if (size > numeric_limits<unsigned>::max())
         throw length_error("Too big size");
 #endif
-    m_Objects.reserve(size);
+    Reserve((unsigned)size);
 }
 
 PdfObject& PdfArray::front()
@@ -0,0 +1,173 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2022 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfCMapCache.h"
+
+#include <array>
+#include <list>
+#include <unordered_map>
+
+#include <openssl/evp.h>
+
+#include "PdfObject.h"
+#include "PdfObjectStream.h"
+#include "PdfCMapEncoding.h"
+
+using namespace std;
+using namespace mm;
+
+namespace
+{
+    using Digest = array<unsigned char, 32>;
+
+    struct DigestHash
+    {
+        size_t operator()(const Digest& digest) const
+        {
+            // The digest is uniformly distributed, just use its first bytes
+            size_t ret;
+            std::memcpy(&ret, digest.data(), sizeof(ret));
+            return ret;
+        }
+    };
+
+    struct Entry
+    {
+        Digest Key;
+        PdfEncodingMapConstPtr Map;
+    };
+
+    using EntryList = list<Entry>;
+
+    struct CMapCache
+    {
+        mutex Mutex;
+        atomic<unsigned> MaxSize{ 0 };
+        EntryList Entries;        // Most recently used first
+        unordered_map<Digest, EntryList::iterator, DigestHash> Map;
+        PdfCMapCacheStats Stats;
+    };
+}
+
+static CMapCache& getCache();
+static Digest computeDigest(const bufferview& buffer);
+static void evict(CMapCache& cache, unsigned maxSize);
+
+void PdfCMapCache::SetMaxSize(unsigned maxSize)
+{
+    auto& cache = getCache();
+    unique_lock<mutex> lock(cache.Mutex);
+    cache.MaxSize = maxSize;
+    evict(cache, maxSize);
+}
+
+unsigned PdfCMapCache::GetMaxSize()
+{
+    return getCache().MaxSize;
+}
+
+bool PdfCMapCache::IsEnabled()
+{
+    return getCache().MaxSize != 0;
+}
+
+PdfCMapCacheStats PdfCMapCache::GetStats()
+{
+    auto& cache = getCache();
+    unique_lock<mutex> lock(cache.Mutex);
+    return cache.Stats;
+}
+
+void PdfCMapCache::ResetStats()
+{
+    auto& cache = getCache();
+    unique_lock<mutex> lock(cache.Mutex);
+    cache.Stats.Hits = 0;
+    cache.Stats.Misses = 0;
+    cache.Stats.Evictions = 0;
+}
+
+void PdfCMapCache::Clear()
+{
+    auto& cache = getCache();
+    unique_lock<mutex> lock(cache.Mutex);
+    cache.Entries.clear();
+    cache.Map.clear();
+    cache.Stats.EntryCount = 0;
+}
+
+PdfEncodingMapConstPtr PdfCMapCache::GetOrCreate(const PdfObject& cmapObj)
+{
+    auto& cache = getCache();
+    if (cache.MaxSize == 0)
+        return PdfCMapEncoding::CreateFromObject(cmapObj);
+
+    charbuff buffer;
+    cmapObj.MustGetStream().CopyTo(buffer);
+    auto digest = computeDigest(buffer);
+    {
+        unique_lock<mutex> lock(cache.Mutex);
+        auto found = cache.Map.find(digest);
+        if (found != cache.Map.end())
+        {
+            // Move the entry to the front of the recently used list
+            cache.Entries.splice(cache.Entries.begin(), cache.Entries, found->second);
+            cache.Stats.Hits++;
+            return found->second->Map;
+        }
+
+        cache.Stats.Misses++;
+    }
+
+    // Parse the CMap outside the lock
+    PdfEncodingMapConstPtr map = PdfCMapEncoding::createFromBuffer(buffer);
+
+    unique_lock<mutex> lock(cache.Mutex);
+    unsigned maxSize = cache.MaxSize;
+    if (maxSize == 0)
+        return map;
+
+    auto found = cache.Map.find(digest);
+    if (found != cache.Map.end())
+    {
+        // The CMap was parsed concurrently by another reader
+        cache.Entries.splice(cache.Entries.begin(), cache.Entries, found->second);
+        return found->second->Map;
+    }
+
+    evict(cache, maxSize - 1);
+    cache.Entries.push_front({ digest, map });
+    cache.Map[digest] = cache.Entries.begin();
+    cache.Stats.EntryCount++;
+    return map;
+}
+
+CMapCache& getCache()
+{
+    static CMapCache s_cache;
+    return s_cache;
+}
+
+Digest computeDigest(const bufferview& buffer)
+{
+    Digest ret;
+    if (EVP_Digest(buffer.data(), buffer.size(), ret.data(), nullptr, EVP_sha256(), nullptr) != 1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error computing SHA-256 digest");
+
+    return ret;
+}
+
+void evict(CMapCache& cache, unsigned maxSize)
+{
+    while (cache.Stats.EntryCount > maxSize)
+    {
+        auto& entry = cache.Entries.back();
+        cache.Stats.EntryCount--;
+        cache.Stats.Evictions++;
+        cache.Map.erase(entry.Key);
+        cache.Entries.pop_back();
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2022 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_CMAP_CACHE_H
+#define PDF_CMAP_CACHE_H
+
+#include "PdfDeclarations.h"
+#include "PdfEncodingMap.h"
+
+namespace mm {
+
+class PdfObject;
+
+/** Statistics of the PdfCMapCache
+ */
+struct PdfCMapCacheStats
+{
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+    uint64_t Evictions = 0;     ///< Entries evicted to fit the maximum size
+    unsigned EntryCount = 0;
+};
+
+/** A process wide cache of parsed CMaps, keyed by a SHA-256
+ *  digest of the decoded CMap stream data, with a maximum count
+ *  of entries and least recently used eviction.
+ *
+ *  The cache is used when loading the /Encoding and /ToUnicode
+ *  CMap streams of fonts, so documents that embed byte identical
+ *  CMaps share the same immutable encoding map instead of parsing
+ *  them again. The cache is disabled by default.
+ *
+ *  \remarks The cache is internally synchronized
+ */
+class PDFMM_API PdfCMapCache final
+{
+    friend class PdfEncodingFactory;
+
+    PdfCMapCache() = delete;
+
+public:
+    /** Set the maximum count of CMaps held by the cache, evicting
+     *  the least recently used entries as needed. 0 disables the cache
+     */
+    static void SetMaxSize(unsigned maxSize);
+
+    static unsigned GetMaxSize();
+
+    static bool IsEnabled();
+
+    static PdfCMapCacheStats GetStats();
+
+    /** Reset the hits, misses and evictions counters
+     */
+    static void ResetStats();
+
+    /** Remove all the entries
+     */
+    static void Clear();
+
+private:
+    /** Get a cached map for the CMap stream object, or
+     *  parse the CMap and add it to the cache
+     */
+    static PdfEncodingMapConstPtr GetOrCreate(const PdfObject& cmapObj);
+};
+
+};
+
+#endif // PDF_CMAP_CACHE_H
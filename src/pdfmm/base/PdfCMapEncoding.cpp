@@ -36,7 +36,7 @@ static void handleRangeMapping(PdfCharCodeMap& map,
     unsigned char codeSize, unsigned rangeSize);
 static vector<char32_t> handleUtf8String(const string& str);
 static void pushMapping(PdfCharCodeMap& map, const PdfCharCode& codeUnit, const std::vector<char32_t>& codePoints);
-static PdfCharCodeMap parseCMapObject(const PdfObjectStream& stream, CodeLimits& limits);
+static PdfCharCodeMap parseCMapObject(const bufferview& buffer, CodeLimits& limits);
 
 PdfCMapEncoding::PdfCMapEncoding(PdfCharCodeMap&& map)
     : PdfCMapEncoding(std::move(map), map.GetLimits()) { }
@@ -45,9 +45,16 @@ PdfCMapEncoding::PdfCMapEncoding(PdfCharCodeMap&& map, const PdfEncodingLimits&
     : PdfEncodingMapBase(std::move(map), PdfEncodingMapType::CMap), m_Limits(limits) { }
 
 unique_ptr<PdfEncodingMap> PdfCMapEncoding::CreateFromObject(const PdfObject& cmapObj)
+{
+    charbuff buffer;
+    cmapObj.MustGetStream().CopyTo(buffer);
+    return createFromBuffer(buffer);
+}
+
+unique_ptr<PdfEncodingMap> PdfCMapEncoding::createFromBuffer(const bufferview& buffer)
 {
     CodeLimits codeLimits;
-    auto map = parseCMapObject(cmapObj.MustGetStream(), codeLimits);
+    auto map = parseCMapObject(buffer, codeLimits);
     auto mapLimits = map.GetLimits();
     // NOTE: In some cases the encoding is degenerate and has no code
     // entries at all, but the CMap may still encode the code size
@@ -101,13 +108,10 @@ bool PdfCMapEncoding::HasLigaturesSupport() const
     return true;
 }
 
-PdfCharCodeMap parseCMapObject(const PdfObjectStream& stream, CodeLimits& limits)
+PdfCharCodeMap parseCMapObject(const bufferview& buffer, CodeLimits& limits)
 {
     PdfCharCodeMap ret;
-    charbuff streamBuffer;
-    stream.CopyTo(streamBuffer);
-
-    SpanStreamDevice device(streamBuffer);
+    SpanStreamDevice device(buffer);
     PdfPostScriptTokenizer tokenizer;
     deque<unique_ptr<PdfVariant>> tokens;
     PdfString str;
@@ -232,14 +236,7 @@ PdfCharCodeMap parseCMapObject(const PdfObjectStream& stream, CodeLimits& limits
                         char32_t dstCIDLo = (char32_t)getCodeFromVariant(*var, limits);
 
                         unsigned rangeSize = srcCodeHi - srcCodeLo + 1;
-                        vector<char32_t> mappedCodes;
-                        for (unsigned i = 0; i < rangeSize; i++)
-                        {
-                            char32_t newbackchar = dstCIDLo + i;
-                            mappedCodes.clear();
-                            mappedCodes.push_back(newbackchar);
-                            pushMapping(ret, { srcCodeLo + i, codeSize }, mappedCodes);
-                        }
+                        ret.PushRangeMapping({ srcCodeLo, codeSize }, rangeSize, dstCIDLo);
                     }
                 }
                 else if (token == "begincidchar")
@@ -299,18 +296,17 @@ void handleRangeMapping(PdfCharCodeMap& map,
     auto it = dstCodeLo.begin();
     auto end = dstCodeLo.end();
     PDFMM_INVARIANT(it != end);
-    char32_t back = dstCodeLo.back();
-    vector<char32_t> newdstbase;
-    // Compute a destination string that has all code points except the last one
-    if (dstCodeLo.size() != 1)
+    if (dstCodeLo.size() == 1)
     {
-        do
-        {
-            newdstbase.push_back(*it);
-            it++;
-        } while (it != end);
+        // Sequential single code point mappings are stored as a range
+        map.PushRangeMapping({ srcCodeLo, codeSize }, rangeSize, dstCodeLo[0]);
+        return;
     }
 
+    char32_t back = dstCodeLo.back();
+    // Compute a destination string that has all code points except the last one
+    vector<char32_t> newdstbase(it, end - 1);
+
     // Compute new destination string with last chracter/code point incremented by one
     vector<char32_t> newdst;
     for (unsigned i = 0; i < rangeSize; i++)
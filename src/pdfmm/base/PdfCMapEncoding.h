@@ -17,6 +17,7 @@ namespace mm
     class PDFMM_API PdfCMapEncoding final : public PdfEncodingMapBase
     {
         friend class PdfEncodingMap;
+        friend class PdfCMapCache;
 
     public:
         /** Construct a PdfCMapEncoding from a map
@@ -31,6 +32,10 @@ namespace mm
     private:
         PdfCMapEncoding(PdfCharCodeMap&& map, const PdfEncodingLimits& limits);
 
+        /** Construct an encoding map from decoded CMap stream data
+         */
+        static std::unique_ptr<PdfEncodingMap> createFromBuffer(const bufferview& buffer);
+
     public:
         bool HasLigaturesSupport() const override;
         const PdfEncodingLimits& GetLimits() const override;
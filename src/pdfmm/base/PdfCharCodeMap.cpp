@@ -13,8 +13,18 @@
 using namespace std;
 using namespace mm;
 
+// Mapping entries layout: the upper bit is a flag set if
+// the remaining bits are an offset in the code point pool,
+// or a single code point plus one otherwise. 0 is an
+// unmapped entry
+constexpr uint32_t EntryPoolFlag = 1u << 31;
+constexpr uint32_t EntryValueMask = EntryPoolFlag - 1;
+constexpr unsigned MaxCodeSpaceSize = 4;
+constexpr unsigned DenseTableSize = 256;
+constexpr unsigned DenseCodeCount = 0x10000;
+
 PdfCharCodeMap::PdfCharCodeMap()
-    : m_MapDirty(false), m_codePointMapHead(nullptr), m_depth(0) { }
+    : m_poolGarbageSize(0), m_Size(0), m_MapDirty(false), m_codePointMapHead(nullptr), m_depth(0) { }
 
 PdfCharCodeMap::PdfCharCodeMap(PdfCharCodeMap&& map) noexcept
 {
@@ -28,13 +38,14 @@ PdfCharCodeMap::~PdfCharCodeMap()
 
 PdfCharCodeMap& PdfCharCodeMap::operator=(PdfCharCodeMap&& map) noexcept
 {
+    deleteNode(m_codePointMapHead);
     move(map);
     return *this;
 }
 
 unsigned PdfCharCodeMap::GetSize() const
 {
-    return (unsigned)m_CodeUnitMap.size();
+    return m_Size;
 }
 
 const PdfEncodingLimits& PdfCharCodeMap::GetLimits() const
@@ -44,9 +55,13 @@ const PdfEncodingLimits& PdfCharCodeMap::GetLimits() const
 
 void PdfCharCodeMap::move(PdfCharCodeMap& map) noexcept
 {
-    m_CodeUnitMap = std::move(map.m_CodeUnitMap);
+    for (unsigned i = 0; i < MaxCodeSpaceSize; i++)
+        m_codeSpaces[i] = std::move(map.m_codeSpaces[i]);
+    m_codePointPool = std::move(map.m_codePointPool);
+    utls::move(map.m_poolGarbageSize, m_poolGarbageSize);
     utls::move(map.m_Limits, m_Limits);
-    utls::move(map.m_MapDirty, m_MapDirty);
+    utls::move(map.m_Size, m_Size);
+    m_MapDirty = map.m_MapDirty.exchange(false);
     utls::move(map.m_codePointMapHead, m_codePointMapHead);
     utls::move(map.m_depth, m_depth);
 }
@@ -56,26 +71,62 @@ void PdfCharCodeMap::PushMapping(const PdfCharCode& codeUnit, const codepointvie
     if (codePoints.size() == 0)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "CodePoints must not be empty");
 
-    vector<codepoint> copy(codePoints.begin(), codePoints.end());
-    pushMapping(codeUnit, std::move(copy));
+    pushMapping(codeUnit, codePoints);
 }
 
 void PdfCharCodeMap::PushMapping(const PdfCharCode& codeUnit, codepoint codePoint)
 {
-    vector<codepoint> codePoints = { codePoint };
-    pushMapping(codeUnit, std::move(codePoints));
+    pushMapping(codeUnit, codepointview(&codePoint, 1));
+}
+
+void PdfCharCodeMap::PushRangeMapping(const PdfCharCode& codeUnit, unsigned size, codepoint codePoint)
+{
+    if (size == 0)
+        return;
+
+    if (size == 1)
+    {
+        pushMapping(codeUnit, codepointview(&codePoint, 1));
+        return;
+    }
+
+    if (codeUnit.CodeSpaceSize == 0 || codeUnit.CodeSpaceSize > MaxCodeSpaceSize)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Code unit must be valid");
+
+    // Clamp ranges overflowing the code space
+    unsigned last = codeUnit.Code + (size - 1);
+    if (last < codeUnit.Code)
+    {
+        last = numeric_limits<unsigned>::max();
+        size = last - codeUnit.Code + 1;
+    }
+
+    // Later mappings replace the previous ones
+    auto& codeSpace = getOrCreateCodeSpace(codeUnit.CodeSpaceSize);
+    eraseEntries(codeSpace, codeUnit.Code, last);
+    eraseRanges(codeSpace, codeUnit.Code, last);
+    auto found = std::upper_bound(codeSpace.Ranges.begin(), codeSpace.Ranges.end(), codeUnit.Code,
+        [](unsigned code, const CodeRange& range) { return code < range.Code; });
+    codeSpace.Ranges.insert(found, CodeRange{ codeUnit.Code, size, codePoint });
+    m_Size += size;
+    compactPool();
+
+    updateLimits(codeUnit);
+    updateLimits(PdfCharCode(last, codeUnit.CodeSpaceSize));
+    m_MapDirty = true;
 }
 
 bool PdfCharCodeMap::TryGetCodePoints(const PdfCharCode& codeUnit, vector<codepoint>& codePoints) const
 {
-    auto found = m_CodeUnitMap.find(codeUnit);
-    if (found == m_CodeUnitMap.end())
+    codepointview view;
+    codepoint temp;
+    if (!tryGetCodePoints(codeUnit, view, temp))
     {
         codePoints.clear();
         return false;
     }
 
-    codePoints = found->second;
+    codePoints.assign(view.begin(), view.end());
     return true;
 }
 
@@ -138,14 +189,30 @@ bool PdfCharCodeMap::TryGetCharCode(codepoint codePoint, PdfCharCode& code) cons
     return true;
 }
 
-void PdfCharCodeMap::pushMapping(const PdfCharCode& codeUnit, vector<codepoint>&& codePoints)
+void PdfCharCodeMap::pushMapping(const PdfCharCode& codeUnit, const codepointview& codePoints)
 {
-    if (codeUnit.CodeSpaceSize == 0)
+    if (codeUnit.CodeSpaceSize == 0 || codeUnit.CodeSpaceSize > MaxCodeSpaceSize)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Code unit must be valid");
 
-    m_CodeUnitMap[codeUnit] = std::move(codePoints);
+    auto& codeSpace = getOrCreateCodeSpace(codeUnit.CodeSpaceSize);
+    if (codeSpace.Ranges.size() != 0)
+        eraseRanges(codeSpace, codeUnit.Code, codeUnit.Code);
+
+    auto newEntry = createEntry(codePoints);
+    auto& entry = getOrCreateEntry(codeSpace, codeUnit.Code);
+    if (entry == 0)
+        m_Size++;
+    else
+        releaseEntry(entry);
+
+    entry = newEntry;
+    compactPool();
+    updateLimits(codeUnit);
+    m_MapDirty = true;
+}
 
-    // Update limits
+void PdfCharCodeMap::updateLimits(const PdfCharCode& codeUnit)
+{
     if (codeUnit.CodeSpaceSize < m_Limits.MinCodeSize)
         m_Limits.MinCodeSize = codeUnit.CodeSpaceSize;
     if (codeUnit.CodeSpaceSize > m_Limits.MaxCodeSize)
@@ -154,8 +221,253 @@ void PdfCharCodeMap::pushMapping(const PdfCharCode& codeUnit, vector<codepoint>&
         m_Limits.FirstChar = codeUnit;
     if (codeUnit.Code > m_Limits.LastChar.Code)
         m_Limits.LastChar = codeUnit;
+}
 
-    m_MapDirty = true;
+bool PdfCharCodeMap::tryGetCodePoints(const PdfCharCode& codeUnit, codepointview& codePoints, codepoint& temp) const
+{
+    auto codeSpace = getCodeSpace(codeUnit.CodeSpaceSize);
+    if (codeSpace == nullptr)
+        return false;
+
+    unsigned code = codeUnit.Code;
+    auto entry = findEntry(*codeSpace, code);
+    if (entry != nullptr && *entry != 0)
+    {
+        codePoints = getCodePoints(*entry, temp);
+        return true;
+    }
+
+    auto& ranges = codeSpace->Ranges;
+    if (ranges.size() == 0)
+        return false;
+
+    auto found = std::upper_bound(ranges.begin(), ranges.end(), code,
+        [](unsigned code, const CodeRange& range) { return code < range.Code; });
+    if (found == ranges.begin())
+        return false;
+
+    found--;
+    if (code - found->Code >= found->Size)
+        return false;
+
+    temp = found->CodePoint + (code - found->Code);
+    codePoints = codepointview(&temp, 1);
+    return true;
+}
+
+PdfCharCodeMap::MappingEntry PdfCharCodeMap::createEntry(const codepointview& codePoints)
+{
+    if (codePoints.size() == 1 && codePoints[0] < EntryValueMask)
+        return codePoints[0] + 1;
+
+    size_t offset = m_codePointPool.size();
+    if (offset > EntryValueMask)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Too many code points in the map");
+
+    m_codePointPool.push_back((codepoint)codePoints.size());
+    m_codePointPool.insert(m_codePointPool.end(), codePoints.begin(), codePoints.end());
+    return EntryPoolFlag | (MappingEntry)offset;
+}
+
+void PdfCharCodeMap::releaseEntry(MappingEntry entry)
+{
+    if ((entry & EntryPoolFlag) != 0)
+        m_poolGarbageSize += m_codePointPool[entry & EntryValueMask] + 1;
+}
+
+void PdfCharCodeMap::compactPool()
+{
+    // Copy the code points still referenced when at
+    // least half of the pool is no more referenced
+    if (m_poolGarbageSize == 0 || m_poolGarbageSize < m_codePointPool.size() / 2)
+        return;
+
+    vector<codepoint> pool;
+    pool.reserve(m_codePointPool.size() - m_poolGarbageSize);
+    auto compactEntry = [&](MappingEntry& entry) {
+        if ((entry & EntryPoolFlag) == 0)
+            return;
+
+        auto codePoints = m_codePointPool.data() + (entry & EntryValueMask);
+        entry = EntryPoolFlag | (MappingEntry)pool.size();
+        pool.insert(pool.end(), codePoints, codePoints + *codePoints + 1);
+    };
+
+    for (auto& codeSpace : m_codeSpaces)
+    {
+        if (codeSpace == nullptr)
+            continue;
+
+        for (auto& table : codeSpace->DenseTables)
+        {
+            if (table == nullptr)
+                continue;
+
+            for (unsigned i = 0; i < DenseTableSize; i++)
+                compactEntry(table[i]);
+        }
+
+        for (auto& pair : codeSpace->Sparse)
+            compactEntry(pair.second);
+    }
+
+    m_codePointPool = std::move(pool);
+    m_poolGarbageSize = 0;
+}
+
+codepointview PdfCharCodeMap::getCodePoints(MappingEntry entry, codepoint& temp) const
+{
+    if ((entry & EntryPoolFlag) == 0)
+    {
+        temp = (entry & EntryValueMask) - 1;
+        return codepointview(&temp, 1);
+    }
+
+    auto codePoints = m_codePointPool.data() + (entry & EntryValueMask);
+    return codepointview(codePoints + 1, *codePoints);
+}
+
+const PdfCharCodeMap::CodeSpaceMappings* PdfCharCodeMap::getCodeSpace(unsigned char codeSpaceSize) const
+{
+    if (codeSpaceSize == 0 || codeSpaceSize > MaxCodeSpaceSize)
+        return nullptr;
+
+    return m_codeSpaces[codeSpaceSize - 1].get();
+}
+
+PdfCharCodeMap::CodeSpaceMappings& PdfCharCodeMap::getOrCreateCodeSpace(unsigned char codeSpaceSize)
+{
+    PDFMM_ASSERT(codeSpaceSize != 0 && codeSpaceSize <= MaxCodeSpaceSize);
+    auto& codeSpace = m_codeSpaces[codeSpaceSize - 1];
+    if (codeSpace == nullptr)
+        codeSpace.reset(new CodeSpaceMappings());
+
+    return *codeSpace;
+}
+
+const PdfCharCodeMap::MappingEntry* PdfCharCodeMap::findEntry(const CodeSpaceMappings& codeSpace, unsigned code)
+{
+    if (code < DenseCodeCount)
+    {
+        unsigned index = code / DenseTableSize;
+        if (index >= codeSpace.DenseTables.size() || codeSpace.DenseTables[index] == nullptr)
+            return nullptr;
+
+        return &codeSpace.DenseTables[index][code % DenseTableSize];
+    }
+
+    auto found = codeSpace.Sparse.find(code);
+    if (found == codeSpace.Sparse.end())
+        return nullptr;
+
+    return &found->second;
+}
+
+PdfCharCodeMap::MappingEntry& PdfCharCodeMap::getOrCreateEntry(CodeSpaceMappings& codeSpace, unsigned code)
+{
+    if (code < DenseCodeCount)
+    {
+        unsigned index = code / DenseTableSize;
+        if (index >= codeSpace.DenseTables.size())
+            codeSpace.DenseTables.resize(index + 1);
+
+        auto& table = codeSpace.DenseTables[index];
+        if (table == nullptr)
+            table.reset(new MappingEntry[DenseTableSize]{ });
+
+        return table[code % DenseTableSize];
+    }
+
+    return codeSpace.Sparse[code];
+}
+
+unsigned PdfCharCodeMap::findNextDenseCode(const CodeSpaceMappings& codeSpace, unsigned code)
+{
+    for (; code < DenseCodeCount; code++)
+    {
+        unsigned index = code / DenseTableSize;
+        if (index >= codeSpace.DenseTables.size())
+            break;
+
+        auto& table = codeSpace.DenseTables[index];
+        if (table == nullptr)
+        {
+            // Skip to the next table
+            code = (index + 1) * DenseTableSize - 1;
+            continue;
+        }
+
+        if (table[code % DenseTableSize] != 0)
+            return code;
+    }
+
+    return DenseCodeCount;
+}
+
+void PdfCharCodeMap::eraseEntries(CodeSpaceMappings& codeSpace, unsigned code, unsigned last)
+{
+    for (unsigned denseCode = findNextDenseCode(codeSpace, code); denseCode <= last && denseCode < DenseCodeCount;
+        denseCode = findNextDenseCode(codeSpace, denseCode + 1))
+    {
+        auto& entry = codeSpace.DenseTables[denseCode / DenseTableSize][denseCode % DenseTableSize];
+        releaseEntry(entry);
+        entry = 0;
+        m_Size--;
+    }
+
+    if (last < DenseCodeCount || codeSpace.Sparse.size() == 0)
+        return;
+
+    auto it = codeSpace.Sparse.lower_bound(code);
+    auto end = codeSpace.Sparse.upper_bound(last);
+    for (auto curr = it; curr != end; curr++)
+        releaseEntry(curr->second);
+
+    m_Size -= (unsigned)std::distance(it, end);
+    codeSpace.Sparse.erase(it, end);
+}
+
+void PdfCharCodeMap::eraseRanges(CodeSpaceMappings& codeSpace, unsigned code, unsigned last)
+{
+    auto& ranges = codeSpace.Ranges;
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), code,
+        [](unsigned code, const CodeRange& range) { return code < range.Code; });
+    if (it != ranges.begin() && code - (it - 1)->Code < (it - 1)->Size)
+        it--;
+
+    while (it != ranges.end() && it->Code <= last)
+    {
+        unsigned rangeLast = it->Code + (it->Size - 1);
+        m_Size -= std::min(last, rangeLast) - std::max(code, it->Code) + 1;
+        if (it->Code < code)
+        {
+            unsigned size = code - it->Code;
+            if (rangeLast > last)
+            {
+                // Split the range
+                CodeRange right{ last + 1, rangeLast - last,
+                    it->CodePoint + (last + 1 - it->Code) };
+                it->Size = size;
+                ranges.insert(it + 1, right);
+                return;
+            }
+
+            it->Size = size;
+            it++;
+        }
+        else if (rangeLast > last)
+        {
+            // Trim the start of the range
+            it->CodePoint += last + 1 - it->Code;
+            it->Size = rangeLast - last;
+            it->Code = last + 1;
+            return;
+        }
+        else
+        {
+            it = ranges.erase(it);
+        }
+    }
 }
 
 bool PdfCharCodeMap::tryFindNextCharacterId(const CPMapNode* node, string_view::iterator& it,
@@ -211,7 +523,11 @@ const PdfCharCodeMap::CPMapNode* PdfCharCodeMap::findNode(const CPMapNode* node,
 
 void PdfCharCodeMap::reviseCPMap()
 {
-    if (!m_MapDirty)
+    if (!m_MapDirty.load(memory_order_acquire))
+        return;
+
+    unique_lock<mutex> lock(m_codePointMapMutex);
+    if (!m_MapDirty.load(memory_order_relaxed))
         return;
 
     if (m_codePointMapHead != nullptr)
@@ -224,18 +540,29 @@ void PdfCharCodeMap::reviseCPMap()
     // so BST creation will be more balanced
     // https://en.wikipedia.org/wiki/Random_binary_tree
     // TODO: Create a perfectly balanced BST
-    vector<pair<PdfCharCode, vector<codepoint>>> pairs;
-    pairs.reserve(m_CodeUnitMap.size());
-    std::copy(m_CodeUnitMap.begin(), m_CodeUnitMap.end(), std::back_inserter(pairs));
+    struct Mapping
+    {
+        PdfCharCode CodeUnit;
+        unsigned Offset;
+        unsigned Length;
+    };
+    vector<Mapping> mappings;
+    vector<codepoint> codePoints;
+    mappings.reserve(m_Size);
+    for (auto& pair : *this)
+    {
+        mappings.push_back({ pair.first, (unsigned)codePoints.size(), (unsigned)pair.second.size() });
+        codePoints.insert(codePoints.end(), pair.second.begin(), pair.second.end());
+    }
     std::mt19937 e(random_device{}());
-    std::shuffle(pairs.begin(), pairs.end(), e);
+    std::shuffle(mappings.begin(), mappings.end(), e);
 
-    for (auto& pair : pairs)
+    for (auto& mapping : mappings)
     {
         CPMapNode** curr = &m_codePointMapHead;      // Node root being searched
         CPMapNode* found;                     // Last found node
-        auto it = pair.second.begin();
-        auto end = pair.second.end();
+        auto it = codePoints.begin() + mapping.Offset;
+        auto end = it + mapping.Length;
         PDFMM_INVARIANT(it != end);
         while (true)
         {
@@ -249,10 +576,10 @@ void PdfCharCodeMap::reviseCPMap()
         }
 
         // Finally set the char code on the last found/added node
-        found->CodeUnit = pair.first;
+        found->CodeUnit = mapping.CodeUnit;
     }
 
-    m_MapDirty = false;
+    m_MapDirty.store(false, memory_order_release);
 }
 
 PdfCharCodeMap::CPMapNode* PdfCharCodeMap::findOrAddNode(CPMapNode*& node, codepoint codePoint)
@@ -274,12 +601,17 @@ PdfCharCodeMap::CPMapNode* PdfCharCodeMap::findOrAddNode(CPMapNode*& node, codep
 
 PdfCharCodeMap::iterator PdfCharCodeMap::begin() const
 {
-    return m_CodeUnitMap.begin();
+    return iterator(MappingIterator(*this, false));
 }
 
 PdfCharCodeMap::iterator PdfCharCodeMap::end() const
 {
-    return m_CodeUnitMap.end();
+    return iterator(MappingIterator(*this, true));
+}
+
+PdfCharCodeMap::MappingIterable PdfCharCodeMap::GetMappings() const
+{
+    return MappingIterable(*this);
 }
 
 void PdfCharCodeMap::deleteNode(CPMapNode* node)
@@ -292,3 +624,217 @@ void PdfCharCodeMap::deleteNode(CPMapNode* node)
     deleteNode(node->Right);
     delete node;
 }
+
+PdfCharCodeMap::MappingIterator::MappingIterator()
+    : m_map(nullptr), m_codeSpaceIndex(MaxCodeSpaceSize), m_denseCode(DenseCodeCount),
+    m_rangeIndex(0), m_rangeOffset(0), m_codePoint(0) { }
+
+PdfCharCodeMap::MappingIterator::MappingIterator(const PdfCharCodeMap& map, bool end)
+    : m_map(&map), m_codeSpaceIndex(MaxCodeSpaceSize), m_denseCode(DenseCodeCount),
+    m_rangeIndex(0), m_rangeOffset(0), m_codePoint(0)
+{
+    if (!end)
+        seekCodeSpace(0);
+}
+
+bool PdfCharCodeMap::MappingIterator::operator==(const MappingIterator& rhs) const
+{
+    if (m_codeSpaceIndex != rhs.m_codeSpaceIndex)
+        return false;
+
+    if (m_codeSpaceIndex == MaxCodeSpaceSize)
+        return true;
+
+    return m_denseCode == rhs.m_denseCode && m_sparseIt == rhs.m_sparseIt
+        && m_rangeIndex == rhs.m_rangeIndex && m_rangeOffset == rhs.m_rangeOffset;
+}
+
+bool PdfCharCodeMap::MappingIterator::operator!=(const MappingIterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+PdfCharCodeMap::MappingIterator& PdfCharCodeMap::MappingIterator::operator++()
+{
+    auto& codeSpace = *m_map->m_codeSpaces[m_codeSpaceIndex];
+    if (isRangeCurrent())
+    {
+        m_rangeOffset++;
+        if (m_rangeOffset == codeSpace.Ranges[m_rangeIndex].Size)
+        {
+            m_rangeIndex++;
+            m_rangeOffset = 0;
+        }
+    }
+    else if (m_denseCode < DenseCodeCount)
+    {
+        m_denseCode = findNextDenseCode(codeSpace, m_denseCode + 1);
+    }
+    else
+    {
+        m_sparseIt++;
+    }
+
+    if (isCodeSpaceEnd())
+        seekCodeSpace(m_codeSpaceIndex + 1);
+
+    return *this;
+}
+
+PdfCharCodeMap::MappingIterator PdfCharCodeMap::MappingIterator::operator++(int)
+{
+    auto copy = *this;
+    operator++();
+    return copy;
+}
+
+PdfCharCodeMap::MappingIterator::reference PdfCharCodeMap::MappingIterator::operator*() const
+{
+    auto& codeSpace = *m_map->m_codeSpaces[m_codeSpaceIndex];
+    unsigned char codeSpaceSize = (unsigned char)(m_codeSpaceIndex + 1);
+    if (isRangeCurrent())
+    {
+        auto& range = codeSpace.Ranges[m_rangeIndex];
+        m_current.first = PdfCharCode(range.Code + m_rangeOffset, codeSpaceSize);
+        m_codePoint = range.CodePoint + m_rangeOffset;
+        m_current.second = codepointview(&m_codePoint, 1);
+        return m_current;
+    }
+
+    unsigned code;
+    MappingEntry entry;
+    if (m_denseCode < DenseCodeCount)
+    {
+        code = m_denseCode;
+        entry = codeSpace.DenseTables[code / DenseTableSize][code % DenseTableSize];
+    }
+    else
+    {
+        code = m_sparseIt->first;
+        entry = m_sparseIt->second;
+    }
+
+    m_current.first = PdfCharCode(code, codeSpaceSize);
+    m_current.second = m_map->getCodePoints(entry, m_codePoint);
+    return m_current;
+}
+
+PdfCharCodeMap::MappingIterator::pointer PdfCharCodeMap::MappingIterator::operator->() const
+{
+    return &operator*();
+}
+
+bool PdfCharCodeMap::MappingIterator::isRangeCurrent() const
+{
+    auto& codeSpace = *m_map->m_codeSpaces[m_codeSpaceIndex];
+    if (m_rangeIndex == codeSpace.Ranges.size())
+        return false;
+
+    unsigned rangeCode = codeSpace.Ranges[m_rangeIndex].Code + m_rangeOffset;
+    if (m_denseCode < DenseCodeCount)
+        return rangeCode < m_denseCode;
+    else if (m_sparseIt != codeSpace.Sparse.end())
+        return rangeCode < m_sparseIt->first;
+    else
+        return true;
+}
+
+bool PdfCharCodeMap::MappingIterator::isCodeSpaceEnd() const
+{
+    auto& codeSpace = *m_map->m_codeSpaces[m_codeSpaceIndex];
+    return m_denseCode == DenseCodeCount && m_sparseIt == codeSpace.Sparse.end()
+        && m_rangeIndex == codeSpace.Ranges.size();
+}
+
+void PdfCharCodeMap::MappingIterator::seekCodeSpace(unsigned index)
+{
+    // Move to the first mapping of the next code space with mappings
+    for (; index < MaxCodeSpaceSize; index++)
+    {
+        auto& codeSpace = m_map->m_codeSpaces[index];
+        if (codeSpace == nullptr)
+            continue;
+
+        m_codeSpaceIndex = index;
+        m_denseCode = findNextDenseCode(*codeSpace, 0);
+        m_sparseIt = codeSpace->Sparse.begin();
+        m_rangeIndex = 0;
+        m_rangeOffset = 0;
+        if (!isCodeSpaceEnd())
+            return;
+    }
+
+    m_codeSpaceIndex = MaxCodeSpaceSize;
+    m_denseCode = DenseCodeCount;
+    m_rangeIndex = 0;
+    m_rangeOffset = 0;
+}
+
+PdfCharCodeMap::iterator::iterator() { }
+
+PdfCharCodeMap::iterator::iterator(const MappingIterator& it)
+    : m_it(it) { }
+
+PdfCharCodeMap::iterator::iterator(const iterator& rhs)
+    : m_it(rhs.m_it) { }
+
+PdfCharCodeMap::iterator& PdfCharCodeMap::iterator::operator=(const iterator& rhs)
+{
+    m_it = rhs.m_it;
+    m_current.reset();
+    return *this;
+}
+
+bool PdfCharCodeMap::iterator::operator==(const iterator& rhs) const
+{
+    return m_it == rhs.m_it;
+}
+
+bool PdfCharCodeMap::iterator::operator!=(const iterator& rhs) const
+{
+    return m_it != rhs.m_it;
+}
+
+PdfCharCodeMap::iterator& PdfCharCodeMap::iterator::operator++()
+{
+    ++m_it;
+    m_current.reset();
+    return *this;
+}
+
+PdfCharCodeMap::iterator PdfCharCodeMap::iterator::operator++(int)
+{
+    auto copy = *this;
+    operator++();
+    return copy;
+}
+
+PdfCharCodeMap::iterator::reference PdfCharCodeMap::iterator::operator*() const
+{
+    if (m_current == nullptr)
+    {
+        auto& mapping = *m_it;
+        m_current.reset(new value_type(mapping.first,
+            vector<codepoint>(mapping.second.begin(), mapping.second.end())));
+    }
+
+    return *m_current;
+}
+
+PdfCharCodeMap::iterator::pointer PdfCharCodeMap::iterator::operator->() const
+{
+    return &operator*();
+}
+
+PdfCharCodeMap::MappingIterable::MappingIterable(const PdfCharCodeMap& map)
+    : m_map(&map) { }
+
+PdfCharCodeMap::MappingIterator PdfCharCodeMap::MappingIterable::begin() const
+{
+    return MappingIterator(*m_map, false);
+}
+
+PdfCharCodeMap::MappingIterator PdfCharCodeMap::MappingIterable::end() const
+{
+    return MappingIterator(*m_map, true);
+}
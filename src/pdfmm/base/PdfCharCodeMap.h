@@ -8,6 +8,10 @@
 #define PDF_CHAR_CODE_MAP_H
 
 #include "PdfDeclarations.h"
+
+#include <atomic>
+#include <mutex>
+
 #include "PdfEncodingCommon.h"
 
 namespace mm
@@ -28,6 +32,12 @@ namespace mm
      * in CID keyed fonts. For generic terminology see
      * https://en.wikipedia.org/wiki/Character_encoding#Terminology
      * See also 5014.CIDFont_Spec, 2.1 Terminology
+     * \remarks Code units are stored separately for each code space size,
+     * so <41> and <0041> are distinct code units. They are stored in dense
+     * tables for 1 and 2 bytes codes, sequential mappings as pushed with
+     * PushRangeMapping() are stored as ranges and code points of multiple
+     * code points mappings are stored in a shared pool
+     * \remarks Lookups are thread safe, provided no mappings are pushed concurrently
      */
     class PDFMM_API PdfCharCodeMap final
     {
@@ -47,6 +57,15 @@ namespace mm
          */
         void PushMapping(const PdfCharCode& codeUnit, codepoint codePoint);
 
+        /** Push a range of sequential mappings, as found in
+         * "beginbfrange" and "begincidrange" CMap clauses
+         * \param codeUnit the first code unit of the range
+         * \param size the count of the code units in the range
+         * \param codePoint the code point mapped by the first code unit,
+         *      following code units are mapped to following code points
+         */
+        void PushRangeMapping(const PdfCharCode& codeUnit, unsigned size, codepoint codePoint);
+
         /** Returns false when no mapped identifiers are not found in the map
          */
         bool TryGetCodePoints(const PdfCharCode& codeUnit, std::vector<codepoint>& codePoints) const;
@@ -74,8 +93,28 @@ namespace mm
         const PdfEncodingLimits& GetLimits() const;
 
     private:
-        void move(PdfCharCodeMap& map) noexcept;
-        void pushMapping(const PdfCharCode& codeUnit, std::vector<codepoint>&& codePoints);
+        // A code unit mapping: either a single code point
+        // or the offset of the code points in the pool
+        using MappingEntry = uint32_t;
+
+        // A range of code units mapped to sequential code points
+        struct CodeRange
+        {
+            unsigned Code;
+            unsigned Size;
+            codepoint CodePoint;
+        };
+
+        using SparseMap = std::map<unsigned, MappingEntry>;
+
+        // The mappings of the code units of a code space size
+        struct CodeSpaceMappings
+        {
+            // Dense tables of 256 entries for codes up to 0xFFFF, allocated on demand
+            std::vector<std::unique_ptr<MappingEntry[]>> DenseTables;
+            SparseMap Sparse;                   // Codes bigger than 0xFFFF
+            std::vector<CodeRange> Ranges;      // Sorted and disjoint from the other entries
+        };
 
         // Map code point(s) -> code units
         struct CPMapNode
@@ -87,11 +126,118 @@ namespace mm
             CPMapNode* Right;
         };
 
+    public:
+        /** Iterate the mappings by code space size, then in code
+         * order. The value is the code unit and a view of the mapped
+         * code points, valid until the iterator is incremented
+         */
+        class PDFMM_API MappingIterator final
+        {
+            friend class PdfCharCodeMap;
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::pair<PdfCharCode, codepointview>;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+            using iterator_category = std::forward_iterator_tag;
+        public:
+            MappingIterator();
+        private:
+            MappingIterator(const PdfCharCodeMap& map, bool end);
+        public:
+            MappingIterator(const MappingIterator&) = default;
+            MappingIterator& operator=(const MappingIterator&) = default;
+            bool operator==(const MappingIterator& rhs) const;
+            bool operator!=(const MappingIterator& rhs) const;
+            MappingIterator& operator++();
+            MappingIterator operator++(int);
+            reference operator*() const;
+            pointer operator->() const;
+        private:
+            bool isRangeCurrent() const;
+            bool isCodeSpaceEnd() const;
+            void seekCodeSpace(unsigned index);
+        private:
+            const PdfCharCodeMap* m_map;
+            unsigned m_codeSpaceIndex;
+            unsigned m_denseCode;
+            SparseMap::const_iterator m_sparseIt;
+            unsigned m_rangeIndex;
+            unsigned m_rangeOffset;
+            mutable codepoint m_codePoint;
+            mutable value_type m_current;
+        };
+
+        /** Iterate the mappings in the same order as MappingIterator,
+         * copying the mapped code points in a vector
+         */
+        class PDFMM_API iterator final
+        {
+            friend class PdfCharCodeMap;
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::pair<const PdfCharCode, std::vector<codepoint>>;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+            using iterator_category = std::forward_iterator_tag;
+        public:
+            iterator();
+        private:
+            iterator(const MappingIterator& it);
+        public:
+            iterator(const iterator& rhs);
+            iterator& operator=(const iterator& rhs);
+            bool operator==(const iterator& rhs) const;
+            bool operator!=(const iterator& rhs) const;
+            iterator& operator++();
+            iterator operator++(int);
+            reference operator*() const;
+            pointer operator->() const;
+        private:
+            MappingIterator m_it;
+            mutable std::unique_ptr<value_type> m_current;
+        };
+
+        class PDFMM_API MappingIterable final
+        {
+            friend class PdfCharCodeMap;
+        private:
+            MappingIterable(const PdfCharCodeMap& map);
+        public:
+            MappingIterator begin() const;
+            MappingIterator end() const;
+        private:
+            const PdfCharCodeMap* m_map;
+        };
+
+    public:
+        iterator begin() const;
+        iterator end() const;
+
+        /** Get the mappings without copying the code points
+         */
+        MappingIterable GetMappings() const;
+
     private:
         PdfCharCodeMap(const PdfCharCodeMap&) = delete;
         PdfCharCodeMap& operator=(const PdfCharCodeMap&) = delete;
 
     private:
+        void move(PdfCharCodeMap& map) noexcept;
+        void pushMapping(const PdfCharCode& codeUnit, const codepointview& codePoints);
+        void updateLimits(const PdfCharCode& codeUnit);
+        bool tryGetCodePoints(const PdfCharCode& codeUnit, codepointview& codePoints, codepoint& temp) const;
+        MappingEntry createEntry(const codepointview& codePoints);
+        void releaseEntry(MappingEntry entry);
+        void compactPool();
+        codepointview getCodePoints(MappingEntry entry, codepoint& temp) const;
+        const CodeSpaceMappings* getCodeSpace(unsigned char codeSpaceSize) const;
+        CodeSpaceMappings& getOrCreateCodeSpace(unsigned char codeSpaceSize);
+        static const MappingEntry* findEntry(const CodeSpaceMappings& codeSpace, unsigned code);
+        static MappingEntry& getOrCreateEntry(CodeSpaceMappings& codeSpace, unsigned code);
+        static unsigned findNextDenseCode(const CodeSpaceMappings& codeSpace, unsigned code);
+        void eraseEntries(CodeSpaceMappings& codeSpace, unsigned code, unsigned last);
+        void eraseRanges(CodeSpaceMappings& codeSpace, unsigned code, unsigned last);
         void reviseCPMap();
         static bool tryFindNextCharacterId(const CPMapNode* node, std::string_view::iterator &it,
             const std::string_view::iterator& end, PdfCharCode& cid);
@@ -99,20 +245,18 @@ namespace mm
         static void deleteNode(CPMapNode* node);
         static CPMapNode* findOrAddNode(CPMapNode*& node, codepoint codePoint);
 
-    public:
-        // Map code units -> code point(s)
-        // pp. 474-475 of PdfReference 1.7 "The value of dstString can be a string of up to 512 bytes"
-        using CodeUnitMap = std::map<PdfCharCode, std::vector<codepoint>>;
-        using iterator = CodeUnitMap::const_iterator;
-
-    public:
-        iterator begin() const;
-        iterator end() const;
-
     private:
         PdfEncodingLimits m_Limits;
-        CodeUnitMap m_CodeUnitMap;
-        bool m_MapDirty;
+        // The mappings by code space size minus one, allocated on demand
+        std::unique_ptr<CodeSpaceMappings> m_codeSpaces[4];
+        // Pool of multiple code points mappings, stored as the
+        // count of the code points followed by the code points
+        // pp. 474-475 of PdfReference 1.7 "The value of dstString can be a string of up to 512 bytes"
+        std::vector<codepoint> m_codePointPool;
+        size_t m_poolGarbageSize;               // Size of the pool items no more referenced
+        unsigned m_Size;
+        std::atomic<bool> m_MapDirty;
+        std::mutex m_codePointMapMutex;          // Guards the lazy creation of the BST
         CPMapNode* m_codePointMapHead;           // Head of a BST to lookup code points
         int m_depth;
     };
@@ -122,6 +122,8 @@ enum class PdfWriteFlags
     Clean = 1,             ///< Create a PDF that is readable in a text editor, i.e. insert spaces and linebreaks between tokens
     NoInlineLiteral = 2,   ///< Don't write spaces before literal types (numerical, references, null)
     NoFlateCompress = 4,
+    FlateBestSpeed = 8,        ///< Flate compress the streams with PdfCompressionLevel::BestSpeed
+    FlateBestCompression = 16, ///< Flate compress the streams with PdfCompressionLevel::BestCompression
 
     // NOTE: The following flags are actually never set but
     // they are kept for documenting some PDF peculiarities
@@ -426,6 +428,23 @@ enum class PdfSaveOptions
     NoCollectGarbage = 8,
     NoModifyDateUpdate = 16,
     Clean = 32,
+    ObjectStreams = 64, ///< Pack eligible objects in compressed object streams. Requires PDF 1.5 and implies a XRef stream
+    _Reserved3 = 128,
+    FlateBestSpeed = 256, ///< Flate compress the streams favoring speed over size. Streams with a compression level set are not affected
+    FlateBestCompression = 512, ///< Flate compress the streams favoring size over speed. Streams with a compression level set are not affected
+};
+
+/**
+ * Compression level used when flate compressing streams.
+ * Levels between BestSpeed and BestCompression can be
+ * specified by casting integer values
+ */
+enum class PdfCompressionLevel : int8_t
+{
+    Default = -1,           ///< The default trade off between speed and size
+    NoCompression = 0,      ///< Store the data in the flate format without compressing it
+    BestSpeed = 1,
+    BestCompression = 9,
 };
 
 /**
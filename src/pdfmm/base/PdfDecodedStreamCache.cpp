@@ -0,0 +1,108 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2022 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfDecodedStreamCache.h"
+
+using namespace std;
+using namespace mm;
+
+PdfDecodedStreamCache::PdfDecodedStreamCache()
+    : m_Budget(0) { }
+
+void PdfDecodedStreamCache::SetBudget(size_t budget)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_Budget = budget;
+    evict(budget);
+}
+
+PdfDecodedStreamCacheStats PdfDecodedStreamCache::GetStats() const
+{
+    unique_lock<mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void PdfDecodedStreamCache::ResetStats()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_stats.Hits = 0;
+    m_stats.Misses = 0;
+    m_stats.Evictions = 0;
+}
+
+void PdfDecodedStreamCache::Clear()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_entries.clear();
+    m_map.clear();
+    m_stats.Size = 0;
+    m_stats.EntryCount = 0;
+}
+
+bool PdfDecodedStreamCache::TryGet(const PdfReference& ref, charbuff& buffer)
+{
+    unique_lock<mutex> lock(m_mutex);
+    auto found = m_map.find(ref);
+    if (found == m_map.end())
+    {
+        m_stats.Misses++;
+        return false;
+    }
+
+    // Move the entry to the front of the recently used list
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    m_stats.Hits++;
+    buffer = found->second->Data;
+    return true;
+}
+
+void PdfDecodedStreamCache::Add(const PdfReference& ref, const charbuff& buffer)
+{
+    unique_lock<mutex> lock(m_mutex);
+    size_t budget = m_Budget;
+    if (buffer.size() > budget)
+        return;
+
+    auto found = m_map.find(ref);
+    if (found != m_map.end())
+    {
+        // The stream was decoded concurrently by another reader
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        return;
+    }
+
+    evict(budget - buffer.size());
+    m_entries.push_front({ ref, buffer });
+    m_map[ref] = m_entries.begin();
+    m_stats.Size += buffer.size();
+    m_stats.EntryCount++;
+}
+
+void PdfDecodedStreamCache::Invalidate(const PdfReference& ref)
+{
+    unique_lock<mutex> lock(m_mutex);
+    auto found = m_map.find(ref);
+    if (found == m_map.end())
+        return;
+
+    m_stats.Size -= found->second->Data.size();
+    m_stats.EntryCount--;
+    m_entries.erase(found->second);
+    m_map.erase(found);
+}
+
+void PdfDecodedStreamCache::evict(size_t budget)
+{
+    while (m_stats.Size > budget)
+    {
+        auto& entry = m_entries.back();
+        m_stats.Size -= entry.Data.size();
+        m_stats.EntryCount--;
+        m_stats.Evictions++;
+        m_map.erase(entry.Reference);
+        m_entries.pop_back();
+    }
+}
@@ -0,0 +1,109 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2022 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_DECODED_STREAM_CACHE_H
+#define PDF_DECODED_STREAM_CACHE_H
+
+#include "PdfDeclarations.h"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "PdfReference.h"
+
+namespace mm {
+
+/** Statistics of a PdfDecodedStreamCache
+ */
+struct PdfDecodedStreamCacheStats
+{
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+    uint64_t Evictions = 0;     ///< Entries evicted to fit the budget
+    size_t Size = 0;            ///< Size of the decoded data held by the cache
+    unsigned EntryCount = 0;
+};
+
+/** A per document cache of decoded stream data, keyed by
+ *  object reference, with a byte budget and least recently
+ *  used eviction.
+ *
+ *  The cache is used when copying the decoded data of a stream,
+ *  eg. with PdfObjectStream::GetCopy(), which is done by content
+ *  stream parsing, text extraction and font loading. Entries are
+ *  invalidated when the stream data is modified or the object is
+ *  removed. Changing the /Filter or /DecodeParms keys without
+ *  rewriting the data requires to Clear() the cache.
+ *  The cache is disabled by default.
+ *
+ *  \remarks The cache is internally synchronized and can be used by
+ *      concurrent readers of the document. See PdfDocument read-only
+ *      concurrency contract
+ *  \see PdfDocument::GetDecodedStreamCache()
+ */
+class PDFMM_API PdfDecodedStreamCache final
+{
+    friend class PdfDocument;
+    friend class PdfObjectStream;
+    friend class PdfObjectOutputStream;
+    friend class PdfIndirectObjectList;
+
+    PdfDecodedStreamCache(const PdfDecodedStreamCache&) = delete;
+    PdfDecodedStreamCache& operator=(const PdfDecodedStreamCache&) = delete;
+
+private:
+    PdfDecodedStreamCache();
+
+public:
+    /** Set the maximum size of the decoded data held by
+     *  the cache, evicting the least recently used entries
+     *  as needed. 0 disables the cache
+     */
+    void SetBudget(size_t budget);
+
+    size_t GetBudget() const { return m_Budget; }
+
+    bool IsEnabled() const { return m_Budget != 0; }
+
+    PdfDecodedStreamCacheStats GetStats() const;
+
+    /** Reset the hits, misses and evictions counters
+     */
+    void ResetStats();
+
+    /** Remove all the entries
+     */
+    void Clear();
+
+private:
+    bool TryGet(const PdfReference& ref, charbuff& buffer);
+    void Add(const PdfReference& ref, const charbuff& buffer);
+    void Invalidate(const PdfReference& ref);
+
+private:
+    void evict(size_t budget);
+
+private:
+    struct Entry
+    {
+        PdfReference Reference;
+        charbuff Data;
+    };
+
+    using EntryList = std::list<Entry>;
+
+private:
+    mutable std::mutex m_mutex;
+    std::atomic<size_t> m_Budget;
+    EntryList m_entries;        // Most recently used first
+    std::unordered_map<PdfReference, EntryList::iterator> m_map;
+    PdfDecodedStreamCacheStats m_stats;
+};
+
+};
+
+#endif // PDF_DECODED_STREAM_CACHE_H
@@ -12,6 +12,11 @@
 using namespace std;
 using namespace mm;
 
+static unsigned lowerBound(const PdfDictionaryIndexEntry* index, unsigned size, const string_view& key);
+
+// The index of empty maps, so flat index positions are never null
+static PdfDictionaryIndexEntry s_emptyIndex[1];
+
 PdfDictionary::PdfDictionary() { }
 
 PdfDictionary::PdfDictionary(const PdfDictionary& rhs)
@@ -107,7 +112,7 @@ pair<PdfDictionaryMap::iterator, bool> PdfDictionary::AddKey(const PdfName& key,
     // NOTE: Empty PdfNames are legal according to the PDF specification.
     // Don't check for it
 
-    pair<PdfDictionaryMap::iterator, bool> inserted = m_Map.try_emplace(key, std::move(obj));
+    auto inserted = m_Map.try_emplace(key, std::move(obj));
     if (!inserted.second)
     {
         if (noDirtySet)
@@ -363,3 +368,350 @@ size_t PdfDictionary::size() const
 {
     return m_Map.size();
 }
+
+PdfDictionaryMap::PdfDictionaryMap() :
+    m_size(0),
+    m_indexCapacity(0),
+    m_lastBlockUsed(0),
+    m_lastBlock(nullptr),
+    m_freeEntries(nullptr)
+{
+}
+
+PdfDictionaryMap::PdfDictionaryMap(const PdfDictionaryMap& rhs)
+    : PdfDictionaryMap()
+{
+    try
+    {
+        // Source entries are already sorted, just append them
+        if (rhs.m_treeIndex == nullptr)
+            reserveIndex(rhs.m_size);
+        else
+            m_treeIndex.reset(new PdfDictionaryTreeIndex());
+
+        auto index = getIndex();
+        for (auto& entry : rhs)
+        {
+            auto newEntry = allocateEntry();
+            try
+            {
+                new(newEntry) PdfDictionaryEntry(entry);
+            }
+            catch (...)
+            {
+                // The entry was not constructed, just release the slot
+                freeEntry(newEntry);
+                throw;
+            }
+
+            if (m_treeIndex == nullptr)
+            {
+                index[m_size] = { newEntry->first.GetRawData(), newEntry };
+            }
+            else
+            {
+                try
+                {
+                    m_treeIndex->emplace_hint(m_treeIndex->end(), newEntry->first.GetRawData(), newEntry);
+                }
+                catch (...)
+                {
+                    newEntry->~PdfDictionaryEntry();
+                    freeEntry(newEntry);
+                    throw;
+                }
+            }
+            m_size++;
+        }
+    }
+    catch (...)
+    {
+        clear();
+        throw;
+    }
+}
+
+PdfDictionaryMap::PdfDictionaryMap(PdfDictionaryMap&& rhs) noexcept
+    : PdfDictionaryMap()
+{
+    moveFrom(rhs);
+}
+
+PdfDictionaryMap::~PdfDictionaryMap()
+{
+    clear();
+}
+
+PdfDictionaryMap& PdfDictionaryMap::operator=(const PdfDictionaryMap& rhs)
+{
+    if (this == &rhs)
+        return *this;
+
+    PdfDictionaryMap copy(rhs);
+    clear();
+    moveFrom(copy);
+    return *this;
+}
+
+PdfDictionaryMap& PdfDictionaryMap::operator=(PdfDictionaryMap&& rhs) noexcept
+{
+    if (this == &rhs)
+        return *this;
+
+    clear();
+    moveFrom(rhs);
+    return *this;
+}
+
+bool PdfDictionaryMap::operator==(const PdfDictionaryMap& rhs) const
+{
+    if (m_size != rhs.m_size)
+        return false;
+
+    // Entries are sorted in both maps, whatever the index kind
+    auto rhsIt = rhs.begin();
+    for (auto& entry : *this)
+    {
+        if (!(entry == *rhsIt))
+            return false;
+
+        rhsIt++;
+    }
+
+    return true;
+}
+
+bool PdfDictionaryMap::operator!=(const PdfDictionaryMap& rhs) const
+{
+    return !(*this == rhs);
+}
+
+pair<PdfDictionaryMap::iterator, bool> PdfDictionaryMap::try_emplace(const PdfName& key, PdfObject&& obj)
+{
+    string_view keyView = key.GetRawData();
+    if (m_treeIndex != nullptr)
+    {
+        auto found = m_treeIndex->lower_bound(keyView);
+        if (found != m_treeIndex->end() && found->first == keyView)
+            return { iterator(found), false };
+
+        auto entry = allocateEntry();
+        try
+        {
+            new(entry) PdfDictionaryEntry(key, std::move(obj));
+        }
+        catch (...)
+        {
+            freeEntry(entry);
+            throw;
+        }
+
+        PdfDictionaryTreeIndex::iterator inserted;
+        try
+        {
+            inserted = m_treeIndex->emplace_hint(found, entry->first.GetRawData(), entry);
+        }
+        catch (...)
+        {
+            entry->~PdfDictionaryEntry();
+            freeEntry(entry);
+            throw;
+        }
+
+        m_size++;
+        return { iterator(inserted), true };
+    }
+
+    auto index = getIndex();
+    unsigned pos = lowerBound(index, m_size, keyView);
+    if (pos != m_size && index[pos].Key == keyView)
+        return { iterator(index + pos), false };
+
+    if (m_size == MaxFlatIndexSize)
+    {
+        // Shifting the flat index would make insertions
+        // linear in the size: switch to the tree index
+        createTreeIndex();
+        return try_emplace(key, std::move(obj));
+    }
+
+    // Reserve all the needed space before constructing the entry
+    reserveIndex(m_size + 1);
+    auto entry = allocateEntry();
+    try
+    {
+        new(entry) PdfDictionaryEntry(key, std::move(obj));
+    }
+    catch (...)
+    {
+        freeEntry(entry);
+        throw;
+    }
+
+    index = getIndex();
+    std::memmove(index + pos + 1, index + pos, (m_size - pos) * sizeof(PdfDictionaryIndexEntry));
+    index[pos] = { entry->first.GetRawData(), entry };
+    m_size++;
+    return { iterator(index + pos), true };
+}
+
+PdfDictionaryMap::iterator PdfDictionaryMap::find(const string_view& key)
+{
+    if (m_treeIndex != nullptr)
+        return iterator(m_treeIndex->find(key));
+
+    auto index = getIndex();
+    unsigned pos = lowerBound(index, m_size, key);
+    if (pos == m_size || index[pos].Key != key)
+        return end();
+
+    return iterator(index + pos);
+}
+
+PdfDictionaryMap::const_iterator PdfDictionaryMap::find(const string_view& key) const
+{
+    return const_cast<PdfDictionaryMap&>(*this).find(key);
+}
+
+PdfDictionaryMap::iterator PdfDictionaryMap::erase(const const_iterator& it)
+{
+    PdfDictionaryEntry* entry;
+    iterator ret;
+    if (m_treeIndex == nullptr)
+    {
+        auto index = getIndex();
+        unsigned pos = (unsigned)(it.m_it - index);
+        entry = index[pos].Entry;
+        std::memmove(index + pos, index + pos + 1, (m_size - pos - 1) * sizeof(PdfDictionaryIndexEntry));
+        ret = iterator(index + pos);
+    }
+    else
+    {
+        entry = it.m_treeIt->second;
+        ret = iterator(m_treeIndex->erase(it.m_treeIt));
+    }
+
+    m_size--;
+    entry->~PdfDictionaryEntry();
+    freeEntry(entry);
+    return ret;
+}
+
+void PdfDictionaryMap::clear()
+{
+    for (auto& entry : *this)
+        entry.~PdfDictionaryEntry();
+
+    while (m_lastBlock != nullptr)
+    {
+        auto previous = reinterpret_cast<EntryBlock*>(m_lastBlock)->Previous;
+        delete[] m_lastBlock;
+        m_lastBlock = previous;
+    }
+
+    m_size = 0;
+    m_indexCapacity = 0;
+    m_lastBlockUsed = 0;
+    m_flatIndex.reset();
+    m_treeIndex.reset();
+    m_freeEntries = nullptr;
+}
+
+PdfDictionaryIndexEntry* PdfDictionaryMap::getIndex() const
+{
+    return m_flatIndex == nullptr ? s_emptyIndex : m_flatIndex.get();
+}
+
+void PdfDictionaryMap::reserveIndex(unsigned size)
+{
+    if (size <= m_indexCapacity)
+        return;
+
+    unsigned capacity = std::max({ size, m_indexCapacity * 2, InitialCapacity });
+    unique_ptr<PdfDictionaryIndexEntry[]> index(new PdfDictionaryIndexEntry[capacity]);
+    std::copy(getIndex(), getIndex() + m_size, index.get());
+    m_flatIndex = std::move(index);
+    m_indexCapacity = capacity;
+}
+
+void PdfDictionaryMap::createTreeIndex()
+{
+    unique_ptr<PdfDictionaryTreeIndex> treeIndex(new PdfDictionaryTreeIndex());
+    auto index = getIndex();
+    for (unsigned i = 0; i < m_size; i++)
+        treeIndex->emplace_hint(treeIndex->end(), index[i].Key, index[i].Entry);
+
+    m_treeIndex = std::move(treeIndex);
+    m_flatIndex.reset();
+    m_indexCapacity = 0;
+}
+
+PdfDictionaryEntry* PdfDictionaryMap::allocateEntry()
+{
+    if (m_freeEntries != nullptr)
+    {
+        // Reuse the most recently released slot
+        auto storage = m_freeEntries;
+        std::memcpy(&m_freeEntries, storage, sizeof(EntryStorage*));
+        return reinterpret_cast<PdfDictionaryEntry*>(storage);
+    }
+
+    static_assert(sizeof(EntryBlock) <= sizeof(EntryStorage), "The block header must fit a slot");
+    if (m_lastBlock == nullptr || m_lastBlockUsed == reinterpret_cast<EntryBlock*>(m_lastBlock)->Capacity)
+    {
+        // Allocate blocks of geometrically increasing size, bounded
+        // to limit the memory left unused in the last block
+        unsigned capacity = m_lastBlock == nullptr ? InitialCapacity
+            : std::min(reinterpret_cast<EntryBlock*>(m_lastBlock)->Capacity * 2, 1024u);
+        auto block = new EntryStorage[capacity + 1];
+        new(block) EntryBlock{ m_lastBlock, capacity };
+        m_lastBlock = block;
+        m_lastBlockUsed = 0;
+    }
+
+    return reinterpret_cast<PdfDictionaryEntry*>(&m_lastBlock[1 + m_lastBlockUsed++]);
+}
+
+// NOTE: The entry must be already destroyed
+void PdfDictionaryMap::freeEntry(PdfDictionaryEntry* entry)
+{
+    // Link the released slot in the free list
+    auto storage = reinterpret_cast<EntryStorage*>(entry);
+    std::memcpy(storage, &m_freeEntries, sizeof(EntryStorage*));
+    m_freeEntries = storage;
+}
+
+// NOTE: This map must be empty. The entries and the
+// indices are just transferred
+void PdfDictionaryMap::moveFrom(PdfDictionaryMap& rhs)
+{
+    m_size = rhs.m_size;
+    m_indexCapacity = rhs.m_indexCapacity;
+    m_lastBlockUsed = rhs.m_lastBlockUsed;
+    m_flatIndex = std::move(rhs.m_flatIndex);
+    m_treeIndex = std::move(rhs.m_treeIndex);
+    m_lastBlock = rhs.m_lastBlock;
+    m_freeEntries = rhs.m_freeEntries;
+
+    rhs.m_size = 0;
+    rhs.m_indexCapacity = 0;
+    rhs.m_lastBlockUsed = 0;
+    rhs.m_lastBlock = nullptr;
+    rhs.m_freeEntries = nullptr;
+}
+
+unsigned lowerBound(const PdfDictionaryIndexEntry* index, unsigned size, const string_view& key)
+{
+    unsigned low = 0;
+    unsigned high = size;
+    while (low < high)
+    {
+        unsigned mid = low + (high - low) / 2;
+        if (index[mid].Key < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
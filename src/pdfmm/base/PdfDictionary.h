@@ -14,27 +14,171 @@ namespace mm {
 
 class PdfDictionary;
 
-// Compartor to enable heterogeneous lookup in
-// PdfDictionary with both PdfName and string_view
-// See https://stackoverflow.com/a/31924435/213871
-struct PdfDictionaryComparator final
+using PdfDictionaryEntry = std::pair<const PdfName, PdfObject>;
+
+/** Entry of the sorted PdfDictionaryMap index. The key
+ * view is cached to make lookups not touch the entries
+ */
+struct PdfDictionaryIndexEntry
+{
+    std::string_view Key;
+    PdfDictionaryEntry* Entry;
+};
+
+/** Ordered index used by large PdfDictionaryMap instances
+ */
+using PdfDictionaryTreeIndex = std::map<std::string_view, PdfDictionaryEntry*>;
+
+/**
+ * Iterator on the entries of a PdfDictionaryMap
+ */
+template <typename TEntry>
+class PdfDictionaryMapIteratorBase final
 {
-    using is_transparent = std::true_type;
-    bool operator()(const PdfName& lhs, const PdfName& rhs) const
+    friend class PdfDictionaryMap;
+
+    template <typename TOtherEntry>
+    friend class PdfDictionaryMapIteratorBase;
+
+public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = PdfDictionaryEntry;
+    using pointer = TEntry*;
+    using reference = TEntry&;
+    using iterator_category = std::bidirectional_iterator_tag;
+
+public:
+    PdfDictionaryMapIteratorBase() : m_it(nullptr) { }
+
+    // Allow conversion from iterator to const_iterator
+    template <typename TOtherEntry, typename = std::enable_if_t<std::is_convertible_v<TOtherEntry*, TEntry*>>>
+    PdfDictionaryMapIteratorBase(const PdfDictionaryMapIteratorBase<TOtherEntry>& it)
+        : m_it(it.m_it), m_treeIt(it.m_treeIt) { }
+
+private:
+    PdfDictionaryMapIteratorBase(const PdfDictionaryIndexEntry* it) : m_it(it) { }
+    PdfDictionaryMapIteratorBase(const PdfDictionaryTreeIndex::const_iterator& it) : m_it(nullptr), m_treeIt(it) { }
+
+public:
+    bool operator==(const PdfDictionaryMapIteratorBase& rhs) const
     {
-        return lhs < rhs;
+        return m_it == rhs.m_it && (m_it != nullptr || m_treeIt == rhs.m_treeIt);
     }
-    bool operator()(const PdfName& lhs, const std::string_view& rhs) const
+    bool operator!=(const PdfDictionaryMapIteratorBase& rhs) const { return !(*this == rhs); }
+    PdfDictionaryMapIteratorBase& operator++() { increment(); return *this; }
+    PdfDictionaryMapIteratorBase operator++(int) { auto ret = *this; increment(); return ret; }
+    PdfDictionaryMapIteratorBase& operator--() { decrement(); return *this; }
+    PdfDictionaryMapIteratorBase operator--(int) { auto ret = *this; decrement(); return ret; }
+    reference operator*() const { return *getEntry(); }
+    pointer operator->() const { return getEntry(); }
+
+private:
+    void increment()
     {
-        return lhs.GetRawData() < rhs;
+        if (m_it == nullptr)
+            m_treeIt++;
+        else
+            m_it++;
     }
-    bool operator()(const std::string_view& lhs, const PdfName& rhs) const
+    void decrement()
     {
-        return lhs < rhs.GetRawData();
+        if (m_it == nullptr)
+            m_treeIt--;
+        else
+            m_it--;
     }
+    pointer getEntry() const { return m_it == nullptr ? m_treeIt->second : m_it->Entry; }
+
+private:
+    // The sorted index position, or nullptr if the map uses the tree index
+    const PdfDictionaryIndexEntry* m_it;
+    PdfDictionaryTreeIndex::const_iterator m_treeIt;
 };
 
-using PdfDictionaryMap = std::map<PdfName, PdfObject, PdfDictionaryComparator>;
+/**
+ * Map of dictionary entries, sorted by key. The storage is allocated on
+ * the first insertion, so empty dictionaries need no heap allocation and
+ * the map itself is as small as a std::map. Entries are allocated in
+ * blocks of increasing size. Small dictionaries are indexed by a flat
+ * sorted array searched with a binary search. When a dictionary grows
+ * past MaxFlatIndexSize entries, the index switches to a balanced tree,
+ * so insertion and removal of keys stay O(log n) also for very large
+ * dictionaries.
+ * Entries are never relocated: as with std::map, references to the
+ * values stay valid until the entry is removed or the map is cleared,
+ * also when the map is moved.
+ * Iterators are invalidated by insertions and removals
+ */
+class PDFMM_API PdfDictionaryMap final
+{
+public:
+    static constexpr unsigned InitialCapacity = 4;
+    static constexpr unsigned MaxFlatIndexSize = 64;
+
+    using value_type = PdfDictionaryEntry;
+    using iterator = PdfDictionaryMapIteratorBase<PdfDictionaryEntry>;
+    using const_iterator = PdfDictionaryMapIteratorBase<const PdfDictionaryEntry>;
+
+public:
+    PdfDictionaryMap();
+    PdfDictionaryMap(const PdfDictionaryMap& rhs);
+    PdfDictionaryMap(PdfDictionaryMap&& rhs) noexcept;
+    ~PdfDictionaryMap();
+
+    PdfDictionaryMap& operator=(const PdfDictionaryMap& rhs);
+    PdfDictionaryMap& operator=(PdfDictionaryMap&& rhs) noexcept;
+
+    bool operator==(const PdfDictionaryMap& rhs) const;
+    bool operator!=(const PdfDictionaryMap& rhs) const;
+
+public:
+    /** Insert a new entry, if the key is not already present
+     * \returns the entry with the given key and true if it was inserted
+     */
+    std::pair<iterator, bool> try_emplace(const PdfName& key, PdfObject&& obj);
+    iterator find(const std::string_view& key);
+    const_iterator find(const std::string_view& key) const;
+    iterator erase(const const_iterator& it);
+    void clear();
+
+    iterator begin() { return m_treeIndex == nullptr ? iterator(getIndex()) : iterator(m_treeIndex->begin()); }
+    iterator end() { return m_treeIndex == nullptr ? iterator(getIndex() + m_size) : iterator(m_treeIndex->end()); }
+    const_iterator begin() const { return const_cast<PdfDictionaryMap&>(*this).begin(); }
+    const_iterator end() const { return const_cast<PdfDictionaryMap&>(*this).end(); }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+private:
+    using EntryStorage = std::aligned_storage_t<sizeof(PdfDictionaryEntry), alignof(PdfDictionaryEntry)>;
+
+    // Header of a block of entry storage, held in the first slot of
+    // the block. Blocks have geometrically increasing size and are
+    // filled in order: only the last block can have unused slots
+    struct EntryBlock
+    {
+        EntryStorage* Previous;
+        unsigned Capacity;
+    };
+
+private:
+    PdfDictionaryIndexEntry* getIndex() const;
+    void reserveIndex(unsigned size);
+    void createTreeIndex();
+    PdfDictionaryEntry* allocateEntry();
+    void freeEntry(PdfDictionaryEntry* entry);
+    void moveFrom(PdfDictionaryMap& rhs);
+
+private:
+    unsigned m_size;
+    unsigned m_indexCapacity;
+    unsigned m_lastBlockUsed;
+    std::unique_ptr<PdfDictionaryIndexEntry[]> m_flatIndex;
+    std::unique_ptr<PdfDictionaryTreeIndex> m_treeIndex;
+    // The last allocated block, linked to the previous ones
+    EntryStorage* m_lastBlock;
+    // Intrusive list of the released block slots
+    EntryStorage* m_freeEntries;
+};
 
 /**
  * Helper class to iterate through indirect objects
@@ -2383,6 +2383,24 @@ static struct {
     {0xFFFF, nullptr}
 };
 
+namespace
+{
+    // Indices in the glyph list tables sorted for binary search. The
+    // sort is stable, so lookups find the same entry as a linear scan
+    // of the tables would, when a name or code point is duplicated
+    struct GlyphListIndex
+    {
+        GlyphListIndex();
+
+        vector<uint16_t> NameToUnicode;         // nameToUnicodeTab sorted by name
+        vector<uint16_t> NameToUnicodeByCode;   // nameToUnicodeTab sorted by code point
+        vector<uint16_t> UnicodeToName;         // UnicodeToNameTab sorted by code point
+    };
+}
+
+static const GlyphListIndex& getGlyphListIndex();
+static const char* findGlyphName(char32_t codePoint);
+
 PdfDifferenceList::PdfDifferenceList() { }
 
 void PdfDifferenceList::AddDifference(unsigned char code, char32_t codePoint)
@@ -2649,11 +2667,11 @@ char32_t PdfDifferenceEncoding::NameToCodePoint(const PdfName& name)
 
 char32_t PdfDifferenceEncoding::NameToCodePoint(const string_view& name)
 {
-    for (unsigned i = 0; nameToUnicodeTab[i].name != nullptr; i++)
-    {
-        if (nameToUnicodeTab[i].name == name)
-            return nameToUnicodeTab[i].u;
-    }
+    auto& index = getGlyphListIndex().NameToUnicode;
+    auto found = std::lower_bound(index.begin(), index.end(), name,
+        [](uint16_t i, const string_view& name) { return nameToUnicodeTab[i].name < name; });
+    if (found != index.end() && nameToUnicodeTab[*found].name == name)
+        return nameToUnicodeTab[*found].u;
 
     // if we get here, then we might be looking up an undefined codepoint
     // so try looking for our special format..
@@ -2673,18 +2691,9 @@ char32_t PdfDifferenceEncoding::NameToCodePoint(const string_view& name)
 
 PdfName PdfDifferenceEncoding::CodePointToName(char32_t inCodePoint)
 {
-    for (unsigned i = 0; UnicodeToNameTab[i].name; i++)
-    {
-        if (UnicodeToNameTab[i].u == inCodePoint)
-            return PdfName(UnicodeToNameTab[i].name);
-    }
-
-    // if we can't find in the canonical list, look in the complete list
-    for (unsigned i = 0; nameToUnicodeTab[i].name; i++)
-    {
-        if (nameToUnicodeTab[i].u == inCodePoint)
-            return PdfName(nameToUnicodeTab[i].name);
-    }
+    auto name = findGlyphName(inCodePoint);
+    if (name != nullptr)
+        return PdfName(name);
 
     // if we get here, then we are looking up an undefined codepoint
     // so we'll just give it an arbitrary name..
@@ -2692,3 +2701,47 @@ PdfName PdfDifferenceEncoding::CodePointToName(char32_t inCodePoint)
     utls::FormatTo(buffer, "uni{:04x}", (unsigned)inCodePoint);
     return PdfName(buffer);
 }
+
+// Find the name in the canonical list or, if not found, in the complete list
+const char* findGlyphName(char32_t codePoint)
+{
+    auto& index = getGlyphListIndex();
+    auto found = std::lower_bound(index.UnicodeToName.begin(), index.UnicodeToName.end(), codePoint,
+        [](uint16_t i, char32_t codePoint) { return UnicodeToNameTab[i].u < codePoint; });
+    if (found != index.UnicodeToName.end() && UnicodeToNameTab[*found].u == codePoint)
+        return UnicodeToNameTab[*found].name;
+
+    found = std::lower_bound(index.NameToUnicodeByCode.begin(), index.NameToUnicodeByCode.end(), codePoint,
+        [](uint16_t i, char32_t codePoint) { return nameToUnicodeTab[i].u < codePoint; });
+    if (found != index.NameToUnicodeByCode.end() && nameToUnicodeTab[*found].u == codePoint)
+        return nameToUnicodeTab[*found].name;
+
+    return nullptr;
+}
+
+const GlyphListIndex& getGlyphListIndex()
+{
+    static GlyphListIndex s_index;
+    return s_index;
+}
+
+GlyphListIndex::GlyphListIndex()
+{
+    for (unsigned i = 0; nameToUnicodeTab[i].name != nullptr; i++)
+        NameToUnicode.push_back((uint16_t)i);
+
+    NameToUnicodeByCode = NameToUnicode;
+    std::stable_sort(NameToUnicode.begin(), NameToUnicode.end(), [](uint16_t lhs, uint16_t rhs) {
+        return string_view(nameToUnicodeTab[lhs].name) < string_view(nameToUnicodeTab[rhs].name);
+    });
+    std::stable_sort(NameToUnicodeByCode.begin(), NameToUnicodeByCode.end(), [](uint16_t lhs, uint16_t rhs) {
+        return nameToUnicodeTab[lhs].u < nameToUnicodeTab[rhs].u;
+    });
+
+    for (unsigned i = 0; UnicodeToNameTab[i].name != nullptr; i++)
+        UnicodeToName.push_back((uint16_t)i);
+
+    std::stable_sort(UnicodeToName.begin(), UnicodeToName.end(), [](uint16_t lhs, uint16_t rhs) {
+        return UnicodeToNameTab[lhs].u < UnicodeToNameTab[rhs].u;
+    });
+}
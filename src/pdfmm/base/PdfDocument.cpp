@@ -6,9 +6,11 @@
 
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include <pdfmm/private/XMPUtils.h>
+#include <pdfmm/private/ParallelUtils.h>
 #include "PdfDocument.h"
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
 
 #include "PdfArray.h"
@@ -34,7 +36,9 @@ using namespace mm;
 PdfDocument::PdfDocument(bool empty) :
     m_Objects(*this),
     m_Metadata(*this),
-    m_FontManager(*this)
+    m_FontManager(*this),
+    m_LoadWaiterCount(0),
+    m_ConcurrentReadMode(false)
 {
     if (!empty)
     {
@@ -58,7 +62,9 @@ PdfDocument::PdfDocument(bool empty) :
 PdfDocument::PdfDocument(const PdfDocument& doc) :
     m_Objects(*this, doc.m_Objects),
     m_Metadata(*this),
-    m_FontManager(*this)
+    m_FontManager(*this),
+    m_LoadWaiterCount(0),
+    m_ConcurrentReadMode(false)
 {
     SetTrailer(std::make_unique<PdfObject>(doc.GetTrailer().GetObject()));
     Init();
@@ -72,6 +78,7 @@ PdfDocument::~PdfDocument()
 void PdfDocument::Clear() 
 {
     m_FontManager.Clear();
+    m_DecodedStreamCache.Clear();
     m_Catalog = nullptr;
     m_Info = nullptr;
     m_Pages = nullptr;
@@ -486,6 +493,33 @@ void PdfDocument::CollectGarbage()
     m_Objects.CollectGarbage();
 }
 
+void PdfDocument::SetConcurrentReadMode(bool enabled)
+{
+    m_ConcurrentReadMode = enabled;
+}
+
+vector<vector<PdfTextEntry>> PdfDocument::ExtractText(unsigned pageIndex, unsigned pageCount,
+    const string_view& pattern, const PdfTextExtractParams& params, unsigned threadCount) const
+{
+    auto& pages = GetPages();
+    if (pageIndex > pages.GetCount() || pageCount > pages.GetCount() - pageIndex)
+        PDFMM_RAISE_ERROR(PdfErrorCode::PageNotFound);
+
+    vector<vector<PdfTextEntry>> ret(pageCount);
+
+    // Pages may have very different extraction costs, so instead
+    // of using the chunk ranges workers pick the next page to
+    // process from a shared counter
+    atomic<unsigned> nextPage(0);
+    utls::ParallelFor(pageCount, threadCount, [&](size_t, size_t, unsigned) {
+        unsigned i;
+        while ((i = nextPage.fetch_add(1, std::memory_order_relaxed)) < pageCount)
+            pages.GetPageAt(pageIndex + i).ExtractTextTo(ret[i], pattern, params);
+    });
+
+    return ret;
+}
+
 PdfOutlines& PdfDocument::GetOrCreateOutlines()
 {
     if (m_Outlines != nullptr)
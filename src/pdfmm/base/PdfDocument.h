@@ -7,11 +7,15 @@
 #ifndef PDF_DOCUMENT_H
 #define PDF_DOCUMENT_H
 
+#include <condition_variable>
+#include <mutex>
+
 #include "PdfTrailer.h"
 #include "PdfCatalog.h"
 #include "PdfIndirectObjectList.h"
 #include "PdfAcroForm.h"
 #include "PdfFontManager.h"
+#include "PdfDecodedStreamCache.h"
 #include "PdfMetadata.h"
 #include "PdfPageCollection.h"
 #include "PdfNameTree.h"
@@ -38,6 +42,16 @@ class PdfEncrypt;
  *  When you are only creating PDF files, please use PdfStreamedDocument
  *  which is usually faster for creating PDFs.
  *
+ *  Read-only concurrency contract: once a document has been loaded,
+ *  multiple threads may concurrently perform read-only operations on
+ *  it, such as accessing pages with GetPages().GetPageAt(), reading
+ *  objects, streams and loaded fonts and extracting text. Lazy loading
+ *  of objects, the page cache and the loaded font cache are internally
+ *  synchronized. Any modification of the document, including creating
+ *  new objects, fonts or pages, requires exclusive access.
+ *  By default lazy loads are serialized on the document: enable the
+ *  concurrent read mode to let them proceed in parallel.
+ *
  *  \see PdfStreamedDocument
  *  \see PdfMemDocument
  */
@@ -46,6 +60,8 @@ class PDFMM_API PdfDocument
     friend class PdfMetadata;
     friend class PdfXObjectForm;
     friend class PdfPageCollection;
+    friend class PdfObject;
+    friend class PdfParserObject;
 
 public:
     /** Close down/destruct the PdfDocument
@@ -101,6 +117,40 @@ public:
 
     void CollectGarbage();
 
+    /** Enable or disable the concurrent read mode
+     *
+     *  In concurrent read mode lazily loaded objects are synchronized
+     *  individually, instead of serializing all the loads on the
+     *  document, and they are read with a private cursor on the
+     *  source memory when the input device exposes it, instead of
+     *  seeking the shared device. Many readers can then load distinct
+     *  objects of the same document in parallel
+     *  \remarks The mode must not be changed while other
+     *      threads are accessing the document
+     */
+    void SetConcurrentReadMode(bool enabled);
+
+    /** \returns true if the concurrent read mode is enabled
+     *  \see SetConcurrentReadMode
+     */
+    bool IsConcurrentReadMode() const { return m_ConcurrentReadMode; }
+
+    /** Extract the text of a range of pages, processing the pages
+     *  concurrently on multiple threads
+     *  \param pageIndex index of the first page, 0-based
+     *  \param pageCount number of pages to process
+     *  \param pattern optional pattern the text entries must match
+     *  \param params extraction parameters, see PdfPage::ExtractTextTo()
+     *  \param threadCount the number of worker threads. 0 means the
+     *      hardware concurrency
+     *  \returns the text entries for each page, in page order
+     *  \remarks The document must not be modified while extracting.
+     *      See the read-only concurrency contract
+     */
+    std::vector<std::vector<PdfTextEntry>> ExtractText(unsigned pageIndex, unsigned pageCount,
+        const std::string_view& pattern = { }, const PdfTextExtractParams& params = { },
+        unsigned threadCount = 0) const;
+
     /** Constuct a new PdfImage object
      *  \param prefix optional prefix for XObject-name
      */
@@ -261,6 +311,13 @@ public:
 
     PdfFontManager& GetFonts() { return m_FontManager; }
 
+    /** Get the cache of decoded stream data, disabled by default
+     *  \see PdfDecodedStreamCache::SetBudget()
+     */
+    PdfDecodedStreamCache& GetDecodedStreamCache() { return m_DecodedStreamCache; }
+
+    const PdfDecodedStreamCache& GetDecodedStreamCache() const { return m_DecodedStreamCache; }
+
 protected:
     /** Construct a new (empty) PdfDocument
      *  \param empty if true NO default objects (such as catalog) are created.
@@ -327,6 +384,7 @@ private:
     PdfIndirectObjectList m_Objects;
     PdfMetadata m_Metadata;
     PdfFontManager m_FontManager;
+    PdfDecodedStreamCache m_DecodedStreamCache;
     std::unique_ptr<PdfObject> m_TrailerObj;
     std::unique_ptr<PdfTrailer> m_Trailer;
     std::unique_ptr<PdfCatalog> m_Catalog;
@@ -335,6 +393,14 @@ private:
     std::unique_ptr<PdfAcroForm> m_AcroForm;
     std::unique_ptr<PdfOutlines> m_Outlines;
     std::unique_ptr<PdfNameTree> m_NameTree;
+    // Serializes delayed loading of objects, see PdfObject::DelayedLoad()
+    std::recursive_mutex m_LoadMutex;
+    // Wake the threads waiting for objects loaded by other
+    // threads in concurrent read mode
+    std::mutex m_LoadWaitMutex;
+    std::condition_variable m_LoadWaitCond;
+    std::atomic<unsigned> m_LoadWaiterCount;
+    bool m_ConcurrentReadMode;
 };
 
 };
@@ -15,6 +15,7 @@
 #include "PdfIdentityEncoding.h"
 #include "PdfDifferenceEncoding.h"
 #include "PdfCMapEncoding.h"
+#include "PdfCMapCache.h"
 #include "PdfEncodingShim.h"
 #include "PdfFontMetrics.h"
 #include "PdfEncodingMapFactory.h"
@@ -99,7 +100,7 @@ PdfEncodingMapConstPtr PdfEncodingFactory::createEncodingMap(
         }
 
         if (obj.HasStream())
-            return PdfCMapEncoding::CreateFromObject(obj);
+            return PdfCMapCache::GetOrCreate(obj);
 
         // CHECK-ME: should we verify if it's a reference by searching /Differences?
         return PdfDifferenceEncoding::Create(obj, metrics);
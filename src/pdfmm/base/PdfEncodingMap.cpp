@@ -290,7 +290,7 @@ void PdfEncodingMapBase::AppendCIDMappingEntries(OutputStream& stream, const Pdf
     utls::FormatTo(temp, m_charMap->GetSize());
     stream.Write(temp);
     stream.Write(" begincidchar\n");
-    for (auto& pair : *m_charMap)
+    for (auto& pair : m_charMap->GetMappings())
     {
         auto& unit = pair.first;
         unsigned cid = pair.second[0]; // We assume the cid to be in the single element
@@ -314,7 +314,7 @@ void PdfEncodingMapBase::AppendCodeSpaceRange(OutputStream& stream, charbuff& te
     };
 
     unordered_map<unsigned char, Limit> ranges;
-    for (auto& pair : *m_charMap)
+    for (auto& pair : m_charMap->GetMappings())
     {
         auto& codeUnit = pair.first;
         auto found = ranges.find(codeUnit.CodeSpaceSize);
@@ -357,7 +357,7 @@ void PdfEncodingMapBase::AppendToUnicodeEntries(OutputStream& stream, charbuff&
     utls::FormatTo(temp, m_charMap->GetSize());
     stream.Write(temp);
     stream.Write(" beginbfchar\n");
-    for (auto& pair : *m_charMap)
+    for (auto& pair : m_charMap->GetMappings())
     {
         pair.first.WriteHexTo(temp);
         stream.Write(temp);
@@ -530,16 +530,15 @@ PdfBuiltInEncoding::PdfBuiltInEncoding(const PdfName& name)
 
 void PdfBuiltInEncoding::InitEncodingTable()
 {
-    if (!m_EncodingTable.empty())
-        return;
-
-    const char32_t* cpUnicodeTable = this->GetToUnicodeTable();
-    for (size_t i = 0; i < 256; i++)
-    {
-        // fill the table with data
-        m_EncodingTable[cpUnicodeTable[i]] =
-            static_cast<unsigned char>(i);
-    }
+    std::call_once(m_EncodingTableInit, [this]() {
+        const char32_t* cpUnicodeTable = this->GetToUnicodeTable();
+        for (size_t i = 0; i < 256; i++)
+        {
+            // fill the table with data
+            m_EncodingTable[cpUnicodeTable[i]] =
+                static_cast<unsigned char>(i);
+        }
+    });
 }
 
 bool PdfBuiltInEncoding::tryGetCharCode(char32_t codePoint, PdfCharCode& codeUnit) const
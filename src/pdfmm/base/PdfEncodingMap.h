@@ -8,6 +8,8 @@
 #define PDF_ENCODING_MAP_H
 
 #include "PdfDeclarations.h"
+
+#include <mutex>
 #include "PdfObject.h"
 #include "PdfName.h"
 #include "PdfCharCodeMap.h"
@@ -275,6 +277,8 @@ private:
 
 private:
     PdfName m_Name;         // The name of the encoding
+    // Built-in encodings are shared, hence the table is initialized once
+    std::once_flag m_EncodingTableInit;
     std::unordered_map<char32_t, char> m_EncodingTable; // The helper table for conversions into this encoding
 };
 
@@ -20,9 +20,9 @@ using namespace mm;
 class PdfFilteredEncodeStream : public OutputStream
 {
 private:
-    void init(OutputStream& outputStream, PdfFilterType filterType)
+    void init(OutputStream& outputStream, PdfFilterType filterType, PdfCompressionLevel level)
     {
-        m_filter = PdfFilterFactory::Create(filterType);
+        m_filter = PdfFilterFactory::Create(filterType, level);
         if (m_filter == nullptr)
             PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
 
@@ -33,10 +33,11 @@ private:
         m_filter->EndEncode();
     }
 public:
-    PdfFilteredEncodeStream(const shared_ptr<OutputStream>& outputStream, PdfFilterType filterType)
+    PdfFilteredEncodeStream(const shared_ptr<OutputStream>& outputStream, PdfFilterType filterType,
+            PdfCompressionLevel level)
         : m_OutputStream(outputStream)
     {
-        init(*outputStream, filterType);
+        init(*outputStream, filterType, level);
     }
 protected:
     void writeBuffer(const char* buffer, size_t len) override
@@ -249,7 +250,7 @@ void PdfFilter::decodeTo(OutputStream& stream, const bufferview& inBuffer, const
 // PdfFilterFactory code
 //
 
-unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType)
+unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType, PdfCompressionLevel level)
 {
     PdfFilter* filter = nullptr;
     switch (filterType)
@@ -264,7 +265,7 @@ unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType)
             filter = new PdfLZWFilter();
             break;
         case PdfFilterType::FlateDecode:
-            filter = new PdfFlateFilter();
+            filter = new PdfFlateFilter(level);
             break;
         case PdfFilterType::RunLengthDecode:
             filter = new PdfRLEFilter();
@@ -283,17 +284,17 @@ unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType)
 }
 
 unique_ptr<OutputStream> PdfFilterFactory::CreateEncodeStream(const shared_ptr<OutputStream>& stream,
-    const PdfFilterList& filters)
+    const PdfFilterList& filters, PdfCompressionLevel level)
 {
     PDFMM_RAISE_LOGIC_IF(!filters.size(), "Cannot create an EncodeStream from an empty list of filters");
 
     PdfFilterList::const_iterator it = filters.begin();
-    unique_ptr<OutputStream> filter(new PdfFilteredEncodeStream(stream, *it));
+    unique_ptr<OutputStream> filter(new PdfFilteredEncodeStream(stream, *it, level));
     it++;
 
     while (it != filters.end())
     {
-        filter.reset(new PdfFilteredEncodeStream(std::move(filter), *it));
+        filter.reset(new PdfFilteredEncodeStream(std::move(filter), *it, level));
         it++;
     }
 
@@ -290,11 +290,165 @@ double PdfFont::GetStringLength(const string_view& str, const PdfTextState& stat
 
 bool PdfFont::TryGetStringLength(const string_view& str, const PdfTextState& state, double& length) const
 {
-    vector<unsigned> gids;
-    bool success = tryConvertToGIDs(str, PdfGlyphAccess::Width, gids);
+    bool success = true;
     length = 0;
-    for (unsigned i = 0; i < gids.size(); i++)
-        length += getGlyphLength(m_Metrics->GetGlyphWidth(gids[i]), state, false);
+    auto it = str.begin();
+    auto end = str.end();
+    while (it != end)
+    {
+        unsigned gid;
+        if (!tryConvertToGID(utf8::next(it, end), PdfGlyphAccess::Width, gid))
+            success = false;
+
+        length += getGlyphLength(m_Metrics->GetGlyphWidth(gid), state, false);
+    }
+
+    return success;
+}
+
+bool PdfFont::TryGetStringLengths(const cspan<string_view>& strs, const PdfTextState& state,
+    const mspan<double>& lengths) const
+{
+    if (lengths.size() != strs.size())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The lengths must be as many as the strings");
+
+    bool success = true;
+    for (size_t i = 0; i < strs.size(); i++)
+    {
+        if (!TryGetStringLength(strs[i], state, lengths[i]))
+            success = false;
+    }
+
+    return success;
+}
+
+bool PdfFont::TryLayoutText(const string_view& str, const PdfTextState& state, double width,
+    PdfTextLayout& layout, bool skipSpaces) const
+{
+    layout.Advances.clear();
+    layout.Positions.clear();
+    layout.Offsets.clear();
+    layout.Lines.clear();
+
+    bool success = true;
+    unsigned lineStart = 0;             // First glyph of the current line
+    unsigned lineOffset = 0;            // Offset of the current line in the string
+    double lineWidth = 0;
+    unsigned spacesStart = 0;           // First glyph of the last spaces in the line
+    double spacesLineWidth = 0;         // Width of the line before the last spaces
+    bool hasBreak = false;              // True if the line can be broken at the last spaces
+    unsigned breakEnd = 0;              // End glyph of the line when broken at the last spaces
+    double breakWidth = 0;
+    unsigned breakNext = 0;             // First glyph of the next line when broken at the last spaces
+    bool prevSpace = false;
+
+    auto pushLine = [&](unsigned end, unsigned endOffset, double endWidth) {
+        layout.Lines.push_back({ lineOffset, endOffset - lineOffset, lineStart, end - lineStart, endWidth });
+    };
+
+    auto it = str.begin();
+    auto end = str.end();
+    while (it != end)
+    {
+        unsigned offset = (unsigned)(it - str.begin());
+        char32_t codePoint = utf8::next(it, end);
+        if (codePoint == U'\n' || codePoint == U'\r')
+        {
+            // Hard break, with \r\n handled as a single break
+            pushLine((unsigned)layout.Advances.size(), offset, lineWidth);
+            if (codePoint == U'\r' && it != end && *it == '\n')
+                it++;
+
+            lineStart = (unsigned)layout.Advances.size();
+            lineOffset = (unsigned)(it - str.begin());
+            lineWidth = 0;
+            hasBreak = false;
+            prevSpace = false;
+            continue;
+        }
+
+        unsigned gid;
+        if (!tryConvertToGID(codePoint, PdfGlyphAccess::Width, gid))
+            success = false;
+
+        double advance = getGlyphLength(m_Metrics->GetGlyphWidth(gid), state, false);
+        unsigned glyph = (unsigned)layout.Advances.size();
+        layout.Advances.push_back(advance);
+        layout.Offsets.push_back(offset);
+
+        bool space = codePoint < 256 && std::isspace((int)codePoint) != 0;
+        if (space)
+        {
+            // Spaces never break the line by themselves
+            if (!prevSpace)
+            {
+                spacesStart = glyph;
+                spacesLineWidth = lineWidth;
+            }
+
+            lineWidth += advance;
+            prevSpace = true;
+            continue;
+        }
+
+        if (prevSpace && spacesStart > lineStart)
+        {
+            hasBreak = true;
+            breakEnd = spacesStart;
+            breakWidth = spacesLineWidth;
+            breakNext = skipSpaces ? glyph : spacesStart;
+        }
+
+        prevSpace = false;
+        while (width > 0 && glyph > lineStart && lineWidth + advance > width)
+        {
+            if (hasBreak)
+            {
+                // Move the current word to the next line
+                pushLine(breakEnd, layout.Offsets[breakEnd], breakWidth);
+                lineStart = breakNext;
+                lineWidth = 0;
+                for (unsigned i = breakNext; i < glyph; i++)
+                    lineWidth += layout.Advances[i];
+
+                hasBreak = false;
+            }
+            else
+            {
+                // The word is longer than the line, break it
+                pushLine(glyph, offset, lineWidth);
+                lineStart = glyph;
+                lineWidth = 0;
+            }
+
+            lineOffset = layout.Offsets[lineStart];
+        }
+
+        lineWidth += advance;
+    }
+
+    if (lineStart < layout.Advances.size())
+        pushLine((unsigned)layout.Advances.size(), (unsigned)str.size(), lineWidth);
+
+    // Compute the glyph positions from the start of their lines.
+    // Spaces skipped at line breaks are positioned after the line end
+    layout.Positions.resize(layout.Advances.size());
+    double position = 0;
+    unsigned lineIndex = 0;
+    for (unsigned i = 0; i < layout.Advances.size(); i++)
+    {
+        while (lineIndex < layout.Lines.size()
+            && i >= layout.Lines[lineIndex].GlyphIndex + layout.Lines[lineIndex].GlyphCount)
+        {
+            lineIndex++;
+        }
+
+        if (lineIndex < layout.Lines.size() && i == layout.Lines[lineIndex].GlyphIndex)
+            position = 0;
+
+        layout.Positions[i] = position;
+        position += layout.Advances[i];
+    }
 
     return success;
 }
@@ -690,77 +844,50 @@ PdfCharCode PdfFont::AddCharCodeSafe(unsigned gid, const unicodeview& codePoints
     return code;
 }
 
-bool PdfFont::tryConvertToGIDs(const std::string_view& utf8Str, PdfGlyphAccess access, std::vector<unsigned>& gids) const
+bool PdfFont::tryConvertToGID(char32_t codePoint, PdfGlyphAccess access, unsigned& gid) const
 {
-    bool success = true;
     if (IsObjectLoaded() || !m_Metrics->HasUnicodeMapping())
     {
         // NOTE: This is a best effort strategy. It's not intended to
         // be accurate in loaded fonts
-        auto it = utf8Str.begin();
-        auto end = utf8Str.end();
+        PdfCharCode codeUnit;
+        unsigned cid;
+        if (!m_Encoding->GetToUnicodeMapSafe().TryGetCharCode(codePoint, codeUnit))
+        {
+            // Fallback
+            gid = codePoint;
+            return false;
+        }
 
-        auto& toUnicode = m_Encoding->GetToUnicodeMapSafe();
-        while (it != end)
+        if (!m_Encoding->TryGetCIDId(codeUnit, cid))
         {
-            char32_t cp = utf8::next(it, end);
-            PdfCharCode codeUnit;
-            unsigned cid;
-            unsigned gid;
-            if (toUnicode.TryGetCharCode(cp, codeUnit))
-            {
-                if (m_Encoding->TryGetCIDId(codeUnit, cid))
-                {
-                    if (!TryMapCIDToGID(cid, access, gid))
-                    {
-                        // Fallback
-                        gid = cid;
-                        success = false;
-                    }
-                }
-                else
-                {
-                    // Fallback
-                    gid = codeUnit.Code;
-                    success = false;
-                }
-            }
-            else
-            {
-                // Fallback
-                gid = cp;
-                success = false;
-            }
+            // Fallback
+            gid = codeUnit.Code;
+            return false;
+        }
 
-            gids.push_back(gid);
+        if (!TryMapCIDToGID(cid, access, gid))
+        {
+            // Fallback
+            gid = cid;
+            return false;
         }
+
+        return true;
     }
     else
     {
-        auto it = utf8Str.begin();
-        auto end = utf8Str.end();
-        vector<unsigned> gids;
-        while (it != end)
+        // NOTE: Glyph substitution is not supported by
+        // the metrics, so glyphs are mapped one at a time
+        if (!m_Metrics->TryGetGID(codePoint, gid))
         {
-            char32_t cp = utf8::next(it, end);
-            unsigned gid;
-            if (!m_Metrics->TryGetGID(cp, gid))
-            {
-                // Fallback
-                gid = cp;
-                success = false;
-            }
-
-            gids.push_back(gid);
+            // Fallback
+            gid = codePoint;
+            return false;
         }
 
-        // Try to subsistute GIDs for fonts that support
-        // a glyph substitution mechanism
-        vector<unsigned char> backwardMap;
-        m_Metrics->SubstituteGIDs(gids, backwardMap);
+        return true;
     }
-
-    return success;
 }
 
 bool PdfFont::tryAddSubsetGID(unsigned gid, const unicodeview& codePoints, PdfCID& cid)
@@ -38,6 +38,32 @@ struct PdfSplittedString
     bool IsSeparator = false;
 };
 
+/** A line of a text laid out with PdfFont::TryLayoutText()
+ */
+struct PdfTextLine
+{
+    unsigned Offset = 0;        ///< Offset of the line in the utf8 string
+    unsigned Length = 0;        ///< Length of the line in the utf8 string
+    unsigned GlyphIndex = 0;    ///< Index of the first glyph of the line in the PdfTextLayout buffers
+    unsigned GlyphCount = 0;
+    double Width = 0;           ///< Width of the line in PDF units
+};
+
+/** Buffers filled by PdfFont::TryLayoutText()
+ *
+ *  There is a glyph for each code point of the text, excluding
+ *  new line characters. The buffers are cleared by each layout
+ *  but keep their capacity, so reusing the same instance to lay
+ *  out many texts doesn't allocate memory
+ */
+struct PdfTextLayout
+{
+    std::vector<double> Advances;   ///< Advance of each glyph in PDF units
+    std::vector<double> Positions;  ///< Position of each glyph from the start of its line
+    std::vector<unsigned> Offsets;  ///< Offset of each glyph in the utf8 string
+    std::vector<PdfTextLine> Lines;
+};
+
 /** Before you can draw text on a PDF document, you have to create
  *  a font object first. You can reuse this font object as often
  *  as you want.
@@ -160,6 +186,28 @@ public:
      */
     bool TryGetStringLength(const std::string_view& str, const PdfTextState& state, double& width) const;
 
+    /** Retrieve the widths of many utf8 strings in PDF units
+     *  \param lengths the widths of the strings, must have the same size of strs
+     *  \remarks Produces a partial result also in case of failures
+     */
+    bool TryGetStringLengths(const cspan<std::string_view>& strs, const PdfTextState& state,
+        const mspan<double>& lengths) const;
+
+    /** Lay out a utf8 text in lines not wider than the given width
+     *
+     *  Lines are broken at new line characters and, when too wide,
+     *  at the last spaces or inside words longer than the line. The
+     *  spaces at wrapping breaks are not part of the lines
+     *  \param width the maximum width of the lines, or 0 to break
+     *      lines only at new line characters
+     *  \param layout filled with the glyphs and the lines of the text
+     *  \param skipSpaces if false the spaces at wrapping breaks
+     *      begin the next line
+     *  \remarks Produces a partial result also in case of failures
+     */
+    bool TryLayoutText(const std::string_view& str, const PdfTextState& state, double width,
+        PdfTextLayout& layout, bool skipSpaces = true) const;
+
     /** Retrieve the width of a given encoded PdfString in PDF units when
      *  drawn with the current font
      *  \param view a text string of which the width should be calculated
@@ -406,7 +454,7 @@ private:
     bool TryMapCIDToGID(unsigned cid, PdfGlyphAccess access, unsigned& gid) const;
 
 private:
-    bool tryConvertToGIDs(const std::string_view& utf8Str, PdfGlyphAccess access, std::vector<unsigned>& gids) const;
+    bool tryConvertToGID(char32_t codePoint, PdfGlyphAccess access, unsigned& gid) const;
     bool tryAddSubsetGID(unsigned gid, const unicodeview& codePoints, PdfCID& cid);
 
     void initBase(const PdfEncoding& encoding);
@@ -101,6 +101,7 @@ PdfFont* PdfFontManager::GetLoadedFont(const PdfObject& obj)
     if (!obj.IsIndirect())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Object is not indirect");
 
+    lock_guard<mutex> lock(m_loadedFontsMutex);
     auto found = m_fonts.find(obj.GetIndirectReference());
     if (found != m_fonts.end())
     {
@@ -115,6 +116,10 @@ PdfFont* PdfFontManager::GetLoadedFont(const PdfObject& obj)
     if (!PdfFont::TryCreateFromObject(const_cast<PdfObject&>(obj), font))
         return nullptr;
 
+    // Perform lazy initializations now, so the
+    // font can be safely shared between readers
+    font->initWordSpacingLength();
+
     auto inserted = m_fonts.emplace(obj.GetIndirectReference(), Storage{ true, std::move(font) });
     return inserted.first->second.Font.get();
 }
@@ -9,6 +9,8 @@
 
 #include "PdfDeclarations.h"
 
+#include <mutex>
+
 #include "PdfFont.h"
 #include "PdfEncodingFactory.h"
 
@@ -67,6 +69,10 @@ public:
      *
      *  \returns a PdfFont object or nullptr if the font could
      *           not be created or found.
+     *  \remarks This method can be called concurrently by readers
+     *      of the document, and the returned font can then be used
+     *      concurrently for read-only operations such as text decoding
+     *      and measurement. See PdfDocument read-only concurrency contract
      */
     PdfFont* GetLoadedFont(const PdfObject& obj);
 
@@ -212,6 +218,8 @@ private:
     ImportedFontMap m_importedFonts;
     // Map of all fonts
     FontMap m_fonts;
+    // Guards concurrent access to loaded fonts
+    std::mutex m_loadedFontsMutex;
 
 #ifdef PDFMM_HAVE_FONTCONFIG
     static std::shared_ptr<PdfFontConfigWrapper> m_fontConfig;
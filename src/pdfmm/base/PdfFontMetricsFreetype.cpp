@@ -12,6 +12,7 @@
 #include FT_TRUETYPE_TABLES_H
 #include FT_TYPE1_TABLES_H
 #include FT_FONT_FORMATS_H
+#include FT_ADVANCES_H
 
 #include "PdfArray.h"
 #include "PdfDictionary.h"
@@ -22,6 +23,10 @@
 using namespace std;
 using namespace mm;
 
+// Sentinel values for the cached glyph advances
+constexpr int32_t AdvanceNotLoaded = numeric_limits<int32_t>::min();
+constexpr int32_t AdvanceInvalid = numeric_limits<int32_t>::min() + 1;
+
 static PdfFontFileType determineTrueTypeFormat(FT_Face face);
 static int determineType1FontWeight(const string_view& weight);
 
@@ -343,17 +348,60 @@ unsigned PdfFontMetricsFreetype::GetGlyphCount() const
 
 bool PdfFontMetricsFreetype::TryGetGlyphWidth(unsigned gid, double& width) const
 {
-    if (FT_Load_Glyph(m_Face.get(), gid, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP) != 0)
+    std::call_once(m_AdvancesInit, [this]() { initAdvances(); });
+    int32_t advance = AdvanceInvalid;
+    if (gid < (unsigned)m_Face.get()->num_glyphs)
+    {
+        advance = m_Advances[gid].load(memory_order_relaxed);
+        if (advance == AdvanceNotLoaded)
+            advance = loadAdvance(gid);
+    }
+
+    if (advance == AdvanceInvalid)
     {
         width = -1;
         return false;
     }
 
-    // zero return code is success!
-    width = m_Face.get()->glyph->metrics.horiAdvance / (double)m_Face.get()->units_per_EM;
+    width = advance / (double)m_Face.get()->units_per_EM;
     return true;
 }
 
+void PdfFontMetricsFreetype::initAdvances() const
+{
+    unsigned glyphCount = (unsigned)m_Face.get()->num_glyphs;
+    m_Advances.reset(new atomic<int32_t>[glyphCount]);
+
+    // Only fonts with a hmtx table support fast advances retrieval,
+    // for the others loading all the glyphs may be too expensive
+    vector<FT_Fixed> advances(glyphCount);
+    if (glyphCount != 0 && FT_Get_Advances(m_Face.get(), 0, glyphCount,
+        FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP | FT_ADVANCE_FLAG_FAST_ONLY, advances.data()) == 0)
+    {
+        for (unsigned i = 0; i < glyphCount; i++)
+            m_Advances[i].store((int32_t)advances[i], memory_order_relaxed);
+    }
+    else
+    {
+        for (unsigned i = 0; i < glyphCount; i++)
+            m_Advances[i].store(AdvanceNotLoaded, memory_order_relaxed);
+    }
+}
+
+int32_t PdfFontMetricsFreetype::loadAdvance(unsigned gid) const
+{
+    // The glyph slot of the face is shared, so glyph loading is serialized
+    unique_lock<mutex> lock(m_AdvancesMutex);
+    int32_t advance;
+    if (FT_Load_Glyph(m_Face.get(), gid, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP) == 0)
+        advance = (int32_t)m_Face.get()->glyph->metrics.horiAdvance;
+    else
+        advance = AdvanceInvalid;
+
+    m_Advances[gid].store(advance, memory_order_relaxed);
+    return advance;
+}
+
 bool PdfFontMetricsFreetype::HasUnicodeMapping() const
 {
     return m_HasUnicodeMapping;
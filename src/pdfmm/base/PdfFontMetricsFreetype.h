@@ -9,6 +9,9 @@
 
 #include "PdfDeclarations.h"
 
+#include <atomic>
+#include <mutex>
+
 #include "PdfFontMetrics.h"
 #include "PdfString.h"
 
@@ -122,6 +125,10 @@ private:
 
     void initType1Lengths(const bufferview& view);
 
+    void initAdvances() const;
+
+    int32_t loadAdvance(unsigned gid) const;
+
 private:
     datahandle m_Data;
     PdfCIDToGIDMapConstPtr m_CIDToGIDMap;
@@ -159,6 +166,13 @@ private:
     unsigned m_Length1;
     unsigned m_Length2;
     unsigned m_Length3;
+
+    // Unscaled glyph advances, indexed by GID. They are read in bulk
+    // from the hmtx table when the font has one, otherwise they are
+    // loaded lazily from the glyphs
+    mutable std::once_flag m_AdvancesInit;
+    mutable std::unique_ptr<std::atomic<int32_t>[]> m_Advances;
+    mutable std::mutex m_AdvancesMutex;
 };
 
 };
@@ -15,6 +15,7 @@
 #include "PdfObject.h"
 #include "PdfReference.h"
 #include "PdfObjectStream.h"
+#include "PdfParserObject.h"
 #include "PdfDocument.h"
 
 using namespace std;
@@ -65,37 +66,51 @@ private:
 PdfIndirectObjectList::PdfIndirectObjectList() :
     m_Document(nullptr),
     m_CanReuseObjectNumbers(true),
-    m_Objects(CompareObject),
+    m_ObjectsSize(0),
     m_ObjectCount(0),
-    m_StreamFactory(nullptr)
+    m_StreamFactory(nullptr),
+    m_ObjectMemoryBudget(0),
+    m_LoadedObjectMemory(0),
+    m_loadDepth(0)
 {
 }
 
 PdfIndirectObjectList::PdfIndirectObjectList(PdfDocument& document) :
     m_Document(&document),
     m_CanReuseObjectNumbers(true),
-    m_Objects(CompareObject),
+    m_ObjectsSize(0),
     m_ObjectCount(1),
-    m_StreamFactory(nullptr)
+    m_StreamFactory(nullptr),
+    m_ObjectMemoryBudget(0),
+    m_LoadedObjectMemory(0),
+    m_loadDepth(0)
 {
 }
 
 PdfIndirectObjectList::PdfIndirectObjectList(PdfDocument& document, const PdfIndirectObjectList& rhs)  :
     m_Document(&document),
     m_CanReuseObjectNumbers(rhs.m_CanReuseObjectNumbers),
-    m_Objects(CompareObject),
+    m_Objects(rhs.m_Objects.size()),
+    m_ObjectsSize(rhs.m_ObjectsSize),
     m_ObjectCount(rhs.m_ObjectCount),
     m_FreeObjects(rhs.m_FreeObjects),
     m_unavailableObjects(rhs.m_unavailableObjects),
-    m_StreamFactory(nullptr)
+    m_StreamFactory(nullptr),
+    m_ObjectMemoryBudget(0),
+    m_LoadedObjectMemory(0),
+    m_loadDepth(0)
 {
     // Copy all objects from source, resetting parent and indirect reference
-    for (auto obj : rhs.m_Objects)
+    for (size_t i = 0; i < rhs.m_Objects.size(); i++)
     {
+        auto obj = rhs.m_Objects[i];
+        if (obj == nullptr)
+            continue;
+
         auto newObj = new PdfObject(*obj);
         newObj->SetIndirectReference(obj->GetIndirectReference());
         newObj->SetDocument(&document);
-        m_Objects.insert(newObj);
+        m_Objects[i] = newObj;
     }
 }
 
@@ -106,12 +121,14 @@ PdfIndirectObjectList::~PdfIndirectObjectList()
 
 void PdfIndirectObjectList::Clear()
 {
-    for (auto obj : m_Objects)
-        delete obj;
+    for (uint32_t i = 0; i < m_Objects.size(); i++)
+        deleteObject(i);
 
     m_Objects.clear();
+    m_ObjectsSize = 0;
     m_ObjectCount = 1;
     m_StreamFactory = nullptr;
+    clearLoadedObjects();
 }
 
 PdfObject& PdfIndirectObjectList::MustGetObject(const PdfReference& ref) const
@@ -125,11 +142,15 @@ PdfObject& PdfIndirectObjectList::MustGetObject(const PdfReference& ref) const
 
 PdfObject* PdfIndirectObjectList::GetObject(const PdfReference& ref) const
 {
-    auto it = std::lower_bound(m_Objects.begin(), m_Objects.end(), ref, CompareReference);
-    if (it == m_Objects.end() || (*it)->GetIndirectReference() != ref)
+    uint32_t objectNum = ref.ObjectNumber();
+    if (objectNum >= m_Objects.size())
         return nullptr;
 
-    return *it;
+    auto obj = m_Objects[objectNum];
+    if (obj == nullptr || obj->GetIndirectReference().GenerationNumber() != ref.GenerationNumber())
+        return nullptr;
+
+    return obj;
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const PdfReference& ref)
@@ -139,16 +160,15 @@ unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const PdfReference& re
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const PdfReference& ref, bool markAsFree)
 {
-    auto it = std::lower_bound(m_Objects.begin(), m_Objects.end(), ref, CompareReference);
-    if (it == m_Objects.end() || (*it)->GetIndirectReference() != ref)
+    if (GetObject(ref) == nullptr)
         return nullptr;
 
-    return removeObject(it, markAsFree);
+    return removeObject(ref.ObjectNumber(), markAsFree);
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const iterator& it)
 {
-    return removeObject(it, true);
+    return removeObject((*it)->GetIndirectReference().ObjectNumber(), true);
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::ReplaceObject(const PdfReference& ref, PdfObject* obj)
@@ -156,35 +176,137 @@ unique_ptr<PdfObject> PdfIndirectObjectList::ReplaceObject(const PdfReference& r
     if (obj == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Object must be non null");
 
-    auto it = std::lower_bound(m_Objects.begin(), m_Objects.end(), ref, CompareReference);
-    if (it == m_Objects.end())
+    if (GetObject(ref) == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Unable to find object with reference {}", ref.ToString());
 
-    auto node = m_Objects.extract(it);
-    unique_ptr<PdfObject> ret(node.value());
-    node.value() = obj;
+    if (m_Document != nullptr)
+        m_Document->GetDecodedStreamCache().Invalidate(ref);
+
+    auto ret = takeObject(ref.ObjectNumber());
+    m_Objects[ref.ObjectNumber()] = obj;
     obj->SetIndirectReference(ref);
-    pushObject(node, obj);
     return ret;
 }
 
-unique_ptr<PdfObject> PdfIndirectObjectList::removeObject(const iterator& it, bool markAsFree)
+unique_ptr<PdfObject> PdfIndirectObjectList::removeObject(uint32_t objectNum, bool markAsFree)
 {
-    auto obj = *it;
-    if (m_objectStreams.find(obj->GetIndirectReference().ObjectNumber()) != m_objectStreams.end())
+    if (m_objectStreams.find(objectNum) != m_objectStreams.end())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Can't remove a compressed object stream");
 
+    auto ret = takeObject(objectNum);
+    if (m_Document != nullptr)
+        m_Document->GetDecodedStreamCache().Invalidate(ret->GetIndirectReference());
+
     if (markAsFree)
-        SafeAddFreeObject(obj->GetIndirectReference());
+        SafeAddFreeObject(ret->GetIndirectReference());
+
+    m_ObjectsSize--;
+    return ret;
+}
+
+void PdfIndirectObjectList::setObjectMemoryBudget(size_t budget)
+{
+    m_ObjectMemoryBudget = budget;
+    if (budget == 0)
+        clearLoadedObjects();
+    else if (m_loadDepth == 0)
+        releaseObjectMemory(budget);
+}
+
+bool PdfIndirectObjectList::isObjectMemoryTracked() const
+{
+    // Objects of a document read concurrently can't be released
+    // while other threads may access them
+    return m_ObjectMemoryBudget != 0 && m_Document != nullptr
+        && !m_Document->IsConcurrentReadMode();
+}
 
-    m_Objects.erase(it);
-    return unique_ptr<PdfObject>(obj);
+void PdfIndirectObjectList::beginObjectLoad()
+{
+    m_loadDepth++;
 }
 
-PdfReference PdfIndirectObjectList::getNextFreeObject()
+void PdfIndirectObjectList::endObjectLoad(const PdfReference& ref, size_t size)
+{
+    auto found = m_loadedObjectMap.find(ref);
+    if (found == m_loadedObjectMap.end())
+    {
+        m_loadedObjects.push_back({ ref, size });
+        m_loadedObjectMap[ref] = std::prev(m_loadedObjects.end());
+    }
+    else
+    {
+        // The stream of an object with the data already
+        // loaded, or the other way around
+        found->second->Size += size;
+        m_loadedObjects.splice(m_loadedObjects.end(), m_loadedObjects, found->second);
+    }
+
+    m_LoadedObjectMemory += size;
+    endObjectLoad();
+}
+
+void PdfIndirectObjectList::endObjectLoad()
+{
+    PDFMM_ASSERT(m_loadDepth != 0);
+    m_loadDepth--;
+
+    // Don't release objects that may be in use by loads
+    // in progress, eg. a stream waiting for its /Length
+    if (m_loadDepth == 0 && m_LoadedObjectMemory > m_ObjectMemoryBudget)
+        releaseObjectMemory(m_ObjectMemoryBudget);
+}
+
+void PdfIndirectObjectList::releaseObjectMemory(size_t budget)
+{
+    // Visit each object at most once, skipping the most recently
+    // loaded one, which is the one the caller is going to access
+    size_t count = m_loadedObjects.size();
+    while (count > 1 && m_LoadedObjectMemory > budget)
+    {
+        count--;
+        auto it = m_loadedObjects.begin();
+        auto parserObj = dynamic_cast<PdfParserObject*>(GetObject(it->Reference));
+        if (m_pinnedObjects.find(it->Reference) != m_pinnedObjects.end()
+            || (parserObj != nullptr && !parserObj->IsDirty() && !parserObj->tryFreeStreamData()))
+        {
+            // The object stream is pinned, or it's being
+            // read or written, try again later
+            m_loadedObjects.splice(m_loadedObjects.end(), m_loadedObjects, it);
+            continue;
+        }
+
+        // Dirty objects are no more tracked, since they can't be released
+        m_LoadedObjectMemory -= it->Size;
+        m_loadedObjectMap.erase(it->Reference);
+        m_loadedObjects.erase(it);
+    }
+}
+
+void PdfIndirectObjectList::pinObject(const PdfReference& ref)
+{
+    m_pinnedObjects[ref]++;
+}
+
+void PdfIndirectObjectList::unpinObject(const PdfReference& ref)
+{
+    auto found = m_pinnedObjects.find(ref);
+    PDFMM_ASSERT(found != m_pinnedObjects.end());
+    if (--found->second == 0)
+        m_pinnedObjects.erase(found);
+}
+
+void PdfIndirectObjectList::clearLoadedObjects()
+{
+    m_loadedObjects.clear();
+    m_loadedObjectMap.clear();
+    m_LoadedObjectMemory = 0;
+}
+
+PdfReference PdfIndirectObjectList::getNextFreeObject(bool reuseFreeObjects)
 {
     // Try to first use list of free objects
-    if (m_CanReuseObjectNumbers && !m_FreeObjects.empty())
+    if (reuseFreeObjects && m_CanReuseObjectNumbers && !m_FreeObjects.empty())
     {
         PdfReference freeObjectRef = m_FreeObjects.front();
         m_FreeObjects.pop_front();
@@ -192,7 +314,7 @@ PdfReference PdfIndirectObjectList::getNextFreeObject()
     }
 
     // If no free objects are available, create a new object with generation 0
-    uint16_t nextObjectNum = static_cast<uint16_t>(m_ObjectCount);
+    uint32_t nextObjectNum = m_ObjectCount;
     while (true)
     {
         if ((size_t)(nextObjectNum + 1) == MaxReserveSize)
@@ -200,7 +322,7 @@ PdfReference PdfIndirectObjectList::getNextFreeObject()
 
         // Check also if the object number it not available,
         // e.g. it reached maximum generation number (65535)
-        if (m_unavailableObjects.find(nextObjectNum) == m_unavailableObjects.end())
+        if (nextObjectNum >= m_unavailableObjects.size() || !m_unavailableObjects[nextObjectNum])
             break;
 
         nextObjectNum++;
@@ -274,7 +396,10 @@ int32_t PdfIndirectObjectList::tryAddFreeObject(uint32_t objnum, uint32_t gennum
     // NOTE: gennum is uint32 to accomodate overflows from callers
     if (gennum >= MaxXRefGenerationNum)
     {
-        m_unavailableObjects.insert(gennum);
+        if (objnum >= m_unavailableObjects.size())
+            m_unavailableObjects.resize((size_t)objnum + 1);
+
+        m_unavailableObjects[objnum] = true;
         return -1;
     }
 
@@ -284,6 +409,15 @@ int32_t PdfIndirectObjectList::tryAddFreeObject(uint32_t objnum, uint32_t gennum
 
 void PdfIndirectObjectList::AddFreeObject(const PdfReference& reference)
 {
+    if (m_FreeObjects.empty() || ReferenceComparatorPredicate()(m_FreeObjects.back(), reference))
+    {
+        // Free objects are usually added with increasing object
+        // numbers, eg. when reading the XRef table: just append them
+        m_FreeObjects.push_back(reference);
+        TryIncrementObjectCount(reference);
+        return;
+    }
+
     auto it = std::equal_range(m_FreeObjects.begin(), m_FreeObjects.end(), reference, ReferenceComparatorPredicate());
     if (it.first != it.second && !m_FreeObjects.empty())
     {
@@ -313,31 +447,128 @@ void PdfIndirectObjectList::addNewObject(PdfObject* obj)
     PushObject(obj);
 }
 
+PdfObject& PdfIndirectObjectList::createObjStmObject()
+{
+    auto ret = new PdfObject(PdfDictionary());
+    ret->GetDictionary().AddKey(PdfName::KeyType, PdfName("ObjStm"));
+    ret->setDirty();
+    ret->SetIndirectReference(getNextFreeObject(false));
+    PushObject(ret);
+    return *ret;
+}
+
+void PdfIndirectObjectList::removeObjStmObjects(const vector<PdfObject*>& objectStreams)
+{
+    if (objectStreams.size() == 0)
+        return;
+
+    uint32_t objectCount = objectStreams[0]->GetIndirectReference().ObjectNumber();
+    for (auto objStm : objectStreams)
+        (void)removeObject(objStm->GetIndirectReference().ObjectNumber(), false);
+
+    m_ObjectCount = objectCount;
+}
+
 void PdfIndirectObjectList::PushObject(PdfObject* obj)
 {
     obj->SetDocument(m_Document);
 
-    ObjectList::node_type node;
-    auto it = m_Objects.find(obj);
-    if (it != m_Objects.end())
+    auto& ref = obj->GetIndirectReference();
+    auto& slot = getSlot(ref.ObjectNumber());
+    if (slot == nullptr)
     {
-        // Delete existing object and replace
-        // the pointer on its node
-        node = m_Objects.extract(it);
-        delete node.value();
-        node.value() = obj;
+        m_ObjectsSize++;
     }
+    else if (slot->GetIndirectReference().GenerationNumber() > ref.GenerationNumber())
+    {
+        // The existing object is more recent: discard the pushed one
+        mm::LogMessage(PdfLogSeverity::Warning, "Discarding object {} {} R, a more recent generation is already present",
+            ref.ObjectNumber(), ref.GenerationNumber());
+        delete obj;
+        return;
+    }
+    else
+    {
+        // Delete existing object and replace it
+        deleteObject(ref.ObjectNumber());
+    }
+
+    slot = obj;
 
-    pushObject(node, obj);
+    TryIncrementObjectCount(obj->GetIndirectReference());
 }
 
-void PdfIndirectObjectList::pushObject(ObjectList::node_type& node, PdfObject* obj)
+PdfObject*& PdfIndirectObjectList::getSlot(uint32_t objectNum)
 {
-    if (node.empty())
-        m_Objects.insert(obj);
-    else
-        m_Objects.insert(std::move(node));
-    TryIncrementObjectCount(obj->GetIndirectReference());
+    if (objectNum >= m_Objects.size())
+    {
+        // Grow geometrically, objects are usually pushed
+        // with increasing object numbers
+        if (objectNum >= m_Objects.capacity())
+            m_Objects.reserve(std::max((size_t)objectNum + 1, m_Objects.capacity() * 2));
+
+        m_Objects.resize((size_t)objectNum + 1);
+    }
+
+    return m_Objects[objectNum];
+}
+
+void PdfIndirectObjectList::deleteObject(uint32_t objectNum)
+{
+    auto& slot = m_Objects[objectNum];
+    delete slot;
+    slot = nullptr;
+}
+
+unique_ptr<PdfObject> PdfIndirectObjectList::takeObject(uint32_t objectNum)
+{
+    auto& slot = m_Objects[objectNum];
+
+    // The object can outlive the document and its source device,
+    // copy the strings borrowed from the device
+    auto parserObj = dynamic_cast<PdfParserObject*>(slot);
+    if (parserObj != nullptr)
+    {
+        materializeStrings(*parserObj);
+        parserObj->SetBorrowSourceData(false);
+    }
+
+    unique_ptr<PdfObject> ret(slot);
+    slot = nullptr;
+    return ret;
+}
+
+void PdfIndirectObjectList::materializeStrings(const PdfObject& obj)
+{
+    switch (obj.GetDataType())
+    {
+        case PdfDataType::String:
+            obj.GetString().materialize();
+            break;
+        case PdfDataType::Array:
+            for (auto& child : obj.GetArray())
+                materializeStrings(child);
+            break;
+        case PdfDataType::Dictionary:
+            for (auto& pair : obj.GetDictionary())
+                materializeStrings(pair.second);
+            break;
+        default:
+            break;
+    }
+}
+
+void PdfIndirectObjectList::detachSourceDevice()
+{
+    for (auto obj : m_Objects)
+    {
+        auto parserObj = dynamic_cast<PdfParserObject*>(obj);
+        if (parserObj != nullptr)
+            parserObj->detachSourceDevice();
+    }
+
+    // The data of the objects can't be released anymore
+    clearLoadedObjects();
 }
 
 void PdfIndirectObjectList::CollectGarbage()
@@ -347,26 +578,24 @@ void PdfIndirectObjectList::CollectGarbage()
 
     unordered_set<PdfReference> referencedOjects;
     visitObject(m_Document->GetTrailer().GetObject(), referencedOjects);
-    vector<PdfObject*> objectsToDelete;
-    ObjectList newlist(CompareObject);
-    for (PdfObject* obj : m_Objects)
+    vector<uint32_t> objectsToDelete;
+    for (auto obj : m_Objects)
     {
+        if (obj == nullptr)
+            continue;
+
         auto& ref = obj->GetIndirectReference();
         if (referencedOjects.find(ref) == referencedOjects.end()
             && m_objectStreams.find(ref.ObjectNumber()) == m_objectStreams.end())
         {
             SafeAddFreeObject(ref);
-            objectsToDelete.push_back(obj);
-            continue;
+            objectsToDelete.push_back(ref.ObjectNumber());
+            m_ObjectsSize--;
         }
-
-        newlist.insert(obj);
     }
 
-    for (auto obj : objectsToDelete)
-        delete obj;
-
-    m_Objects.swap(newlist);
+    for (auto objectNum : objectsToDelete)
+        deleteObject(objectNum);
 }
 
 void PdfIndirectObjectList::visitObject(const PdfObject& obj, unordered_set<PdfReference>& referencedObjects)
@@ -484,7 +713,7 @@ void PdfIndirectObjectList::SetCanReuseObjectNumbers(bool canReuseObjectNumbers)
 
 unsigned PdfIndirectObjectList::GetSize() const
 {
-    return (unsigned)m_Objects.size();
+    return m_ObjectsSize;
 }
 
 void PdfIndirectObjectList::Attach(Observer& observer)
@@ -510,35 +739,68 @@ void PdfIndirectObjectList::TryIncrementObjectCount(const PdfReference& ref)
 
 PdfIndirectObjectList::iterator PdfIndirectObjectList::begin() const
 {
-    return m_Objects.begin();
+    return iterator(m_Objects.begin(), m_Objects.end());
 }
 
 PdfIndirectObjectList::iterator PdfIndirectObjectList::end() const
 {
-    return m_Objects.end();
+    return iterator(m_Objects.end(), m_Objects.end());
 }
 
 PdfIndirectObjectList::reverse_iterator PdfIndirectObjectList::rbegin() const
 {
-    return m_Objects.rbegin();
+    return reverse_iterator(end());
 }
 
 PdfIndirectObjectList::reverse_iterator PdfIndirectObjectList::rend() const
 {
-    return m_Objects.rend();
+    return reverse_iterator(begin());
 }
 
 size_t PdfIndirectObjectList::size() const
 {
-    return m_Objects.size();
+    return m_ObjectsSize;
+}
+
+PdfIndirectObjectList::MemoryPin::MemoryPin()
+    : m_objects(nullptr) { }
+
+PdfIndirectObjectList::MemoryPin::MemoryPin(const PdfObject& obj)
+    : m_objects(nullptr)
+{
+    auto document = obj.GetDocument();
+    if (document == nullptr || !obj.IsIndirect())
+        return;
+
+    m_objects = &document->GetObjects();
+    m_reference = obj.GetIndirectReference();
+    m_objects->pinObject(m_reference);
+}
+
+PdfIndirectObjectList::MemoryPin::MemoryPin(MemoryPin&& rhs) noexcept
+    : m_reference(rhs.m_reference)
+{
+    utls::move(rhs.m_objects, m_objects);
+}
+
+PdfIndirectObjectList::MemoryPin::~MemoryPin()
+{
+    reset();
 }
 
-bool PdfIndirectObjectList::CompareObject(const PdfObject* p1, const PdfObject* p2)
+PdfIndirectObjectList::MemoryPin& PdfIndirectObjectList::MemoryPin::operator=(MemoryPin&& rhs) noexcept
 {
-    return *p1 < *p2;
+    reset();
+    m_reference = rhs.m_reference;
+    utls::move(rhs.m_objects, m_objects);
+    return *this;
 }
 
-bool PdfIndirectObjectList::CompareReference(const PdfObject* obj, const PdfReference& ref)
+void PdfIndirectObjectList::MemoryPin::reset()
 {
-    return obj->GetIndirectReference() < ref;
+    if (m_objects == nullptr)
+        return;
+
+    m_objects->unpinObject(m_reference);
+    m_objects = nullptr;
 }
@@ -8,6 +8,7 @@
 #define PDF_INDIRECT_OBJECT_LIST_H
 
 #include <list>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "PdfObject.h"
@@ -31,25 +32,83 @@ using ReferenceList = std::deque<PdfReference>;
  */
 class PDFMM_API PdfIndirectObjectList final
 {
+    PDFMM_UNIT_TEST(PdfIndirectObjectListTest);
     friend class PdfWriter;
     friend class PdfDocument;
     friend class PdfParser;
     friend class PdfObjectStreamParser;
     friend class PdfImmediateWriter;
+    friend class PdfMemDocument;
+    friend class PdfParserObject;
 
 private:
-    static bool CompareObject(const PdfObject* p1, const PdfObject* p2);
-    static bool CompareReference(const PdfObject* obj, const PdfReference& ref);
-
-private:
-    using ObjectList = std::set<PdfObject*, decltype(CompareObject)*>;
+    // Dense table of objects indexed by object number. Free
+    // object numbers have null slots
+    using ObjectList = std::vector<PdfObject*>;
 
 public:
-    // An incomplete set of container typedefs, just enough to handle
-    // the begin() and end() methods we wrap from the internal vector.
-    // TODO: proper wrapper iterator class.
-    using iterator = ObjectList::const_iterator;
-    using reverse_iterator = ObjectList::const_reverse_iterator;
+    /** Iterator over the objects, ordered by reference,
+     * skipping free object numbers
+     */
+    class PDFMM_API iterator final
+    {
+        friend class PdfIndirectObjectList;
+    public:
+        using difference_type = ptrdiff_t;
+        using value_type = PdfObject*;
+        using pointer = PdfObject* const*;
+        using reference = PdfObject* const&;
+        using iterator_category = std::bidirectional_iterator_tag;
+    public:
+        iterator() { }
+    private:
+        iterator(const ObjectList::const_iterator& it, const ObjectList::const_iterator& end)
+            : m_it(it), m_end(end)
+        {
+            while (m_it != m_end && *m_it == nullptr)
+                m_it++;
+        }
+    public:
+        iterator(const iterator&) = default;
+        iterator& operator=(const iterator&) = default;
+        bool operator==(const iterator& rhs) const { return m_it == rhs.m_it; }
+        bool operator!=(const iterator& rhs) const { return m_it != rhs.m_it; }
+        reference operator*() const { return *m_it; }
+        pointer operator->() const { return &*m_it; }
+        iterator& operator++()
+        {
+            do
+            {
+                m_it++;
+            } while (m_it != m_end && *m_it == nullptr);
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            auto copy = *this;
+            ++(*this);
+            return copy;
+        }
+        iterator& operator--()
+        {
+            do
+            {
+                m_it--;
+            } while (*m_it == nullptr);
+            return *this;
+        }
+        iterator operator--(int)
+        {
+            auto copy = *this;
+            --(*this);
+            return copy;
+        }
+    private:
+        ObjectList::const_iterator m_it;
+        ObjectList::const_iterator m_end;
+    };
+
+    using reverse_iterator = std::reverse_iterator<iterator>;
 
     /** Every observer of PdfIndirectObjectList has to implement this interface.
      */
@@ -90,6 +149,29 @@ public:
         virtual std::unique_ptr<PdfObjectStreamProvider> CreateStream() = 0;
     };
 
+    /** Scope guard that prevents the stream data of an object from being
+     *  released to fit the object memory budget while the guard is alive,
+     *  eg. when the data is accessed by other threads
+     *  \see PdfMemDocument::SetObjectMemoryBudget()
+     */
+    class PDFMM_API MemoryPin final
+    {
+    public:
+        MemoryPin();
+        MemoryPin(const PdfObject& obj);
+        MemoryPin(MemoryPin&& rhs) noexcept;
+        ~MemoryPin();
+    public:
+        MemoryPin& operator=(MemoryPin&& rhs) noexcept;
+    private:
+        MemoryPin(const MemoryPin&) = delete;
+        MemoryPin& operator=(const MemoryPin&) = delete;
+        void reset();
+    private:
+        PdfIndirectObjectList* m_objects;
+        PdfReference m_reference;
+    };
+
 public:
     PdfIndirectObjectList();
 
@@ -264,6 +346,9 @@ private:
      *  the vector remains sorted w.r.t.
      *  the ordering based on object and generation numbers
      *  m_ObjectCount will be increased for the object.
+     *  An existing object with the same object number is replaced,
+     *  unless it has a greater generation number: in that case the
+     *  pushed object is deleted
      *
      *  \param obj pointer to the object you want to insert
      */
@@ -315,21 +400,84 @@ private:
     void CollectGarbage();
 
 private:
-    void pushObject(ObjectList::node_type& it, PdfObject* obj);
+    PdfObject*& getSlot(uint32_t objectNum);
+
+    /** Delete the object in the slot, if any
+     */
+    void deleteObject(uint32_t objectNum);
+
+    /** Take the ownership of the object in the slot
+     */
+    std::unique_ptr<PdfObject> takeObject(uint32_t objectNum);
+
+    /** Copy the strings of the object borrowed from the source device
+     */
+    static void materializeStrings(const PdfObject& obj);
+
+    /** Load all the objects and copy the data borrowed from the source
+     * device, so the device is not accessed anymore
+     */
+    void detachSourceDevice();
 
-    std::unique_ptr<PdfObject> removeObject(const iterator& it, bool markAsFree);
+    std::unique_ptr<PdfObject> removeObject(uint32_t objectNum, bool markAsFree);
 
     void addNewObject(PdfObject* obj);
 
+    /** Create an empty /ObjStm object stream container. Free
+     * object numbers are not reused, since object streams
+     * must have generation number 0
+     */
+    PdfObject& createObjStmObject();
+
+    /** Remove the object streams created with createObjStmObject(),
+     * which are the last objects, and make their numbers available
+     * again, so repeated full saves don't grow the trailer /Size
+     */
+    void removeObjStmObjects(const std::vector<PdfObject*>& objectStreams);
+
     /**
+     * \param reuseFreeObjects try to reuse a free object number first
      * \returns the next free object reference
      */
-    PdfReference getNextFreeObject();
+    PdfReference getNextFreeObject(bool reuseFreeObjects = true);
 
     int32_t tryAddFreeObject(uint32_t objnum, uint32_t gennum);
 
     void visitObject(const PdfObject& obj, std::unordered_set<PdfReference>& referencedObj);
 
+    /** Set the budget for the stream data of parsed objects that can be
+     * automatically released. 0 disables the tracking
+     * \see PdfMemDocument::SetObjectMemoryBudget()
+     */
+    void setObjectMemoryBudget(size_t budget);
+
+    /** \returns true if loaded parsed streams should be tracked
+     */
+    bool isObjectMemoryTracked() const;
+
+    void beginObjectLoad();
+
+    /** End the load of the stream of a parsed object, tracking the
+     * size of the loaded data. Memory is released when no other
+     * object load is in progress
+     */
+    void endObjectLoad(const PdfReference& ref, size_t size);
+
+    /** End an object load that failed
+     */
+    void endObjectLoad();
+
+    /** Release the stream data of the least recently loaded objects,
+     * except the last one and the pinned ones, to fit the budget
+     */
+    void releaseObjectMemory(size_t budget);
+
+    void pinObject(const PdfReference& ref);
+
+    void unpinObject(const PdfReference& ref);
+
+    void clearLoadedObjects();
+
 public:
     /** Iterator pointing at the beginning of the vector
      *  \returns beginning iterator
@@ -367,13 +515,29 @@ private:
     PdfDocument* m_Document;
     bool m_CanReuseObjectNumbers;
     ObjectList m_Objects;
+    unsigned m_ObjectsSize;
     unsigned m_ObjectCount;
     ReferenceList m_FreeObjects;
-    ObjectNumSet m_unavailableObjects;
+    std::vector<bool> m_unavailableObjects; // Object numbers that reached the maximum generation number
     ObjectNumSet m_objectStreams;
 
     ObserverList m_observers;
     StreamFactory* m_StreamFactory;
+
+    struct LoadedObject
+    {
+        PdfReference Reference;
+        size_t Size;
+    };
+
+    using LoadedObjectList = std::list<LoadedObject>;
+
+    size_t m_ObjectMemoryBudget;
+    size_t m_LoadedObjectMemory;
+    unsigned m_loadDepth;
+    LoadedObjectList m_loadedObjects;       // Least recently loaded first
+    std::unordered_map<PdfReference, LoadedObjectList::iterator> m_loadedObjectMap;
+    std::unordered_map<PdfReference, unsigned> m_pinnedObjects;     // Pin count of objects in use
 };
 
 };
@@ -25,6 +25,18 @@ bool InputStreamDevice::Peek(char& ch) const
     return peek(ch);
 }
 
+bool InputStreamDevice::TryGetSpan(bufferview& span) const
+{
+    EnsureAccess(DeviceAccess::Read);
+    return tryGetSpan(span);
+}
+
+bool InputStreamDevice::tryGetSpan(bufferview& span) const
+{
+    span = { };
+    return false;
+}
+
 void InputStreamDevice::checkRead() const
 {
     EnsureAccess(DeviceAccess::Read);
@@ -31,12 +31,25 @@ public:
      */
     bool Peek(char& ch) const;
 
+    /** Try to get a view of the whole device contents, without copying.
+     * This is possible only if the device is backed by contiguous memory,
+     * eg. a memory mapped file or a memory buffer. The view is valid as
+     * long as the device is alive and the contents are not modified
+     * \returns true if the device is backed by contiguous memory
+     */
+    bool TryGetSpan(bufferview& span) const;
+
 protected:
     /** Peek at next char in stream.
      *  /returns true if success, false if EOF
      */
     virtual bool peek(char& ch) const = 0;
 
+    /** Try to get a view of the whole device contents
+     * \remarks default implementation returns false
+     */
+    virtual bool tryGetSpan(bufferview& span) const;
+
     void checkRead() const override;
 };
 
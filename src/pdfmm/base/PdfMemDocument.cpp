@@ -42,7 +42,9 @@ PdfMemDocument::PdfMemDocument(bool empty) :
     m_Version(PdfVersionDefault),
     m_InitialVersion(PdfVersionDefault),
     m_HasXRefStream(false),
-    m_PrevXRefOffset(-1)
+    m_PrevXRefOffset(-1),
+    m_ObjectStreamGroupSize(100),
+    m_CompressionThreadCount(1)
 {
 }
 
@@ -60,7 +62,9 @@ PdfMemDocument::PdfMemDocument(const PdfMemDocument& rhs) :
     m_Version(rhs.m_Version),
     m_InitialVersion(rhs.m_InitialVersion),
     m_HasXRefStream(rhs.m_HasXRefStream),
-    m_PrevXRefOffset(rhs.m_PrevXRefOffset)
+    m_PrevXRefOffset(rhs.m_PrevXRefOffset),
+    m_ObjectStreamGroupSize(rhs.m_ObjectStreamGroupSize),
+    m_CompressionThreadCount(rhs.m_CompressionThreadCount)
 {
     auto encryptObj = GetTrailer().GetDictionary().FindKey("Encrypt");
     if (encryptObj != nullptr)
@@ -230,6 +234,14 @@ void PdfMemDocument::RemovePdfExtension(const PdfName& ns, int64_t level)
 
 void PdfMemDocument::Save(const string_view& filename, PdfSaveOptions options)
 {
+    // The destination may be the file the document was loaded from,
+    // which is truncated when it's opened: read everything first
+    if (m_device != nullptr)
+    {
+        GetObjects().detachSourceDevice();
+        m_device = nullptr;
+    }
+
     FileStreamDevice device(filename, FileMode::Create);
     this->Save(device, options);
 }
@@ -241,6 +253,8 @@ void PdfMemDocument::Save(OutputStreamDevice& device, PdfSaveOptions opts)
     PdfWriter writer(this->GetObjects(), this->GetTrailer().GetObject());
     writer.SetPdfVersion(this->GetPdfVersion());
     writer.SetSaveOptions(opts);
+    writer.SetObjectStreamGroupSize(m_ObjectStreamGroupSize);
+    writer.SetCompressionThreadCount(m_CompressionThreadCount);
 
     if (m_Encrypt != nullptr)
         writer.SetEncrypt(*m_Encrypt);
@@ -269,6 +283,8 @@ void PdfMemDocument::SaveUpdate(OutputStreamDevice& device, PdfSaveOptions opts)
     PdfWriter writer(this->GetObjects(), this->GetTrailer().GetObject());
     writer.SetPdfVersion(this->GetPdfVersion());
     writer.SetSaveOptions(opts);
+    writer.SetObjectStreamGroupSize(m_ObjectStreamGroupSize);
+    writer.SetCompressionThreadCount(m_CompressionThreadCount);
     writer.SetPrevXRefOffset(m_PrevXRefOffset);
     writer.SetUseXRefStream(m_HasXRefStream);
     writer.SetIncrementalUpdate(false);
@@ -298,6 +314,13 @@ void PdfMemDocument::SaveUpdate(OutputStreamDevice& device, PdfSaveOptions opts)
 
 void PdfMemDocument::beforeWrite(PdfSaveOptions opts)
 {
+    // Object streams require at least PDF 1.5
+    if ((opts & PdfSaveOptions::ObjectStreams) != PdfSaveOptions::None
+        && GetPdfVersion() < PdfVersion::V1_5)
+    {
+        SetPdfVersion(PdfVersion::V1_5);
+    }
+
     if ((opts & PdfSaveOptions::NoModifyDateUpdate) ==
         PdfSaveOptions::None)
     {
@@ -325,6 +348,14 @@ void PdfMemDocument::SetEncrypt(unique_ptr<PdfEncrypt>&& encrypt)
     m_Encrypt = std::move(encrypt);
 }
 
+void PdfMemDocument::SetObjectStreamGroupSize(unsigned groupSize)
+{
+    if (groupSize == 0 || groupSize > numeric_limits<uint16_t>::max())
+        PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    m_ObjectStreamGroupSize = groupSize;
+}
+
 void PdfMemDocument::FreeObjectMemory(const PdfReference& ref, bool force)
 {
     FreeObjectMemory(this->GetObjects().GetObject(ref), force);
@@ -345,6 +376,21 @@ void PdfMemDocument::FreeObjectMemory(PdfObject* obj, bool force)
     parserObject->FreeObjectMemory(force);
 }
 
+void PdfMemDocument::SetObjectMemoryBudget(size_t budget)
+{
+    GetObjects().setObjectMemoryBudget(budget);
+}
+
+size_t PdfMemDocument::GetObjectMemoryBudget() const
+{
+    return GetObjects().m_ObjectMemoryBudget;
+}
+
+size_t PdfMemDocument::GetLoadedObjectMemory() const
+{
+    return GetObjects().m_LoadedObjectMemory;
+}
+
 const PdfEncrypt* PdfMemDocument::GetEncrypt() const
 {
     return m_Encrypt.get();
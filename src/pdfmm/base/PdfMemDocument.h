@@ -71,6 +71,12 @@ public:
      *
      *  \param device the input device containing the PDF
      *
+     *  To load a file with a MappedFileStreamDevice, pass it explicitly
+     *  to this method. Data of the mapped file is then borrowed while
+     *  the document is loaded on demand, so the file must not be
+     *  modified by others until the document is closed. Save() to the
+     *  same path copies the data first
+     *
      *  \see WriteUpdate, Load, LoadFromBuffer
      */
     void LoadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password = { });
@@ -79,6 +85,10 @@ public:
      *
      *  \param filename filename of the document
      *
+     *  The file can be the one the document was loaded from: all the
+     *  objects are then read in memory first, and the document doesn't
+     *  access the source device anymore
+     *
      *  \see Save, SaveUpdate
      *
      *  This is an overloaded member function for your convenience.
@@ -174,6 +184,33 @@ public:
      */
     void SetEncrypt(std::unique_ptr<PdfEncrypt>&& encrypt);
 
+    /** Set the maximum count of objects grouped in a single object
+     *  stream, when saving with PdfSaveOptions::ObjectStreams
+     *  Default is 100.
+     *  \param groupSize the group size, in the range [1, 65535]
+     */
+    void SetObjectStreamGroupSize(unsigned groupSize);
+
+    /**
+     *  \returns the maximum count of objects grouped in a single object stream
+     */
+    unsigned GetObjectStreamGroupSize() const { return m_ObjectStreamGroupSize; }
+
+    /** Set the number of threads used to flate compress the object
+     *  streams when saving. The output is identical to the one
+     *  obtained with serial compression
+     *  Default is 1, meaning streams are compressed serially.
+     *  \param threadCount the number of threads to use. 0 means
+     *     to use the hardware concurrency
+     *  \see PdfWriter::SetCompressionThreadCount
+     */
+    void SetCompressionThreadCount(unsigned threadCount) { m_CompressionThreadCount = threadCount; }
+
+    /**
+     *  \returns the number of threads used to compress the object streams
+     */
+    unsigned GetCompressionThreadCount() const { return m_CompressionThreadCount; }
+
     /** Tries to free all memory allocated by the given
      *  PdfObject (variables and streams) and reads
      *  it from disk again if it is requested another time.
@@ -213,6 +250,35 @@ public:
      */
     void FreeObjectMemory(PdfObject* obj, bool force = false);
 
+    /** Set a budget for the memory of the stream data loaded from
+     *  the source device. When it's exceeded, the data of the least
+     *  recently loaded streams of objects that are not dirty is
+     *  automatically released, and read from the device again when
+     *  the stream is accessed another time. Dictionaries and other
+     *  object values are never released automatically.
+     *
+     *  \param budget the budget in bytes. 0 disables the automatic
+     *      release of stream data, which is the default
+     *
+     *  \remarks References to the released PdfObjectStream stay valid.
+     *      Streams with input or output streams in progress are not
+     *      released, and PdfIndirectObjectList::MemoryPin can be used to
+     *      keep the data of other streams in memory, eg. while a
+     *      bufferview from PdfObjectStreamProvider::TryGetSpan() is in
+     *      use. The budget is not applied when the document is in
+     *      concurrent read mode
+     *  \see FreeObjectMemory
+     */
+    void SetObjectMemoryBudget(size_t budget);
+
+    size_t GetObjectMemoryBudget() const;
+
+    /** \returns the memory of the loaded stream data tracked
+     *      for the budget
+     *  \see SetObjectMemoryBudget
+     */
+    size_t GetLoadedObjectMemory() const;
+
     const PdfEncrypt* GetEncrypt() const override;
 
 protected:
@@ -251,6 +317,8 @@ private:
     PdfVersion m_InitialVersion;
     bool m_HasXRefStream;
     int64_t m_PrevXRefOffset;
+    unsigned m_ObjectStreamGroupSize;
+    unsigned m_CompressionThreadCount;
     std::unique_ptr<PdfEncrypt> m_Encrypt;
     std::shared_ptr<InputStreamDevice> m_device;
 };
@@ -17,6 +17,7 @@ using namespace std;
 using namespace mm;
 
 PdfMemoryObjectStream::PdfMemoryObjectStream()
+    : m_borrowed(false)
 {
 }
 
@@ -27,7 +28,11 @@ void PdfMemoryObjectStream::Init(PdfObject& obj)
 
 void PdfMemoryObjectStream::Clear()
 {
-    m_buffer.clear();
+    // Release the memory too, as streams are
+    // cleared to fit the object memory budget
+    charbuff().swap(m_buffer);
+    m_borrowedView = { };
+    m_borrowed = false;
 }
 
 bool PdfMemoryObjectStream::TryCopyFrom(const PdfObjectStreamProvider& rhs)
@@ -36,7 +41,11 @@ bool PdfMemoryObjectStream::TryCopyFrom(const PdfObjectStreamProvider& rhs)
     if (memstream == nullptr)
         return false;
 
-    m_buffer = memstream->m_buffer;
+    // NOTE: Always copy borrowed data, since the
+    // source memory may not outlive this stream
+    m_buffer = memstream->getView();
+    m_borrowedView = { };
+    m_borrowed = false;
     return true;
 }
 
@@ -46,35 +55,47 @@ bool PdfMemoryObjectStream::TryMoveFrom(PdfObjectStreamProvider&& rhs)
     if (memstream == nullptr)
         return false;
 
-    m_buffer = std::move(memstream->m_buffer);
+    if (memstream->m_borrowed)
+    {
+        m_buffer = memstream->m_borrowedView;
+        memstream->Clear();
+    }
+    else
+    {
+        m_buffer = std::move(memstream->m_buffer);
+    }
+
+    m_borrowedView = { };
+    m_borrowed = false;
     return true;
 }
 
 unique_ptr<InputStream> PdfMemoryObjectStream::GetInputStream(PdfObject& obj)
 {
     (void)obj;
-    return unique_ptr<InputStream>(new SpanStreamDevice(m_buffer));
+    return unique_ptr<InputStream>(new SpanStreamDevice(getView()));
 }
 
 unique_ptr<OutputStream> PdfMemoryObjectStream::GetOutputStream(PdfObject& obj)
 {
     (void)obj;
-    m_buffer.clear();
+    Clear();
     return unique_ptr<OutputStream>(new StringStreamDevice(m_buffer));
 }
 
 void PdfMemoryObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt& encrypt)
 {
     stream.Write("stream\n");
+    auto view = getView();
     if (encrypt.HasEncrypt())
     {
         charbuff encrypted;
-        encrypt.EncryptTo(encrypted, { m_buffer.data(), m_buffer.size() });
+        encrypt.EncryptTo(encrypted, view);
         stream.Write(encrypted);
     }
     else
     {
-        stream.Write(string_view(m_buffer.data(), m_buffer.size()));
+        stream.Write(string_view(view.data(), view.size()));
     }
 
     stream.Write("\nendstream\n");
@@ -83,5 +104,48 @@ void PdfMemoryObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt
 
 size_t PdfMemoryObjectStream::GetLength() const
 {
-    return m_buffer.size();
+    return getView().size();
+}
+
+bool PdfMemoryObjectStream::TryBorrowData(const bufferview& buffer)
+{
+    m_buffer.clear();
+    m_borrowedView = buffer;
+    m_borrowed = true;
+    return true;
+}
+
+bool PdfMemoryObjectStream::TryGetSpan(bufferview& span) const
+{
+    span = getView();
+    return true;
+}
+
+const charbuff& PdfMemoryObjectStream::GetBuffer() const
+{
+    const_cast<PdfMemoryObjectStream&>(*this).ensureOwned();
+    return m_buffer;
+}
+
+bufferview PdfMemoryObjectStream::GetView() const
+{
+    return getView();
+}
+
+bufferview PdfMemoryObjectStream::getView() const
+{
+    if (m_borrowed)
+        return m_borrowedView;
+    else
+        return m_buffer;
+}
+
+void PdfMemoryObjectStream::ensureOwned()
+{
+    if (!m_borrowed)
+        return;
+
+    m_buffer = m_borrowedView;
+    m_borrowedView = { };
+    m_borrowed = false;
 }
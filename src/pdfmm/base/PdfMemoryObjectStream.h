@@ -22,6 +22,9 @@ namespace mm {
  *  to draw onto a page or binary data like a font or an image.
  *
  *  A PdfMemoryObjectStream is implicitly shared and can therefore be copied very quickly.
+ *  The data can also be borrowed from externally owned memory, in which
+ *  case it's copied on the first modification, or when copied/moved to
+ *  another stream.
  */
 class PDFMM_API PdfMemoryObjectStream final : public PdfObjectStreamProvider
 {
@@ -49,10 +52,33 @@ public:
 
     size_t GetLength() const override;
 
-    const charbuff& GetBuffer() const { return m_buffer; }
+    bool TryBorrowData(const bufferview& buffer) override;
 
- private:
+    bool TryGetSpan(bufferview& span) const override;
+
+    /** Get the stream data buffer. Borrowed data is copied
+     * in the buffer first, see IsBorrowed()
+     */
+    const charbuff& GetBuffer() const;
+
+    /** Get a view of the stream data, without copying borrowed
+     * data, see IsBorrowed(). The view is invalidated by modifications
+     */
+    bufferview GetView() const;
+
+    /** True if the stream data is a view of externally owned memory,
+     * eg. the source device the object was parsed from
+     */
+    bool IsBorrowed() const { return m_borrowed; }
+
+private:
+    bufferview getView() const;
+    void ensureOwned();
+
+private:
     charbuff m_buffer;
+    bufferview m_borrowedView;
+    bool m_borrowed;
 };
 
 };
@@ -21,6 +21,30 @@ void hexchr(const unsigned char ch, T& it);
 
 static void EscapeNameTo(string& dst, const string_view& view);
 static string UnescapeName(const string_view& view);
+static unique_ptr<string> expandUtf8String(const string_view& raw);
+
+// Names that are interned in the pool. They are the most
+// frequent keys and values found in PDF dictionaries
+static const string_view s_WellKnownNames[] = {
+    "", "A", "AA", "AcroForm", "Alternate", "Annot", "Annots", "AP", "ArtBox", "AS", "Ascent",
+    "Author", "BaseEncoding", "BaseFont", "BBox", "BitsPerComponent", "BleedBox", "Border",
+    "Catalog", "CapHeight", "CIDFontType0", "CIDFontType2", "CIDSystemInfo", "CIDToGIDMap",
+    "ColorSpace", "Colors", "Columns", "Contents", "Count", "CreationDate", "Creator", "CropBox",
+    "CS", "D", "DA", "DCTDecode", "Decode", "DecodeParms", "Descent", "DescendantFonts", "Dest",
+    "DeviceCMYK", "DeviceGray", "DeviceRGB", "Differences", "DR", "DW", "Encoding", "Encrypt",
+    "ExtGState", "F", "Ff", "Fields", "Filter", "First", "FirstChar", "Flags", "FlateDecode",
+    "Font", "FontBBox", "FontDescriptor", "FontFile", "FontFile2", "FontFile3", "FontName",
+    "Form", "FT", "Group", "GS0", "Height", "I", "ICCBased", "ID", "Identity", "Identity-H",
+    "Image", "ImageB", "ImageC", "ImageI", "Index", "Indexed", "Info", "Interpolate",
+    "ItalicAngle", "K", "Kids", "LastChar", "Length", "Length1", "Length2", "Length3", "Link",
+    "Mask", "Matrix", "MediaBox", "Metadata", "MissingWidth", "MK", "ModDate", "N", "Names",
+    "ObjStm", "Ordering", "Outlines", "P", "Page", "Pages", "Parent", "Pattern", "PDF",
+    "Predictor", "Prev", "ProcSet", "Producer", "Properties", "Rect", "Registry", "Resources",
+    "Root", "Rotate", "S", "Shading", "Size", "SMask", "StemH", "StemV", "StructParents",
+    "Subtype", "Supplement", "T", "Tabs", "Text", "Title", "ToUnicode", "Trapped", "TrimBox",
+    "TrueType", "Type", "Type0", "Type1", "Type3", "URI", "V", "W", "Widget", "Width",
+    "Widths", "WinAnsiEncoding", "XHeight", "XML", "XObject", "XRef", "XRefStm",
+};
 
 const PdfName PdfName::KeyNull = PdfName();
 const PdfName PdfName::KeyContents = PdfName("Contents");
@@ -33,7 +57,7 @@ const PdfName PdfName::KeyType = PdfName("Type");
 const PdfName PdfName::KeyFilter = PdfName("Filter");
 
 PdfName::PdfName()
-    : m_data(new NameData{ true, { }, nullptr })
+    : m_data(*tryGetInterned({ }))
 {
 }
 
@@ -58,7 +82,12 @@ PdfName::PdfName(const PdfName& rhs)
 }
 
 PdfName::PdfName(charbuff&& buff)
-    : m_data(new NameData{ false, std::move(buff), nullptr })
+{
+    initFromRaw(std::move(buff));
+}
+
+PdfName::PdfName(const shared_ptr<NameData>& data)
+    : m_data(data)
 {
 }
 
@@ -67,9 +96,12 @@ void PdfName::initFromUtf8String(const string_view& view)
     if (view.data() == nullptr)
         throw runtime_error("Name is null");
 
-    if (view.length() == 0)
+    // Interned names are plain ASCII, hence valid
+    // PdfDocEncoding that is equal to the UTF-8 input
+    auto interned = tryGetInterned(view);
+    if (interned != nullptr)
     {
-        m_data.reset(new NameData{ true, { }, nullptr });
+        m_data = *interned;
         return;
     }
 
@@ -78,19 +110,71 @@ void PdfName::initFromUtf8String(const string_view& view)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidName, "Characters in string must be PdfDocEncoding character set");
 
     if (isAsciiEqual)
-        m_data.reset(new NameData{ true, charbuff(view), nullptr });
+        m_data = std::make_shared<NameData>(NameData{ charbuff(view), nullptr });
     else
-        m_data.reset(new NameData{ true, (charbuff)mm::ConvertUTF8ToPdfDocEncoding(view), std::make_unique<string>(view) });
+        m_data = std::make_shared<NameData>(NameData{ (charbuff)mm::ConvertUTF8ToPdfDocEncoding(view), std::make_unique<string>(view) });
+}
+
+void PdfName::initFromRaw(charbuff&& buff)
+{
+    auto interned = tryGetInterned(buff);
+    if (interned != nullptr)
+    {
+        m_data = *interned;
+        return;
+    }
+
+    // Expand the UTF-8 string now, so name data is
+    // immutable and can be safely shared between threads
+    auto utf8str = expandUtf8String(buff);
+    m_data = std::make_shared<NameData>(NameData{ std::move(buff), std::move(utf8str) });
 }
 
 PdfName PdfName::FromEscaped(const string_view& view)
 {
+    // Unescaping is needed only if there are escape sequences
+    if (view.find('#') == string_view::npos)
+        return FromRaw(view);
+
     return FromRaw(UnescapeName(view));
 }
 
 PdfName PdfName::FromRaw(const bufferview& rawcontent)
 {
-    return PdfName((charbuff)rawcontent);
+    // Don't copy the content if the name is interned
+    auto interned = tryGetInterned(string_view(rawcontent.data(), rawcontent.size()));
+    if (interned == nullptr)
+        return PdfName((charbuff)rawcontent);
+    else
+        return PdfName(*interned);
+}
+
+const shared_ptr<PdfName::NameData>* PdfName::tryGetInterned(const string_view& raw)
+{
+    struct NamePool
+    {
+        NamePool()
+        {
+            for (auto& name : s_WellKnownNames)
+            {
+                auto& data = Storage.emplace_back(NameData{ charbuff(name), nullptr });
+                // The storage is never released before the pool: alias it
+                // with no control block, so copies don't need reference counting
+                Names[data.Chars] = shared_ptr<NameData>(shared_ptr<NameData>(), &data);
+            }
+        }
+
+        deque<NameData> Storage;
+        unordered_map<string_view, shared_ptr<NameData>> Names;
+    };
+
+    // The pool is built on first use, thread safely
+    static NamePool pool;
+    auto found = pool.Names.find(raw);
+    if (found == pool.Names.end())
+        return nullptr;
+
+    return &found->second;
 }
 
 void PdfName::Write(OutputStreamDevice& device, PdfWriteFlags,
@@ -116,18 +200,30 @@ string PdfName::GetEscapedName() const
     return ret;
 }
 
-void PdfName::expandUtf8String() const
+unique_ptr<string> expandUtf8String(const string_view& raw)
 {
-    if (!m_data->IsUtf8Expanded)
+    // Printable ASCII characters are the same in PdfDocEncoding,
+    // skip the conversion for the common case
+    bool isPrintableAscii = true;
+    for (char ch : raw)
     {
-        bool isAsciiEqual;
-        string utf8str;
-        mm::ConvertPdfDocEncodingToUTF8(m_data->Chars, utf8str, isAsciiEqual);
-        if (!isAsciiEqual)
-            m_data->Utf8String.reset(new string(std::move(utf8str)));
-
-        m_data->IsUtf8Expanded = true;
+        if (ch < 0x20 || ch > 0x7E)
+        {
+            isPrintableAscii = false;
+            break;
+        }
     }
+
+    if (isPrintableAscii)
+        return nullptr;
+
+    bool isAsciiEqual;
+    string utf8str;
+    mm::ConvertPdfDocEncodingToUTF8(raw, utf8str, isAsciiEqual);
+    if (isAsciiEqual)
+        return nullptr;
+
+    return unique_ptr<string>(new string(std::move(utf8str)));
 }
 
 /** Escape the input string according to the PDF name
@@ -222,7 +318,6 @@ string UnescapeName(const string_view& view)
 
 const string& PdfName::GetString() const
 {
-    expandUtf8String();
     if (m_data->Utf8String == nullptr)
         return m_data->Chars;
     else
@@ -295,6 +390,9 @@ bool PdfName::operator!=(const string_view& view) const
 
 bool PdfName::operator<(const PdfName& rhs) const
 {
+    if (this->m_data == rhs.m_data)
+        return false;
+
     return this->m_data->Chars < rhs.m_data->Chars;
 }
 
@@ -20,6 +20,11 @@ namespace mm {
  *
  *  PdfName may have a maximum length of 127 characters.
  *
+ *  Well-known names, such as the common dictionary keys, are
+ *  interned in a pool built on first use: names with the same value
+ *  share the same immutable storage, with no allocation or reference
+ *  counting
+ *
  *  \see PdfObject \see PdfVariant
  */
 class PDFMM_API PdfName final : public PdfDataProvider
@@ -127,14 +132,16 @@ public:
     static const PdfName KeyFilter;
 
 private:
-    void expandUtf8String() const;
+    struct NameData;
+
+    PdfName(const std::shared_ptr<NameData>& data);
     void initFromUtf8String(const std::string_view& view);
+    void initFromRaw(charbuff&& buff);
+    static const std::shared_ptr<NameData>* tryGetInterned(const std::string_view& raw);
 
 private:
     struct NameData
     {
-        bool IsUtf8Expanded;
-
         // The unescaped name raw data, without leading '/'.
         // It can store also the utf8 expanded string, if coincident
         charbuff Chars;
@@ -7,6 +7,8 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfObject.h"
 
+#include <thread>
+
 #include "PdfDocument.h"
 #include "PdfArray.h"
 #include "PdfDictionary.h"
@@ -18,6 +20,20 @@
 using namespace std;
 using namespace mm;
 
+namespace
+{
+    // A delayed load in progress on the calling thread, in concurrent read mode
+    struct LoadInProgress
+    {
+        const atomic<uint8_t>* State;
+        LoadInProgress* Previous;
+    };
+}
+
+static bool isLoadInProgress(const atomic<uint8_t>& state);
+
+static thread_local LoadInProgress* s_loadsInProgress;
+
 PdfObject PdfObject::Null;
 
 PdfObject::PdfObject()
@@ -29,70 +45,70 @@ PdfObject::PdfObject(const PdfVariant& var)
     : PdfObject(PdfVariant(var), PdfReference(), false) { }
 
 PdfObject::PdfObject(PdfVariant&& var) noexcept
-    : m_Variant(std::move(var)), m_IsDirty(false)
+    : m_Variant(std::move(var))
 {
     initObject();
     SetVariantOwner();
 }
 
 PdfObject::PdfObject(bool b)
-    : m_Variant(b), m_IsDirty(false)
+    : m_Variant(b)
 {
     initObject();
 }
 
 PdfObject::PdfObject(int64_t l)
-    : m_Variant(l), m_IsDirty(false)
+    : m_Variant(l)
 {
     initObject();
 }
 
 PdfObject::PdfObject(double d)
-    : m_Variant(d), m_IsDirty(false)
+    : m_Variant(d)
 {
     initObject();
 }
 
 PdfObject::PdfObject(const PdfString& str)
-    : m_Variant(str), m_IsDirty(false)
+    : m_Variant(str)
 {
     initObject();
 }
 PdfObject::PdfObject(const PdfName& name)
-    : m_Variant(name), m_IsDirty(false)
+    : m_Variant(name)
 {
     initObject();
 }
 
 PdfObject::PdfObject(const PdfReference& ref)
-    : m_Variant(ref), m_IsDirty(false)
+    : m_Variant(ref)
 {
     initObject();
 }
 
 PdfObject::PdfObject(const PdfArray& arr)
-    : m_Variant(arr), m_IsDirty(false)
+    : m_Variant(arr)
 {
     initObject();
     m_Variant.GetArray().SetOwner(*this);
 }
 
 PdfObject::PdfObject(PdfArray&& arr) noexcept
-    : m_Variant(std::move(arr)), m_IsDirty(false)
+    : m_Variant(std::move(arr))
 {
     initObject();
     m_Variant.GetArray().SetOwner(*this);
 }
 
 PdfObject::PdfObject(const PdfDictionary& dict)
-    : m_Variant(dict), m_IsDirty(false)
+    : m_Variant(dict)
 {
     initObject();
     m_Variant.GetDictionary().SetOwner(*this);
 }
 
 PdfObject::PdfObject(PdfDictionary&& dict) noexcept
-    : m_Variant(std::move(dict)), m_IsDirty(false)
+    : m_Variant(std::move(dict))
 {
     initObject();
     m_Variant.GetDictionary().SetOwner(*this);
@@ -111,8 +127,7 @@ PdfObject::PdfObject(const PdfObject& rhs)
 // always detached. Ownership will be set automatically elsewhere.
 // Also don't move reference
 PdfObject::PdfObject(PdfObject&& rhs) noexcept :
-    m_Variant(std::move(rhs.m_Variant)),
-    m_IsDirty(false)
+    m_Variant(std::move(rhs.m_Variant))
 {
     initObject();
     SetVariantOwner();
@@ -122,21 +137,28 @@ PdfObject::PdfObject(PdfObject&& rhs) noexcept :
 const PdfObjectStream* PdfObject::GetStream() const
 {
     DelayedLoadStream();
-    return m_Stream.get();
+    return getStream();
 }
 
 PdfObjectStream* PdfObject::GetStream()
 {
     DelayedLoadStream();
-    return m_Stream.get();
+    return getStream();
 }
 
 // NOTE: Dirty objects are those who are supposed to be serialized
 // or deserialized.
 PdfObject::PdfObject(PdfVariant&& var, const PdfReference& indirectReference, bool isDirty)
-    : m_Variant(std::move(var)), m_IndirectReference(indirectReference), m_IsDirty(isDirty)
+    : m_Variant(std::move(var))
 {
     initObject();
+    if (indirectReference.IsIndirect() || isDirty)
+    {
+        auto& data = getIndirectData();
+        data.Reference = indirectReference;
+        data.IsDirty = isDirty;
+    }
+
     SetVariantOwner();
 }
 
@@ -148,24 +170,36 @@ void PdfObject::ForceCreateStream()
 
 void PdfObject::SetDocument(PdfDocument* document)
 {
-    if (m_Document == document)
-    {
-        // The inner document for variant data objects is guaranteed to be same
+    if (m_IndirectData == nullptr && document == nullptr)
         return;
-    }
 
-    m_Document = document;
-    SetVariantOwner();
+    // NOTE: Direct children get the document from their parent
+    getIndirectData().Document = document;
+}
+
+PdfDocument* PdfObject::GetDocument() const
+{
+    if (m_IndirectData != nullptr && m_IndirectData->Document != nullptr)
+        return m_IndirectData->Document;
+
+    return m_Parent == nullptr ? nullptr : m_Parent->GetObjectDocument();
+}
+
+const PdfReference& PdfObject::GetIndirectReference() const
+{
+    static PdfReference s_nullReference;
+    return m_IndirectData == nullptr ? s_nullReference : m_IndirectData->Reference;
 }
 
 void PdfObject::DelayedLoad() const
 {
-    if (m_IsDelayedLoadDone)
+    if (m_IndirectData == nullptr
+        || m_IndirectData->DelayedLoadState.load(std::memory_order_acquire) == DelayedLoadDone)
+    {
         return;
+    }
 
-    const_cast<PdfObject&>(*this).DelayedLoadImpl();
-    m_IsDelayedLoadDone = true;
-    const_cast<PdfObject&>(*this).SetVariantOwner();
+    delayedLoad(m_IndirectData->DelayedLoadState, false);
 }
 
 void PdfObject::DelayedLoadImpl()
@@ -193,16 +227,23 @@ void PdfObject::SetVariantOwner()
 
 void PdfObject::FreeStream()
 {
-    m_Stream = nullptr;
+    if (m_IndirectData != nullptr)
+        m_IndirectData->Stream = nullptr;
 }
 
 void PdfObject::initObject()
 {
-    m_Document = nullptr;
+    // By default delayed load is disabled, which is
+    // implied by the lack of the indirect data
     m_Parent = nullptr;
-    // By default delayed load is disabled
-    m_IsDelayedLoadDone = true;
-    m_IsDelayedLoadStreamDone = true;
+}
+
+PdfObject::IndirectData& PdfObject::getIndirectData()
+{
+    if (m_IndirectData == nullptr)
+        m_IndirectData.reset(new IndirectData());
+
+    return *m_IndirectData;
 }
 
 void PdfObject::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
@@ -211,53 +252,41 @@ void PdfObject::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
     DelayedLoad();
     DelayedLoadStream();
 
+    auto& reference = GetIndirectReference();
     PdfStatefulEncrypt encrypt;
     if (encrypt_ != nullptr)
-        encrypt = PdfStatefulEncrypt(*encrypt_, m_IndirectReference);
+        encrypt = PdfStatefulEncrypt(*encrypt_, reference);
 
-    if (m_IndirectReference.IsIndirect())
+    if (reference.IsIndirect())
     {
         if ((writeMode & PdfWriteFlags::Clean) == PdfWriteFlags::None
             && (writeMode & PdfWriteFlags::NoPDFAPreserve) != PdfWriteFlags::None)
         {
-            utls::FormatTo(buffer, "{} {} obj", m_IndirectReference.ObjectNumber(), m_IndirectReference.GenerationNumber());
+            utls::FormatTo(buffer, "{} {} obj", reference.ObjectNumber(), reference.GenerationNumber());
             device.Write(buffer);
         }
         else
         {
             // PDF/A compliance requires all objects to be written in a clean way
-            utls::FormatTo(buffer, "{} {} obj\n", m_IndirectReference.ObjectNumber(), m_IndirectReference.GenerationNumber());
+            utls::FormatTo(buffer, "{} {} obj\n", reference.ObjectNumber(), reference.GenerationNumber());
             device.Write(buffer);
         }
     }
 
-    if (m_Stream != nullptr)
+    auto stream = const_cast<PdfObject&>(*this).getStream();
+    if (stream != nullptr)
     {
-        // Try to compress the flate compress the stream if it has no filters,
-        // the compression is not disabled and it's not the /MetaData object,
-        // which must be unfiltered as per PDF/A
-        const PdfObject* metadataObj;
-        if ((writeMode & PdfWriteFlags::NoFlateCompress) == PdfWriteFlags::None
-            && m_Stream->GetFilters().size() == 0
-            && (m_Document == nullptr 
-                || (metadataObj = m_Document->GetCatalog().GetMetadataObject()) == nullptr
-                || m_IndirectReference != metadataObj->GetIndirectReference()))
+        if (isStreamFlateCompressible(writeMode))
         {
             PdfObject object;
-            auto& stream = object.GetOrCreateStream();
-            {
-                auto output = stream.GetOutputStream({ PdfFilterType::FlateDecode });
-                auto input = m_Stream->GetInputStream();
-                input.CopyTo(output);
-            }
-
-            stream.MoveFrom(*m_Stream);
+            flateCompressStream(object, writeMode);
+            stream->MoveFrom(object.MustGetStream());
         }
 
         // Set length if it's not handled by the underlying provider
-        if (!m_Stream->GetProvider().IsLengthHandled())
+        if (!stream->GetProvider().IsLengthHandled())
         {
-            size_t length = m_Stream->GetLength();
+            size_t length = stream->GetLength();
             if (encrypt.HasEncrypt())
                 length = encrypt.CalculateStreamLength(length);
 
@@ -270,16 +299,59 @@ void PdfObject::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
     m_Variant.Write(device, writeMode, encrypt, buffer);
     device.Write('\n');
 
-    if (m_Stream != nullptr)
-        m_Stream->Write(device, encrypt);
+    if (stream != nullptr)
+        stream->Write(device, encrypt);
 
-    if (m_IndirectReference.IsIndirect())
+    if (reference.IsIndirect())
         device.Write("endobj\n");
 
     // After write we ca reset the dirty flag
     const_cast<PdfObject&>(*this).ResetDirty();
 }
 
+bool PdfObject::isStreamFlateCompressible(PdfWriteFlags writeMode) const
+{
+    DelayedLoadStream();
+
+    // Try to compress the flate compress the stream if it has no filters,
+    // the compression is not disabled and it's not the /MetaData object,
+    // which must be unfiltered as per PDF/A
+    auto stream = const_cast<PdfObject&>(*this).getStream();
+    auto document = GetDocument();
+    const PdfObject* metadataObj;
+    return stream != nullptr
+        && (writeMode & PdfWriteFlags::NoFlateCompress) == PdfWriteFlags::None
+        && stream->GetFilters().size() == 0
+        && (document == nullptr
+            || (metadataObj = document->GetCatalog().GetMetadataObject()) == nullptr
+            || GetIndirectReference() != metadataObj->GetIndirectReference());
+}
+
+void PdfObject::flateCompressStream(PdfObject& compressed, PdfWriteFlags writeMode) const
+{
+    // The level set on the stream takes precedence over the write flags
+    auto& stream = *m_IndirectData->Stream;
+    PdfCompressionLevel level = stream.GetCompressionLevel();
+    if (level == PdfCompressionLevel::Default)
+    {
+        if ((writeMode & PdfWriteFlags::FlateBestSpeed) != PdfWriteFlags::None)
+            level = PdfCompressionLevel::BestSpeed;
+        else if ((writeMode & PdfWriteFlags::FlateBestCompression) != PdfWriteFlags::None)
+            level = PdfCompressionLevel::BestCompression;
+    }
+
+    auto& compressedStream = compressed.GetOrCreateStream();
+    compressedStream.SetCompressionLevel(level);
+    auto output = compressedStream.GetOutputStream({ PdfFilterType::FlateDecode });
+    auto input = stream.GetInputStream();
+    input.CopyTo(output);
+}
+
+void PdfObject::moveCompressedStreamFrom(PdfObject& compressed)
+{
+    m_IndirectData->Stream->MoveFrom(compressed.MustGetStream());
+}
+
 PdfObjectStream& PdfObject::GetOrCreateStream()
 {
     DelayedLoadStream();
@@ -289,60 +361,88 @@ PdfObjectStream& PdfObject::GetOrCreateStream()
 const PdfObjectStream& PdfObject::MustGetStream() const
 {
     DelayedLoadStream();
-    if (m_Stream == nullptr)
+    auto stream = getStream();
+    if (stream == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The object doesn't have a stream");
 
-    return *m_Stream.get();
+    return *stream;
 }
 
 PdfObjectStream& PdfObject::MustGetStream()
 {
     DelayedLoadStream();
-    if (m_Stream == nullptr)
+    auto stream = getStream();
+    if (stream == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The object doesn't have a stream");
 
-    return *m_Stream.get();
+    return *stream;
 }
 
 bool PdfObject::IsIndirect() const
 {
-    return m_IndirectReference.IsIndirect();
+    return m_IndirectData != nullptr && m_IndirectData->Reference.IsIndirect();
 }
 
 bool PdfObject::HasStream() const
 {
-    DelayedLoadStream();
-    return m_Stream != nullptr;
+    if (m_IndirectData == nullptr)
+        return false;
+
+    if (m_IndirectData->DelayedLoadStreamState.load(std::memory_order_acquire) != DelayedLoadDone)
+    {
+        // Don't read again stream data released to fit the object memory
+        // budget. Streams are released and created by serialized loads,
+        // so check the stream holding the load lock. The budget isn't
+        // tracked in concurrent read mode
+        auto document = m_IndirectData->Document;
+        if (document != nullptr && !document->m_ConcurrentReadMode)
+        {
+            lock_guard<recursive_mutex> lock(document->m_LoadMutex);
+            if (getStream() != nullptr)
+                return true;
+        }
+
+        DelayedLoadStream();
+    }
+
+    return getStream() != nullptr;
 }
 
 PdfObjectStream& PdfObject::getOrCreateStream()
 {
     forceCreateStream();
-    return *m_Stream;
+    return *m_IndirectData->Stream;
 }
 
 void PdfObject::forceCreateStream()
 {
-    if (m_Stream != nullptr)
+    if (getStream() != nullptr)
         return;
 
     if (m_Variant.GetDataType() != PdfDataType::Dictionary)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Tried to get stream of non-dictionary object");
 
-    if (m_Document == nullptr)
+    auto document = GetDocument();
+    auto& data = getIndirectData();
+    if (document == nullptr)
     {
-        m_Stream.reset(new PdfObjectStream(*this,
+        data.Stream.reset(new PdfObjectStream(*this,
             unique_ptr<PdfObjectStreamProvider>(new PdfMemoryObjectStream())));
     }
     else
     {
-        m_Stream.reset(new PdfObjectStream(*this, m_Document->GetObjects().CreateStream()));
+        data.Stream.reset(new PdfObjectStream(*this, document->GetObjects().CreateStream()));
     }
 }
 
 PdfObjectStream* PdfObject::getStream()
 {
-    return m_Stream.get();
+    return m_IndirectData == nullptr ? nullptr : m_IndirectData->Stream.get();
+}
+
+const PdfObjectStream* PdfObject::getStream() const
+{
+    return m_IndirectData == nullptr ? nullptr : m_IndirectData->Stream.get();
 }
 
 void PdfObject::DelayedLoadStream() const
@@ -353,11 +453,104 @@ void PdfObject::DelayedLoadStream() const
 
 void PdfObject::delayedLoadStream() const
 {
-    if (m_IsDelayedLoadStreamDone)
+    if (m_IndirectData == nullptr
+        || m_IndirectData->DelayedLoadStreamState.load(std::memory_order_acquire) == DelayedLoadDone)
+    {
         return;
+    }
 
-    const_cast<PdfObject&>(*this).DelayedLoadStreamImpl();
-    m_IsDelayedLoadStreamDone = true;
+    delayedLoad(m_IndirectData->DelayedLoadStreamState, true);
+}
+
+void PdfObject::delayedLoad(atomic<uint8_t>& state, bool stream) const
+{
+    auto document = m_IndirectData->Document;
+    if (document == nullptr || !document->m_ConcurrentReadMode)
+    {
+        // Loading is serialized on the document, so concurrent
+        // readers of the same object will load it only once
+        unique_lock<recursive_mutex> lock;
+        if (document != nullptr)
+            lock = unique_lock<recursive_mutex>(document->m_LoadMutex);
+
+        if (state.load(std::memory_order_relaxed) == DelayedLoadDone)
+            return;
+
+        delayedLoadImpl(stream);
+        state.store(DelayedLoadDone, std::memory_order_release);
+        return;
+    }
+
+    // Concurrent read mode: objects are loaded independently. The
+    // first thread to claim the object loads it, the others wait
+    // for it to complete. Loads of distinct objects don't wait on
+    // each other, except for a stream waiting for its /Length
+    uint8_t expected = DelayedLoadPending;
+    while (!state.compare_exchange_strong(expected, DelayedLoadInProgress,
+        std::memory_order_acquire, std::memory_order_acquire))
+    {
+        if (expected == DelayedLoadDone)
+            return;
+
+        // Waiting for a load in progress on the calling thread would never end
+        if (isLoadInProgress(state))
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Recursive loading of object {}", GetIndirectReference().ToString());
+
+        // NOTE: The waiter count and the state are accessed with
+        // sequential consistency, so either the loader sees the
+        // waiter or the waiter sees the load completed
+        document->m_LoadWaiterCount.fetch_add(1);
+        {
+            unique_lock<mutex> lock(document->m_LoadWaitMutex);
+            document->m_LoadWaitCond.wait(lock, [&state]() {
+                return state.load() != DelayedLoadInProgress;
+            });
+        }
+        document->m_LoadWaiterCount.fetch_sub(1);
+        expected = DelayedLoadPending;
+    }
+
+    // Notify the waiters also on failure, so one of them loads the object
+    LoadInProgress load{ &state, s_loadsInProgress };
+    s_loadsInProgress = &load;
+    auto complete = [&state, &load, document](uint8_t newState) {
+        s_loadsInProgress = load.Previous;
+        state.store(newState);
+        if (document->m_LoadWaiterCount.load() != 0)
+        {
+            // Wait for a waiter that is between its check and its wait
+            unique_lock<mutex> lock(document->m_LoadWaitMutex);
+            lock.unlock();
+            document->m_LoadWaitCond.notify_all();
+        }
+    };
+
+    try
+    {
+        delayedLoadImpl(stream);
+    }
+    catch (...)
+    {
+        // Let the object be loaded again
+        complete(DelayedLoadPending);
+        throw;
+    }
+
+    complete(DelayedLoadDone);
+}
+
+void PdfObject::delayedLoadImpl(bool stream) const
+{
+    auto& obj = const_cast<PdfObject&>(*this);
+    if (stream)
+    {
+        obj.DelayedLoadStreamImpl();
+    }
+    else
+    {
+        obj.DelayedLoadImpl();
+        obj.SetVariantOwner();
+    }
 }
 
 // TODO2: SetDirty only if the value to be added is different
@@ -382,27 +575,37 @@ void PdfObject::copyStreamFrom(const PdfObject& obj)
     // NOTE: Don't call rhs.DelayedLoad() here. It's implicitly
     // called in PdfVariant assignment or copy constructor
     obj.delayedLoadStream();
-    if (obj.m_Stream != nullptr)
+    auto objStream = obj.getStream();
+    if (objStream != nullptr)
     {
         auto& stream = getOrCreateStream();
-        stream = *obj.m_Stream;
+        stream = *objStream;
     }
 }
 
 void PdfObject::moveStreamFrom(PdfObject& obj)
 {
     obj.DelayedLoadStream();
-    m_Stream = std::move(obj.m_Stream);
+    if (obj.getStream() != nullptr)
+    {
+        auto& stream = getIndirectData().Stream;
+        stream = std::move(obj.m_IndirectData->Stream);
+        stream->m_Parent = this;
+    }
+    else
+    {
+        FreeStream();
+    }
 }
 
 void PdfObject::EnableDelayedLoading()
 {
-    m_IsDelayedLoadDone = false;
+    getIndirectData().DelayedLoadState = DelayedLoadPending;
 }
 
 void PdfObject::EnableDelayedLoadingStream()
 {
-    m_IsDelayedLoadStreamDone = false;
+    getIndirectData().DelayedLoadStreamState = DelayedLoadPending;
 }
 
 void PdfObject::DelayedLoadStreamImpl()
@@ -423,8 +626,6 @@ void PdfObject::Assign(const PdfObject& rhs)
 void PdfObject::SetParent(PdfDataContainer& parent)
 {
     m_Parent = &parent;
-    auto document = parent.GetObjectDocument();
-    SetDocument(document);
 }
 
 // NOTE: Don't copy parent document/container and indirect reference.
@@ -433,10 +634,13 @@ void PdfObject::assign(const PdfObject& rhs)
 {
     rhs.DelayedLoad();
     m_Variant = rhs.m_Variant;
-    m_IsDelayedLoadDone = true;
     SetVariantOwner();
     copyStreamFrom(rhs);
-    m_IsDelayedLoadStreamDone = true;
+    if (m_IndirectData != nullptr)
+    {
+        m_IndirectData->DelayedLoadState = DelayedLoadDone;
+        m_IndirectData->DelayedLoadStreamState = DelayedLoadDone;
+    }
 }
 
 // NOTE: Don't move parent document/container and indirect reference.
@@ -445,15 +649,18 @@ void PdfObject::moveFrom(PdfObject& rhs)
 {
     rhs.DelayedLoad();
     m_Variant = std::move(rhs.m_Variant);
-    m_IsDelayedLoadDone = true;
     SetVariantOwner();
     moveStreamFrom(rhs);
-    m_IsDelayedLoadStreamDone = true;
+    if (m_IndirectData != nullptr)
+    {
+        m_IndirectData->DelayedLoadState = DelayedLoadDone;
+        m_IndirectData->DelayedLoadStreamState = DelayedLoadDone;
+    }
 }
 
 void PdfObject::ResetDirty()
 {
-    PDFMM_ASSERT(m_IsDelayedLoadDone);
+    PDFMM_ASSERT(IsDelayedLoadDone());
     // Propagate new dirty state to subclasses
     switch (m_Variant.GetDataType())
     {
@@ -498,12 +705,13 @@ void PdfObject::SetDirty()
 
 void PdfObject::setDirty()
 {
-    m_IsDirty = true;
+    getIndirectData().IsDirty = true;
 }
 
 void PdfObject::resetDirty()
 {
-    m_IsDirty = false;
+    if (m_IndirectData != nullptr)
+        m_IndirectData->IsDirty = false;
 }
 
 PdfObject::operator const PdfVariant& () const
@@ -514,10 +722,11 @@ PdfObject::operator const PdfVariant& () const
 
 PdfDocument& PdfObject::MustGetDocument() const
 {
-    if (m_Document == nullptr)
+    auto document = GetDocument();
+    if (document == nullptr)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
-    return *m_Document;
+    return *document;
 }
 
 const PdfVariant& PdfObject::GetVariant() const
@@ -809,10 +1018,10 @@ bool PdfObject::IsReference() const
 
 bool PdfObject::operator<(const PdfObject& rhs) const
 {
-    if (m_Document != rhs.m_Document)
+    if (GetDocument() != rhs.GetDocument())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Can't compare objects with different parent document");
 
-    return m_IndirectReference < rhs.m_IndirectReference;
+    return GetIndirectReference() < rhs.GetIndirectReference();
 }
 
 bool PdfObject::operator==(const PdfObject& rhs) const
@@ -820,11 +1029,11 @@ bool PdfObject::operator==(const PdfObject& rhs) const
     if (this == &rhs)
         return true;
 
-    if (m_IndirectReference.IsIndirect())
+    if (IsIndirect())
     {
         // If lhs is indirect, just check document and reference
-        return m_Document == rhs.m_Document &&
-            m_IndirectReference == rhs.m_IndirectReference;
+        return GetDocument() == rhs.GetDocument() &&
+            GetIndirectReference() == rhs.GetIndirectReference();
     }
     else
     {
@@ -840,11 +1049,11 @@ bool PdfObject::operator!=(const PdfObject& rhs) const
     if (this != &rhs)
         return true;
 
-    if (m_IndirectReference.IsIndirect())
+    if (IsIndirect())
     {
         // If lhs is indirect, just check document and reference
-        return m_Document != rhs.m_Document ||
-            m_IndirectReference != rhs.m_IndirectReference;
+        return GetDocument() != rhs.GetDocument() ||
+            GetIndirectReference() != rhs.GetIndirectReference();
     }
     else
     {
@@ -866,3 +1075,14 @@ bool PdfObject::operator!=(const PdfVariant& rhs) const
     DelayedLoad();
     return m_Variant != rhs;
 }
+
+bool isLoadInProgress(const atomic<uint8_t>& state)
+{
+    for (auto load = s_loadsInProgress; load != nullptr; load = load->Previous)
+    {
+        if (load->State == &state)
+            return true;
+    }
+
+    return false;
+}
@@ -7,6 +7,8 @@
 #ifndef PDF_OBJECT_H
 #define PDF_OBJECT_H
 
+#include <atomic>
+
 #include "PdfVariant.h"
 #include "PdfObjectStream.h"
 
@@ -41,6 +43,7 @@ class PDFMM_API PdfObject
     friend class PdfDataContainer;
     friend class PdfObjectStreamParser;
     friend class PdfParser;
+    friend class PdfWriter;
 
 public:
     static PdfObject Null;
@@ -384,12 +387,12 @@ public:
      *  \returns true if the value is dirty and has been
      *                modified since construction
      */
-    inline bool IsDirty() const { return m_IsDirty; }
+    inline bool IsDirty() const { return m_IndirectData != nullptr && m_IndirectData->IsDirty; }
 
     /** Get the document of this object.
      *  \return the owner (if it wasn't changed anywhere, creator) of this object
      */
-    inline PdfDocument* GetDocument() const { return m_Document; }
+    PdfDocument* GetDocument() const;
 
     /** Get the document of this object.
      *  \return the owner (if it wasn't changed anywhere, creator) of this object
@@ -399,7 +402,7 @@ public:
     /** Get an indirect reference to this object.
      *  \returns a PdfReference pointing to this object.
      */
-    inline const PdfReference& GetIndirectReference() const { return m_IndirectReference; }
+    const PdfReference& GetIndirectReference() const;
 
     inline const PdfDataContainer* GetParent() const { return m_Parent; }
 
@@ -408,7 +411,19 @@ public:
      * and loading has completed. External callers should never need to
      * see this, it's an internal state flag only.
      */
-    inline bool IsDelayedLoadDone() const { return m_IsDelayedLoadDone; }
+    inline bool IsDelayedLoadDone() const
+    {
+        return m_IndirectData == nullptr || m_IndirectData->DelayedLoadState == DelayedLoadDone;
+    }
+
+    /**
+     * Returns true if delayed loading of the stream is disabled, or if
+     * it is enabled and loading has completed. It's an internal state flag
+     */
+    inline bool IsDelayedLoadStreamDone() const
+    {
+        return m_IndirectData == nullptr || m_IndirectData->DelayedLoadStreamState == DelayedLoadDone;
+    }
 
     const PdfObjectStream* GetStream() const;
     PdfObjectStream* GetStream();
@@ -469,13 +484,19 @@ protected:
 
     PdfObjectStream* getStream();
 
+    const PdfObjectStream* getStream() const;
+
     void DelayedLoadStream() const;
 
     void delayedLoadStream() const;
 
+    void delayedLoad(std::atomic<uint8_t>& state, bool stream) const;
+
+    void delayedLoadImpl(bool stream) const;
+
     void EnableDelayedLoadingStream();
 
-    inline void SetIndirectReference(const PdfReference& reference) { m_IndirectReference = reference; }
+    inline void SetIndirectReference(const PdfReference& reference) { getIndirectData().Reference = reference; }
 
     /** Flag the object  incompletely loaded.  DelayedLoad() will be called
      *  when any method that requires more information than is currently
@@ -512,23 +533,61 @@ private:
 
     void moveStreamFrom(PdfObject& obj);
 
+    /** Test if the stream must be flate compressed when writing
+     *  the object, loading the stream if needed
+     */
+    bool isStreamFlateCompressible(PdfWriteFlags writeMode) const;
+
+    /** Flate compress the stream into the stream of another object,
+     *  with the compression level requested by the stream or the write flags.
+     *  Distinct objects with loaded streams can be compressed concurrently
+     */
+    void flateCompressStream(PdfObject& compressed, PdfWriteFlags writeMode) const;
+
+    /** Replace the stream with the one compressed by flateCompressStream()
+     */
+    void moveCompressedStreamFrom(PdfObject& compressed);
+
     // Shared initialization between all the ctors
     void initObject();
 
+    struct IndirectData;
+
+    /** Get the indirect object state, creating it if needed
+     */
+    IndirectData& getIndirectData();
+
 protected:
     PdfVariant m_Variant;
 
 private:
-    PdfReference m_IndirectReference;
-    PdfDocument* m_Document;
-    PdfDataContainer* m_Parent;
-    bool m_IsDirty; // Indicates if this object was modified after construction
+    // Delayed load states
+    enum : uint8_t
+    {
+        DelayedLoadPending,
+        DelayedLoadInProgress,
+        DelayedLoadDone,
+    };
 
-    mutable bool m_IsDelayedLoadDone;
-    mutable bool m_IsDelayedLoadStreamDone;
-    std::unique_ptr<PdfObjectStream> m_Stream;
-    // Tracks whether deferred loading is still pending (in which case it'll be
-    // false). If true, deferred loading is not required or has been completed.
+    /** The state of indirect objects, of objects owned directly by a document
+     *  (eg. the trailer) and of objects with a stream. It's kept aside so
+     *  direct objects, such as array elements and dictionary values, only pay
+     *  for the variant and the parent. Direct objects get the document from
+     *  their parent container
+     */
+    struct IndirectData
+    {
+        PdfReference Reference;
+        PdfDocument* Document = nullptr;
+        bool IsDirty = false;   // Indicates if this object was modified after construction
+        std::atomic<uint8_t> DelayedLoadState { DelayedLoadDone };
+        std::atomic<uint8_t> DelayedLoadStreamState { DelayedLoadDone };
+        std::unique_ptr<PdfObjectStream> Stream;
+    };
+
+private:
+    PdfDataContainer* m_Parent;
+    std::unique_ptr<IndirectData> m_IndirectData;
 };
 
     /** Templatized object type getter helper
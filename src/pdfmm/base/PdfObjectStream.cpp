@@ -20,11 +20,17 @@ using namespace mm;
 constexpr PdfFilterType DefaultFilter = PdfFilterType::FlateDecode;
 static const PdfName DecodeParmsKey("DecodeParms");
 
+// Highest decoded/encoded size ratio trusted when pre-sizing buffers, as
+// achievable by flate, used to not allocate for bogus /DL values
+constexpr size_t MaxDecodeRatio = 1032;
+
 static bool isMediaFilter(PdfFilterType filterType);
 static PdfFilterList stripMediaFilters(const PdfFilterList& filters, PdfFilterList& mediaFilters);
+static size_t getDecodedSizeHint(PdfFilterType filterType, size_t encodedSize);
 
 PdfObjectStream::PdfObjectStream(PdfObject& parent, std::unique_ptr<PdfObjectStreamProvider>&& provider)
-    : m_Parent(&parent), m_Provider(std::move(provider)), m_locked(false)
+    : m_Parent(&parent), m_Provider(std::move(provider)), m_locked(false),
+    m_CompressionLevel(PdfCompressionLevel::Default), m_readerCount(0)
 {
     m_Provider->Init(parent);
 }
@@ -34,42 +40,89 @@ PdfObjectStream::~PdfObjectStream() { }
 PdfObjectOutputStream PdfObjectStream::GetOutputStreamRaw(bool append)
 {
     ensureClosed();
+    ensureDataLoaded();
     return PdfObjectOutputStream(*this, PdfFilterList(), append);
 }
 
 PdfObjectOutputStream PdfObjectStream::GetOutputStream(bool append)
 {
     ensureClosed();
+    ensureDataLoaded();
     return PdfObjectOutputStream(*this, { DefaultFilter }, append);
 }
 
 PdfObjectOutputStream PdfObjectStream::GetOutputStream(const PdfFilterList& filters, bool append)
 {
     ensureClosed();
+    ensureDataLoaded();
     return PdfObjectOutputStream(*this, PdfFilterList(filters), append);
 }
 
 PdfObjectInputStream PdfObjectStream::GetInputStream(bool raw) const
 {
-    ensureClosed();
+    ensureNotWriting();
+    ensureDataLoaded();
     return PdfObjectInputStream(const_cast<PdfObjectStream&>(*this), raw);
 }
 
 void PdfObjectStream::CopyTo(charbuff& buffer, bool raw) const
 {
-    buffer.clear();
-    BufferStreamDevice stream(buffer);
-    CopyTo(stream, raw);
+    ensureDataLoaded();
+    auto cache = raw ? nullptr : getDecodedStreamCache();
+    if (cache != nullptr && cache->TryGet(m_Parent->GetIndirectReference(), buffer))
+        return;
+
+    if (!tryDecodeTo(buffer, raw, false))
+    {
+        buffer.clear();
+        BufferStreamDevice stream(buffer);
+        copyTo(stream, raw);
+    }
+
+    if (cache != nullptr)
+        cache->Add(m_Parent->GetIndirectReference(), buffer);
 }
 
 void PdfObjectStream::CopyToSafe(charbuff& buffer) const
 {
+    ensureDataLoaded();
+    if (tryDecodeTo(buffer, false, true))
+        return;
+
     buffer.clear();
     BufferStreamDevice stream(buffer);
     CopyToSafe(stream);
 }
 
 void PdfObjectStream::CopyTo(OutputStream& stream, bool raw) const
+{
+    ensureDataLoaded();
+    if (!raw)
+    {
+        charbuff buffer;
+        bool decoded;
+        if (getDecodedStreamCache() == nullptr)
+        {
+            decoded = tryDecodeTo(buffer, false, false);
+        }
+        else
+        {
+            CopyTo(buffer, false);
+            decoded = true;
+        }
+
+        if (decoded)
+        {
+            stream.Write(buffer);
+            stream.Flush();
+            return;
+        }
+    }
+
+    copyTo(stream, raw);
+}
+
+void PdfObjectStream::copyTo(OutputStream& stream, bool raw) const
 {
     PdfFilterList mediaFilters;
     vector<const PdfDictionary*> decodeParms;
@@ -83,6 +136,15 @@ void PdfObjectStream::CopyTo(OutputStream& stream, bool raw) const
 
 void PdfObjectStream::CopyToSafe(OutputStream& stream) const
 {
+    ensureDataLoaded();
+    charbuff buffer;
+    if (tryDecodeTo(buffer, false, true))
+    {
+        stream.Write(buffer);
+        stream.Flush();
+        return;
+    }
+
     PdfFilterList mediaFilters;
     vector<const PdfDictionary*> decodeParms;
     auto inputStream = const_cast<PdfObjectStream&>(*this).getInputStream(false, mediaFilters, decodeParms);
@@ -93,16 +155,14 @@ void PdfObjectStream::CopyToSafe(OutputStream& stream) const
 charbuff PdfObjectStream::GetCopy(bool raw) const
 {
     charbuff ret;
-    StringStreamDevice stream(ret);
-    CopyTo(stream, raw);
+    CopyTo(ret, raw);
     return ret;
 }
 
 charbuff PdfObjectStream::GetCopySafe() const
 {
     charbuff ret;
-    StringStreamDevice stream(ret);
-    CopyToSafe(stream);
+    CopyToSafe(ret);
     return ret;
 }
 
@@ -195,17 +255,20 @@ void PdfObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt& encr
 
 size_t PdfObjectStream::GetLength() const
 {
+    ensureDataLoaded();
     return m_Provider->GetLength();
 }
 
 void PdfObjectStream::MoveFrom(PdfObjectStream& rhs)
 {
     ensureClosed();
+    ensureDataLoaded();
+    rhs.ensureDataLoaded();
     if (!m_Provider->TryMoveFrom(std::move(*rhs.m_Provider)))
     {
         auto stream = rhs.GetInputStream(true);
         this->SetData(stream, true);
-        m_Provider->Clear();
+        rhs.m_Provider->Clear();
     }
 
     // Fix the /Filter and /DecodeParms keys for
@@ -235,11 +298,16 @@ void PdfObjectStream::MoveFrom(PdfObjectStream& rhs)
     }
 
     m_Filters = std::move(rhs.m_Filters);
+    m_CompressionLevel = rhs.m_CompressionLevel;
+    invalidateDecodedStreamCache();
+    rhs.invalidateDecodedStreamCache();
 }
 
 void PdfObjectStream::CopyFrom(const PdfObjectStream& rhs)
 {
     ensureClosed();
+    ensureDataLoaded();
+    rhs.ensureDataLoaded();
     if (!m_Provider->TryCopyFrom(*rhs.m_Provider))
     {
         auto stream = rhs.GetInputStream(true);
@@ -262,6 +330,8 @@ void PdfObjectStream::CopyFrom(const PdfObjectStream& rhs)
         lhsDict.AddKey(DecodeParmsKey, *decodeParms);
 
     m_Filters = rhs.m_Filters;
+    m_CompressionLevel = rhs.m_CompressionLevel;
+    invalidateDecodedStreamCache();
 }
 
 void PdfObjectStream::SetData(const bufferview& buffer, bool raw)
@@ -305,31 +375,8 @@ unique_ptr<InputStream> PdfObjectStream::getInputStream(bool raw, PdfFilterList&
     }
     else
     {
-        vector<const PdfDictionary*> decodeParms(m_Filters.size());
-        auto decodeParmsObj = m_Parent->GetDictionary().FindKey(DecodeParmsKey);
-        if (decodeParmsObj != nullptr)
-        {
-            const PdfDictionary* decodeParmsDict;
-            const PdfArray* decodeParmsArr;
-            if (decodeParmsObj->TryGetDictionary(decodeParmsDict))
-            {
-                std::fill(decodeParms.begin(), decodeParms.end(), decodeParmsDict);
-            }
-            else if (decodeParmsObj->TryGetArray(decodeParmsArr))
-            {
-                for (unsigned i = 0; i < decodeParmsArr->GetSize(); i++)
-                {
-                    auto decodeParmsEntry = decodeParmsArr->FindAt(i);
-                    if (decodeParmsEntry == nullptr || !decodeParmsEntry->TryGetDictionary(decodeParmsDict))
-                        continue;
-
-                    decodeParms[i] = decodeParmsDict;
-                }
-            }
-            // Else ignore it
-            // TODO: Warning
-        }
-
+        vector<const PdfDictionary*> decodeParms;
+        getDecodeParms(decodeParms);
         auto nonMediaFilters = stripMediaFilters(m_Filters, mediaFilters);
         if (mediaFilters.size() != 0)
         {
@@ -350,8 +397,96 @@ unique_ptr<InputStream> PdfObjectStream::getInputStream(bool raw, PdfFilterList&
     }
 }
 
+void PdfObjectStream::getDecodeParms(vector<const PdfDictionary*>& decodeParms) const
+{
+    decodeParms.assign(m_Filters.size(), nullptr);
+    auto decodeParmsObj = m_Parent->GetDictionary().FindKey(DecodeParmsKey);
+    if (decodeParmsObj == nullptr)
+        return;
+
+    const PdfDictionary* decodeParmsDict;
+    const PdfArray* decodeParmsArr;
+    if (decodeParmsObj->TryGetDictionary(decodeParmsDict))
+    {
+        std::fill(decodeParms.begin(), decodeParms.end(), decodeParmsDict);
+    }
+    else if (decodeParmsObj->TryGetArray(decodeParmsArr))
+    {
+        for (unsigned i = 0; i < decodeParmsArr->GetSize(); i++)
+        {
+            auto decodeParmsEntry = decodeParmsArr->FindAt(i);
+            if (decodeParmsEntry == nullptr || !decodeParmsEntry->TryGetDictionary(decodeParmsDict))
+                continue;
+
+            decodeParms[i] = decodeParmsDict;
+        }
+    }
+    // Else ignore it
+    // TODO: Warning
+}
+
+bool PdfObjectStream::tryDecodeTo(charbuff& buffer, bool raw, bool safe) const
+{
+    // Streams held in memory are decoded with one call per
+    // filter on the whole data, avoiding the chunked decoding
+    bufferview span;
+    if (m_locked || !m_Provider->TryGetSpan(span))
+        return false;
+
+    if (raw || m_Filters.size() == 0)
+    {
+        buffer.assign(span.data(), span.size());
+        return true;
+    }
+
+    PdfFilterList mediaFilters;
+    auto filters = stripMediaFilters(m_Filters, mediaFilters);
+    if (mediaFilters.size() != 0 && !safe)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFilter, "Unsupported expansion with media filters. Use GetInputStream(true) instead");
+
+    if (filters.size() == 0)
+    {
+        buffer.assign(span.data(), span.size());
+        return true;
+    }
+
+    vector<const PdfDictionary*> decodeParms;
+    getDecodeParms(decodeParms);
+
+    // The /DL key is a hint for the size of the fully decoded data
+    int64_t decodedLength = -1;
+    if (mediaFilters.size() == 0)
+        decodedLength = m_Parent->GetDictionary().FindKeyAs<int64_t>("DL", -1);
+
+    charbuff input;
+    bufferview view = span;
+    for (unsigned i = 0; i < filters.size(); i++)
+    {
+        auto filter = PdfFilterFactory::Create(filters[i]);
+        if (filter == nullptr)
+            PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
+
+        size_t sizeHint = getDecodedSizeHint(filters[i], view.size());
+        if (i == filters.size() - 1 && decodedLength >= 0
+            && (uint64_t)decodedLength <= (uint64_t)view.size() * MaxDecodeRatio)
+        {
+            sizeHint = (size_t)decodedLength;
+        }
+
+        charbuff output;
+        output.reserve(sizeHint);
+        filter->DecodeTo(output, view, decodeParms[i]);
+        input = std::move(output);
+        view = input;
+    }
+
+    buffer = std::move(input);
+    return true;
+}
+
 void PdfObjectStream::setData(InputStream& stream, PdfFilterList filters, ssize_t size, bool markObjectDirty)
 {
+    ensureDataLoaded();
     if (markObjectDirty)
     {
         // We must make sure the parent will be set dirty. All methods
@@ -373,9 +508,65 @@ void PdfObjectStream::InitData(InputStream& stream, size_t size, PdfFilterList&&
     m_Filters = std::move(filterList);
 }
 
+void PdfObjectStream::InitData(const bufferview& buffer, PdfFilterList&& filterList)
+{
+    if (!m_Provider->TryBorrowData(buffer))
+    {
+        SpanStreamDevice stream(buffer);
+        InitData(stream, buffer.size(), std::move(filterList));
+        return;
+    }
+
+    m_Filters = std::move(filterList);
+}
+
+PdfDecodedStreamCache* PdfObjectStream::getDecodedStreamCache() const
+{
+    // Only filtered streams of indirect objects are cached, since
+    // copying unfiltered data is not more expensive than a lookup
+    auto document = m_Parent->GetDocument();
+    if (document == nullptr || m_Filters.size() == 0 || !m_Parent->IsIndirect())
+        return nullptr;
+
+    auto& cache = document->GetDecodedStreamCache();
+    if (!cache.IsEnabled())
+        return nullptr;
+
+    return &cache;
+}
+
+void PdfObjectStream::invalidateDecodedStreamCache()
+{
+    auto document = m_Parent->GetDocument();
+    if (document == nullptr || !m_Parent->IsIndirect())
+        return;
+
+    auto& cache = document->GetDecodedStreamCache();
+    if (cache.IsEnabled())
+        cache.Invalidate(m_Parent->GetIndirectReference());
+}
+
+void PdfObjectStream::freeData()
+{
+    // NOTE: Keep the provider, callers may hold a reference to it
+    m_Provider->Clear();
+}
+
+void PdfObjectStream::ensureDataLoaded() const
+{
+    // The data may have been released to fit
+    // the object memory budget of the document
+    m_Parent->DelayedLoadStream();
+}
+
 void PdfObjectStream::ensureClosed() const
 {
-    PDFMM_RAISE_LOGIC_IF(m_locked, "The stream should have no read/write operations in progress");
+    PDFMM_RAISE_LOGIC_IF(m_locked || m_readerCount.load() != 0, "The stream should have no read/write operations in progress");
+}
+
+void PdfObjectStream::ensureNotWriting() const
+{
+    PDFMM_RAISE_LOGIC_IF(m_locked, "The stream should have no write operations in progress");
 }
 
 PdfObjectInputStream::PdfObjectInputStream()
@@ -384,10 +575,11 @@ PdfObjectInputStream::PdfObjectInputStream()
 PdfObjectInputStream::~PdfObjectInputStream()
 {
     if (m_stream != nullptr)
-        m_stream->m_locked = false;
+        m_stream->m_readerCount--;
 }
 
 PdfObjectInputStream::PdfObjectInputStream(PdfObjectInputStream&& rhs) noexcept
+    : m_input(std::move(rhs.m_input)), m_MediaFilters(std::move(rhs.m_MediaFilters))
 {
     utls::move(rhs.m_stream, m_stream);
     utls::move(rhs.m_MediaDecodeParms, m_MediaDecodeParms);
@@ -396,8 +588,16 @@ PdfObjectInputStream::PdfObjectInputStream(PdfObjectInputStream&& rhs) noexcept
 PdfObjectInputStream::PdfObjectInputStream(PdfObjectStream& stream, bool raw)
     : m_stream(&stream)
 {
-    m_stream->m_locked = true;
-    m_input = stream.getInputStream(raw, m_MediaFilters, m_MediaDecodeParms);
+    m_stream->m_readerCount++;
+    try
+    {
+        m_input = stream.getInputStream(raw, m_MediaFilters, m_MediaDecodeParms);
+    }
+    catch (...)
+    {
+        m_stream->m_readerCount--;
+        throw;
+    }
 }
 
 size_t PdfObjectInputStream::readBuffer(char* buffer, size_t size, bool& eof)
@@ -412,7 +612,13 @@ bool PdfObjectInputStream::readChar(char& ch)
 
 PdfObjectInputStream& PdfObjectInputStream::operator=(PdfObjectInputStream&& rhs) noexcept
 {
+    if (m_stream != nullptr)
+        m_stream->m_readerCount--;
+
     utls::move(rhs.m_stream, m_stream);
+    m_input = std::move(rhs.m_input);
+    m_MediaFilters = std::move(rhs.m_MediaFilters);
+    utls::move(rhs.m_MediaDecodeParms, m_MediaDecodeParms);
     return *this;
 }
 
@@ -488,6 +694,9 @@ PdfObjectOutputStream::PdfObjectOutputStream(PdfObjectStream& stream,
     if (append)
         stream.CopyTo(buffer);
 
+    // The decoded data is going to be rewritten
+    stream.invalidateDecodedStreamCache();
+
     if (m_filters.has_value())
     {
         auto& filters = *m_filters;
@@ -498,7 +707,8 @@ PdfObjectOutputStream::PdfObjectOutputStream(PdfObjectStream& stream,
         else
         {
             m_output = PdfFilterFactory::CreateEncodeStream(
-                stream.m_Provider->GetOutputStream(stream.GetParent()), filters);
+                stream.m_Provider->GetOutputStream(stream.GetParent()), filters,
+                stream.m_CompressionLevel);
         }
     }
     else
@@ -537,6 +747,18 @@ bool PdfObjectStreamProvider::IsLengthHandled() const
     return false;
 }
 
+bool PdfObjectStreamProvider::TryBorrowData(const bufferview& buffer)
+{
+    (void)buffer;
+    return false;
+}
+
+bool PdfObjectStreamProvider::TryGetSpan(bufferview& span) const
+{
+    (void)span;
+    return false;
+}
+
 // Strip media filters from regular ones
 PdfFilterList stripMediaFilters(const PdfFilterList& filters, PdfFilterList& mediaFilters)
 {
@@ -560,6 +782,25 @@ PdfFilterList stripMediaFilters(const PdfFilterList& filters, PdfFilterList& med
     return ret;
 }
 
+size_t getDecodedSizeHint(PdfFilterType filterType, size_t encodedSize)
+{
+    switch (filterType)
+    {
+        case PdfFilterType::ASCIIHexDecode:
+            return encodedSize / 2 + 1;
+        case PdfFilterType::ASCII85Decode:
+            return encodedSize / 5 * 4 + 4;
+        case PdfFilterType::LZWDecode:
+        case PdfFilterType::FlateDecode:
+            // Typical compression ratio of content streams
+            return encodedSize * 4;
+        case PdfFilterType::RunLengthDecode:
+            return encodedSize * 2;
+        default:
+            return encodedSize;
+    }
+}
+
 bool isMediaFilter(PdfFilterType filterType)
 {
     switch (filterType)
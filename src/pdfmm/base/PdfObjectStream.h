@@ -9,6 +9,8 @@
 
 #include "PdfDeclarations.h"
 
+#include <atomic>
+
 #include "PdfFilter.h"
 #include "PdfEncrypt.h"
 #include "PdfOutputStream.h"
@@ -19,8 +21,9 @@ namespace mm {
 
 class PdfObject;
 class PdfObjectStream;
+class PdfDecodedStreamCache;
 
-class PdfObjectInputStream : public InputStream
+class PDFMM_API PdfObjectInputStream : public InputStream
 {
     friend class PdfObjectStream;
 public:
@@ -44,7 +47,7 @@ private:
     std::vector<const PdfDictionary*> m_MediaDecodeParms;
 };
 
-class PdfObjectOutputStream : public OutputStream
+class PDFMM_API PdfObjectOutputStream : public OutputStream
 {
     friend class PdfObjectStream;
 public:
@@ -182,6 +185,15 @@ public:
 
     const PdfFilterList& GetFilters() { return m_Filters; }
 
+    /** Set the compression level used when flate encoding data
+     *  written to this stream, including the compression applied
+     *  when saving the document, which takes precedence over the
+     *  level requested with PdfSaveOptions
+     */
+    void SetCompressionLevel(PdfCompressionLevel level) { m_CompressionLevel = level; }
+
+    PdfCompressionLevel GetCompressionLevel() const { return m_CompressionLevel; }
+
     /** Create a copy of a PdfObjectStream object
      *  \param rhs the object to clone
      *  \returns a reference to this object
@@ -190,7 +202,7 @@ public:
 
     PdfObjectStream& operator=(PdfObjectStream&& rhs) noexcept;
 
-    const PdfObjectStreamProvider& GetProvider() const { return *m_Provider; }
+    const PdfObjectStreamProvider& GetProvider() const { ensureDataLoaded(); return *m_Provider; }
 
 private:
     /** Write the stream to an output device
@@ -203,6 +215,12 @@ private:
 
     void InitData(InputStream& stream, size_t len, PdfFilterList&& filterList);
 
+    /** Init the stream data borrowing the given buffer, if
+     * supported by the provider, or copying it otherwise.
+     * The buffer must outlive the stream
+     */
+    void InitData(const bufferview& buffer, PdfFilterList&& filterList);
+
     /** Copy data and non data fields from rhs
      */
     void CopyFrom(const PdfObjectStream& rhs);
@@ -214,11 +232,31 @@ private:
     PdfObjectStreamProvider& GetProvider() { return *m_Provider; }
 
 private:
+    /** Release the data, which is read again on demand
+     * by the parent parsed object
+     */
+    void freeData();
+
+    void ensureDataLoaded() const;
+
     void ensureClosed() const;
+    void ensureNotWriting() const;
 
     std::unique_ptr<InputStream> getInputStream(bool raw, PdfFilterList& mediaFilters,
         std::vector<const PdfDictionary*>& decodeParms);
 
+    void getDecodeParms(std::vector<const PdfDictionary*>& decodeParms) const;
+
+    // Decode the whole data at once if it's held in memory,
+    // returns false if the streamed decoding must be used
+    bool tryDecodeTo(charbuff& buffer, bool raw, bool safe) const;
+
+    void copyTo(OutputStream& stream, bool raw) const;
+
+    PdfDecodedStreamCache* getDecodedStreamCache() const;
+
+    void invalidateDecodedStreamCache();
+
     void setData(InputStream& stream, PdfFilterList filters, ssize_t size, bool markObjectDirty);
 
 private:
@@ -228,7 +266,11 @@ private:
     PdfObject* m_Parent;
     std::unique_ptr<PdfObjectStreamProvider> m_Provider;
     PdfFilterList m_Filters;
-    bool m_locked;
+    bool m_locked;  // A write operation is in progress
+    PdfCompressionLevel m_CompressionLevel;
+    // Number of input streams in progress. Multiple
+    // readers are allowed at the same time
+    mutable std::atomic<unsigned> m_readerCount;
 };
 
 };
@@ -28,6 +28,25 @@ PdfObjectStreamParser::PdfObjectStreamParser(PdfParserObject& parser,
 }
 
 void PdfObjectStreamParser::Parse(const cspan<int64_t>& objectList)
+{
+    vector<unique_ptr<PdfObject>> objects;
+    try
+    {
+        Parse(objectList, objects);
+    }
+    catch (...)
+    {
+        for (auto& obj : objects)
+            m_Objects->PushObject(obj.release());
+
+        throw;
+    }
+
+    for (auto& obj : objects)
+        m_Objects->PushObject(obj.release());
+}
+
+void PdfObjectStreamParser::Parse(const cspan<int64_t>& objectList, vector<unique_ptr<PdfObject>>& objects)
 {
     int64_t num = m_Parser->GetDictionary().FindKeyAs<int64_t>("N", 0);
     int64_t first = m_Parser->GetDictionary().FindKeyAs<int64_t>("First", 0);
@@ -35,12 +54,12 @@ void PdfObjectStreamParser::Parse(const cspan<int64_t>& objectList)
     charbuff buffer;
     m_Parser->GetOrCreateStream().CopyTo(buffer);
 
-    this->readObjectsFromStream(buffer.data(), buffer.size(), num, first, objectList);
+    this->readObjectsFromStream(buffer.data(), buffer.size(), num, first, objectList, objects);
     m_Parser = nullptr;
 }
 
 void PdfObjectStreamParser::readObjectsFromStream(char* buffer, size_t bufferLen,
-    int64_t num, int64_t first, const cspan<int64_t>& objectList)
+    int64_t num, int64_t first, const cspan<int64_t>& objectList, vector<unique_ptr<PdfObject>>& objects)
 {
     SpanStreamDevice device(buffer, bufferLen);
     PdfTokenizer tokenizer(m_buffer);
@@ -77,9 +96,9 @@ void PdfObjectStreamParser::readObjectsFromStream(char* buffer, size_t bufferLen
             // The generation number of an object stream and of any
             // compressed object is implicitly zero
             PdfReference reference(static_cast<uint32_t>(objNo), 0);
-            auto obj = new PdfObject(std::move(var));
+            unique_ptr<PdfObject> obj(new PdfObject(std::move(var)));
             obj->SetIndirectReference(reference);
-            m_Objects->PushObject(obj);
+            objects.push_back(std::move(obj));
         }
 
         // move back to the position inside of the table of contents
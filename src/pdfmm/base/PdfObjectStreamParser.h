@@ -38,8 +38,18 @@ public:
 
     void Parse(const cspan<int64_t>& objectList);
 
+    /** Parse the object stream without adding the read objects
+     * to the object list. This is safe to be called concurrently
+     * on different object streams, as long the stream objects
+     * are fully loaded and each parser has its own buffer
+     * \param objects the read objects are appended here, also
+     *     if parsing fails
+     */
+    void Parse(const cspan<int64_t>& objectList, std::vector<std::unique_ptr<PdfObject>>& objects);
+
 private:
-    void readObjectsFromStream(char* buffer, size_t lBufferLen, int64_t lNum, int64_t lFirst, const cspan<int64_t>& list);
+    void readObjectsFromStream(char* buffer, size_t lBufferLen, int64_t lNum, int64_t lFirst,
+        const cspan<int64_t>& list, std::vector<std::unique_ptr<PdfObject>>& objects);
 
 private:
     PdfParserObject* m_Parser;
@@ -39,6 +39,18 @@ public:
     virtual size_t GetLength() const = 0;
 
     virtual bool IsLengthHandled() const;
+
+    /** Try to set the stream data to a view of externally owned
+     * memory, without copying it. The memory must outlive the provider
+     * \remarks default implementation returns false
+     */
+    virtual bool TryBorrowData(const bufferview& buffer);
+
+    /** Try to get a view of the whole stream data, when it's
+     * held in memory. The view is valid until the data is modified
+     * \remarks default implementation returns false
+     */
+    virtual bool TryGetSpan(bufferview& span) const;
 };
 
 };
@@ -19,7 +19,7 @@ using namespace std;
 using namespace mm;
 
 static int normalize(int value, int start, int end);
-static PdfResources* getResources(PdfObject& obj, const deque<PdfObject*>& listOfParents);
+static PdfObject* findResources(PdfObject& obj, const deque<PdfObject*>& listOfParents);
 
 PdfPage::PdfPage(PdfDocument& parent, unsigned index, const PdfRect& size) :
     PdfDictionaryElement(parent, "Page"),
@@ -31,10 +31,13 @@ PdfPage::PdfPage(PdfDocument& parent, unsigned index, const PdfRect& size) :
 }
 
 PdfPage::PdfPage(PdfObject& obj, unsigned index, const deque<PdfObject*>& listOfParents) :
+    PdfPage(obj, index, findResources(obj, listOfParents)) { }
+
+PdfPage::PdfPage(PdfObject& obj, unsigned index, PdfObject* resources) :
     PdfDictionaryElement(obj),
     m_Index(index),
     m_Contents(nullptr),
-    m_Resources(::getResources(obj, listOfParents)),
+    m_Resources(resources == nullptr ? nullptr : new PdfResources(*resources)),
     m_Annotations(*this)
 {
     PdfObject* contents = obj.GetDictionary().FindKey("Contents");
@@ -510,18 +513,20 @@ int normalize(int value, int start, int end)
     return offsetValue - (offsetValue / width) * width + start;
 }
 
-PdfResources* getResources(PdfObject& obj, const deque<PdfObject*>& listOfParents)
+PdfObject* findResources(PdfObject& obj, const deque<PdfObject*>& listOfParents)
 {
     auto resources = obj.GetDictionary().FindKey("Resources");
-    if (resources == nullptr)
+    if (resources != nullptr)
+        return resources;
+
+    // Resources might be inherited: the nearest
+    // parent defining them takes precedence
+    for (auto it = listOfParents.rbegin(); it != listOfParents.rend(); it++)
     {
-        // Resources might be inherited
-        for (auto& parent : listOfParents)
-            resources = parent->GetDictionary().FindKey("Resources");
+        resources = (*it)->GetDictionary().FindKey("Resources");
+        if (resources != nullptr)
+            return resources;
     }
 
-    if (resources == nullptr)
-        return nullptr;
-
-    return new PdfResources(*resources);
+    return nullptr;
 }
@@ -65,6 +65,13 @@ private:
      */
     PdfPage(PdfObject& obj, unsigned index, const std::deque<PdfObject*>& listOfParents);
 
+    /** Create a PdfPage based on an existing PdfObject
+     *  \param obj an existing PdfObject
+     *  \param resources the /Resources dictionary of the page,
+     *                   possibly inherited from a parent, or nullptr
+     */
+    PdfPage(PdfObject& obj, unsigned index, PdfObject* resources);
+
 public:
     void ExtractTextTo(std::vector<PdfTextEntry>& entries,
         const PdfTextExtractParams& params) const;
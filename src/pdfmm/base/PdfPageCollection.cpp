@@ -59,6 +59,10 @@ const PdfPage& PdfPageCollection::GetPageAt(unsigned index) const
 
 PdfPage& PdfPageCollection::getPage(unsigned index)
 {
+    // Pages may be concurrently retrieved by readers,
+    // see PdfDocument read-only concurrency contract
+    lock_guard<mutex> lock(m_cacheMutex);
+
     // Take a look into the cache first
     auto page = m_cache.GetPage(index);
     if (page != nullptr)
@@ -230,6 +234,127 @@ void PdfPageCollection::RemovePageAt(unsigned atIndex)
     GetDocument().GetCatalog().GetDictionary().RemoveKey("OpenAction");
 }
 
+PdfPageCollection::iterator PdfPageCollection::begin()
+{
+    return iterator(*this);
+}
+
+PdfPageCollection::iterator PdfPageCollection::end()
+{
+    return iterator();
+}
+
+PdfPageCollection::const_iterator PdfPageCollection::begin() const
+{
+    return const_iterator(const_cast<PdfPageCollection&>(*this));
+}
+
+PdfPageCollection::const_iterator PdfPageCollection::end() const
+{
+    return const_iterator();
+}
+
+void PdfPageCollection::walkBegin(WalkState& state)
+{
+    auto& root = GetRoot();
+    auto kidsObj = root.GetDictionary().FindKey("Kids");
+    if (kidsObj == nullptr || !kidsObj->IsArray())
+        return;
+
+    state.Nodes.push_back({ &root, &kidsObj->GetArray(), root.GetDictionary().FindKey("Resources"), 0 });
+    state.PageIndex = 0;
+    walkNext(state);
+}
+
+void PdfPageCollection::walkNext(WalkState& state)
+{
+    if (state.Page != nullptr)
+    {
+        state.Page = nullptr;
+        state.TransientPage = nullptr;
+        state.PageIndex++;
+    }
+
+    auto& objects = GetRoot().GetDocument()->GetObjects();
+    while (state.Nodes.size() != 0)
+    {
+        auto& node = state.Nodes.back();
+        if (node.KidIndex == node.Kids->GetSize())
+        {
+            state.Nodes.pop_back();
+            continue;
+        }
+
+        auto& child = (*node.Kids)[node.KidIndex];
+        node.KidIndex++;
+        if (!child.IsReference())
+        {
+            mm::LogMessage(PdfLogSeverity::Error, "Invalid datatype in kids array: {}",
+                child.GetDataTypeString());
+            continue;
+        }
+
+        PdfObject* childObj = objects.GetObject(child.GetReference());
+        if (childObj == nullptr)
+        {
+            mm::LogMessage(PdfLogSeverity::Error, "Child not found: {}",
+                child.GetReference().ToString());
+            continue;
+        }
+
+        if (this->isTypePage(*childObj))
+        {
+            // Prefer the cached page, if any
+            PdfPage* page;
+            {
+                lock_guard<mutex> lock(m_cacheMutex);
+                page = m_cache.GetPage(state.PageIndex);
+            }
+
+            if (page == nullptr || &page->GetObject() != childObj)
+            {
+                state.TransientPage.reset(new PdfPage(*childObj, state.PageIndex, node.Resources));
+                page = state.TransientPage.get();
+            }
+
+            state.Page = page;
+            return;
+        }
+
+        if (!this->isTypePages(*childObj))
+        {
+            mm::LogMessage(PdfLogSeverity::Error,
+                "Invalid datatype referenced in kids array: {}. "
+                "Reference to invalid object: {}",
+                childObj->GetDataTypeString(), childObj->GetIndirectReference().ToString());
+            continue;
+        }
+
+        for (auto& walkNode : state.Nodes)
+        {
+            if (walkNode.Object == childObj)
+            {
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::PageNotFound,
+                    "Cycle in page tree: child in /Kids array of object {} back-references "
+                    "to object {} one of whose descendants the former is",
+                    node.Object->GetIndirectReference().ToString(),
+                    childObj->GetIndirectReference().ToString());
+            }
+        }
+
+        auto kidsObj = childObj->GetDictionary().FindKey("Kids");
+        if (kidsObj == nullptr || !kidsObj->IsArray())
+            continue;
+
+        // Resources not defined by the node are inherited from the parent
+        auto resources = childObj->GetDictionary().FindKey("Resources");
+        if (resources == nullptr)
+            resources = node.Resources;
+
+        state.Nodes.push_back({ childObj, &kidsObj->GetArray(), resources, 0 });
+    }
+}
+
 PdfObject* PdfPageCollection::getPageNode(unsigned index, PdfObject& parent,
     PdfObjectList& parents)
 {
@@ -252,88 +377,146 @@ PdfObject* PdfPageCollection::getPageNode(unsigned index, PdfObject& parent,
         return nullptr;
     }
 
-    // We have to traverse the tree
-    //
     // BEWARE: There is no valid shortcut for tree traversal.
     // Even if eKidsArray.size()==numKids, this does not imply that
     // eKidsArray can be accessed with the index of the page directly.
     // The tree could have an arbitrary complex structure because
     // internal nodes with no leaves (page objects) are not forbidden
-    // by the PDF spec.
-    for (auto& child : kidsArray)
+    // by the PDF spec. Locate instead the kid whose subtree contains
+    // the page with a binary search on the cumulative kids page counts
+    auto& counts = getKidsPageCounts(parent, kidsArray);
+    auto found = std::upper_bound(counts.begin(), counts.end(), index);
+    if (found == counts.end())
+    {
+        mm::LogMessage(PdfLogSeverity::Error, "Requesting page index {}. Page not found in kids array of {}",
+            index, parent.GetIndirectReference().ToString());
+        return nullptr;
+    }
+
+    unsigned kidIndex = (unsigned)(found - counts.begin());
+    unsigned kidPageCount = counts[kidIndex];
+    unsigned kidIndexBase = 0;
+    if (kidIndex != 0)
+    {
+        kidIndexBase = counts[kidIndex - 1];
+        kidPageCount -= kidIndexBase;
+    }
+
+    // The kid was already validated when computing the counts. Its
+    // /Count may have been edited directly since the counts were
+    // cached: in that case compute them again
+    PdfObject* childObj = GetRoot().GetDocument()->GetObjects().GetObject(kidsArray[kidIndex].GetReference());
+    if (childObj == nullptr
+        || kidPageCount != (this->isTypePages(*childObj) ? getChildCount(*childObj) : 1))
+    {
+        m_kidsPageCounts.erase(parent.GetIndirectReference());
+        return getPageNode(index, parent, parents);
+    }
+
+    index -= kidIndexBase;
+    parents.push_back(&parent);
+    if (this->isTypePage(*childObj))
+    {
+        // page found
+        return childObj;
+    }
+
+    // page is in the subtree of child
+    // => call GetPageNode() recursively
+    if (std::find(parents.begin(), parents.end(), childObj)
+        != parents.end()) // cycle in parent list detected, fend
+    { // off security vulnerability similar to CVE-2017-8054 (infinite recursion)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::PageNotFound,
+            "Cycle in page tree: child in /Kids array of object {} back-references "
+            "to object {} one of whose descendants the former is",
+            (*(parents.rbegin()))->GetIndirectReference().ToString(),
+            childObj->GetIndirectReference().ToString());
+    }
+
+    return this->getPageNode(index, *childObj, parents);
+}
+
+const vector<unsigned>& PdfPageCollection::getKidsPageCounts(const PdfObject& node, const PdfArray& kids)
+{
+    auto& ref = node.GetIndirectReference();
+    if (!ref.IsIndirect())
+    {
+        // Direct nodes can't be identified: just compute the counts,
+        // which are stored with the null reference key
+        auto& counts = m_kidsPageCounts[ref];
+        computeKidsPageCounts(kids, counts);
+        return counts;
+    }
+
+    // The counts are invalidated when the tree is modified through
+    // the collection. Check them also against the /Kids size and the
+    // node /Count, in case the tree was edited directly
+    auto found = m_kidsPageCounts.find(ref);
+    if (found != m_kidsPageCounts.end())
+    {
+        auto& counts = found->second;
+        if (counts.size() == kids.size()
+            && (counts.size() == 0 || counts.back() == getChildCount(node)))
+        {
+            return counts;
+        }
+
+        computeKidsPageCounts(kids, counts);
+        return counts;
+    }
+
+    vector<unsigned> counts;
+    computeKidsPageCounts(kids, counts);
+    return m_kidsPageCounts.emplace(ref, std::move(counts)).first->second;
+}
+
+void PdfPageCollection::computeKidsPageCounts(const PdfArray& kids, vector<unsigned>& counts)
+{
+    counts.clear();
+    counts.reserve(kids.size());
+    unsigned count = 0;
+    for (auto& child : kids)
     {
         if (!child.IsReference())
         {
-            mm::LogMessage(PdfLogSeverity::Error, "Requesting page index {}. Invalid datatype in kids array: {}",
-                index, child.GetDataTypeString());
-            return nullptr;
+            mm::LogMessage(PdfLogSeverity::Error, "Invalid datatype in kids array: {}",
+                child.GetDataTypeString());
+            break;
         }
 
         PdfObject* childObj = GetRoot().GetDocument()->GetObjects().GetObject(child.GetReference());
         if (childObj == nullptr)
         {
-            mm::LogMessage(PdfLogSeverity::Error, "Requesting page index {}. Child not found: {}",
-                index, child.GetReference().ToString());
-            return nullptr;
+            mm::LogMessage(PdfLogSeverity::Error, "Child not found: {}",
+                child.GetReference().ToString());
+            break;
         }
 
         if (this->isTypePages(*childObj))
         {
-            unsigned childCount = getChildCount(*childObj);
-            if (childCount < index + 1) // Pages are 0 based
-            {
-                // skip this page tree node
-                // and go to the next child in rKidsArray
-                index -= childCount;
-            }
-            else
-            {
-                // page is in the subtree of child
-                // => call GetPageNode() recursively
-
-                parents.push_back(&parent);
-
-                if (std::find(parents.begin(), parents.end(), childObj)
-                    != parents.end()) // cycle in parent list detected, fend
-                { // off security vulnerability similar to CVE-2017-8054 (infinite recursion)
-                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::PageNotFound,
-                        "Cycle in page tree: child in /Kids array of object {} back-references "
-                        "to object {} one of whose descendants the former is",
-                        (*(parents.rbegin()))->GetIndirectReference().ToString(),
-                        childObj->GetIndirectReference().ToString());
-                }
-
-                return this->getPageNode(index, *childObj, parents);
-            }
+            count += getChildCount(*childObj);
         }
         else if (this->isTypePage(*childObj))
         {
-            if (index == 0)
-            {
-                // page found
-                parents.push_back(&parent);
-                return childObj;
-            }
-
-            // Skip a normal page
-            if (index > 0)
-                index--;
+            count++;
         }
         else
         {
-            const PdfReference& rLogRef = childObj->GetIndirectReference();
-            uint32_t nLogObjNum = rLogRef.ObjectNumber();
-            uint16_t nLogGenNum = rLogRef.GenerationNumber();
             mm::LogMessage(PdfLogSeverity::Error,
-                "Requesting page index {}. "
                 "Invalid datatype referenced in kids array: {}. "
-                "Reference to invalid object: {} {} R", index,
-                childObj->GetDataTypeString(), nLogObjNum, nLogGenNum);
-            return nullptr;
+                "Reference to invalid object: {}",
+                childObj->GetDataTypeString(), childObj->GetIndirectReference().ToString());
+            break;
         }
+
+        counts.push_back(count);
     }
+}
 
-    return nullptr;
+void PdfPageCollection::invalidateKidsPageCounts(const PdfObjectList& nodes)
+{
+    for (auto node : nodes)
+        m_kidsPageCounts.erase(node->GetIndirectReference());
 }
 
 bool PdfPageCollection::isTypePage(const PdfObject& obj) const
@@ -422,7 +605,7 @@ void PdfPageCollection::insertPagesIntoNode(PdfObject& parent, const PdfObjectLi
     }
 
     parent.GetDictionary().AddKey("Kids", newKids);
-
+    invalidateKidsPageCounts(parents);
 
     // 2. increase count
     for (PdfObjectList::const_reverse_iterator itParents = parents.rbegin(); itParents != parents.rend(); itParents++)
@@ -444,8 +627,10 @@ void PdfPageCollection::deletePageFromNode(PdfObject& parent, const PdfObjectLis
 
     // TODO: Tell cache to free page object
 
-    // 1. Delete reference
+    // 1. Delete reference. The counts of all the parents
+    // change, including the nodes that may be removed
     this->deletePageNode(parent, index);
+    invalidateKidsPageCounts(parents);
 
     // 2. Decrease count
     PdfObjectList::const_reverse_iterator itParents = parents.rbegin();
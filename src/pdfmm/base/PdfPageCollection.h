@@ -9,6 +9,9 @@
 
 #include "PdfDeclarations.h"
 
+#include <mutex>
+#include <unordered_map>
+
 #include "PdfElement.h"
 #include "PdfArray.h"
 #include "PdfPageTreeCache.h"
@@ -118,6 +121,97 @@ public:
      */
     void RemovePageAt(unsigned atIndex);
 
+private:
+    struct WalkNode
+    {
+        PdfObject* Object;
+        const PdfArray* Kids;
+        PdfObject* Resources;
+        unsigned KidIndex;
+    };
+
+    struct WalkState
+    {
+        std::vector<WalkNode> Nodes;
+        unsigned PageIndex = 0;
+        PdfPage* Page = nullptr;
+        std::shared_ptr<PdfPage> TransientPage;
+    };
+
+public:
+    /** Forward iterator over the pages of the tree
+     *
+     * The pages are enumerated with a single depth-first walk of the
+     * /Pages tree, resolving inherited attributes incrementally. Pages
+     * already cached by the collection are returned as is, the others
+     * are created on the fly without being cached: they are owned by the
+     * iterator and stay valid as long as a copy of it points to them.
+     * Modifying the pages tree invalidates all the iterators
+     */
+    template <typename TPage>
+    class Iterator final
+    {
+        friend class PdfPageCollection;
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = TPage;
+        using pointer = TPage*;
+        using reference = TPage&;
+        using iterator_category = std::forward_iterator_tag;
+    public:
+        Iterator() : m_pages(nullptr) { }
+    private:
+        Iterator(PdfPageCollection& pages) : m_pages(&pages)
+        {
+            pages.walkBegin(m_state);
+        }
+    public:
+        Iterator(const Iterator&) = default;
+        Iterator& operator=(const Iterator&) = default;
+        bool operator==(const Iterator& rhs) const
+        {
+            if (m_state.Page == nullptr || rhs.m_state.Page == nullptr)
+                return m_state.Page == rhs.m_state.Page;
+
+            return m_pages == rhs.m_pages && m_state.PageIndex == rhs.m_state.PageIndex;
+        }
+        bool operator!=(const Iterator& rhs) const
+        {
+            return !(*this == rhs);
+        }
+        Iterator& operator++()
+        {
+            m_pages->walkNext(m_state);
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            auto copy = *this;
+            m_pages->walkNext(m_state);
+            return copy;
+        }
+        reference operator*() const
+        {
+            return *m_state.Page;
+        }
+        pointer operator->() const
+        {
+            return m_state.Page;
+        }
+    private:
+        PdfPageCollection* m_pages;
+        WalkState m_state;
+    };
+
+    using iterator = Iterator<PdfPage>;
+    using const_iterator = Iterator<const PdfPage>;
+
+public:
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
 private:
     /**
      * Insert page at the given index
@@ -140,6 +234,24 @@ private:
 
     PdfObject* getPageNode(unsigned index, PdfObject& parent, PdfObjectList& parents);
 
+    /**
+     * Get the cumulative page counts of the kids of a pages node,
+     * used to locate the kid containing a page with a binary search.
+     * The counts stop before the first invalid kid. The counts of
+     * indirect nodes are cached by reference, and computed again when
+     * they don't match the /Kids size or the node /Count anymore
+     */
+    const std::vector<unsigned>& getKidsPageCounts(const PdfObject& node, const PdfArray& kids);
+
+    void computeKidsPageCounts(const PdfArray& kids, std::vector<unsigned>& counts);
+
+    /** Invalidate the cached kids page counts of the given nodes
+     */
+    void invalidateKidsPageCounts(const PdfObjectList& nodes);
+
+    void walkBegin(WalkState& state);
+    void walkNext(WalkState& state);
+
     unsigned getChildCount(const PdfObject& nodeObj) const;
 
     /**
@@ -214,6 +326,10 @@ private:
 
 private:
     PdfPageTreeCache m_cache;
+    // Guards concurrent lookup and creation of pages in the cache
+    std::mutex m_cacheMutex;
+    // Cumulative kids page counts, keyed by pages node reference
+    std::unordered_map<PdfReference, std::vector<unsigned>> m_kidsPageCounts;
 };
 
 };
@@ -14,6 +14,9 @@ namespace mm {
 /**
  *  This class implements a cache infront of a PdfPageTree
  *
+ *  The cache itself is not synchronized: PdfPageCollection serializes
+ *  page lookups so pages can be retrieved concurrently by readers
+ *
  *  \see PdfCachedPagesTree
  */
 class PDFMM_API PdfPageTreeCache final
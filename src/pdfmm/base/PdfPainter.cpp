@@ -36,19 +36,6 @@ constexpr double ARC_MAGIC = 0.552284749;
 
 string expandTabs(const string_view& str, unsigned tabWidth, unsigned nTabCnt);
 
-inline bool IsNewLineChar(char32_t ch)
-{
-    return ch == U'\n' || ch == U'\r';
-}
-
-inline bool IsSpaceChar(char32_t ch)
-{
-    if (ch > 255)
-        return false;
-
-    return std::isspace((int)ch) != 0;
-}
-
 PdfPainter::PdfPainter(PdfPainterFlags flags) :
     m_flags(flags),
     m_stream(nullptr),
@@ -575,7 +562,9 @@ void PdfPainter::drawMultiLineText(const std::string_view& str, double x, double
 
     auto expanded = this->expandTabs(str);
 
-    vector<string> lines = getMultiLineTextAsLines(expanded, width, skipSpaces);
+    // Ignore glyph mapping failures
+    (void)font.TryLayoutText(expanded, m_TextState, width, m_textLayout, skipSpaces);
+    auto& lines = m_textLayout.Lines;
     double dLineGap = font.GetLineSpacing(m_TextState) - font.GetAscent(m_TextState) + font.GetDescent(m_TextState);
     // Do vertical alignment
     switch (vAlignment)
@@ -593,184 +582,30 @@ void PdfPainter::drawMultiLineText(const std::string_view& str, double x, double
 
     y -= (font.GetAscent(m_TextState) + dLineGap / (2.0));
 
-    vector<string>::const_iterator it = lines.begin();
-    while (it != lines.end())
-    {
-        if (it->length() != 0)
-            this->drawTextAligned(*it, x, y, width, hAlignment);
-
-        y -= font.GetLineSpacing(m_TextState);
-        it++;
-    }
-    this->Restore();
-}
-
-// FIX-ME/CLEAN-ME: The following was found
-// in this deprecable state while cleaning the code
-vector<string> PdfPainter::getMultiLineTextAsLines(const string_view& str, double width, bool skipSpaces)
-{
-    // FIX-ME: This method is currently broken, just rewrite it later
-    vector<string> ret = { (string)str };
-    return ret;
-
-    if (width <= 0.0) // nonsense arguments
-        return vector<string>();
-
-    if (str.length() == 0) // empty string
-        return vector<string>(1, (string)str);
-
-    auto& font = *m_TextState.Font;
-    const char* const stringBegin = str.data();
-    const char* lineBegin = stringBegin;
-    const char* currentCharacter = stringBegin;
-    const char* startOfCurrentWord = stringBegin;
-    bool startOfWord = true;
-    double curWidthOfLine = 0.0;
-    vector<string> lines;
-
-    // do simple word wrapping
-    while (*currentCharacter)
+    for (auto& line : lines)
     {
-        if (IsNewLineChar(*currentCharacter)) // hard-break!
+        if (line.Length != 0)
         {
-            lines.push_back(string(lineBegin, (size_t)(currentCharacter - lineBegin)));
-
-            lineBegin = currentCharacter + 1; // skip the line feed
-            startOfWord = true;
-            curWidthOfLine = 0.0;
-        }
-        else if (IsSpaceChar(*currentCharacter))
-        {
-            if (curWidthOfLine > width)
+            double lineX = x;
+            switch (hAlignment)
             {
-                // The previous word does not fit in the current line.
-                // -> Move it to the next one.
-                if (startOfCurrentWord > lineBegin)
-                {
-                    lines.push_back(string(lineBegin, (size_t)(startOfCurrentWord - lineBegin)));
-                }
-                else
-                {
-                    lines.push_back(string(lineBegin, (size_t)(currentCharacter - lineBegin)));
-                    if (skipSpaces)
-                    {
-                        // Skip all spaces at the end of the line
-                        while (IsSpaceChar(*(currentCharacter + 1)))
-                            currentCharacter++;
-
-                        startOfCurrentWord = currentCharacter + 1;
-                    }
-                    else
-                    {
-                        startOfCurrentWord = currentCharacter;
-                    }
-                    startOfWord = true;
-                }
-                lineBegin = startOfCurrentWord;
-
-                if (!startOfWord)
-                {
-                    curWidthOfLine = font.GetStringLength(
-                        { startOfCurrentWord, (size_t)(currentCharacter - startOfCurrentWord) },
-                        m_TextState);
-                }
-                else
-                {
-                    curWidthOfLine = 0.0;
-                }
-            }
-            ////else if( ( dCurWidthOfLine + font.GetCharWidth( *currentCharacter, m_textState) ) > width )
-            {
-                lines.push_back(string(lineBegin, (size_t)(currentCharacter - lineBegin)));
-                if (skipSpaces)
-                {
-                    // Skip all spaces at the end of the line
-                    while (IsSpaceChar(*(currentCharacter + 1)))
-                        currentCharacter++;
-
-                    startOfCurrentWord = currentCharacter + 1;
-                }
-                else
-                {
-                    startOfCurrentWord = currentCharacter;
-                }
-                lineBegin = startOfCurrentWord;
-                startOfWord = true;
-                curWidthOfLine = 0.0;
-            }
-            ////else
-            {
-                ////    dCurWidthOfLine += font.GetCharWidth( *currentCharacter, m_textState);
+                default:
+                case PdfHorizontalAlignment::Left:
+                    break;
+                case PdfHorizontalAlignment::Center:
+                    lineX += (width - line.Width) / 2.0;
+                    break;
+                case PdfHorizontalAlignment::Right:
+                    lineX += (width - line.Width);
+                    break;
             }
 
-            startOfWord = true;
+            this->drawText(string_view(expanded).substr(line.Offset, line.Length), lineX, y, false, false);
         }
-        else
-        {
-            if (startOfWord)
-            {
-                startOfCurrentWord = currentCharacter;
-                startOfWord = false;
-            }
-            //else do nothing
 
-            ////if ((dCurWidthOfLine + font.GetCharWidth(*currentCharacter, m_textState)) > width)
-            {
-                if (lineBegin == startOfCurrentWord)
-                {
-                    // This word takes up the whole line.
-                    // Put as much as possible on this line.
-                    if (lineBegin == currentCharacter)
-                    {
-                        lines.push_back(string(currentCharacter, 1));
-                        lineBegin = currentCharacter + 1;
-                        startOfCurrentWord = currentCharacter + 1;
-                        curWidthOfLine = 0;
-                    }
-                    else
-                    {
-                        lines.push_back(string(lineBegin, (size_t)(currentCharacter - lineBegin)));
-                        lineBegin = currentCharacter;
-                        startOfCurrentWord = currentCharacter;
-                        ////dCurWidthOfLine = font.GetCharWidth(*currentCharacter, m_textState);
-                    }
-                }
-                else
-                {
-                    // The current word does not fit in the current line.
-                    // -> Move it to the next one.
-                    lines.push_back(string(lineBegin, (size_t)(startOfCurrentWord - lineBegin)));
-                    lineBegin = startOfCurrentWord;
-                    curWidthOfLine = font.GetStringLength({ startOfCurrentWord, (size_t)((currentCharacter - startOfCurrentWord) + 1) }, m_TextState);
-                }
-            }
-            ////else
-            {
-                ////    dCurWidthOfLine += font.GetCharWidth(*currentCharacter, m_textState);
-            }
-        }
-        currentCharacter++;
-    }
-
-    if ((currentCharacter - lineBegin) > 0)
-    {
-        if (curWidthOfLine > width && startOfCurrentWord > lineBegin)
-        {
-            // The previous word does not fit in the current line.
-            // -> Move it to the next one.
-            lines.push_back(string(lineBegin, (size_t)(startOfCurrentWord - lineBegin)));
-            lineBegin = startOfCurrentWord;
-        }
-        //else do nothing
-
-        if (currentCharacter - lineBegin > 0)
-        {
-            lines.push_back(string(lineBegin, (size_t)(currentCharacter - lineBegin)));
-        }
-        //else do nothing
+        y -= font.GetLineSpacing(m_TextState);
     }
-
-    return lines;
+    this->Restore();
 }
 
 void PdfPainter::drawTextAligned(const std::string_view& str, double x, double y, double width, PdfHorizontalAlignment hAlignment)
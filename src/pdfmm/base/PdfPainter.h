@@ -12,6 +12,7 @@
 #include "PdfRect.h"
 #include "PdfColor.h"
 #include "PdfCanvas.h"
+#include "PdfFont.h"
 #include "PdfTextState.h"
 #include "PdfGraphicsState.h"
 #include "PdfStringStream.h"
@@ -681,14 +682,6 @@ private:
     void setTextRenderingMode(PdfTextRenderingMode value);
 
 private:
-    /** Gets the text divided into individual lines, using the current font and clipping rectangle.
-     *
-     *  \param str the text which should be drawn
-     *  \param width width of the text area
-     *  \param skipSpaces whether the trailing whitespaces should be skipped, so that next line doesn't start with whitespace
-     */
-    std::vector<std::string> getMultiLineTextAsLines(const std::string_view& str, double width, bool skipSpaces);
-
     /** Coverts a rectangle to an array of points which can be used
      *  to draw an ellipse using 4 bezier curves.
      *
@@ -774,6 +767,10 @@ private:
      */
     PdfStringStream  m_tmpStream;
 
+    /** Layout of multi line texts, reused to avoid allocations
+     */
+    PdfTextLayout m_textLayout;
+
     // TODO: Next comment was found like this and it's is really bad.
     // Document the next fields accurately, possibly moving them
     // to a structure
@@ -9,6 +9,7 @@
 
 #include "PdfArray.h"
 #include "PdfDictionary.h"
+#include "PdfDocument.h"
 #include "PdfEncrypt.h"
 #include "PdfInputDevice.h"
 #include "PdfMemoryObjectStream.h"
@@ -17,8 +18,12 @@
 #include "PdfObjectStream.h"
 #include "PdfVariant.h"
 #include "PdfXRefStreamParserObject.h"
+#include "PdfStreamDevice.h"
 
 #include <algorithm>
+#include <atomic>
+
+#include <pdfmm/private/ParallelUtils.h>
 
 constexpr unsigned PDF_VERSION_LENGHT = 3;
 constexpr unsigned PDF_MAGIC_LENGHT = 8;
@@ -39,7 +44,8 @@ PdfParser::PdfParser(PdfIndirectObjectList& objects) :
     m_buffer(std::make_shared<charbuff>(PdfTokenizer::BufferSize)),
     m_tokenizer(m_buffer, true),
     m_Objects(&objects),
-    m_StrictParsing(false)
+    m_StrictParsing(false),
+    m_LoadThreadCount(1)
 {
     this->Reset();
 }
@@ -706,6 +712,9 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
                                 }
                             }
 
+                            // When loading on demand the device must outlive
+                            // the objects, so stream data and strings can be borrowed
+                            obj->SetBorrowSourceData(m_LoadOnDemand);
                             m_Objects->PushObject(obj.release());
                         }
                         catch (PdfError& e)
@@ -778,20 +787,38 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
         // robustly from all places which are either free or unparsed
     }
 
+    // Encryption objects are not safe to be used concurrently,
+    // so encrypted documents are always read serially. Objects
+    // memory is tracked by serial loads only, so the same
+    // applies when an object memory budget is set
+    unsigned threadCount = 1;
+    if (!m_LoadOnDemand && m_Encrypt == nullptr && !m_Objects->isObjectMemoryTracked())
+        threadCount = utls::GetThreadCount(m_LoadThreadCount);
+
+    if (threadCount > 1)
+        readObjectsParallel(device, threadCount);
+
     // all normal objects including object streams are available now,
     // we can parse the object streams safely now.
     //
     // Note that even if demand loading is enabled we still currently read all
     // objects from the stream into memory then free the stream.
     //
-    for (auto& pair : compressedObjects)
+    if (threadCount > 1)
     {
+        readCompressedObjectsParallel(compressedObjects, threadCount);
+    }
+    else
+    {
+        for (auto& pair : compressedObjects)
+        {
 #ifndef VERBOSE_DEBUG_DISABLED
-        if (m_LoadOnDemand)
-            cerr << "Demand loading on, but can't demand-load from object stream." << endl;
+            if (m_LoadOnDemand)
+                cerr << "Demand loading on, but can't demand-load from object stream." << endl;
 #endif
-        ReadCompressedObjectFromStream((uint32_t)pair.first, pair.second);
-        m_Objects->AddObjectStream((uint32_t)pair.first);
+            ReadCompressedObjectFromStream((uint32_t)pair.first, pair.second);
+            m_Objects->AddObjectStream((uint32_t)pair.first);
+        }
     }
 
     if (!m_LoadOnDemand)
@@ -802,8 +829,11 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
         // in a second pass, or (if demand loading is enabled) defer it for later.
         for (auto objToLoad : *m_Objects)
         {
+            // NOTE: Objects read from object streams are not parser
+            // objects and they are already fully loaded
             auto obj = dynamic_cast<PdfParserObject*>(objToLoad);
-            obj->ParseStream();
+            if (obj != nullptr)
+                obj->ParseStream();
         }
     }
 
@@ -831,6 +861,172 @@ void PdfParser::ReadCompressedObjectFromStream(uint32_t objNo, const cspan<int64
     parserObject.Parse(objectList);
 }
 
+void PdfParser::readObjectsParallel(InputStreamDevice& device, unsigned threadCount)
+{
+    vector<PdfParserObject*> objects;
+    objects.reserve(m_Objects->GetSize());
+    for (auto obj : *m_Objects)
+    {
+        auto parserObj = dynamic_cast<PdfParserObject*>(obj);
+        if (parserObj != nullptr)
+            objects.push_back(parserObj);
+    }
+
+    // Every worker uses an independent cursor over the source contents:
+    // use the device backing memory, if exposed, or read it in memory
+    charbuff buffer;
+    bufferview source;
+    if (!device.TryGetSpan(source))
+    {
+        buffer.resize(device.GetLength());
+        device.Seek(0);
+        device.Read(buffer.data(), buffer.size());
+        source = buffer;
+    }
+
+    // Objects are loaded in concurrent read mode, so they are
+    // synchronized individually instead of serializing all the
+    // workers on the document load mutex
+    auto& document = m_Objects->GetDocument();
+    bool concurrentReadMode = document.IsConcurrentReadMode();
+    document.SetConcurrentReadMode(true);
+
+    // NOTE: Workers temporarily replace the device of the objects
+    // they read, which is restored after all of them completed
+    auto restoreState = [&]() {
+        for (auto obj : objects)
+            obj->m_device = &device;
+
+        document.SetConcurrentReadMode(concurrentReadMode);
+    };
+
+    atomic<bool> failed(false);
+    try
+    {
+        // First read the objects. Errors are not handled here: broken
+        // objects are left unloaded and they will be read again by the
+        // following serial steps, which are responsible to handle them
+        utls::ParallelFor(objects.size(), threadCount, [&](size_t begin, size_t end, unsigned) {
+            SpanStreamDevice cursor(source.data(), source.size());
+            for (size_t i = begin; i < end; i++)
+            {
+                auto obj = objects[i];
+                obj->m_device = &cursor;
+                try
+                {
+                    obj->DelayedLoad();
+                }
+                catch (PdfError&)
+                {
+                    failed = true;
+                }
+            }
+        });
+
+        // Streams can be read only after all the objects have been read,
+        // since the /Length key may reference another object. If some
+        // objects couldn't be read, resolving the reference could trigger
+        // a concurrent load, so leave the streams to serial loading
+        if (!failed)
+        {
+            utls::ParallelFor(objects.size(), threadCount, [&](size_t begin, size_t end, unsigned) {
+                SpanStreamDevice cursor(source.data(), source.size());
+                for (size_t i = begin; i < end; i++)
+                {
+                    auto obj = objects[i];
+                    obj->m_device = &cursor;
+                    try
+                    {
+                        obj->DelayedLoadStream();
+                    }
+                    catch (PdfError&)
+                    {
+                        // The /Length key may reference an object in an object
+                        // stream that is not loaded yet. Drop what may have been
+                        // read: the stream will be read again serially
+                        obj->FreeStream();
+                    }
+                }
+            });
+        }
+    }
+    catch (...)
+    {
+        restoreState();
+        throw;
+    }
+
+    restoreState();
+}
+
+void PdfParser::readCompressedObjectsParallel(const map<int64_t, vector<int64_t>>& compressedObjects,
+    unsigned threadCount)
+{
+    struct ObjectStreamTask
+    {
+        uint32_t ObjectNumber;
+        const vector<int64_t>* ObjectList;
+        PdfParserObject* StreamObject;
+        vector<unique_ptr<PdfObject>> Objects;
+        exception_ptr Exception;
+    };
+
+    vector<ObjectStreamTask> tasks;
+    tasks.reserve(compressedObjects.size());
+    for (auto& pair : compressedObjects)
+    {
+        ObjectStreamTask task{ (uint32_t)pair.first, &pair.second, nullptr, { }, nullptr };
+        task.StreamObject = dynamic_cast<PdfParserObject*>(m_Objects->GetObject(PdfReference(task.ObjectNumber, 0)));
+        if (task.StreamObject != nullptr)
+        {
+            // Ensure the object stream is fully loaded in memory, as
+            // concurrent reads of the source device are not allowed
+            task.StreamObject->ParseStream();
+        }
+        tasks.push_back(std::move(task));
+    }
+
+    utls::ParallelFor(tasks.size(), threadCount, [&](size_t begin, size_t end, unsigned) {
+        auto buffer = std::make_shared<charbuff>(PdfTokenizer::BufferSize);
+        for (size_t i = begin; i < end; i++)
+        {
+            auto& task = tasks[i];
+            if (task.StreamObject == nullptr)
+                continue;
+
+            try
+            {
+                PdfObjectStreamParser parserObject(*task.StreamObject, *m_Objects, buffer);
+                parserObject.Parse(*task.ObjectList, task.Objects);
+            }
+            catch (...)
+            {
+                task.Exception = current_exception();
+            }
+        }
+    });
+
+    // Merge the read objects in the same order of serial loading
+    for (auto& task : tasks)
+    {
+        if (task.StreamObject == nullptr)
+        {
+            if (m_IgnoreBrokenObjects)
+                mm::LogMessage(PdfLogSeverity::Error, "Loading of object {} 0 R failed!", task.ObjectNumber);
+            else
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Loading of object {} 0 R failed!", task.ObjectNumber);
+        }
+
+        for (auto& obj : task.Objects)
+            m_Objects->PushObject(obj.release());
+
+        if (task.Exception != nullptr)
+            rethrow_exception(task.Exception);
+
+        m_Objects->AddObjectStream(task.ObjectNumber);
+    }
+}
+
 void PdfParser::FindTokenBackward(InputStreamDevice& device, const char* token, size_t range)
 {
     // Offset read position to the EOF marker if it is not the last thing in the file
@@ -176,6 +176,29 @@ public:
      */
     inline void SetIgnoreBrokenObjects(bool broken) { m_IgnoreBrokenObjects = broken; }
 
+    /**
+     * \returns the number of threads used to read objects
+     *     when load on demand is disabled
+     *
+     * \see SetLoadThreadCount
+     */
+    inline unsigned GetLoadThreadCount() const { return m_LoadThreadCount; }
+
+    /**
+     * Set the number of threads used to read objects when load on
+     * demand is disabled. Objects (and their streams) are read from
+     * independent cursors over the source data, and objects from
+     * object streams are parsed concurrently as well. The resulting
+     * object list is identical to the one obtained with serial loading.
+     * Encrypted documents are always read serially.
+     *
+     * Default is 1, meaning objects are read serially.
+     *
+     * \param threadCount the number of threads to use. 0 means
+     *     to use the hardware concurrency
+     */
+    inline void SetLoadThreadCount(unsigned threadCount) { m_LoadThreadCount = threadCount; }
+
     inline size_t GetXRefOffset() const { return m_XRefOffset; }
 
     inline bool HasXRefStream() const { return m_HasXRefStream; }
@@ -285,6 +308,17 @@ private:
      */
     void ReadCompressedObjectFromStream(uint32_t objNo, const cspan<int64_t>& objectList);
 
+    /** Read concurrently all the objects pushed so far, and their streams,
+     *  so the following serial loading steps will find them already loaded
+     */
+    void readObjectsParallel(InputStreamDevice& device, unsigned threadCount);
+
+    /** Read concurrently all the compressed objects from the object streams
+     *  and push them in the objects list in the same order of serial loading
+     */
+    void readCompressedObjectsParallel(const std::map<int64_t, std::vector<int64_t>>& compressedObjects,
+        unsigned threadCount);
+
     /** Checks the magic number at the start of the pdf file
      *  and sets the m_PdfVersion member to the correct version
      *  of the pdf file.
@@ -349,6 +383,7 @@ private:
 
     bool m_StrictParsing;
     bool m_IgnoreBrokenObjects;
+    unsigned m_LoadThreadCount;
 
     unsigned m_IncrementalUpdateCount;
 
@@ -15,6 +15,8 @@
 #include "PdfInputStream.h"
 #include "PdfParser.h"
 #include "PdfObjectStream.h"
+#include "PdfMemoryObjectStream.h"
+#include "PdfStreamDevice.h"
 #include "PdfVariant.h"
 
 using namespace mm;
@@ -41,6 +43,7 @@ PdfParserObject::PdfParserObject(PdfDocument* doc, const PdfReference& indirectR
     m_device(&device),
     m_Encrypt(nullptr),
     m_IsTrailer(false),
+    m_BorrowSourceData(false),
     m_Offset(offset < 0 ? device.GetPosition() : offset),
     m_HasStream(false),
     m_StreamOffset(0)
@@ -70,24 +73,39 @@ void PdfParserObject::ParseStream()
 
 void PdfParserObject::DelayedLoadImpl()
 {
-    PdfTokenizer tokenizer;
-    m_device->Seek(m_Offset);
-    if (!m_IsTrailer)
-        checkReference(tokenizer);
+    auto load = [&](InputStreamDevice& device) {
+        PdfTokenizer tokenizer;
+        tokenizer.m_borrowStrings = m_BorrowSourceData;
+        device.Seek(m_Offset);
+        if (!m_IsTrailer)
+            checkReference(device, tokenizer);
+
+        parse(device, tokenizer);
+    };
 
-    Parse(tokenizer);
+    bufferview span;
+    if (tryGetSourceSpan(span))
+    {
+        SpanStreamDevice device(span);
+        load(device);
+    }
+    else
+    {
+        auto lock = lockDevice();
+        load(*m_device);
+    }
 }
 
 void PdfParserObject::DelayedLoadStreamImpl()
 {
-    PDFMM_ASSERT(getStream() == nullptr);
-
+    // NOTE: The stream may already exist when its data
+    // was released to fit the object memory budget
     // Note: we can't use HasStream() here because it'll call DelayedLoad()
     if (HasStreamToParse())
     {
         try
         {
-            parseStream();
+            trackStreamLoad();
         }
         catch (PdfError& e)
         {
@@ -99,16 +117,106 @@ void PdfParserObject::DelayedLoadStreamImpl()
     }
 }
 
+void PdfParserObject::trackStreamLoad()
+{
+    auto document = GetDocument();
+    if (document == nullptr || m_IsTrailer || !IsIndirect()
+        || !document->GetObjects().isObjectMemoryTracked())
+    {
+        (void)parseStream();
+        return;
+    }
+
+    auto& objects = document->GetObjects();
+    objects.beginObjectLoad();
+    size_t size;
+    try
+    {
+        size = parseStream();
+    }
+    catch (...)
+    {
+        objects.endObjectLoad();
+        throw;
+    }
+
+    objects.endObjectLoad(GetIndirectReference(), size);
+}
+
+void PdfParserObject::detachSourceDevice()
+{
+    if (m_device == nullptr)
+        return;
+
+    DelayedLoad();
+    DelayedLoadStream();
+    PdfIndirectObjectList::materializeStrings(*this);
+    const PdfObjectStream* stream = getStream();
+    if (stream != nullptr)
+    {
+        auto provider = dynamic_cast<const PdfMemoryObjectStream*>(&stream->GetProvider());
+        if (provider != nullptr && provider->IsBorrowed())
+            (void)provider->GetBuffer();
+    }
+
+    m_BorrowSourceData = false;
+    m_device = nullptr;
+}
+
+bool PdfParserObject::tryFreeStreamData()
+{
+    auto stream = getStream();
+    if (stream == nullptr)
+        return true;
+
+    // The data can't be read again without the device
+    if (m_device == nullptr)
+        return false;
+
+    if (stream->m_locked || stream->m_readerCount.load() != 0)
+        return false;
+
+    // Keep the stream instance, so references to it stay
+    // valid, and read the data again when it's accessed
+    stream->freeData();
+    EnableDelayedLoadingStream();
+    return true;
+}
+
+bool PdfParserObject::tryGetSourceSpan(bufferview& span) const
+{
+    // NOTE: Encryption engines are not thread safe, hence
+    // encrypted objects are always read serially
+    auto document = GetDocument();
+    return document != nullptr && document->IsConcurrentReadMode()
+        && m_Encrypt == nullptr && m_device->TryGetSpan(span);
+}
+
+unique_lock<recursive_mutex> PdfParserObject::lockDevice() const
+{
+    // The input device is shared between all the objects of the document
+    auto document = GetDocument();
+    if (document == nullptr)
+        return { };
+
+    return unique_lock<recursive_mutex>(document->m_LoadMutex);
+}
+
 PdfReference PdfParserObject::ReadReference(PdfTokenizer& tokenizer)
 {
     m_device->Seek(m_Offset);
-    return readReference(tokenizer);
+    return readReference(*m_device, tokenizer);
 }
 
 // Only called via the demand loading mechanism
 // Be very careful to avoid recursive demand loads via PdfVariant
 // or PdfObject method calls here.
 void PdfParserObject::Parse(PdfTokenizer& tokenizer)
+{
+    parse(*m_device, tokenizer);
+}
+
+void PdfParserObject::parse(InputStreamDevice& device, PdfTokenizer& tokenizer)
 {
     PdfStatefulEncrypt encrypt;
     if (m_Encrypt != nullptr)
@@ -121,18 +229,18 @@ void PdfParserObject::Parse(PdfTokenizer& tokenizer)
 
     PdfTokenType tokenType;
     string_view token;
-    bool gotToken = tokenizer.TryReadNextToken(*m_device, token, tokenType);
+    bool gotToken = tokenizer.TryReadNextToken(device, token, tokenType);
     if (!gotToken)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Expected variant");
 
     // Check if we have an empty object or data
     if (token != "endobj")
     {
-        tokenizer.ReadNextVariant(*m_device, token, tokenType, m_Variant, encrypt);
+        tokenizer.ReadNextVariant(device, token, tokenType, m_Variant, encrypt);
 
         if (!m_IsTrailer)
         {
-            bool gotToken = tokenizer.TryReadNextToken(*m_device, token);
+            bool gotToken = tokenizer.TryReadNextToken(device, token);
             if (!gotToken)
                 PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Expected 'endobj' or (if dict) 'stream', got EOF");
 
@@ -144,7 +252,7 @@ void PdfParserObject::Parse(PdfTokenizer& tokenizer)
             else if (m_Variant.IsDictionary() && token == "stream")
             {
                 m_HasStream = true;
-                m_StreamOffset = m_device->GetPosition(); // NOTE: whitespace after "stream" handle in stream parser!
+                m_StreamOffset = device.GetPosition(); // NOTE: whitespace after "stream" handle in stream parser!
             }
             else
             {
@@ -158,23 +266,57 @@ void PdfParserObject::Parse(PdfTokenizer& tokenizer)
 // Only called during delayed loading. Must be careful to avoid
 // triggering recursive delay loading due to use of accessors of
 // PdfVariant or PdfObject.
-void PdfParserObject::parseStream()
+size_t PdfParserObject::parseStream()
 {
     PDFMM_ASSERT(IsDelayedLoadDone());
 
+    // NOTE: Resolve everything needed from other objects before
+    // reading from the device, since loading them may use it too
     int64_t size = -1;
-    char ch;
-
     auto& lengthObj = this->m_Variant.GetDictionary().MustFindKey(PdfName::KeyLength);
     if (!lengthObj.TryGetNumber(size))
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidStreamLength);
 
-    m_device->Seek(m_StreamOffset);
+    if (m_Encrypt != nullptr && !m_Encrypt->IsMetadataEncrypted())
+    {
+        // If metadata is not encrypted the Filter is set to "Crypt"
+        auto filterObj = this->m_Variant.GetDictionary().FindKey(PdfName::KeyFilter);
+        if (filterObj != nullptr && filterObj->IsArray())
+        {
+            auto& filters = filterObj->GetArray();
+            for (unsigned i = 0; i < filters.GetSize(); i++)
+            {
+                auto& obj = filters.MustFindAt(i);
+                if (obj.IsName() && obj.GetName() == "Crypt")
+                    m_Encrypt = nullptr;
+            }
+        }
+    }
+
+    auto filters = PdfFilterFactory::CreateFilterList(*this);
+
+    bufferview span;
+    if (tryGetSourceSpan(span))
+    {
+        SpanStreamDevice device(span);
+        return readStream(device, size, std::move(filters));
+    }
+    else
+    {
+        auto lock = lockDevice();
+        return readStream(*m_device, size, std::move(filters));
+    }
+}
+
+size_t PdfParserObject::readStream(InputStreamDevice& device, int64_t size, PdfFilterList&& filters)
+{
+    char ch;
+    device.Seek(m_StreamOffset);
 
     size_t streamOffset;
     while (true)
     {
-        if (!m_device->Peek(ch))
+        if (!device.Peek(ch))
             PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Unexpected EOF when reading stream");
 
         switch (ch)
@@ -184,7 +326,7 @@ void PdfParserObject::parseStream()
             // but certain PDFs have additionals whitespaces
             case ' ':
             case '\t':
-                (void)m_device->ReadChar();
+                (void)device.ReadChar();
                 break;
             // From PDF 32000:2008 7.3.8.1 General
             // "The keyword stream that follows the stream dictionary shall be
@@ -192,61 +334,59 @@ void PdfParserObject::parseStream()
             // RETURN and a LINE FEED or just a LINE FEED, and not by a CARRIAGE
             // RETURN alone"
             case '\r':
-                streamOffset = m_device->GetPosition();
-                (void)m_device->ReadChar();
-                if (!m_device->Peek(ch))
+                streamOffset = device.GetPosition();
+                (void)device.ReadChar();
+                if (!device.Peek(ch))
                     PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Unexpected EOF when reading stream");
 
                 if (ch == '\n')
                 {
-                    (void)m_device->ReadChar();
-                    streamOffset = m_device->GetPosition();
+                    (void)device.ReadChar();
+                    streamOffset = device.GetPosition();
                 }
                 goto ReadStream;
             case '\n':
-                (void)m_device->ReadChar();
-                streamOffset = m_device->GetPosition();
+                (void)device.ReadChar();
+                streamOffset = device.GetPosition();
                 goto ReadStream;
             // Assume malformed PDF with no whitespaces after the stream keyword
             default:
-                streamOffset = m_device->GetPosition();
+                streamOffset = device.GetPosition();
                 goto ReadStream;
         }
     }
 
 ReadStream:
-    m_device->Seek(streamOffset);	// reset it before reading!
-    if (m_Encrypt != nullptr && !m_Encrypt->IsMetadataEncrypted())
-    {
-        // If metadata is not encrypted the Filter is set to "Crypt"
-        auto filterObj = this->m_Variant.GetDictionary().FindKey(PdfName::KeyFilter);
-        if (filterObj != nullptr && filterObj->IsArray())
-        {
-            auto& filters = filterObj->GetArray();
-            for (unsigned i = 0; i < filters.GetSize(); i++)
-            {
-                auto& obj = filters.MustFindAt(i);
-                if (obj.IsName() && obj.GetName() == "Crypt")
-                    m_Encrypt = nullptr;
-            }
-        }
-    }
+    device.Seek(streamOffset);	// reset it before reading!
 
     // Set stream raw data without marking the object dirty
-    if (m_Encrypt != nullptr)
+    bufferview span;
+    if (m_Encrypt == nullptr && m_BorrowSourceData && size >= 0
+        && device.TryGetSpan(span) && (size_t)size <= span.size() - streamOffset)
+    {
+        // The device exposes its backing memory: borrow
+        // the raw stream data instead of copying it
+        getOrCreateStream().InitData(span.subspan(streamOffset, (size_t)size), std::move(filters));
+
+        // Borrowed data is not owned by the object
+        return 0;
+    }
+    else if (m_Encrypt != nullptr)
     {
-        auto input = m_Encrypt->CreateEncryptionInputStream(*m_device, static_cast<size_t>(size), GetIndirectReference());
-        getOrCreateStream().InitData(*input, static_cast<ssize_t>(size), PdfFilterFactory::CreateFilterList(*this));
+        auto input = m_Encrypt->CreateEncryptionInputStream(device, static_cast<size_t>(size), GetIndirectReference());
+        getOrCreateStream().InitData(*input, static_cast<ssize_t>(size), std::move(filters));
     }
     else
     {
-        getOrCreateStream().InitData(*m_device, static_cast<ssize_t>(size), PdfFilterFactory::CreateFilterList(*this));
+        getOrCreateStream().InitData(device, static_cast<ssize_t>(size), std::move(filters));
     }
+
+    return getStream()->m_Provider->GetLength();
 }
 
-void PdfParserObject::checkReference(PdfTokenizer& tokenizer)
+void PdfParserObject::checkReference(InputStreamDevice& device, PdfTokenizer& tokenizer)
 {
-    auto reference = readReference(tokenizer);
+    auto reference = readReference(device, tokenizer);
     if (GetIndirectReference() != reference)
     {
         mm::LogMessage(PdfLogSeverity::Warning,
@@ -255,13 +395,13 @@ void PdfParserObject::checkReference(PdfTokenizer& tokenizer)
     }
 }
 
-PdfReference PdfParserObject::readReference(PdfTokenizer& tokenizer)
+PdfReference PdfParserObject::readReference(InputStreamDevice& device, PdfTokenizer& tokenizer)
 {
     PdfReference reference;
     try
     {
-        int64_t obj = tokenizer.ReadNextNumber(*m_device);
-        int64_t gen = tokenizer.ReadNextNumber(*m_device);
+        int64_t obj = tokenizer.ReadNextNumber(device);
+        int64_t gen = tokenizer.ReadNextNumber(device);
         reference = PdfReference(static_cast<uint32_t>(obj), static_cast<uint16_t>(gen));
 
     }
@@ -271,7 +411,7 @@ PdfReference PdfParserObject::readReference(PdfTokenizer& tokenizer)
         throw e;
     }
 
-    if (!tokenizer.IsNextToken(*m_device, "obj"))
+    if (!tokenizer.IsNextToken(device, "obj"))
     {
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Error while reading object {} {} R: Next token is not 'obj'",
             reference.ObjectNumber(), reference.GenerationNumber());
@@ -282,6 +422,10 @@ PdfReference PdfParserObject::readReference(PdfTokenizer& tokenizer)
 
 void PdfParserObject::FreeObjectMemory(bool force)
 {
+    // The object can't be read again without the device
+    if (m_device == nullptr)
+        return;
+
     if (!this->IsDirty() || force)
     {
         if (IsDelayedLoadDone())
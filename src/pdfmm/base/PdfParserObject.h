@@ -8,6 +8,9 @@
 #define PDF_PARSER_OBJECT_H
 
 #include "PdfDeclarations.h"
+
+#include <mutex>
+
 #include "PdfObject.h"
 #include "PdfTokenizer.h"
 
@@ -22,6 +25,7 @@ class PdfEncrypt;
 class PDFMM_API PdfParserObject : public PdfObject
 {
     friend class PdfParser;
+    friend class PdfIndirectObjectList;
 
 private:
     /** Parse the object data from the given file handle starting at
@@ -88,6 +92,12 @@ public:
 
     inline void SetIsTrailer(bool isTrailer) { m_IsTrailer = isTrailer; }
 
+    /** Set if the raw stream data and the strings can be borrowed from the
+     * source device, when it exposes its backing memory, instead of being
+     * copied. The device must then outlive the object
+     */
+    inline void SetBorrowSourceData(bool borrow) { m_BorrowSourceData = borrow; }
+
 protected:
     void DelayedLoadImpl() override;
     void DelayedLoadStreamImpl() override;
@@ -104,16 +114,49 @@ private:
      *
      *  Called from DelayedLoadStream(). Do not call directly.
      */
-    void parseStream();
+    size_t parseStream();
 
-    PdfReference readReference(PdfTokenizer& tokenizer);
+    /** \returns the size of the stream data held in memory
+     */
+    size_t readStream(InputStreamDevice& device, int64_t size, PdfFilterList&& filters);
+
+    /** Parse the stream, tracking the loaded data in the
+     * document when an object memory budget is set
+     */
+    void trackStreamLoad();
+
+    /** Load the object and its stream, copying the data borrowed
+     * from the source device, and stop using the device. The
+     * object memory can't be freed anymore afterwards
+     */
+    void detachSourceDevice();
 
-    void checkReference(PdfTokenizer& tokenizer);
+    /** Free the stream data, unless the stream is in use.
+     * The data is read again from the device on demand
+     * \returns true if the data was freed
+     */
+    bool tryFreeStreamData();
+
+    void parse(InputStreamDevice& device, PdfTokenizer& tokenizer);
+
+    PdfReference readReference(InputStreamDevice& device, PdfTokenizer& tokenizer);
+
+    void checkReference(InputStreamDevice& device, PdfTokenizer& tokenizer);
+
+    /** Get the memory of the source device to read the object with a
+     *  private cursor, when allowed by the concurrent read mode
+     */
+    bool tryGetSourceSpan(bufferview& span) const;
+
+    /** Lock the shared source device, when reading it directly
+     */
+    std::unique_lock<std::recursive_mutex> lockDevice() const;
 
 private:
     InputStreamDevice*m_device;
     PdfEncrypt* m_Encrypt;
     bool m_IsTrailer;
+    bool m_BorrowSourceData;
     size_t m_Offset;
     bool m_HasStream;
     size_t m_StreamOffset;
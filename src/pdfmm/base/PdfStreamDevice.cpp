@@ -11,9 +11,22 @@
 
 #include <pdfmm/private/FileSystem.h>
 
+#ifdef _WIN32
+#include <pdfmm/private/WindowsLeanMean.h>
+#include <utfcpp/utf8.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 using namespace std;
 using namespace mm;
 
+static const char* mapFile(const string_view& filepath, size_t& length);
+static void unmapFile(const char* buffer, size_t length);
+
 template <typename TStream>
 size_t getPosition(TStream& stream)
 {
@@ -611,7 +624,203 @@ bool SpanStreamDevice::peek(char& ch) const
     return true;
 }
 
+bool SpanStreamDevice::tryGetSpan(bufferview& span) const
+{
+    span = bufferview(m_buffer, m_Length);
+    return true;
+}
+
 void SpanStreamDevice::seek(ssize_t offset, SeekDirection direction)
 {
     m_Position = SeekPosition(m_Position, m_Length, offset, direction);
 }
+
+MappedFileStreamDevice::MappedFileStreamDevice(const string_view& filepath)
+    : StreamDevice(DeviceAccess::Read), m_Filepath(filepath), m_buffer(nullptr), m_Length(0), m_Position(0)
+{
+    m_buffer = mapFile(filepath, m_Length);
+}
+
+MappedFileStreamDevice::~MappedFileStreamDevice()
+{
+    unmap();
+}
+
+size_t MappedFileStreamDevice::GetLength() const
+{
+    return m_Length;
+}
+
+size_t MappedFileStreamDevice::GetPosition() const
+{
+    return m_Position;
+}
+
+bool MappedFileStreamDevice::Eof() const
+{
+    return m_Position == m_Length;
+}
+
+bool MappedFileStreamDevice::CanSeek() const
+{
+    return true;
+}
+
+void MappedFileStreamDevice::writeBuffer(const char* buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Mapped file devices are read only");
+}
+
+size_t MappedFileStreamDevice::readBuffer(char* buffer, size_t size, bool& eof)
+{
+    size_t readCount = std::min(size, m_Length - m_Position);
+    std::memcpy(buffer, m_buffer + m_Position, readCount);
+    m_Position += readCount;
+    eof = m_Position == m_Length;
+    return readCount;
+}
+
+bool MappedFileStreamDevice::readChar(char& ch)
+{
+    if (m_Position == m_Length)
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = m_buffer[m_Position];
+    m_Position++;
+    return true;
+}
+
+bool MappedFileStreamDevice::peek(char& ch) const
+{
+    if (m_Position == m_Length)
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = m_buffer[m_Position];
+    return true;
+}
+
+bool MappedFileStreamDevice::tryGetSpan(bufferview& span) const
+{
+    span = bufferview(m_buffer, m_Length);
+    return true;
+}
+
+void MappedFileStreamDevice::seek(ssize_t offset, SeekDirection direction)
+{
+    m_Position = SeekPosition(m_Position, m_Length, offset, direction);
+}
+
+void MappedFileStreamDevice::close()
+{
+    unmap();
+}
+
+void MappedFileStreamDevice::unmap()
+{
+    if (m_buffer == nullptr)
+        return;
+
+    unmapFile(m_buffer, m_Length);
+    m_buffer = nullptr;
+    m_Length = 0;
+    m_Position = 0;
+}
+
+#ifdef _WIN32
+
+const char* mapFile(const string_view& filepath, size_t& length)
+{
+    length = 0;
+    auto filepath16 = utf8::utf8to16((string)filepath);
+    // NOTE: Allow concurrent writers, so incremental updates
+    // can be appended to the mapped file
+    HANDLE file = CreateFileW((LPCWSTR)filepath16.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::FileNotFound, filepath);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to get the file size");
+    }
+
+    if (size.QuadPart == 0)
+    {
+        // Empty files can't be mapped
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // NOTE: The view keeps a reference to the mapping
+    // and the file, so the handles can be closed
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to map the file");
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to map the file");
+
+    length = (size_t)size.QuadPart;
+    return (const char*)view;
+}
+
+void unmapFile(const char* buffer, size_t length)
+{
+    (void)length;
+    UnmapViewOfFile(buffer);
+}
+
+#else // _WIN32
+
+const char* mapFile(const string_view& filepath, size_t& length)
+{
+    length = 0;
+    int fd = ::open(((string)filepath).c_str(), O_RDONLY);
+    if (fd == -1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::FileNotFound, filepath);
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        ::close(fd);
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to get the file size");
+    }
+
+    if (st.st_size == 0)
+    {
+        // Empty files can't be mapped
+        ::close(fd);
+        return nullptr;
+    }
+
+    // NOTE: The mapping keeps a reference to
+    // the file, so the descriptor can be closed
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to map the file");
+
+    length = (size_t)st.st_size;
+    return (const char*)view;
+}
+
+void unmapFile(const char* buffer, size_t length)
+{
+    munmap(const_cast<char*>(buffer), length);
+}
+
+#endif // _WIN32
@@ -121,6 +121,54 @@ private:
     std::string m_Filepath;
 };
 
+/** A read only device that maps a file in memory, allowing
+ * zero-copy access to its contents
+ * \remarks The file should not be truncated or modified
+ * while it's mapped
+ */
+class PDFMM_API MappedFileStreamDevice final : public StreamDevice
+{
+public:
+    /** Open and map for reading the supplied filepath
+     */
+    MappedFileStreamDevice(const std::string_view& filepath);
+
+    ~MappedFileStreamDevice();
+
+public:
+    size_t GetLength() const override;
+
+    size_t GetPosition() const override;
+
+    bool Eof() const override;
+
+    bool CanSeek() const override;
+
+    const std::string& GetFilepath() const { return m_Filepath; }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override;
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override;
+    bool readChar(char& ch) override;
+    bool peek(char& ch) const override;
+    bool tryGetSpan(bufferview& span) const override;
+    void seek(ssize_t offset, SeekDirection direction) override;
+    void close() override;
+
+private:
+    void unmap();
+
+private:
+    MappedFileStreamDevice(const MappedFileStreamDevice&) = delete;
+    MappedFileStreamDevice& operator=(const MappedFileStreamDevice&) = delete;
+
+private:
+    std::string m_Filepath;
+    const char* m_buffer;
+    size_t m_Length;
+    size_t m_Position;
+};
+
 template <typename TContainer>
 class ContainerStreamDevice final : public StreamDevice
 {
@@ -190,6 +238,12 @@ protected:
         return true;
     }
 
+    bool tryGetSpan(bufferview& span) const override
+    {
+        span = bufferview(m_container->data(), m_container->size());
+        return true;
+    }
+
     void seek(ssize_t offset, SeekDirection direction) override
     {
         m_Position = SeekPosition(m_Position, m_container->size(), offset, direction);
@@ -232,6 +286,7 @@ protected:
     size_t readBuffer(char* buffer, size_t size, bool& eof) override;
     bool readChar(char& ch) override;
     bool peek(char& ch) const override;
+    bool tryGetSpan(bufferview& span) const override;
     void seek(ssize_t offset, SeekDirection direction) override;
 
 private:
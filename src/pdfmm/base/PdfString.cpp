@@ -7,6 +7,8 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfString.h"
 
+#include <thread>
+
 #include <utfcpp/utf8.h>
 
 #include <pdfmm/private/PdfEncodingPrivate.h>
@@ -29,34 +31,45 @@ enum class StringEncoding
     PdfDocEncoding
 };
 
+// Marks the borrowed bytes of a string while
+// they are copied by materialize()
+static const char s_materializing = '\0';
+
 static char getEscapedCharacter(char ch);
 static StringEncoding getEncoding(const string_view& view);
 
 PdfString::PdfString()
-    : m_data(new StringData{ PdfStringState::Ascii, { } }), m_isHex(false)
+    : m_data(new StringData{ PdfStringState::Ascii, { } }), m_borrowed(nullptr), m_borrowedSize(0), m_isHex(false)
 {
 }
 
 PdfString::PdfString(charbuff&& buff, bool isHex)
-    : m_data(new StringData{ PdfStringState::RawBuffer, std::move(buff) }), m_isHex(isHex)
+    : m_data(new StringData{ PdfStringState::RawBuffer, std::move(buff) }),
+    m_borrowed(nullptr), m_borrowedSize(0), m_isHex(isHex)
 {
 }
 
 PdfString::PdfString(const char* str)
-    : m_isHex(false)
+    : m_borrowed(nullptr), m_borrowedSize(0), m_isHex(false)
 {
     initFromUtf8String({ str, std::strlen(str) });
 }
 
 PdfString::PdfString(const string_view& view)
-    : m_isHex(false)
+    : m_borrowed(nullptr), m_borrowedSize(0), m_isHex(false)
 {
     initFromUtf8String(view);
 }
 
 PdfString::PdfString(const PdfString& rhs)
+    : m_borrowed(nullptr), m_borrowedSize(0)
+{
+    assign(rhs);
+}
+
+PdfString::PdfString(const char* borrowed, uint32_t size, bool isHex)
+    : m_borrowed(borrowed), m_borrowedSize(size), m_isHex(isHex)
 {
-    this->operator=(rhs);
 }
 
 PdfString PdfString::FromRaw(const bufferview& view, bool isHex)
@@ -126,34 +139,44 @@ void PdfString::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
     string_view dataview;
     u16string string16;
     string pdfDocEncoded;
-    switch (m_data->State)
+    auto borrowed = getBorrowed();
+    if (borrowed != nullptr && !m_isHex)
     {
-        case PdfStringState::RawBuffer:
-        case PdfStringState::Ascii:
-        {
-            dataview = string_view(m_data->Chars);
-            break;
-        }
-        case PdfStringState::PdfDocEncoding:
-        {
-            (void)mm::TryConvertUTF8ToPdfDocEncoding(m_data->Chars, pdfDocEncoded);
-            dataview = string_view(pdfDocEncoded);
-            break;
-        }
-        case PdfStringState::Unicode:
+        // Write the source bytes without copying them
+        dataview = string_view(borrowed, m_borrowedSize);
+    }
+    else
+    {
+        auto& data = getData();
+        switch (data.State)
         {
-            // Prepend utf-16 BE BOM
-            string16.push_back((char16_t)(0xFEFF));
-            utf8::utf8to16(m_data->Chars.data(), m_data->Chars.data() + m_data->Chars.size(), std::back_inserter(string16));
+            case PdfStringState::RawBuffer:
+            case PdfStringState::Ascii:
+            {
+                dataview = string_view(data.Chars);
+                break;
+            }
+            case PdfStringState::PdfDocEncoding:
+            {
+                (void)mm::TryConvertUTF8ToPdfDocEncoding(data.Chars, pdfDocEncoded);
+                dataview = string_view(pdfDocEncoded);
+                break;
+            }
+            case PdfStringState::Unicode:
+            {
+                // Prepend utf-16 BE BOM
+                string16.push_back((char16_t)(0xFEFF));
+                utf8::utf8to16(data.Chars.data(), data.Chars.data() + data.Chars.size(), std::back_inserter(string16));
 #ifdef PDFMM_IS_LITTLE_ENDIAN
-            // Ensure the output will be BE
-            utls::ByteSwap(string16);
+                // Ensure the output will be BE
+                utls::ByteSwap(string16);
 #endif
-            dataview = string_view((const char*)string16.data(), string16.size() * sizeof(char16_t));
-            break;
+                dataview = string_view((const char*)string16.data(), string16.size() * sizeof(char16_t));
+                break;
+            }
+            default:
+                PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
         }
-        default:
-            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
     }
 
     charbuff tempBuffer;
@@ -210,6 +233,9 @@ void PdfString::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
 
 PdfStringState PdfString::GetState() const
 {
+    if (m_borrowed.load(memory_order_acquire) != nullptr)
+        return PdfStringState::RawBuffer;
+
     return m_data->State;
 }
 
@@ -221,16 +247,76 @@ const string& PdfString::GetString() const
 
 bool PdfString::IsEmpty() const
 {
-    return m_data->Chars.empty();
+    return getData().Chars.empty();
 }
 
 const PdfString& PdfString::operator=(const PdfString& rhs)
 {
-    this->m_data = rhs.m_data;
-    this->m_isHex = rhs.m_isHex;
+    if (this != &rhs)
+        assign(rhs);
+
     return *this;
 }
 
+void PdfString::assign(const PdfString& rhs)
+{
+    // Copies never reference the source bytes, so
+    // they can outlive the document of the string
+    (void)rhs.getData();
+    m_data = rhs.m_data;
+    m_borrowed.store(nullptr, memory_order_release);
+    m_borrowedSize = 0;
+    m_isHex = rhs.m_isHex;
+}
+
+void PdfString::materialize() const
+{
+    // The thread that swaps the borrowed bytes with the marker
+    // copies them. Concurrent readers of the same string wait for
+    // it, which is short since strings are copied only once
+    auto borrowed = m_borrowed.load(memory_order_acquire);
+    while (true)
+    {
+        if (borrowed == nullptr)
+            return;
+
+        if (borrowed == &s_materializing)
+        {
+            this_thread::yield();
+            borrowed = m_borrowed.load(memory_order_acquire);
+            continue;
+        }
+
+        if (m_borrowed.compare_exchange_weak(borrowed, &s_materializing, memory_order_acquire))
+            break;
+    }
+
+    try
+    {
+        string_view view(borrowed, m_borrowedSize);
+        if (m_isHex)
+            m_data = FromHexData(view).m_data;
+        else
+            m_data = std::make_shared<StringData>(StringData{ PdfStringState::RawBuffer, charbuff(view) });
+    }
+    catch (...)
+    {
+        m_borrowed.store(borrowed, memory_order_release);
+        throw;
+    }
+
+    m_borrowed.store(nullptr, memory_order_release);
+}
+
+const char* PdfString::getBorrowed() const
+{
+    auto borrowed = m_borrowed.load(memory_order_acquire);
+    if (borrowed == &s_materializing)
+        return nullptr;
+
+    return borrowed;
+}
+
 bool PdfString::operator==(const PdfString& rhs) const
 {
     if (this == &rhs)
@@ -239,10 +325,10 @@ bool PdfString::operator==(const PdfString& rhs) const
     if (!canPerformComparison(*this, rhs))
         return false;
 
-    if (this->m_data == rhs.m_data)
+    if (&getData() == &rhs.getData())
         return true;
 
-    return this->m_data->Chars == rhs.m_data->Chars;
+    return getData().Chars == rhs.getData().Chars;
 }
 
 bool PdfString::operator==(const char* str) const
@@ -271,10 +357,10 @@ bool PdfString::operator!=(const PdfString& rhs) const
     if (!canPerformComparison(*this, rhs))
         return true;
 
-    if (this->m_data == rhs.m_data)
+    if (&getData() == &rhs.getData())
         return false;
 
-    return this->m_data->Chars != rhs.m_data->Chars;
+    return getData().Chars != rhs.getData().Chars;
 }
 
 bool PdfString::operator!=(const char* str) const
@@ -321,7 +407,8 @@ void PdfString::initFromUtf8String(const string_view& view)
 
 void PdfString::evaluateString() const
 {
-    switch (m_data->State)
+    auto& data = getData();
+    switch (data.State)
     {
         case PdfStringState::Ascii:
         case PdfStringState::PdfDocEncoding:
@@ -329,42 +416,42 @@ void PdfString::evaluateString() const
             return;
         case PdfStringState::RawBuffer:
         {
-            auto encoding = getEncoding(m_data->Chars);
+            auto encoding = getEncoding(data.Chars);
             switch (encoding)
             {
                 case StringEncoding::utf16be:
                 {
                     // Remove BOM and decode utf-16 string
                     string utf8;
-                    auto view = string_view(m_data->Chars).substr(2);
+                    auto view = string_view(data.Chars).substr(2);
                     utls::ReadUtf16BEString(view, utf8);
-                    utf8.swap(m_data->Chars);
-                    m_data->State = PdfStringState::Unicode;
+                    utf8.swap(data.Chars);
+                    data.State = PdfStringState::Unicode;
                     break;
                 }
                 case StringEncoding::utf16le:
                 {
                     // Remove BOM and decode utf-16 string
                     string utf8;
-                    auto view = string_view(m_data->Chars).substr(2);
+                    auto view = string_view(data.Chars).substr(2);
                     utls::ReadUtf16LEString(view, utf8);
-                    utf8.swap(m_data->Chars);
-                    m_data->State = PdfStringState::Unicode;
+                    utf8.swap(data.Chars);
+                    data.State = PdfStringState::Unicode;
                     break;
                 }
                 case StringEncoding::utf8:
                 {
                     // Remove BOM
-                    m_data->Chars.substr(3).swap(m_data->Chars);
-                    m_data->State = PdfStringState::Unicode;
+                    data.Chars.substr(3).swap(data.Chars);
+                    data.State = PdfStringState::Unicode;
                     break;
                 }
                 case StringEncoding::PdfDocEncoding:
                 {
                     bool isAsciiEqual;
-                    auto utf8 = mm::ConvertPdfDocEncodingToUTF8(m_data->Chars, isAsciiEqual);
-                    utf8.swap(m_data->Chars);
-                    m_data->State = isAsciiEqual ? PdfStringState::Ascii : PdfStringState::PdfDocEncoding;
+                    auto utf8 = mm::ConvertPdfDocEncodingToUTF8(data.Chars, isAsciiEqual);
+                    utf8.swap(data.Chars);
+                    data.State = isAsciiEqual ? PdfStringState::Ascii : PdfStringState::PdfDocEncoding;
                     break;
                 }
                 default:
@@ -381,7 +468,7 @@ void PdfString::evaluateString() const
 // Returns true only if same state or it's valid text string
 bool PdfString::canPerformComparison(const PdfString& lhs, const PdfString& rhs)
 {
-    if (lhs.m_data->State == rhs.m_data->State)
+    if (lhs.getData().State == rhs.getData().State)
         return true;
 
     if (lhs.isValidText() || rhs.isValidText())
@@ -392,15 +479,16 @@ bool PdfString::canPerformComparison(const PdfString& lhs, const PdfString& rhs)
 
 const string& PdfString::GetRawData() const
 {
-    if (m_data->State != PdfStringState::RawBuffer)
+    auto& data = getData();
+    if (data.State != PdfStringState::RawBuffer)
         throw runtime_error("The string buffer has been evaluated");
 
-    return m_data->Chars;
+    return data.Chars;
 }
 
 bool PdfString::isValidText() const
 {
-    switch (m_data->State)
+    switch (getData().State)
     {
         case PdfStringState::Ascii:
         case PdfStringState::PdfDocEncoding:
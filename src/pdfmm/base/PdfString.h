@@ -9,6 +9,8 @@
 
 #include "PdfDeclarations.h"
 
+#include <atomic>
+
 #include "PdfDataProvider.h"
 
 namespace mm {
@@ -21,9 +23,18 @@ namespace mm {
  *  PdfString is an implicitly shared class. As a reason
  *  it is very fast to copy PdfString objects.
  *
+ *  Strings parsed from a document loaded on demand from a memory
+ *  buffer may reference the source bytes, if they are not encrypted
+ *  and have no escape sequences. The contents are copied when first
+ *  accessed, or when the string is copied, so copies can safely
+ *  outlive the document. Objects removed from the document are
+ *  copied as well
  */
 class PDFMM_API PdfString final : public PdfDataProvider
 {
+    friend class PdfTokenizer;
+    friend class PdfIndirectObjectList;
+
 public:
     /** Create an empty string
      */
@@ -131,6 +142,11 @@ public:
     operator std::string_view() const;
 
 private:
+    /** Construct a string referencing the source bytes, which are
+     *  copied only when accessed. Hex strings are decoded then
+     */
+    PdfString(const char* borrowed, uint32_t size, bool isHex);
+
     /** Construct a new PdfString from a 0-terminated string.
      *
      *  The input string will be copied.
@@ -142,6 +158,9 @@ private:
     void initFromUtf8String(const std::string_view& view);
     void evaluateString() const;
     bool isValidText() const;
+    void materialize() const;
+    const char* getBorrowed() const;
+    void assign(const PdfString& rhs);
     static bool canPerformComparison(const PdfString& lhs, const PdfString& rhs);
 
 private:
@@ -151,8 +170,18 @@ private:
         charbuff Chars;
     };
 
+    inline StringData& getData() const
+    {
+        if (m_borrowed.load(std::memory_order_acquire) != nullptr)
+            materialize();
+
+        return *m_data;
+    }
+
 private:
-    std::shared_ptr<StringData> m_data;
+    mutable std::shared_ptr<StringData> m_data;
+    mutable std::atomic<const char*> m_borrowed;    // The source bytes, until materialized. See materialize()
+    uint32_t m_borrowedSize;
     bool m_isHex;    // This string is converted to hex during writing it out
 };
 
@@ -31,7 +31,7 @@ PdfTokenizer::PdfTokenizer(bool readReferences)
 }
 
 PdfTokenizer::PdfTokenizer(const shared_ptr<charbuff>& buffer, bool readReferences)
-    : m_buffer(buffer), m_readReferences(readReferences)
+    : m_buffer(buffer), m_readReferences(readReferences), m_borrowStrings(false)
 {
     if (buffer == nullptr)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
@@ -65,11 +65,33 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
         return true;
     }
 
+    // Devices backed by contiguous memory allow to return
+    // the token as a view of the device contents, without copying it
+    bufferview span;
+    bool hasSpan = device.TryGetSpan(span);
+    size_t start = 0;
+
     tokenType = PdfTokenType::Literal;
 
     char ch1;
     char ch2;
     size_t count = 0;
+    auto consumeChar = [&](char ch) {
+        if (hasSpan)
+        {
+            if (count == 0)
+                start = device.GetPosition();
+        }
+        else
+        {
+            buffer[count] = ch;
+        }
+
+        (void)device.ReadChar();
+
+        count++;
+    };
+
     while (count < bufferSize)
     {
         if (!device.Peek(ch1))
@@ -104,9 +126,7 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
         else if (count == 0 && (ch1 == '<' || ch1 == '>'))
         {
             // Really consume character from stream
-            (void)device.ReadChar();
-            buffer[count] = ch1;
-            count++;
+            consumeChar(ch1);
 
             if (!device.Peek(ch2))
                 goto Eof;
@@ -115,13 +135,11 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
             // If so, consume that character too.
             if (ch2 == ch1)
             {
-                (void)device.ReadChar();
-                buffer[count] = ch2;
+                consumeChar(ch2);
                 if (ch1 == '<')
                     tokenType = PdfTokenType::DoubleAngleBracketsLeft;
                 else
                     tokenType = PdfTokenType::DoubleAngleBracketsRight;
-                count++;
             }
             else
             {
@@ -142,9 +160,7 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
         else
         {
             // Consume the next character and add it to the token we're building.
-            (void)device.ReadChar();
-            buffer[count] = ch1;
-            count++;
+            consumeChar(ch1);
 
             PdfTokenType tokenDelimiterType;
             if (IsTokenDelimiter(ch1, tokenDelimiterType))
@@ -159,8 +175,15 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
     }
 
 Exit:
-    buffer[count] = '\0';
-    token = string_view(buffer, count);
+    if (hasSpan)
+    {
+        token = string_view(span.data() + start, count);
+    }
+    else
+    {
+        buffer[count] = '\0';
+        token = string_view(buffer, count);
+    }
     return true;
 
 Eof:
@@ -262,21 +285,19 @@ PdfTokenizer::PdfLiteralDataType PdfTokenizer::DetermineDataType(InputStreamDevi
                 return PdfLiteralDataType::Bool;
             }
 
+            // NOTE: The token is not necessarily null terminated
             PdfLiteralDataType dataType = PdfLiteralDataType::Number;
-            const char* start = token.data();
-            while (*start)
+            for (char ch : token)
             {
-                if (*start == '.')
+                if (ch == '.')
                 {
                     dataType = PdfLiteralDataType::Real;
                 }
-                else if (!(isdigit(*start) || *start == '-' || *start == '+'))
+                else if (!(isdigit(ch) || ch == '-' || ch == '+'))
                 {
                     dataType = PdfLiteralDataType::Unknown;
                     break;
                 }
-
-                start++;
             }
 
             if (dataType == PdfLiteralDataType::Real)
@@ -496,6 +517,9 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
     char octValue = 0;
     int balanceCount = 0; // Balanced parathesis do not have to be escaped in strings
 
+    if (tryBorrowString(device, variant, encrypt, false))
+        return;
+
     m_charBuffer.clear();
     while (device.Read(ch))
     {
@@ -611,6 +635,9 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
 
 void PdfTokenizer::ReadHexString(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
 {
+    if (tryBorrowString(device, variant, encrypt, true))
+        return;
+
     readHexString(device, m_charBuffer);
     variant = PdfString::FromHexData({ m_charBuffer.size() ? m_charBuffer.data() : "", m_charBuffer.size() }, encrypt);
 }
@@ -648,6 +675,68 @@ void PdfTokenizer::ReadName(InputStreamDevice& device, PdfVariant& variant)
         variant = PdfName::FromEscaped(token);
 }
 
+bool PdfTokenizer::tryBorrowString(InputStreamDevice& device, PdfVariant& variant,
+    const PdfStatefulEncrypt& encrypt, bool hex)
+{
+    bufferview span;
+    if (!m_borrowStrings || encrypt.HasEncrypt() || !device.TryGetSpan(span))
+        return false;
+
+    // Look for the end of the string. Strings with escape sequences,
+    // or hex strings with an odd count of digits or invalid
+    // characters, are read normally
+    size_t start = device.GetPosition();
+    size_t end = start;
+    int balanceCount = 0;
+    unsigned digitCount = 0;
+    unsigned char hexValue;
+    for (; end < span.size(); end++)
+    {
+        char ch = span[end];
+        if (hex)
+        {
+            if (ch == '>')
+                break;
+
+            if (utls::TryGetHexValue(ch, hexValue))
+                digitCount++;
+            else if (!IsWhitespace(ch))
+                return false;
+        }
+        else
+        {
+            if (ch == '\\')
+                return false;
+
+            if (ch == '(')
+            {
+                balanceCount++;
+            }
+            else if (ch == ')')
+            {
+                if (balanceCount == 0)
+                    break;
+
+                balanceCount--;
+            }
+        }
+    }
+
+    size_t size = end - start;
+    if (end == span.size() || size == 0 || size > numeric_limits<uint32_t>::max()
+        || digitCount % 2 != 0)
+    {
+        return false;
+    }
+
+    // Construct the string in place, since copies of
+    // the string don't reference the source bytes
+    variant = PdfVariant(PdfDataType::String);
+    variant.m_Data.Data = new PdfString(span.data() + start, (uint32_t)size, hex);
+    device.Seek(end + 1);
+    return true;
+}
+
 void PdfTokenizer::EnqueueToken(const string_view& token, PdfTokenType tokenType)
 {
     m_tokenQueque.push_back(TokenizerPair(string(token), tokenType));
@@ -52,12 +52,14 @@ public:
     /** Reads the next token from the current file position
      *  ignoring all comments.
      *
-     *  \param[out] token On true return, set to a pointer to the read
-     *                     token (a nullptr-terminated C string). The pointer is
-     *                     to memory owned by PdfTokenizer and must NOT be
-     *                     freed.  The contents are invalidated on the next
-     *                     call to tryReadNextToken(..) and by the destruction of
-     *                     the PdfTokenizer. Undefined on false return.
+     *  \param[out] token On true return, set to a view of the read
+     *                     token. The view may point to memory owned by
+     *                     PdfTokenizer or, if the device exposes its backing
+     *                     memory, directly to the device contents. It's not
+     *                     guaranteed to be null terminated. The contents are
+     *                     invalidated on the next call to tryReadNextToken(..)
+     *                     and by the destruction of the PdfTokenizer. Undefined
+     *                     on false return.
      *
      *  \param[out] tokenType On true return, if not nullptr the type of the read token
      *                     will be stored into this parameter. Undefined on false
@@ -231,6 +233,7 @@ protected:
 
 private:
     bool tryReadDataType(InputStreamDevice& device, PdfLiteralDataType dataType, PdfVariant& variant, const PdfStatefulEncrypt& encrypt);
+    bool tryBorrowString(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt, bool hex);
 
 private:
     using TokenizerPair = std::pair<std::string, PdfTokenType>;
@@ -241,6 +244,8 @@ private:
     bool m_readReferences;
     TokenizerQueque m_tokenQueque;
     charbuff m_charBuffer;
+    // Strings can reference the device contents, which must outlive them
+    bool m_borrowStrings;
 };
 
 };
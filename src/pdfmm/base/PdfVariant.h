@@ -34,6 +34,7 @@ class PDFMM_API PdfVariant final
 {
     friend class PdfArray;
     friend class PdfDictionary;
+    friend class PdfTokenizer;
 
 private:
     PdfVariant(PdfDataType type);
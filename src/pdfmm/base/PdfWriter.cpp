@@ -5,11 +5,13 @@
  */
 
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include <pdfmm/private/ParallelUtils.h>
 #include "PdfWriter.h"
 
 #include "PdfData.h"
 #include "PdfDate.h"
 #include "PdfDictionary.h"
+#include "PdfDocument.h"
 #include "PdfObject.h"
 #include "PdfParser.h"
 #include "PdfParserObject.h"
@@ -19,6 +21,12 @@
 #include "PdfXRefStream.h"
 #include "PdfStreamDevice.h"
 
+#include <array>
+#include <atomic>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
+
 #define PDF_MAGIC           "\xe2\xe3\xcf\xd3\n"
 // 10 spaces
 #define LINEARIZATION_PADDING "          "
@@ -26,13 +34,111 @@
 using namespace std;
 using namespace mm;
 
+// The users of an object, as classified for linearization
+enum class LinearizedUser
+{
+    Root,
+    OpenDocument,
+    Outlines,
+    Page,
+    Thumbnail,
+    Other,
+};
+
+struct LinearizedObject
+{
+    LinearizedObject()
+        : UserCount(0), IsRoot(false), InOpenDocument(false), InOutlines(false),
+        InFirstPage(false), OtherPageCount(0), ThumbnailCount(0), OtherCount(0),
+        Placed(false), Offset(0), Length(0) { }
+
+    unsigned UserCount;
+    bool IsRoot;
+    bool InOpenDocument;
+    bool InOutlines;
+    bool InFirstPage;
+    unsigned OtherPageCount;
+    unsigned ThumbnailCount;
+    unsigned OtherCount;
+    bool Placed;
+    size_t Offset;      // Offset in the containing section
+    size_t Length;      // Length, including the trailing whitespace
+};
+
+// Categories of objects, determining their placement in the
+// parts of the linearized file, see ISO 32000-1:2008 F.3
+enum class LinearizedCategory
+{
+    Root,               // Part 4
+    OpenDocument,       // Part 4
+    FirstPagePrivate,   // Part 6
+    FirstPageShared,    // Part 6
+    OtherPagePrivate,   // Part 7
+    OtherPageShared,    // Part 8
+    Outlines,           // Part 9, or part 6 with /PageMode /UseOutlines
+    Other,              // Part 9
+};
+
+// Writes the bit streams of the hint tables, most significant bit first
+class HintWriter final
+{
+public:
+    HintWriter(charbuff& buffer)
+        : m_buffer(&buffer), m_current(0), m_bitCount(0) { }
+
+    void WriteBits(uint64_t value, unsigned bitCount)
+    {
+        for (unsigned i = bitCount; i > 0; i--)
+        {
+            m_current = (uint8_t)((m_current << 1) | ((value >> (i - 1)) & 1));
+            m_bitCount++;
+            if (m_bitCount == 8)
+            {
+                m_buffer->push_back((char)m_current);
+                m_current = 0;
+                m_bitCount = 0;
+            }
+        }
+    }
+
+    // Pad the last byte with zeros. Every hint
+    // table item sequence starts at a byte boundary
+    void Flush()
+    {
+        if (m_bitCount == 0)
+            return;
+
+        m_buffer->push_back((char)(m_current << (8 - m_bitCount)));
+        m_current = 0;
+        m_bitCount = 0;
+    }
+
+private:
+    charbuff* m_buffer;
+    uint8_t m_current;
+    unsigned m_bitCount;
+};
+
 static PdfWriteFlags ToWriteFlags(PdfSaveOptions opts);
+static LinearizedCategory getLinearizedCategory(const LinearizedObject& obj);
+static bool isInheritablePageKey(const PdfName& key);
+static void collectPages(PdfIndirectObjectList& objects, const PdfObject& root,
+    vector<const PdfObject*>& pages, vector<array<const PdfObject*, 4>>& inheritedAttributes,
+    unordered_set<const PdfObject*>& nodes);
+static void remapReferences(PdfObject& obj, const unordered_map<PdfReference, PdfReference>& references);
+static unsigned getBitCount(uint64_t value);
+
+// Page attributes that can be inherited from the page tree nodes,
+// see ISO 32000-1:2008 Table 30 "Entries in a page object"
+static const string_view s_inheritablePageKeys[] = { "Resources", "MediaBox", "CropBox", "Rotate" };
 
 PdfWriter::PdfWriter(PdfIndirectObjectList* objects, const PdfObject& trailer, PdfVersion version) :
     m_Objects(objects),
     m_Trailer(&trailer),
     m_Version(version),
     m_UseXRefStream(false),
+    m_ObjectStreamGroupSize(100),
+    m_CompressionThreadCount(1),
     m_EncryptObj(nullptr),
     m_SaveOptions(PdfSaveOptions::None),
     m_WriteFlags(PdfWriteFlags::None),
@@ -71,6 +177,21 @@ PdfWriter::~PdfWriter()
 
 void PdfWriter::Write(OutputStreamDevice& device)
 {
+    bool linearize = (m_SaveOptions & PdfSaveOptionsLinearize) != PdfSaveOptions::None;
+    if (linearize)
+    {
+        if (m_IncrementalUpdate)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "Linearized incremental updates are not supported");
+
+        if ((m_SaveOptions & PdfSaveOptions::ObjectStreams) != PdfSaveOptions::None)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "Linearized output with object streams is not supported");
+    }
+    else if ((m_SaveOptions & PdfSaveOptions::ObjectStreams) != PdfSaveOptions::None)
+    {
+        // Compressed objects can be referenced only by XRef streams
+        SetUseXRefStream(true);
+    }
+
     CreateFileIdentifier(m_identifier, *m_Trailer, &m_originalIdentifier);
 
     // setup encrypt dictionary
@@ -83,23 +204,31 @@ void PdfWriter::Write(OutputStreamDevice& device)
         m_Encrypt->CreateEncryptionDictionary(m_EncryptObj->GetDictionary());
     }
 
-    unique_ptr<PdfXRef> xRef;
-    if (m_UseXRefStream)
-        xRef.reset(new PdfXRefStream(*this));
-    else
-        xRef.reset(new PdfXRef(*this));
-
     try
     {
-        if (!m_IncrementalUpdate)
-            WritePdfHeader(device);
+        if (linearize)
+        {
+            // Linearized files are always written with XRef tables
+            writeLinearized(device);
+        }
+        else
+        {
+            unique_ptr<PdfXRef> xRef;
+            if (m_UseXRefStream)
+                xRef.reset(new PdfXRefStream(*this));
+            else
+                xRef.reset(new PdfXRef(*this));
 
-        WritePdfObjects(device, *m_Objects, *xRef);
+            if (!m_IncrementalUpdate)
+                WritePdfHeader(device);
 
-        if (m_IncrementalUpdate)
-            xRef->SetFirstEmptyBlock();
+            WritePdfObjects(device, *m_Objects, *xRef);
+
+            if (m_IncrementalUpdate)
+                xRef->SetFirstEmptyBlock();
 
-        xRef->Write(device, m_buffer);
+            xRef->Write(device, m_buffer);
+        }
     }
     catch (PdfError& e)
     {
@@ -130,6 +259,94 @@ void PdfWriter::WritePdfHeader(OutputStreamDevice& device)
 
 void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObjectList& objects, PdfXRef& xref)
 {
+    bool useObjectStreams = (m_SaveOptions & PdfSaveOptions::ObjectStreams) != PdfSaveOptions::None;
+
+    // Streams to be flate compressed are compressed on worker threads, a
+    // batch at a time, ahead of the serial write of the objects. The data
+    // is moved in the objects just before they are written, so the output
+    // is identical to the one of the serial compression in PdfObject::Write()
+    unsigned threadCount = utls::GetThreadCount(m_CompressionThreadCount);
+    vector<PdfObject*> streamObjects;
+    if (threadCount > 1 && (m_WriteFlags & PdfWriteFlags::NoFlateCompress) == PdfWriteFlags::None)
+    {
+        // The /Metadata object must be unfiltered as per PDF/A
+        PdfReference metadataRef;
+        const PdfObject* metadataObj;
+        if (objects.m_Document != nullptr
+            && (metadataObj = objects.m_Document->GetCatalog().GetMetadataObject()) != nullptr)
+        {
+            metadataRef = metadataObj->GetIndirectReference();
+        }
+
+        for (PdfObject* obj : objects)
+        {
+            if ((m_IncrementalUpdate && !obj->IsDirty())
+                || xref.ShouldSkipWrite(obj->GetIndirectReference()))
+            {
+                continue;
+            }
+
+            if (isStreamCompressionEligible(*obj, metadataRef))
+                streamObjects.push_back(obj);
+        }
+    }
+
+    // The stream data of the objects being compressed must not
+    // be released to fit the object memory budget of the document
+    vector<PdfIndirectObjectList::MemoryPin> pins(streamObjects.size());
+    vector<unique_ptr<PdfObject>> compressedStreams(streamObjects.size());
+    size_t streamIndex = 0;     // The next object to be written
+    size_t readyEnd = 0;        // End of the compressed batch
+    size_t pendingEnd = 0;      // End of the batch being compressed
+    atomic<size_t> pendingIndex(0);
+    future<void> pending;
+    auto compressNextBatch = [&]() {
+        // Batch enough data to keep all the threads busy
+        constexpr size_t BatchObjectCount = 16;
+        constexpr size_t BatchLength = 4 * 1024 * 1024;
+        size_t begin = pendingEnd;
+        size_t length = 0;
+        while (pendingEnd < streamObjects.size()
+            && pendingEnd - begin < threadCount * BatchObjectCount
+            && length < threadCount * BatchLength)
+        {
+            // Pin the object before loading the stream, so
+            // the data is kept until the object is written
+            pins[pendingEnd] = PdfIndirectObjectList::MemoryPin(*streamObjects[pendingEnd]);
+            length += streamObjects[pendingEnd]->MustGetStream().GetLength();
+            pendingEnd++;
+        }
+
+        if (begin == pendingEnd)
+            return;
+
+        pendingIndex = begin;
+        auto compressBatch = [&, end = pendingEnd]() {
+            // Streams sizes may vary widely, hence the
+            // threads pick the objects from a shared index
+            utls::ParallelFor(threadCount, threadCount, [&](size_t, size_t, unsigned) {
+                size_t i;
+                while ((i = pendingIndex++) < end)
+                {
+                    compressedStreams[i].reset(new PdfObject());
+                    streamObjects[i]->flateCompressStream(*compressedStreams[i], m_WriteFlags);
+                }
+            });
+        };
+
+        try
+        {
+            pending = std::async(std::launch::async, compressBatch);
+        }
+        catch (system_error&)
+        {
+            // Unable to spawn a new thread, compress the batch when needed
+            pending = std::async(std::launch::deferred, compressBatch);
+        }
+    };
+
+    compressNextBatch();
+    vector<PdfObject*> compressedObjects;
     for (PdfObject* obj : objects)
     {
         if (m_IncrementalUpdate && !obj->IsDirty())
@@ -168,20 +385,735 @@ void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObj
             // offset of the object and not retrieve it from the device
             xref.AddInUseObject(obj->GetIndirectReference(), 0xFFFFFFFF);
         }
+        else if (useObjectStreams && isObjectStreamEligible(*obj))
+        {
+            // Defer the write after all the other objects
+            compressedObjects.push_back(obj);
+        }
         else
         {
+            bool compressed = false;
+            if (streamIndex < streamObjects.size() && streamObjects[streamIndex] == obj)
+            {
+                if (streamIndex == readyEnd)
+                {
+                    // Wait for the batch being compressed, then start the following one
+                    pending.get();
+                    readyEnd = pendingEnd;
+                    compressNextBatch();
+                }
+
+                obj->moveCompressedStreamFrom(*compressedStreams[streamIndex]);
+                compressedStreams[streamIndex].reset();
+                streamIndex++;
+                compressed = true;
+            }
+
             xref.AddInUseObject(obj->GetIndirectReference(), device.GetPosition());
             // Also make sure that we do not encrypt the encryption dictionary!
             obj->Write(device, m_WriteFlags, obj == m_EncryptObj ? nullptr : m_Encrypt.get(), m_buffer);
+            if (compressed)
+                pins[streamIndex - 1] = { };
         }
     }
 
+    if (compressedObjects.size() != 0)
+        writeObjectStreams(device, compressedObjects, xref);
+
     for (auto& freeObjectRef : objects.GetFreeObjects())
     {
         xref.AddFreeObject(freeObjectRef);
     }
 }
 
+bool PdfWriter::isObjectStreamEligible(const PdfObject& obj) const
+{
+    // ISO 32000-1:2008 7.5.7 "Object Streams": stream objects, objects
+    // with a generation number other than zero and the encryption
+    // dictionary shall not be stored in an object stream
+    return !obj.HasStream()
+        && obj.GetIndirectReference().GenerationNumber() == 0
+        && &obj != m_EncryptObj;
+}
+
+bool PdfWriter::isStreamCompressionEligible(const PdfObject& obj, const PdfReference& metadataRef) const
+{
+    // NOTE: The /Filter key of the dictionary is kept in sync with the
+    // stream filters. Streams left out here are still compressed when
+    // writing the object, serially
+    obj.DelayedLoad();
+    if (!obj.m_Variant.IsDictionary()
+        || obj.m_Variant.GetDictionary().HasKey(PdfName::KeyFilter)
+        || obj.GetIndirectReference() == metadataRef)
+    {
+        return false;
+    }
+
+    if (obj.getStream() != nullptr)
+        return true;
+
+    // Streams not loaded yet, or released to fit the object memory budget
+    auto parserObj = dynamic_cast<const PdfParserObject*>(&obj);
+    return parserObj != nullptr && parserObj->HasStreamToParse();
+}
+
+void PdfWriter::writeObjectStreams(OutputStreamDevice& device, const vector<PdfObject*>& objects, PdfXRef& xref)
+{
+    vector<PdfObject*> objectStreams;
+    try
+    {
+        charbuff header;
+        charbuff data;
+        for (size_t i = 0; i < objects.size(); i += m_ObjectStreamGroupSize)
+        {
+            unsigned count = (unsigned)std::min((size_t)m_ObjectStreamGroupSize, objects.size() - i);
+            auto& objStm = m_Objects->createObjStmObject();
+            objectStreams.push_back(&objStm);
+            uint32_t objStmNum = objStm.GetIndirectReference().ObjectNumber();
+
+            // The stream starts with pairs of object numbers and offsets
+            // relative to the first object, followed by the objects
+            header.clear();
+            data.clear();
+            BufferStreamDevice dataDevice(data);
+            for (unsigned j = 0; j < count; j++)
+            {
+                auto obj = objects[i + j];
+                utls::FormatTo(m_buffer, "{} {} ", obj->GetIndirectReference().ObjectNumber(), dataDevice.GetPosition());
+                header.append(m_buffer);
+
+                // Objects are written without the "obj" envelope and
+                // they are encrypted along with the containing stream
+                obj->GetVariant().Write(dataDevice, m_WriteFlags, { }, m_buffer);
+                dataDevice.Write('\n');
+                obj->ResetDirty();
+                xref.AddCompressedObject(obj->GetIndirectReference(), objStmNum, j);
+            }
+
+            objStm.GetDictionary().AddKey("N", static_cast<int64_t>(count));
+            objStm.GetDictionary().AddKey("First", static_cast<int64_t>(header.size()));
+            header.append(data);
+
+            // The stream is flate compressed when written,
+            // unless PdfWriteFlags::NoFlateCompress is set
+            objStm.GetOrCreateStream().SetData(header, true);
+            xref.AddInUseObject(objStm.GetIndirectReference(), device.GetPosition());
+            objStm.Write(device, m_WriteFlags, m_Encrypt.get(), m_buffer);
+        }
+    }
+    catch (PdfError& e)
+    {
+        m_Objects->removeObjStmObjects(objectStreams);
+        PDFMM_PUSH_FRAME(e);
+        throw e;
+    }
+
+    if (m_IncrementalUpdate)
+    {
+        // Objects in the written update reference the object streams,
+        // which then must be preserved for further updates
+        for (auto objStm : objectStreams)
+            m_Objects->AddObjectStream(objStm->GetIndirectReference().ObjectNumber());
+    }
+    else
+    {
+        m_Objects->removeObjStmObjects(objectStreams);
+    }
+}
+
+void PdfWriter::writeLinearized(OutputStreamDevice& device)
+{
+    auto& objects = *m_Objects;
+    auto resolve = [&objects](const PdfObject* obj) -> const PdfObject* {
+        if (obj != nullptr && obj->IsReference())
+            return objects.GetObject(obj->GetReference());
+
+        return obj;
+    };
+
+    auto& trailerDict = m_Trailer->GetDictionary();
+    auto root = resolve(trailerDict.GetKey("Root"));
+    if (root == nullptr || !root->IsDictionary() || !root->IsIndirect())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Missing document catalog");
+
+    auto& rootDict = root->GetDictionary();
+    auto pagesRoot = resolve(rootDict.GetKey("Pages"));
+    if (pagesRoot == nullptr || !pagesRoot->IsDictionary())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Missing page tree");
+
+    vector<const PdfObject*> pages;
+    vector<array<const PdfObject*, 4>> inheritedAttributes;
+    unordered_set<const PdfObject*> pageNodes;
+    collectPages(objects, *pagesRoot, pages, inheritedAttributes, pageNodes);
+    if (pages.size() == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::PageNotFound, "Linearized files must have at least one page");
+
+    unordered_map<const PdfObject*, unsigned> pageIndices;
+    for (unsigned i = 0; i < pages.size(); i++)
+    {
+        if (!pages[i]->IsIndirect() || !pageIndices.insert({ pages[i], i }).second)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::BrokenFile, "Pages must be indirect objects referenced once in the page tree");
+    }
+
+    // Determine the users of every object, visiting the objects
+    // reachable from each user without crossing page boundaries
+    struct PendingObject
+    {
+        const PdfObject* Object;
+        LinearizedUser User;
+        bool IsTop;
+    };
+
+    unordered_map<const PdfObject*, LinearizedObject> linearizedObjects;
+    vector<vector<const PdfObject*>> pageObjects(pages.size());
+    vector<const PdfObject*> pageTreeObjects;
+    vector<const PdfObject*> outlineObjects;
+    vector<PendingObject> pending;
+    unordered_set<const PdfObject*> visited;
+    auto addUser = [&](const PdfObject& start, LinearizedUser user, unsigned pageIndex,
+        vector<const PdfObject*>* reached)
+    {
+        visited.clear();
+        pending.push_back({ &start, user, true });
+        while (pending.size() != 0)
+        {
+            auto curr = pending.back();
+            pending.pop_back();
+            auto obj = resolve(curr.Object);
+            if (obj == nullptr)
+                continue;
+
+            auto foundPage = pageIndices.find(obj);
+            bool isPage = foundPage != pageIndices.end();
+            if (isPage && !curr.IsTop)
+                continue;
+
+            if (obj->IsIndirect())
+            {
+                if (!visited.insert(obj).second)
+                    continue;
+
+                auto& linearized = linearizedObjects[obj];
+                linearized.UserCount++;
+                switch (curr.User)
+                {
+                    case LinearizedUser::Root:
+                        linearized.IsRoot = true;
+                        break;
+                    case LinearizedUser::OpenDocument:
+                        linearized.InOpenDocument = true;
+                        break;
+                    case LinearizedUser::Outlines:
+                        linearized.InOutlines = true;
+                        break;
+                    case LinearizedUser::Page:
+                        if (pageIndex == 0)
+                            linearized.InFirstPage = true;
+                        else
+                            linearized.OtherPageCount++;
+                        break;
+                    case LinearizedUser::Thumbnail:
+                        linearized.ThumbnailCount++;
+                        break;
+                    case LinearizedUser::Other:
+                        linearized.OtherCount++;
+                        break;
+                }
+
+                if (reached != nullptr && curr.User == user)
+                    reached->push_back(obj);
+            }
+
+            // Children are pushed in reverse order, so they are visited in natural order
+            size_t first = pending.size();
+            if (obj->IsArray())
+            {
+                for (auto& child : obj->GetArray())
+                    pending.push_back({ &child, curr.User, false });
+            }
+            else if (obj->IsDictionary())
+            {
+                bool isPageNode = pageNodes.find(obj) != pageNodes.end();
+                for (auto& pair : obj->GetDictionary())
+                {
+                    if (isPage && pair.first == "Parent")
+                        continue;
+                    else if (isPageNode && isInheritablePageKey(pair.first))
+                        continue;
+                    else if (isPage && pair.first == "Thumb")
+                        pending.push_back({ &pair.second, LinearizedUser::Thumbnail, false });
+                    else
+                        pending.push_back({ &pair.second, curr.User, false });
+                }
+
+                if (isPage)
+                {
+                    // Inherited attributes are written in the pages
+                    for (auto inherited : inheritedAttributes[foundPage->second])
+                    {
+                        if (inherited != nullptr)
+                            pending.push_back({ inherited, curr.User, false });
+                    }
+                }
+            }
+
+            std::reverse(pending.begin() + first, pending.end());
+        }
+    };
+
+    for (unsigned i = 0; i < pages.size(); i++)
+        addUser(*pages[i], LinearizedUser::Page, i, &pageObjects[i]);
+
+    auto info = trailerDict.GetKey("Info");
+    if (info != nullptr)
+        addUser(*info, LinearizedUser::Other, 0, nullptr);
+
+    if (m_EncryptObj != nullptr)
+        addUser(*m_EncryptObj, LinearizedUser::OpenDocument, 0, nullptr);
+
+    for (auto& pair : rootDict)
+    {
+        if (pair.first == "ViewerPreferences" || pair.first == "PageMode"
+            || pair.first == "Threads" || pair.first == "OpenAction"
+            || pair.first == "AcroForm")
+        {
+            addUser(pair.second, LinearizedUser::OpenDocument, 0, nullptr);
+        }
+        else if (pair.first == "Outlines")
+        {
+            addUser(pair.second, LinearizedUser::Outlines, 0, &outlineObjects);
+        }
+        else
+        {
+            addUser(pair.second, LinearizedUser::Other, 0,
+                pair.first == "Pages" ? &pageTreeObjects : nullptr);
+        }
+    }
+
+    auto& rootLinearized = linearizedObjects[root];
+    rootLinearized.IsRoot = true;
+    rootLinearized.UserCount++;
+
+    // Place the objects in the parts of the file. Part 4 holds the catalog and
+    // the objects needed to open the document, part 6 the first page, part 7
+    // the other pages, part 8 the objects shared by them and part 9 the rest
+    auto place = [&linearizedObjects](vector<const PdfObject*>& part, const PdfObject* obj) {
+        auto& linearized = linearizedObjects[obj];
+        if (linearized.Placed)
+            return;
+
+        linearized.Placed = true;
+        part.push_back(obj);
+    };
+    auto placeCategory = [&](vector<const PdfObject*>& part, const vector<const PdfObject*>& candidates,
+        LinearizedCategory category) {
+        for (auto obj : candidates)
+        {
+            if (getLinearizedCategory(linearizedObjects[obj]) == category)
+                place(part, obj);
+        }
+    };
+
+    vector<const PdfObject*> allObjects(objects.begin(), objects.end());
+    vector<const PdfObject*> openDocumentPart;
+    place(openDocumentPart, root);
+    placeCategory(openDocumentPart, allObjects, LinearizedCategory::OpenDocument);
+
+    vector<const PdfObject*> firstPagePart;
+    place(firstPagePart, pages[0]);
+    placeCategory(firstPagePart, allObjects, LinearizedCategory::FirstPagePrivate);
+    placeCategory(firstPagePart, allObjects, LinearizedCategory::FirstPageShared);
+
+    // Outlines hints are written only for an indirect outline dictionary,
+    // which is then the first object reached from the catalog
+    auto outlinesKey = rootDict.GetKey("Outlines");
+    bool hintOutlines = outlinesKey != nullptr && outlinesKey->IsReference()
+        && outlineObjects.size() != 0
+        && getLinearizedCategory(linearizedObjects[outlineObjects[0]]) == LinearizedCategory::Outlines;
+    bool outlinesInFirstPage = hintOutlines
+        && rootDict.FindKeyAs<PdfName>("PageMode") == "UseOutlines";
+    vector<const PdfObject*>* outlinesPart;
+    size_t outlinesFirstIndex;
+    size_t outlinesCount;
+    auto placeOutlines = [&](vector<const PdfObject*>& part) {
+        outlinesPart = &part;
+        outlinesFirstIndex = part.size();
+        placeCategory(part, outlineObjects, LinearizedCategory::Outlines);
+        outlinesCount = part.size() - outlinesFirstIndex;
+    };
+    if (outlinesInFirstPage)
+        placeOutlines(firstPagePart);
+
+    vector<const PdfObject*> otherPart;
+    vector<size_t> pageFirstIndices(pages.size());
+    vector<size_t> pageObjectCounts(pages.size());
+    pageObjectCounts[0] = firstPagePart.size();
+    for (unsigned i = 1; i < pages.size(); i++)
+    {
+        pageFirstIndices[i] = otherPart.size();
+        place(otherPart, pages[i]);
+        placeCategory(otherPart, pageObjects[i], LinearizedCategory::OtherPagePrivate);
+        pageObjectCounts[i] = otherPart.size() - pageFirstIndices[i];
+    }
+
+    size_t sharedFirstIndex = otherPart.size();
+    placeCategory(otherPart, allObjects, LinearizedCategory::OtherPageShared);
+    size_t sharedCount = otherPart.size() - sharedFirstIndex;
+
+    placeCategory(otherPart, pageTreeObjects, LinearizedCategory::Other);
+    if (!outlinesInFirstPage)
+        placeOutlines(otherPart);
+
+    for (auto obj : allObjects)
+        place(otherPart, obj);
+
+    // Renumber the objects in file order, except for the first page
+    // section that starts with the linearization dictionary
+    unordered_map<PdfReference, PdfReference> references;
+    uint32_t objectNum = 1;
+    auto renumber = [&](const vector<const PdfObject*>& part) {
+        for (auto obj : part)
+            references[obj->GetIndirectReference()] = PdfReference(objectNum++, 0);
+    };
+    renumber(otherPart);
+    uint32_t linearizationNum = objectNum++;
+    renumber(openDocumentPart);
+    uint32_t hintNum = objectNum++;
+    renumber(firstPagePart);
+    uint32_t objectCount = objectNum;
+
+    // Write remapped copies of the objects, leaving the document untouched
+    auto metadata = resolve(rootDict.GetKey("Metadata"));
+    auto writeObjects = [&](const vector<const PdfObject*>& part, charbuff& buffer) {
+        BufferStreamDevice stream(buffer);
+        for (auto obj : part)
+        {
+            auto& linearized = linearizedObjects[obj];
+            linearized.Offset = stream.GetPosition();
+            PdfObject copy(*obj);
+            auto foundPage = pageIndices.find(obj);
+            if (foundPage != pageIndices.end())
+            {
+                auto& inherited = inheritedAttributes[foundPage->second];
+                for (unsigned i = 0; i < inherited.size(); i++)
+                {
+                    if (inherited[i] != nullptr)
+                        copy.GetDictionary().AddKey(PdfName(s_inheritablePageKeys[i]), *inherited[i]);
+                }
+            }
+            else if (pageNodes.find(obj) != pageNodes.end())
+            {
+                for (auto& key : s_inheritablePageKeys)
+                    copy.GetDictionary().RemoveKey(PdfName(key));
+            }
+
+            remapReferences(copy, references);
+            copy.SetIndirectReference(references[obj->GetIndirectReference()]);
+
+            // Don't compress the XMP metadata and don't encrypt the encryption dictionary
+            auto flags = m_WriteFlags;
+            if (obj == metadata)
+                flags |= PdfWriteFlags::NoFlateCompress;
+
+            copy.Write(stream, flags, obj == m_EncryptObj ? nullptr : m_Encrypt.get(), m_buffer);
+            linearized.Length = stream.GetPosition() - linearized.Offset;
+        }
+    };
+
+    charbuff openDocumentData;
+    charbuff firstPageData;
+    charbuff otherData;
+    writeObjects(openDocumentPart, openDocumentData);
+    writeObjects(firstPagePart, firstPageData);
+    writeObjects(otherPart, otherData);
+
+    // The linearization dictionary and the first page trailer are written
+    // padded to the length they have with the largest allowed values
+    constexpr uint64_t MaxOffset = numeric_limits<uint32_t>::max();
+    PdfArray identifier;
+    identifier.Add(m_identifier);
+    identifier.Add(m_identifier);
+    auto formatLinearizationDict = [&](charbuff& buffer, uint64_t fileLength, uint64_t hintOffset,
+        uint64_t hintLength, uint64_t firstPageEnd, uint64_t mainXRefEntryOffset) {
+        PdfDictionary dict;
+        dict.AddKey("Linearized", static_cast<int64_t>(1));
+        dict.AddKey("L", static_cast<int64_t>(fileLength));
+        PdfArray hint;
+        hint.Add(static_cast<int64_t>(hintOffset));
+        hint.Add(static_cast<int64_t>(hintLength));
+        dict.AddKey("H", hint);
+        dict.AddKey("O", static_cast<int64_t>(references[pages[0]->GetIndirectReference()].ObjectNumber()));
+        dict.AddKey("E", static_cast<int64_t>(firstPageEnd));
+        dict.AddKey("N", static_cast<int64_t>(pages.size()));
+        dict.AddKey("T", static_cast<int64_t>(mainXRefEntryOffset));
+        buffer.clear();
+        BufferStreamDevice stream(buffer);
+        PdfObject(std::move(dict)).GetVariant().Write(stream, m_WriteFlags, { }, m_buffer);
+    };
+    auto formatFirstPageTrailer = [&](charbuff& buffer, uint64_t mainXRefOffset) {
+        PdfDictionary dict;
+        dict.AddKey(PdfName::KeySize, static_cast<int64_t>(objectCount));
+        dict.AddKey("Root", references[root->GetIndirectReference()]);
+        if (info != nullptr)
+        {
+            PdfObject infoCopy(*info);
+            remapReferences(infoCopy, references);
+            dict.AddKey("Info", infoCopy);
+        }
+
+        if (m_EncryptObj != nullptr)
+            dict.AddKey("Encrypt", references[m_EncryptObj->GetIndirectReference()]);
+
+        dict.AddKey("ID", identifier);
+        dict.AddKey("Prev", static_cast<int64_t>(mainXRefOffset));
+        buffer.clear();
+        BufferStreamDevice stream(buffer);
+        PdfObject(std::move(dict)).GetVariant().Write(stream, m_WriteFlags, { }, m_buffer);
+    };
+    auto writePadded = [&device](const charbuff& buffer, size_t length) {
+        device.Write(buffer);
+        for (size_t i = buffer.size(); i < length; i++)
+            device.Write(' ');
+    };
+
+    charbuff buffer;
+    formatLinearizationDict(buffer, MaxOffset, MaxOffset, MaxOffset, MaxOffset, MaxOffset);
+    size_t linearizationDictLength = buffer.size();
+    formatFirstPageTrailer(buffer, MaxOffset);
+    size_t firstPageTrailerLength = buffer.size();
+
+    charbuff header;
+    {
+        BufferStreamDevice stream(header);
+        WritePdfHeader(stream);
+    }
+
+    constexpr size_t XRefEntryLength = 20;
+    constexpr string_view EndObj = "\nendobj\n";
+    constexpr string_view TrailerKeyword = "trailer\n";
+    constexpr string_view FirstPageStartXRef = "\nstartxref\n0\n%%EOF\n";
+    string linearizationObjHeader = utls::Format("{} 0 obj\n", linearizationNum);
+    string firstPageXRefHeader = utls::Format("xref\n{} {}\n", linearizationNum, objectCount - linearizationNum);
+    size_t firstPageXRefOffset = header.size() + linearizationObjHeader.size()
+        + linearizationDictLength + EndObj.size();
+    size_t openDocumentOffset = firstPageXRefOffset + firstPageXRefHeader.size()
+        + (objectCount - linearizationNum) * XRefEntryLength
+        + TrailerKeyword.size() + firstPageTrailerLength + FirstPageStartXRef.size();
+    size_t hintOffset = openDocumentOffset + openDocumentData.size();
+
+    // Locations in the hint tables are computed as if the hint stream were not present
+    if (hintOffset + firstPageData.size() + otherData.size() > MaxOffset)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Linearized files larger than 4GB are not supported");
+
+    size_t firstPageAdjustedOffset = hintOffset;
+    size_t otherAdjustedOffset = hintOffset + firstPageData.size();
+
+    // Page offset hint table, see ISO 32000-1:2008 F.4.1
+    unordered_map<const PdfObject*, unsigned> sharedIndices;
+    for (unsigned i = 0; i < firstPagePart.size(); i++)
+        sharedIndices[firstPagePart[i]] = i;
+    for (unsigned i = 0; i < sharedCount; i++)
+        sharedIndices[otherPart[sharedFirstIndex + i]] = (unsigned)firstPagePart.size() + i;
+
+    vector<uint64_t> pageLengths(pages.size());
+    vector<vector<unsigned>> pageSharedIds(pages.size());
+    pageLengths[0] = firstPageData.size();
+    for (unsigned i = 1; i < pages.size(); i++)
+    {
+        for (size_t j = 0; j < pageObjectCounts[i]; j++)
+            pageLengths[i] += linearizedObjects[otherPart[pageFirstIndices[i] + j]].Length;
+
+        for (auto obj : pageObjects[i])
+        {
+            if (linearizedObjects[obj].UserCount < 2)
+                continue;
+
+            auto found = sharedIndices.find(obj);
+            if (found != sharedIndices.end())
+                pageSharedIds[i].push_back(found->second);
+        }
+    }
+
+    size_t minObjectCount = *std::min_element(pageObjectCounts.begin(), pageObjectCounts.end());
+    size_t maxObjectCount = *std::max_element(pageObjectCounts.begin(), pageObjectCounts.end());
+    uint64_t minPageLength = *std::min_element(pageLengths.begin(), pageLengths.end());
+    uint64_t maxPageLength = *std::max_element(pageLengths.begin(), pageLengths.end());
+    size_t maxSharedCount = 0;
+    for (auto& sharedIds : pageSharedIds)
+        maxSharedCount = std::max(maxSharedCount, sharedIds.size());
+
+    unsigned objectCountBits = getBitCount(maxObjectCount - minObjectCount);
+    unsigned pageLengthBits = getBitCount(maxPageLength - minPageLength);
+    unsigned sharedCountBits = getBitCount(maxSharedCount);
+    unsigned sharedIdBits = getBitCount(firstPagePart.size() + sharedCount);
+
+    charbuff hintData;
+    HintWriter hints(hintData);
+    hints.WriteBits(minObjectCount, 32);
+    hints.WriteBits(firstPageAdjustedOffset, 32);
+    hints.WriteBits(objectCountBits, 16);
+    hints.WriteBits(minPageLength, 32);
+    hints.WriteBits(pageLengthBits, 16);
+    hints.WriteBits(0, 32);                 // Least content stream offset
+    hints.WriteBits(0, 16);                 // Bits for the content stream offset
+    hints.WriteBits(minPageLength, 32);     // Least content stream length
+    hints.WriteBits(pageLengthBits, 16);    // Bits for the content stream length
+    hints.WriteBits(sharedCountBits, 16);
+    hints.WriteBits(sharedIdBits, 16);
+    hints.WriteBits(0, 16);                 // Bits for the fractional positions numerators
+    hints.WriteBits(4, 16);                 // Fractional positions denominator
+
+    for (unsigned i = 0; i < pages.size(); i++)
+        hints.WriteBits(pageObjectCounts[i] - minObjectCount, objectCountBits);
+    hints.Flush();
+    for (unsigned i = 0; i < pages.size(); i++)
+        hints.WriteBits(pageLengths[i] - minPageLength, pageLengthBits);
+    hints.Flush();
+    for (unsigned i = 0; i < pages.size(); i++)
+        hints.WriteBits(pageSharedIds[i].size(), sharedCountBits);
+    hints.Flush();
+    for (unsigned i = 0; i < pages.size(); i++)
+    {
+        for (unsigned sharedId : pageSharedIds[i])
+            hints.WriteBits(sharedId, sharedIdBits);
+    }
+    hints.Flush();
+    // The numerators have zero bits and the content streams
+    // are considered to span the whole pages
+    hints.Flush();
+    for (unsigned i = 0; i < pages.size(); i++)
+        hints.WriteBits(0, 0);
+    hints.Flush();
+    for (unsigned i = 0; i < pages.size(); i++)
+        hints.WriteBits(pageLengths[i] - minPageLength, pageLengthBits);
+    hints.Flush();
+
+    // Shared object hint table, see ISO 32000-1:2008 F.4.2. Every
+    // group holds a single object, the first page objects come first
+    size_t sharedTableOffset = hintData.size();
+    vector<uint64_t> groupLengths;
+    for (auto obj : firstPagePart)
+        groupLengths.push_back(linearizedObjects[obj].Length);
+    for (size_t i = 0; i < sharedCount; i++)
+        groupLengths.push_back(linearizedObjects[otherPart[sharedFirstIndex + i]].Length);
+
+    uint64_t minGroupLength = *std::min_element(groupLengths.begin(), groupLengths.end());
+    uint64_t maxGroupLength = *std::max_element(groupLengths.begin(), groupLengths.end());
+    unsigned groupLengthBits = getBitCount(maxGroupLength - minGroupLength);
+    if (sharedCount == 0)
+    {
+        hints.WriteBits(0, 32);
+        hints.WriteBits(0, 32);
+    }
+    else
+    {
+        auto firstShared = otherPart[sharedFirstIndex];
+        hints.WriteBits(references[firstShared->GetIndirectReference()].ObjectNumber(), 32);
+        hints.WriteBits(otherAdjustedOffset + linearizedObjects[firstShared].Offset, 32);
+    }
+    hints.WriteBits(firstPagePart.size(), 32);
+    hints.WriteBits(groupLengths.size(), 32);
+    hints.WriteBits(0, 16);                 // Bits for the object counts in the groups
+    hints.WriteBits(minGroupLength, 32);
+    hints.WriteBits(groupLengthBits, 16);
+    for (uint64_t length : groupLengths)
+        hints.WriteBits(length - minGroupLength, groupLengthBits);
+    hints.Flush();
+    for (size_t i = 0; i < groupLengths.size(); i++)
+        hints.WriteBits(0, 1);              // No MD5 signatures
+    hints.Flush();
+
+    // Outline hint table, see ISO 32000-1:2008 F.3.5
+    size_t outlineTableOffset = hintData.size();
+    if (hintOutlines)
+    {
+        auto firstOutline = (*outlinesPart)[outlinesFirstIndex];
+        uint64_t outlinesLength = 0;
+        for (size_t i = 0; i < outlinesCount; i++)
+            outlinesLength += linearizedObjects[(*outlinesPart)[outlinesFirstIndex + i]].Length;
+
+        hints.WriteBits(references[firstOutline->GetIndirectReference()].ObjectNumber(), 32);
+        hints.WriteBits((outlinesInFirstPage ? firstPageAdjustedOffset : otherAdjustedOffset)
+            + linearizedObjects[firstOutline].Offset, 32);
+        hints.WriteBits(outlinesCount, 32);
+        hints.WriteBits(outlinesLength, 32);
+    }
+
+    PdfObject hintObj;
+    hintObj.GetDictionary().AddKey("S", static_cast<int64_t>(sharedTableOffset));
+    if (hintOutlines)
+        hintObj.GetDictionary().AddKey("O", static_cast<int64_t>(outlineTableOffset));
+
+    hintObj.GetOrCreateStream().SetData(hintData, true);
+    hintObj.SetIndirectReference(PdfReference(hintNum, 0));
+    charbuff hintStreamData;
+    {
+        BufferStreamDevice stream(hintStreamData);
+        hintObj.Write(stream, m_WriteFlags, m_Encrypt.get(), m_buffer);
+    }
+
+    size_t firstPageOffset = hintOffset + hintStreamData.size();
+    size_t otherOffset = firstPageOffset + firstPageData.size();
+    size_t mainXRefOffset = otherOffset + otherData.size();
+
+    // The main XRef section, referenced by the
+    // first page trailer, has only the /Size key
+    charbuff mainXRef;
+    utls::FormatTo(mainXRef, "xref\n0 {}\n", linearizationNum);
+    size_t mainXRefEntryOffset = mainXRefOffset + mainXRef.size() - 1;
+    mainXRef.append("0000000000 65535 f \n");
+    for (auto obj : otherPart)
+    {
+        utls::FormatTo(m_buffer, "{:010d} {:05d} {} \n", otherOffset + linearizedObjects[obj].Offset, 0, 'n');
+        mainXRef.append(m_buffer);
+    }
+    mainXRef.append(TrailerKeyword);
+    {
+        PdfDictionary dict;
+        dict.AddKey(PdfName::KeySize, static_cast<int64_t>(linearizationNum));
+        buffer.clear();
+        BufferStreamDevice stream(buffer);
+        PdfObject(std::move(dict)).GetVariant().Write(stream, m_WriteFlags, { }, m_buffer);
+        mainXRef.append(buffer);
+    }
+    utls::FormatTo(m_buffer, "\nstartxref\n{}\n%%EOF\n", firstPageXRefOffset);
+    mainXRef.append(m_buffer);
+    size_t fileLength = mainXRefOffset + mainXRef.size();
+    if (fileLength > MaxOffset)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Linearized files larger than 4GB are not supported");
+
+    // Write the first page section: the linearization
+    // dictionary, the first page XRef section and trailer
+    device.Write(header);
+    device.Write(linearizationObjHeader);
+    formatLinearizationDict(buffer, fileLength, hintOffset, hintStreamData.size(), otherOffset, mainXRefEntryOffset);
+    writePadded(buffer, linearizationDictLength);
+    device.Write(EndObj);
+
+    device.Write(firstPageXRefHeader);
+    auto writeXRefEntry = [&](size_t offset) {
+        utls::FormatTo(m_buffer, "{:010d} {:05d} {} \n", offset, 0, 'n');
+        device.Write(m_buffer);
+    };
+    writeXRefEntry(header.size());
+    for (auto obj : openDocumentPart)
+        writeXRefEntry(openDocumentOffset + linearizedObjects[obj].Offset);
+    writeXRefEntry(hintOffset);
+    for (auto obj : firstPagePart)
+        writeXRefEntry(firstPageOffset + linearizedObjects[obj].Offset);
+
+    device.Write(TrailerKeyword);
+    formatFirstPageTrailer(buffer, mainXRefOffset);
+    writePadded(buffer, firstPageTrailerLength);
+    device.Write(FirstPageStartXRef);
+
+    device.Write(openDocumentData);
+    device.Write(hintStreamData);
+    device.Write(firstPageData);
+    device.Write(otherData);
+    device.Write(mainXRef);
+}
+
 void PdfWriter::FillTrailerObject(PdfObject& trailer, size_t size, bool onlySizeKey) const
 {
     trailer.GetDictionary().AddKey(PdfName::KeySize, static_cast<int64_t>(size));
@@ -313,6 +1245,14 @@ void PdfWriter::SetEncrypt(const PdfEncrypt& encrypt)
     m_Encrypt = PdfEncrypt::CreateFromEncrypt(encrypt);
 }
 
+void PdfWriter::SetObjectStreamGroupSize(unsigned groupSize)
+{
+    if (groupSize == 0 || groupSize > numeric_limits<uint16_t>::max())
+        PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    m_ObjectStreamGroupSize = groupSize;
+}
+
 void PdfWriter::SetUseXRefStream(bool useXRefStream)
 {
     if (useXRefStream && m_Version < PdfVersion::V1_5)
@@ -336,5 +1276,159 @@ PdfWriteFlags ToWriteFlags(PdfSaveOptions opts)
         ret |= PdfWriteFlags::Clean;
     }
 
+    if ((opts & PdfSaveOptions::FlateBestSpeed) !=
+        PdfSaveOptions::None)
+    {
+        ret |= PdfWriteFlags::FlateBestSpeed;
+    }
+    else if ((opts & PdfSaveOptions::FlateBestCompression) !=
+        PdfSaveOptions::None)
+    {
+        ret |= PdfWriteFlags::FlateBestCompression;
+    }
+
+    return ret;
+}
+
+LinearizedCategory getLinearizedCategory(const LinearizedObject& obj)
+{
+    if (obj.IsRoot)
+        return LinearizedCategory::Root;
+    else if (obj.InOutlines)
+        return LinearizedCategory::Outlines;
+    else if (obj.InOpenDocument)
+        return LinearizedCategory::OpenDocument;
+
+    bool hasOtherUsers = obj.ThumbnailCount != 0 || obj.OtherCount != 0;
+    if (obj.InFirstPage)
+    {
+        return obj.OtherPageCount == 0 && !hasOtherUsers
+            ? LinearizedCategory::FirstPagePrivate
+            : LinearizedCategory::FirstPageShared;
+    }
+    else if (obj.OtherPageCount == 1 && !hasOtherUsers)
+    {
+        return LinearizedCategory::OtherPagePrivate;
+    }
+    else if (obj.OtherPageCount > 1)
+    {
+        return LinearizedCategory::OtherPageShared;
+    }
+
+    return LinearizedCategory::Other;
+}
+
+bool isInheritablePageKey(const PdfName& key)
+{
+    for (auto& inheritableKey : s_inheritablePageKeys)
+    {
+        if (key == inheritableKey)
+            return true;
+    }
+
+    return false;
+}
+
+void collectPages(PdfIndirectObjectList& objects, const PdfObject& root,
+    vector<const PdfObject*>& pages, vector<array<const PdfObject*, 4>>& inheritedAttributes,
+    unordered_set<const PdfObject*>& nodes)
+{
+    struct Node
+    {
+        const PdfObject* Object;
+        array<const PdfObject*, 4> Inherited;
+    };
+
+    // Depth first visit of the page tree, keeping
+    // track of the attributes set in the ancestors
+    vector<Node> stack;
+    stack.push_back({ &root, { } });
+    while (stack.size() != 0)
+    {
+        auto node = stack.back();
+        stack.pop_back();
+        auto& dict = node.Object->GetDictionary();
+        auto type = dict.FindKeyAs<PdfName>("Type");
+        if (type == "Page")
+        {
+            array<const PdfObject*, 4> inherited;
+            for (unsigned i = 0; i < inherited.size(); i++)
+                inherited[i] = dict.HasKey(s_inheritablePageKeys[i]) ? nullptr : node.Inherited[i];
+
+            pages.push_back(node.Object);
+            inheritedAttributes.push_back(inherited);
+            continue;
+        }
+
+        if ((type != "Pages" && node.Object != &root) || !nodes.insert(node.Object).second)
+            continue;
+
+        for (unsigned i = 0; i < node.Inherited.size(); i++)
+        {
+            auto value = dict.GetKey(s_inheritablePageKeys[i]);
+            if (value != nullptr)
+                node.Inherited[i] = value;
+        }
+
+        const PdfObject* kids = dict.GetKey("Kids");
+        if (kids != nullptr && kids->IsReference())
+            kids = objects.GetObject(kids->GetReference());
+
+        if (kids == nullptr || !kids->IsArray())
+            continue;
+
+        auto& kidsArr = kids->GetArray();
+        for (unsigned i = kidsArr.GetSize(); i > 0; i--)
+        {
+            const PdfObject* kid = &kidsArr[i - 1];
+            if (kid->IsReference())
+                kid = objects.GetObject(kid->GetReference());
+
+            if (kid != nullptr && kid->IsDictionary())
+                stack.push_back({ kid, node.Inherited });
+        }
+    }
+}
+
+void remapReferences(PdfObject& obj, const unordered_map<PdfReference, PdfReference>& references)
+{
+    switch (obj.GetDataType())
+    {
+        case PdfDataType::Reference:
+        {
+            // References to missing objects are replaced with null
+            auto found = references.find(obj.GetReference());
+            if (found == references.end())
+                obj = PdfObject::Null;
+            else
+                obj = PdfObject(found->second);
+            break;
+        }
+        case PdfDataType::Array:
+        {
+            for (auto& child : obj.GetArray())
+                remapReferences(child, references);
+            break;
+        }
+        case PdfDataType::Dictionary:
+        {
+            for (auto& pair : obj.GetDictionary())
+                remapReferences(pair.second, references);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+unsigned getBitCount(uint64_t value)
+{
+    unsigned ret = 0;
+    while (value != 0)
+    {
+        ret++;
+        value >>= 1;
+    }
+
     return ret;
 }
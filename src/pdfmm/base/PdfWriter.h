@@ -67,6 +67,25 @@ public:
      */
     void SetEncrypt(const PdfEncrypt& encrypt);
 
+    /** Set the maximum count of objects grouped in a single object
+     *  stream, when writing with PdfSaveOptions::ObjectStreams
+     *  Default is 100.
+     *  \param groupSize the group size, in the range [1, 65535]
+     */
+    void SetObjectStreamGroupSize(unsigned groupSize);
+
+    /** Set the number of threads used to flate compress the object
+     *  streams. Streams are compressed on worker threads ahead of the
+     *  serial write of the objects, with output identical to the one
+     *  of the serial compression. Encryption is always serial.
+     *
+     *  Default is 1, meaning streams are compressed serially.
+     *
+     *  \param threadCount the number of threads to use. 0 means
+     *     to use the hardware concurrency
+     */
+    inline void SetCompressionThreadCount(unsigned threadCount) { m_CompressionThreadCount = threadCount; }
+
 
     /** Add required keys to a trailer object
      *  \param trailer add keys to this object
@@ -99,6 +118,16 @@ public:
      */
     inline bool GetUseXRefStream() const { return m_UseXRefStream; }
 
+    /**
+     *  \returns the maximum count of objects grouped in a single object stream
+     */
+    inline unsigned GetObjectStreamGroupSize() const { return m_ObjectStreamGroupSize; }
+
+    /**
+     *  \returns the number of threads used to compress the object streams
+     */
+    inline unsigned GetCompressionThreadCount() const { return m_CompressionThreadCount; }
+
     /** Sets an offset to the previous XRef table. Set it to lower than
      *  or equal to 0, to not write a reference to the previous XRef table.
      *  The default is 0.
@@ -170,6 +199,33 @@ protected:
     void SetIdentifier(const PdfString& identifier) { m_identifier = identifier; }
     void SetEncryptObj(PdfObject& obj);
 
+private:
+    /** Test if the object can be stored in a compressed object stream
+     */
+    bool isObjectStreamEligible(const PdfObject& obj) const;
+
+    /** Test if the stream of the object will be flate compressed when
+     *  writing it, deciding from the object dictionary without loading
+     *  the stream
+     *  \param metadataRef the reference of the document /Metadata object
+     */
+    bool isStreamCompressionEligible(const PdfObject& obj, const PdfReference& metadataRef) const;
+
+    /** Write the objects grouped in compressed object streams
+     *  \param device write to this output device
+     *  \param objects the objects to write
+     *  \param xref add all the written objects to this XRefTable
+     */
+    void writeObjectStreams(OutputStreamDevice& device, const std::vector<PdfObject*>& objects, PdfXRef& xref);
+
+    /** Write a linearized file, as described in ISO 32000-1:2008 Annex F.
+     *  The objects are renumbered and reordered so the objects needed
+     *  to display the first page come first, followed by the hint stream
+     *  describing the location of the objects of the other pages
+     *  \param device write to this output device
+     */
+    void writeLinearized(OutputStreamDevice& device);
+
 protected:
     charbuff m_buffer;
 
@@ -179,6 +235,8 @@ private:
     PdfVersion m_Version;
 
     bool m_UseXRefStream;
+    unsigned m_ObjectStreamGroupSize;
+    unsigned m_CompressionThreadCount;
 
     std::unique_ptr<PdfEncrypt> m_Encrypt;    // If not nullptr encrypt all strings and streams and
                                                // create an encryption dictionary in the trailer
@@ -28,31 +28,41 @@ PdfXRef::~PdfXRef() { }
 
 void PdfXRef::AddInUseObject(const PdfReference& ref, nullable<uint64_t> offset)
 {
-    addObject(ref, offset, true);
+    if (offset == nullptr)
+    {
+        // Objects with no offset provided will not be written
+        // in the entry list
+        if (ref.ObjectNumber() > m_maxObjCount)
+            m_maxObjCount = ref.ObjectNumber();
+
+        return;
+    }
+
+    XRefItem item(ref, *offset);
+    addObject(ref, &item);
 }
 
 void PdfXRef::AddFreeObject(const PdfReference& ref)
 {
-    addObject(ref, nullptr, false);
+    addObject(ref, nullptr);
 }
 
-void PdfXRef::addObject(const PdfReference& ref, nullable<uint64_t> offset, bool inUse)
+void PdfXRef::AddCompressedObject(const PdfReference& ref, uint32_t objectStreamNum, unsigned index)
+{
+    XRefItem item(ref, objectStreamNum, index);
+    addObject(ref, &item);
+}
+
+void PdfXRef::addObject(const PdfReference& ref, const XRefItem* item)
 {
     if (ref.ObjectNumber() > m_maxObjCount)
         m_maxObjCount = ref.ObjectNumber();
 
-    if (inUse && offset == nullptr)
-    {
-        // Objects with no offset provided will not be written
-        // in the entry list
-        return;
-    }
-
     bool insertDone = false;
 
     for (auto& block : m_blocks)
     {
-        if (block.InsertItem(ref, offset, inUse))
+        if (block.InsertItem(ref, item))
         {
             insertDone = true;
             break;
@@ -64,8 +74,8 @@ void PdfXRef::addObject(const PdfReference& ref, nullable<uint64_t> offset, bool
         PdfXRefBlock block;
         block.First = ref.ObjectNumber();
         block.Count = 1;
-        if (inUse)
-            block.Items.push_back(XRefItem(ref, offset.value()));
+        if (item != nullptr)
+            block.Items.push_back(*item);
         else
             block.FreeItems.push_back(ref);
 
@@ -130,8 +140,16 @@ void PdfXRef::Write(OutputStreamDevice& device, charbuff& buffer)
                 itFree++;
             }
 
-            this->WriteXRefEntry(device, itItems->Reference,
-                PdfXRefEntry::CreateInUse(itItems->Offset, itItems->Reference.GenerationNumber()), buffer);
+            if (itItems->Type == XRefEntryType::Compressed)
+            {
+                this->WriteXRefEntry(device, itItems->Reference,
+                    PdfXRefEntry::CreateCompressed((uint32_t)itItems->Offset, itItems->Index), buffer);
+            }
+            else
+            {
+                this->WriteXRefEntry(device, itItems->Reference,
+                    PdfXRefEntry::CreateInUse(itItems->Offset, itItems->Reference.GenerationNumber()), buffer);
+            }
             itItems++;
         }
 
@@ -319,16 +337,16 @@ bool PdfXRef::ShouldSkipWrite(const PdfReference& ref)
     return false;
 }
 
-bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, nullable<uint64_t> offset, bool inUse)
+bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, const XRefItem* item)
 {
-    PDFMM_ASSERT(!inUse || offset.has_value());
+    bool inUse = item != nullptr;
     if (ref.ObjectNumber() == First + Count)
     {
         // Insert at back
         Count++;
 
         if (inUse)
-            Items.push_back(XRefItem(ref, offset.value()));
+            Items.push_back(*item);
         else
             FreeItems.push_back(ref);
 
@@ -342,7 +360,7 @@ bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, nullable<uint64_
 
         // This is known to be slow, but should not occur actually
         if (inUse)
-            Items.insert(Items.begin(), XRefItem(ref, offset.value()));
+            Items.insert(Items.begin(), *item);
         else
             FreeItems.insert(FreeItems.begin(), ref);
 
@@ -356,7 +374,7 @@ bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, nullable<uint64_
 
         if (inUse)
         {
-            Items.push_back(XRefItem(ref, offset.value()));
+            Items.push_back(*item);
             std::sort(Items.begin(), Items.end());
         }
         else
@@ -27,10 +27,15 @@ protected:
     struct XRefItem
     {
         XRefItem(const PdfReference& ref, uint64_t off)
-            : Reference(ref), Offset(off) { }
+            : Reference(ref), Offset(off), Index(0), Type(XRefEntryType::InUse) { }
+
+        XRefItem(const PdfReference& ref, uint32_t objectStreamNum, unsigned index)
+            : Reference(ref), Offset(objectStreamNum), Index(index), Type(XRefEntryType::Compressed) { }
 
         PdfReference Reference;
-        uint64_t Offset;
+        uint64_t Offset;    // The object stream number for compressed items
+        unsigned Index;     // Index of the object in the stream for compressed items
+        XRefEntryType Type;
 
         bool operator<(const XRefItem& rhs) const
         {
@@ -48,7 +53,7 @@ protected:
 
         PdfXRefBlock(const PdfXRefBlock& rhs) = default;
 
-        bool InsertItem(const PdfReference& ref, nullable<uint64_t> offset, bool bUsed);
+        bool InsertItem(const PdfReference& ref, const XRefItem* item);
 
         bool operator<(const PdfXRefBlock& rhs) const
         {
@@ -91,6 +96,15 @@ public:
      */
     void AddFreeObject(const PdfReference& ref);
 
+    /** Add an object stored in a compressed object stream to the XRef table.
+     *  Requires the table to be written as a XRef stream
+     *
+     *  \param ref reference of this object
+     *  \param objectStreamNum the object number of the containing object stream
+     *  \param index the index of the object in the object stream
+     */
+    void AddCompressedObject(const PdfReference& ref, uint32_t objectStreamNum, unsigned index);
+
     /** Write the XRef table to an output device.
      *
      *  \param device an output device (usually a PDF file)
@@ -161,7 +175,7 @@ protected:
     virtual void EndWriteImpl(OutputStreamDevice& device, charbuff& buffer);
 
 private:
-    void addObject(const PdfReference& ref, nullable<uint64_t> offset, bool inUse);
+    void addObject(const PdfReference& ref, const XRefItem* item);
 
     /** Called at the end of writing the XRef table.
      *  Sub classes can overload this method to finish a XRef table.
@@ -73,10 +73,14 @@ void PdfXRefStream::WriteXRefEntry(OutputStreamDevice& device, const PdfReferenc
         case XRefEntryType::InUse:
             stmEntry.Variant = AS_BIG_ENDIAN(static_cast<uint32_t>(entry.Offset));
             break;
+        case XRefEntryType::Compressed:
+            stmEntry.Variant = AS_BIG_ENDIAN(static_cast<uint32_t>(entry.ObjectNumber));
+            break;
         default:
             PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
     }
 
+    // NOTE: For compressed entries this is the index of the object in the stream
     stmEntry.Generation = AS_BIG_ENDIAN(static_cast<uint16_t>(entry.Generation));
     m_rawEntries.push_back(stmEntry);
 }
@@ -21,9 +21,11 @@
 #include "base/PdfData.h"
 #include "base/PdfDataProvider.h"
 #include "base/PdfDate.h"
+#include "base/PdfDecodedStreamCache.h"
 #include "base/PdfDictionary.h"
 #include "base/PdfEncoding.h"
 #include "base/PdfCMapEncoding.h"
+#include "base/PdfCMapCache.h"
 #include "base/PdfEncodingFactory.h"
 #include "base/PdfEncodingMapFactory.h"
 #include "base/PdfDifferenceEncoding.h"
@@ -0,0 +1,94 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2022 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDFMM_PARALLEL_UTILS_H
+#define PDFMM_PARALLEL_UTILS_H
+
+#include <thread>
+#include <vector>
+#include <exception>
+#include <system_error>
+
+namespace utls
+{
+    /** Get the effective number of worker threads to use
+     * \param threadCount the requested thread count. 0 means
+     *     the hardware concurrency
+     */
+    inline unsigned GetThreadCount(unsigned threadCount)
+    {
+        if (threadCount == 0)
+            threadCount = std::thread::hardware_concurrency();
+
+        return threadCount == 0 ? 1 : threadCount;
+    }
+
+    /** Split the [0, count) range in contiguous chunks and process
+     * them concurrently with the supplied function, which has
+     * signature void(size_t begin, size_t end, unsigned chunkIndex)
+     *
+     * The first chunk is processed on the calling thread. If any
+     * chunk throws, the exception of the chunk with the lowest index
+     * is rethrown after all threads joined
+     * \returns the number of chunks that were processed
+     */
+    template <typename TFunction>
+    unsigned ParallelFor(size_t count, unsigned threadCount, const TFunction& function)
+    {
+        if (count == 0)
+            return 0;
+
+        threadCount = GetThreadCount(threadCount);
+        unsigned chunkCount = count < threadCount ? (unsigned)count : threadCount;
+        if (chunkCount == 1)
+        {
+            function((size_t)0, count, 0u);
+            return 1;
+        }
+
+        std::vector<std::exception_ptr> exceptions(chunkCount);
+        auto runChunk = [&](unsigned chunkIndex) {
+            size_t begin = count * chunkIndex / chunkCount;
+            size_t end = count * (chunkIndex + 1) / chunkCount;
+            try
+            {
+                function(begin, end, chunkIndex);
+            }
+            catch (...)
+            {
+                exceptions[chunkIndex] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(chunkCount - 1);
+        for (unsigned i = 1; i < chunkCount; i++)
+        {
+            try
+            {
+                threads.emplace_back(runChunk, i);
+            }
+            catch (std::system_error&)
+            {
+                // Unable to spawn a new thread, process the chunk here
+                runChunk(i);
+            }
+        }
+
+        runChunk(0);
+        for (auto& thread : threads)
+            thread.join();
+
+        for (auto& exception : exceptions)
+        {
+            if (exception != nullptr)
+                std::rethrow_exception(exception);
+        }
+
+        return chunkCount;
+    }
+}
+
+#endif // PDFMM_PARALLEL_UTILS_H
@@ -161,6 +161,12 @@ namespace mm
     std::string_view AnnotationTypeToName(PdfAnnotationType type);
     PdfAnnotationType NameToAnnotationType(const std::string_view& str);
 
+    /** Write a linearized file, optimized for incremental access ("Fast Web View").
+     *  Not supported with incremental updates and object streams. Kept out of the
+     *  public PdfSaveOptions until the output is checked with an external validator
+     */
+    constexpr PdfSaveOptions PdfSaveOptionsLinearize = PdfSaveOptions::_Reserved3;
+
     constexpr double DEG2RAD = std::numbers::pi / 180;
     constexpr double RAD2DEG = 180 / std::numbers::pi;
 
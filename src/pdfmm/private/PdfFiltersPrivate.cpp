@@ -10,6 +10,8 @@
 #include <pdfmm/base/PdfTokenizer.h>
 #include <pdfmm/base/PdfStreamDevice.h>
 
+#include "PredictorUtils.h"
+
 using namespace std;
 using namespace mm;
 
@@ -20,6 +22,15 @@ namespace mm {
 // evaluation.
 const unsigned s_Powers85[] = { 85 * 85 * 85 * 85, 85 * 85 * 85, 85 * 85, 85, 1 };
 
+#ifdef PDFMM_HAVE_LIBDEFLATE
+// Deflate can't expand data more than 1032:1
+constexpr size_t MaxDeflateRatio = 1032;
+// The maximum size of the data decoded by libdeflate as a whole buffer
+constexpr size_t MaxWholeBufferDecodeSize = 64 * 1024 * 1024;
+// The maximum size of the encoded data collected for libdeflate
+constexpr size_t MaxWholeBufferDecodeInputSize = 4 * 1024 * 1024;
+#endif
+
 /**
  * This structur contains all necessary values
  * for a FlateDecode and LZWDecode Predictor.
@@ -35,7 +46,6 @@ public:
         m_Colors = static_cast<int>(decodeParms.FindKeyAs<int64_t>("Colors", 1));
         m_BitsPerComponent = static_cast<int>(decodeParms.FindKeyAs<int64_t>("BitsPerComponent", 8));
         m_ColumnCount = static_cast<int>(decodeParms.FindKeyAs<int64_t>("Columns", 1));
-        m_EarlyChange = static_cast<int>(decodeParms.FindKeyAs<int64_t>("EarlyChange", 1));
 
         // check that input values are in range (CVE-2018-20797)
         // ISO 32000-2008 specifies these values as all 1 or greater
@@ -43,37 +53,55 @@ public:
         if (m_ColumnCount < 1 || m_Colors < 1 || m_BitsPerComponent < 1)
             PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
 
-        if (m_Predictor >= 10)
-        {
-            m_NextByteIsPredictor = true;
-            m_CurrPredictor = -1;
-        }
-        else
+        switch (m_Predictor)
         {
-            m_NextByteIsPredictor = false;
-            m_CurrPredictor = m_Predictor;
+            case 1: // No prediction
+                break;
+            case 2: // Tiff Predictor
+            {
+                switch (m_BitsPerComponent)
+                {
+                    case 1:
+                    case 2:
+                    case 4:
+                    case 8:
+                    case 16:
+                        break;
+                    default:
+                        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor,
+                            "Unsupported bits per component {} for tiff predictor", m_BitsPerComponent);
+                }
+                break;
+            }
+            case 10: // Png predictors: the actual filter
+            case 11: // is specified by the tag byte of each row
+            case 12:
+            case 13:
+            case 14:
+            case 15:
+                break;
+            default:
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor, "Invalid predictor {}", m_Predictor);
         }
 
-        m_CurrRowIndex = 0;
-        m_BytesPerPixel = (m_BitsPerComponent * m_Colors) >> 3;
-        m_Rows = (m_ColumnCount * m_Colors * m_BitsPerComponent) >> 3;
-
         // check for multiplication overflow on buffer sizes (e.g. if m_nBPC=2 and m_nColors=SIZE_MAX/2+1)
         if (utls::DoesMultiplicationOverflow(m_BitsPerComponent, m_Colors)
-            || utls::DoesMultiplicationOverflow(m_ColumnCount, m_BitsPerComponent * m_Colors))
+            || utls::DoesMultiplicationOverflow(m_ColumnCount, m_BitsPerComponent * m_Colors)
+            || (size_t)m_ColumnCount * (m_BitsPerComponent * m_Colors) > numeric_limits<int>::max() - 7)
         {
             PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
         }
 
-        // check that computed allocation sizes are > 0 (CVE-2018-20797)
-        if (m_Rows < 1 || m_BitsPerComponent < 1)
-            PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
-
-        m_Prev.resize(m_Rows);
-        memset(m_Prev.data(), 0, sizeof(char) * m_Rows);
+        // Rows and pixels are padded to byte boundaries. The png bytes
+        // per pixel are rounded up to 1 for less than 8 bits per pixel
+        m_RowLength = (m_ColumnCount * m_Colors * m_BitsPerComponent + 7) >> 3;
+        m_BytesPerPixel = std::max(1, (m_BitsPerComponent * m_Colors + 7) >> 3);
 
-        m_UpperLeftPixelComponents.resize(m_BytesPerPixel);
-        memset(m_UpperLeftPixelComponents.data(), 0, sizeof(char) * m_BytesPerPixel);
+        // Png rows are prefixed with the tag byte of the row filter
+        m_RowOffset = m_Predictor >= 10 ? 1 : 0;
+        m_Row.resize(m_RowOffset + m_RowLength);
+        m_Prev.resize(m_RowOffset + m_RowLength);
+        m_RowFill = 0;
     }
 
     void Decode(const char* buffer, size_t len, OutputStream* stream)
@@ -84,115 +112,35 @@ public:
             return;
         }
 
-        while (len-- != 0)
+        // Collect complete rows and decode them at once
+        size_t rowSize = m_Row.size();
+        while (len != 0)
         {
-            if (m_NextByteIsPredictor)
+            size_t count = std::min(len, rowSize - m_RowFill);
+            std::memcpy(m_Row.data() + m_RowFill, buffer, count);
+            m_RowFill += count;
+            buffer += count;
+            len -= count;
+            if (m_RowFill < rowSize)
+                break;
+
+            auto row = reinterpret_cast<uint8_t*>(m_Row.data()) + m_RowOffset;
+            if (m_Predictor == 2)
             {
-                m_CurrPredictor = *buffer + 10;
-                m_NextByteIsPredictor = false;
+                utls::DecodeTiffRow(row, (unsigned)m_ColumnCount, (unsigned)m_Colors, (unsigned)m_BitsPerComponent);
             }
             else
             {
-                switch (m_CurrPredictor)
-                {
-                    case 2: // Tiff Predictor
-                    {
-                        if (m_BitsPerComponent == 8)
-                        {   // Same as png sub
-                            int prev = (m_CurrRowIndex - m_BytesPerPixel < 0
-                                ? 0 : m_Prev[m_CurrRowIndex - m_BytesPerPixel]);
-                            m_Prev[m_CurrRowIndex] = *buffer + prev;
-                            break;
-                        }
-
-                        // TODO: implement tiff predictor for other than 8 BPC
-                        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor, "tiff predictors other than 8 BPC are not implemented");
-                        break;
-                    }
-                    case 10: // png none
-                    {
-                        m_Prev[m_CurrRowIndex] = *buffer;
-                        break;
-                    }
-                    case 11: // png sub
-                    {
-                        int prev = (m_CurrRowIndex - m_BytesPerPixel < 0
-                            ? 0 : m_Prev[m_CurrRowIndex - m_BytesPerPixel]);
-                        m_Prev[m_CurrRowIndex] = *buffer + prev;
-                        break;
-                    }
-                    case 12: // png up
-                    {
-                        m_Prev[m_CurrRowIndex] += *buffer;
-                        break;
-                    }
-                    case 13: // png average
-                    {
-                        int prev = (m_CurrRowIndex - m_BytesPerPixel < 0
-                            ? 0 : m_Prev[m_CurrRowIndex - m_BytesPerPixel]);
-                        m_Prev[m_CurrRowIndex] = ((prev + m_Prev[m_CurrRowIndex]) >> 1) + *buffer;
-                        break;
-                    }
-                    case 14: // png paeth
-                    {
-                        int nLeftByteIndex = m_CurrRowIndex - m_BytesPerPixel;
-
-                        int a = nLeftByteIndex < 0 ? 0 : static_cast<unsigned char>(m_Prev[nLeftByteIndex]);
-                        int b = static_cast<unsigned char>(m_Prev[m_CurrRowIndex]);
-
-                        int nCurrComponentIndex = m_CurrRowIndex % m_BytesPerPixel;
-                        int c = nLeftByteIndex < 0 ? 0 : static_cast<unsigned char>(m_UpperLeftPixelComponents[nCurrComponentIndex]);
-
-                        int p = a + b - c;
-
-                        int pa = p - a;
-                        if (pa < 0)
-                            pa = -pa;
-
-                        int pb = p - b;
-                        if (pb < 0)
-                            pb = -pb;
-
-                        int pc = p - c;
-                        if (pc < 0)
-                            pc = -pc;
-
-                        char closestByte;
-                        if (pa <= pb && pa <= pc)
-                            closestByte = a;
-                        else if (pb <= pc)
-                            closestByte = b;
-                        else
-                            closestByte = c;
-
-                        // Save the byte we're about to clobber for the next pixel's prediction
-                        m_UpperLeftPixelComponents[nCurrComponentIndex] = m_Prev[m_CurrRowIndex];
-
-                        m_Prev[m_CurrRowIndex] = *buffer + closestByte;
-                        break;
-                    }
-                    case 15: // png optimum
-                        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor, "png optimum predictor is not implemented");
-                        break;
-
-                    default:
-                    {
-                        //PDFMM_RAISE_ERROR( EPdfError::InvalidPredictor );
-                        break;
-                    }
-                }
-
-                m_CurrRowIndex++;
+                utls::DecodePngRow((utls::PngFilterType)m_Row[0], row,
+                    reinterpret_cast<const uint8_t*>(m_Prev.data()) + m_RowOffset,
+                    (size_t)m_RowLength, (unsigned)m_BytesPerPixel);
             }
 
-            buffer++;
+            stream->Write(m_Row.data() + m_RowOffset, m_RowLength);
 
-            if (m_CurrRowIndex >= m_Rows)
-            {   // One line finished
-                m_CurrRowIndex = 0;
-                m_NextByteIsPredictor = (m_CurrPredictor >= 10);
-                stream->Write(m_Prev.data(), m_Rows);
-            }
+            // The decoded row is the upper row of the next one
+            std::swap(m_Row, m_Prev);
+            m_RowFill = 0;
         }
     }
 
@@ -201,21 +149,13 @@ private:
     int m_Colors;
     int m_BitsPerComponent;
     int m_ColumnCount;
-    int m_EarlyChange;
     int m_BytesPerPixel;     // Bytes per pixel
+    int m_RowLength;         // Decoded row length in bytes
+    size_t m_RowOffset;
+    size_t m_RowFill;
 
-    int m_CurrPredictor;
-    int m_CurrRowIndex;
-    int m_Rows;
-
-    bool m_NextByteIsPredictor;
-
+    charbuff m_Row;
     charbuff m_Prev;
-
-    // The PNG Paeth predictor uses the values of the pixel above and to the left
-    // of the current pixel. But we overwrite the row above as we go, so we'll
-    // have to store the bytes of the upper-left pixel separately.
-    charbuff m_UpperLeftPixelComponents;
 };
 
 } // end anonymous namespace
@@ -462,25 +402,49 @@ void PdfAscii85Filter::WidePut(unsigned tuple, int bytes) const
 
 #pragma endregion PdfFlateFilter
 
-PdfFlateFilter::PdfFlateFilter()
+PdfFlateFilter::PdfFlateFilter(PdfCompressionLevel level) :
+    m_level(level)
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    , m_streamDecode(false),
+    m_compressor(nullptr),
+    m_decompressor(nullptr)
+#endif
 {
     memset(m_buffer, 0, sizeof(m_buffer));
     memset(&m_stream, 0, sizeof(m_stream));
 }
 
+PdfFlateFilter::~PdfFlateFilter()
+{
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    if (m_compressor != nullptr)
+        libdeflate_free_compressor(m_compressor);
+    if (m_decompressor != nullptr)
+        libdeflate_free_decompressor(m_decompressor);
+#endif
+}
+
 void PdfFlateFilter::BeginEncodeImpl()
 {
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    m_data.clear();
+#else
     m_stream.zalloc = Z_NULL;
     m_stream.zfree = Z_NULL;
     m_stream.opaque = Z_NULL;
 
-    if (deflateInit(&m_stream, Z_DEFAULT_COMPRESSION))
+    if (deflateInit(&m_stream, static_cast<int>(m_level)))
         PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+#endif
 }
 
 void PdfFlateFilter::EncodeBlockImpl(const char* buffer, size_t len)
 {
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    m_data.append(buffer, len);
+#else
     this->EncodeBlockInternal(buffer, len, Z_NO_FLUSH);
+#endif
 }
 
 void PdfFlateFilter::EncodeBlockInternal(const char* buffer, size_t len, int nMode)
@@ -521,24 +485,104 @@ void PdfFlateFilter::EncodeBlockInternal(const char* buffer, size_t len, int nMo
 
 void PdfFlateFilter::EndEncodeImpl()
 {
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    if (m_compressor == nullptr)
+    {
+        // libdeflate has no default level: use the
+        // one zlib maps Z_DEFAULT_COMPRESSION to
+        m_compressor = libdeflate_alloc_compressor(m_level == PdfCompressionLevel::Default
+            ? 6 : static_cast<int>(m_level));
+        if (m_compressor == nullptr)
+        {
+            FailEncodeDecode();
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::Flate, "Unsupported compression level");
+        }
+    }
+
+    charbuff compressed(libdeflate_zlib_compress_bound(m_compressor, m_data.size()));
+    size_t compressedSize = libdeflate_zlib_compress(m_compressor,
+        m_data.data(), m_data.size(), compressed.data(), compressed.size());
+    m_data.clear();
+    if (compressedSize == 0)
+    {
+        FailEncodeDecode();
+        PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+    }
+
+    try
+    {
+        GetStream()->Write(compressed.data(), compressedSize);
+    }
+    catch (PdfError& e)
+    {
+        // clean up after any output stream errors
+        FailEncodeDecode();
+        PDFMM_PUSH_FRAME(e);
+        throw e;
+    }
+#else
     this->EncodeBlockInternal(nullptr, 0, Z_FINISH);
     deflateEnd(&m_stream);
+#endif
 }
 
 void PdfFlateFilter::BeginDecodeImpl(const PdfDictionary* decodeParms)
 {
+    if (decodeParms != nullptr)
+        m_Predictor.reset(new PdfPredictorDecoder(*decodeParms));
+
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    m_data.clear();
+    m_streamDecode = false;
+#else
     m_stream.zalloc = Z_NULL;
     m_stream.zfree = Z_NULL;
     m_stream.opaque = Z_NULL;
 
-    if (decodeParms != nullptr)
-        m_Predictor.reset(new PdfPredictorDecoder(*decodeParms));
-
     if (inflateInit(&m_stream) != Z_OK)
         PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+#endif
 }
 
 void PdfFlateFilter::DecodeBlockImpl(const char* buffer, size_t len)
+{
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    if (!m_streamDecode)
+    {
+        if (m_data.size() + len <= MaxWholeBufferDecodeInputSize)
+        {
+            m_data.append(buffer, len);
+            return;
+        }
+
+        // Don't hold big encoded streams in memory: decode
+        // them with zlib as the data comes instead
+        beginStreamDecode();
+    }
+#endif
+    DecodeBlockInternal(buffer, len);
+}
+
+#ifdef PDFMM_HAVE_LIBDEFLATE
+void PdfFlateFilter::beginStreamDecode()
+{
+    m_stream.zalloc = Z_NULL;
+    m_stream.zfree = Z_NULL;
+    m_stream.opaque = Z_NULL;
+    if (inflateInit(&m_stream) != Z_OK)
+    {
+        FailEncodeDecode();
+        PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+    }
+
+    m_streamDecode = true;
+    charbuff data = std::move(m_data);
+    m_data.clear();
+    DecodeBlockInternal(data.data(), data.size());
+}
+#endif
+
+void PdfFlateFilter::DecodeBlockInternal(const char* buffer, size_t len)
 {
     int flateErr;
     unsigned writtenDataSize;
@@ -568,29 +612,93 @@ void PdfFlateFilter::DecodeBlockImpl(const char* buffer, size_t len)
         }
 
         writtenDataSize = BUFFER_SIZE - m_stream.avail_out;
-        try
-        {
-            if (m_Predictor != nullptr)
-                m_Predictor->Decode(reinterpret_cast<char*>(m_buffer), writtenDataSize, GetStream());
-            else
-                GetStream()->Write(reinterpret_cast<char*>(m_buffer), writtenDataSize);
-        }
-        catch (PdfError& e)
-        {
-            // clean up after any output stream errors
-            FailEncodeDecode();
-            PDFMM_PUSH_FRAME(e);
-            throw e;
-        }
+        writeDecoded(reinterpret_cast<char*>(m_buffer), writtenDataSize);
     } while (m_stream.avail_out == 0);
 }
 
+void PdfFlateFilter::writeDecoded(const char* buffer, size_t len)
+{
+    try
+    {
+        if (m_Predictor != nullptr)
+            m_Predictor->Decode(buffer, len, GetStream());
+        else
+            GetStream()->Write(buffer, len);
+    }
+    catch (PdfError& e)
+    {
+        // clean up after any output stream errors
+        FailEncodeDecode();
+        PDFMM_PUSH_FRAME(e);
+        throw e;
+    }
+}
+
 void PdfFlateFilter::EndDecodeImpl()
 {
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    if (!m_streamDecode)
+        decodeWholeBuffer();
+
+    if (m_streamDecode)
+    {
+        (void)inflateEnd(&m_stream);
+        m_streamDecode = false;
+    }
+#else
     (void)inflateEnd(&m_stream);
+#endif
     m_Predictor.reset();
 }
 
+#ifdef PDFMM_HAVE_LIBDEFLATE
+void PdfFlateFilter::decodeWholeBuffer()
+{
+    if (m_decompressor == nullptr)
+    {
+        m_decompressor = libdeflate_alloc_decompressor();
+        if (m_decompressor == nullptr)
+        {
+            FailEncodeDecode();
+            PDFMM_RAISE_ERROR(PdfErrorCode::OutOfMemory);
+        }
+    }
+
+    // The decoded size is unknown: start from a typical compression
+    // ratio and grow the buffer as needed, up to the maximum deflate
+    // ratio and a size limit. Bigger data is decoded by zlib a block at
+    // a time, so decompression bombs can't exhaust memory here
+    size_t maxSize = m_data.size() > MaxWholeBufferDecodeSize / MaxDeflateRatio
+        ? MaxWholeBufferDecodeSize : std::max<size_t>(BUFFER_SIZE, m_data.size() * MaxDeflateRatio);
+    charbuff decoded(std::min(maxSize, std::max<size_t>(BUFFER_SIZE, m_data.size() * 4)));
+    size_t decodedSize;
+    libdeflate_result result;
+    while ((result = libdeflate_zlib_decompress(m_decompressor, m_data.data(), m_data.size(),
+        decoded.data(), decoded.size(), &decodedSize)) == LIBDEFLATE_INSUFFICIENT_SPACE
+        && decoded.size() < maxSize)
+    {
+        // Don't copy the partially decoded data
+        size_t size = std::min(decoded.size() * 2, maxSize);
+        decoded.clear();
+        decoded.resize(size);
+    }
+
+    if (result == LIBDEFLATE_SUCCESS)
+    {
+        m_data.clear();
+        writeDecoded(decoded.data(), decodedSize);
+    }
+    else
+    {
+        // Damaged streams, such as truncated ones, are decoded
+        // by zlib as far as it's possible, as well as the ones
+        // exceeding the size limit
+        charbuff().swap(decoded);
+        beginStreamDecode();
+    }
+}
+#endif
+
 #pragma endregion // PdfFlateFilter
 
 #pragma region PdfRLEFilter
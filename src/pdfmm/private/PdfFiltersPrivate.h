@@ -19,6 +19,9 @@
 #include <pdfmm/base/PdfFilter.h>
 
 #include <zlib.h>
+#ifdef PDFMM_HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
 
 namespace mm {
 
@@ -86,13 +89,20 @@ private:
 };
 
 /** The Flate filter.
+ *
+ * When built with libdeflate the data is collected and
+ * compressed or decompressed as a whole buffer at the end,
+ * falling back to zlib for damaged streams. Big encoded
+ * streams are decoded by zlib a block at a time instead
  */
 class PdfFlateFilter final : public PdfFilter
 {
     static constexpr unsigned BUFFER_SIZE = 4096;
 
 public:
-    PdfFlateFilter();
+    PdfFlateFilter(PdfCompressionLevel level = PdfCompressionLevel::Default);
+
+    ~PdfFlateFilter();
 
     inline bool CanEncode() const override { return true; }
 
@@ -114,12 +124,25 @@ public:
 
 private:
     void EncodeBlockInternal(const char* buffer, size_t len, int nMode);
+    void DecodeBlockInternal(const char* buffer, size_t len);
+    void writeDecoded(const char* buffer, size_t len);
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    void beginStreamDecode();
+    void decodeWholeBuffer();
+#endif
 
 private:
     unsigned char m_buffer[BUFFER_SIZE];
 
+    PdfCompressionLevel m_level;
     z_stream m_stream;
     std::shared_ptr<PdfPredictorDecoder> m_Predictor;
+#ifdef PDFMM_HAVE_LIBDEFLATE
+    charbuff m_data;
+    bool m_streamDecode;
+    libdeflate_compressor* m_compressor;
+    libdeflate_decompressor* m_decompressor;
+#endif
 };
 
 /** The RLE filter.
@@ -0,0 +1,388 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2022 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PredictorUtils.h"
+
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PDFMM_PREDICTOR_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) || defined(__GNUC__)
+// AVX2 kernels are compiled regardless of the target
+// architecture flags and selected at runtime
+#define PDFMM_PREDICTOR_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PDFMM_TARGET_AVX2
+#else
+#define PDFMM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#endif
+
+using namespace std;
+using namespace mm;
+
+using DecodeUpFunction = void(*)(uint8_t* row, const uint8_t* prev, size_t len);
+
+static DecodeUpFunction selectDecodeUp();
+static void decodeSub(uint8_t* row, size_t len, unsigned bpp);
+static void decodeAverage(uint8_t* row, const uint8_t* prev, size_t len, unsigned bpp);
+static void decodePaeth(uint8_t* row, const uint8_t* prev, size_t len, unsigned bpp);
+static void decodeUpScalar(uint8_t* row, const uint8_t* prev, size_t len);
+static uint8_t paethPredictor(int a, int b, int c);
+
+void utls::DecodePngRow(PngFilterType type, uint8_t* row, const uint8_t* prev,
+    size_t len, unsigned bpp)
+{
+    switch (type)
+    {
+        case PngFilterType::Sub:
+            decodeSub(row, len, bpp);
+            break;
+        case PngFilterType::Up:
+        {
+            static const DecodeUpFunction decodeUp = selectDecodeUp();
+            decodeUp(row, prev, len);
+            break;
+        }
+        case PngFilterType::Average:
+            decodeAverage(row, prev, len, bpp);
+            break;
+        case PngFilterType::Paeth:
+            decodePaeth(row, prev, len, bpp);
+            break;
+        case PngFilterType::None:
+        default:
+            // The row is already reconstructed
+            break;
+    }
+}
+
+void utls::DecodeTiffRow(uint8_t* row, unsigned columns, unsigned colors,
+    unsigned bitsPerComponent)
+{
+    size_t sampleCount = (size_t)columns * colors;
+    switch (bitsPerComponent)
+    {
+        case 8:
+        {
+            for (size_t i = colors; i < sampleCount; i++)
+                row[i] = (uint8_t)(row[i] + row[i - colors]);
+            break;
+        }
+        case 16:
+        {
+            // Samples are stored big-endian
+            for (size_t i = colors; i < sampleCount; i++)
+            {
+                uint8_t* curr = row + i * 2;
+                const uint8_t* left = row + (i - colors) * 2;
+                unsigned value = ((unsigned)curr[0] << 8 | curr[1])
+                    + ((unsigned)left[0] << 8 | left[1]);
+                curr[0] = (uint8_t)(value >> 8);
+                curr[1] = (uint8_t)value;
+            }
+            break;
+        }
+        case 1:
+        case 2:
+        case 4:
+        {
+            // Samples are packed starting from the most significant bit
+            unsigned mask = (1u << bitsPerComponent) - 1;
+            size_t leftOffset = (size_t)colors * bitsPerComponent;
+            for (size_t i = colors; i < sampleCount; i++)
+            {
+                size_t offset = i * bitsPerComponent;
+                size_t left = offset - leftOffset;
+                unsigned shift = 8 - bitsPerComponent - (unsigned)(offset & 7);
+                unsigned leftShift = 8 - bitsPerComponent - (unsigned)(left & 7);
+                unsigned value = (row[offset >> 3] >> shift) + (row[left >> 3] >> leftShift);
+                row[offset >> 3] = (uint8_t)((row[offset >> 3] & ~(mask << shift))
+                    | ((value & mask) << shift));
+            }
+            break;
+        }
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor,
+                "Unsupported bits per component {} for tiff predictor", bitsPerComponent);
+    }
+}
+
+#ifdef PDFMM_PREDICTOR_SSE2
+
+// The kernels below that depend on the reconstructed left pixel process one
+// pixel at a time, as the PNG filters are inherently serial in that direction
+
+template <unsigned Bpp>
+static __m128i loadPixel(const uint8_t* src)
+{
+    uint64_t value = 0;
+    std::memcpy(&value, src, Bpp);
+    return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&value));
+}
+
+template <unsigned Bpp>
+static void storePixel(uint8_t* dst, __m128i pixel)
+{
+    uint64_t value;
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&value), pixel);
+    std::memcpy(dst, &value, Bpp);
+}
+
+static __m128i selectMask(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static __m128i abs16(__m128i x)
+{
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static void decodeUpSSE2(uint8_t* row, const uint8_t* prev, size_t len)
+{
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), _mm_add_epi8(x, b));
+    }
+
+    decodeUpScalar(row + i, prev + i, len - i);
+}
+
+template <unsigned Bpp>
+static void decodeSubSSE2(uint8_t* row, size_t len)
+{
+    __m128i a = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + Bpp <= len; i += Bpp)
+    {
+        a = _mm_add_epi8(a, loadPixel<Bpp>(row + i));
+        storePixel<Bpp>(row + i, a);
+    }
+
+    for (; i < len; i++)
+        row[i] = (uint8_t)(row[i] + row[i - Bpp]);
+}
+
+template <unsigned Bpp>
+static void decodeAverageSSE2(uint8_t* row, const uint8_t* prev, size_t len)
+{
+    const __m128i ones = _mm_set1_epi8(1);
+    __m128i a = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + Bpp <= len; i += Bpp)
+    {
+        __m128i b = loadPixel<Bpp>(prev + i);
+        // _mm_avg_epu8 rounds up: subtract the rounding bit to get floor((a + b) / 2)
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), ones));
+        a = _mm_add_epi8(loadPixel<Bpp>(row + i), avg);
+        storePixel<Bpp>(row + i, a);
+    }
+
+    for (; i < len; i++)
+        row[i] = (uint8_t)(row[i] + ((row[i - Bpp] + prev[i]) >> 1));
+}
+
+template <unsigned Bpp>
+static void decodePaethSSE2(uint8_t* row, const uint8_t* prev, size_t len)
+{
+    // The predictor is computed on 16 bit lanes to not overflow
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowMask = _mm_set1_epi16(0xFF);
+    __m128i a = zero;
+    __m128i c = zero;
+    size_t i = 0;
+    for (; i + Bpp <= len; i += Bpp)
+    {
+        __m128i b = _mm_unpacklo_epi8(loadPixel<Bpp>(prev + i), zero);
+        __m128i x = _mm_unpacklo_epi8(loadPixel<Bpp>(row + i), zero);
+
+        // With p = a + b - c: |p - a| = |b - c|, |p - b| = |a - c|, |p - c| = |a + b - 2c|
+        __m128i pa = _mm_sub_epi16(b, c);
+        __m128i pb = _mm_sub_epi16(a, c);
+        __m128i pc = abs16(_mm_add_epi16(pa, pb));
+        pa = abs16(pa);
+        pb = abs16(pb);
+        __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+        __m128i nearest = selectMask(_mm_cmpeq_epi16(pa, smallest), a,
+            selectMask(_mm_cmpeq_epi16(pb, smallest), b, c));
+
+        a = _mm_and_si128(_mm_add_epi16(x, nearest), lowMask);
+        storePixel<Bpp>(row + i, _mm_packus_epi16(a, a));
+        c = b;
+    }
+
+    for (; i < len; i++)
+        row[i] = (uint8_t)(row[i] + paethPredictor(row[i - Bpp], prev[i], prev[i - Bpp]));
+}
+
+#endif // PDFMM_PREDICTOR_SSE2
+
+#ifdef PDFMM_PREDICTOR_AVX2
+
+PDFMM_TARGET_AVX2 static void decodeUpAVX2(uint8_t* row, const uint8_t* prev, size_t len)
+{
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i), _mm256_add_epi8(x, b));
+    }
+
+    decodeUpSSE2(row + i, prev + i, len - i);
+}
+
+static bool isAVX2Supported()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // Check that AVX is supported and the OS saves the YMM registers
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0
+        || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // PDFMM_PREDICTOR_AVX2
+
+DecodeUpFunction selectDecodeUp()
+{
+#if defined(PDFMM_PREDICTOR_AVX2)
+    if (isAVX2Supported())
+        return decodeUpAVX2;
+#endif
+#if defined(PDFMM_PREDICTOR_SSE2)
+    return decodeUpSSE2;
+#else
+    return decodeUpScalar;
+#endif
+}
+
+void decodeUpScalar(uint8_t* row, const uint8_t* prev, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        row[i] = (uint8_t)(row[i] + prev[i]);
+}
+
+void decodeSub(uint8_t* row, size_t len, unsigned bpp)
+{
+#ifdef PDFMM_PREDICTOR_SSE2
+    switch (bpp)
+    {
+        case 3:
+            decodeSubSSE2<3>(row, len);
+            return;
+        case 4:
+            decodeSubSSE2<4>(row, len);
+            return;
+        case 6:
+            decodeSubSSE2<6>(row, len);
+            return;
+        case 8:
+            decodeSubSSE2<8>(row, len);
+            return;
+        default:
+            break;
+    }
+#endif
+    for (size_t i = bpp; i < len; i++)
+        row[i] = (uint8_t)(row[i] + row[i - bpp]);
+}
+
+void decodeAverage(uint8_t* row, const uint8_t* prev, size_t len, unsigned bpp)
+{
+#ifdef PDFMM_PREDICTOR_SSE2
+    switch (bpp)
+    {
+        case 3:
+            decodeAverageSSE2<3>(row, prev, len);
+            return;
+        case 4:
+            decodeAverageSSE2<4>(row, prev, len);
+            return;
+        case 6:
+            decodeAverageSSE2<6>(row, prev, len);
+            return;
+        case 8:
+            decodeAverageSSE2<8>(row, prev, len);
+            return;
+        default:
+            break;
+    }
+#endif
+    size_t i = 0;
+    for (; i < bpp && i < len; i++)
+        row[i] = (uint8_t)(row[i] + (prev[i] >> 1));
+
+    for (; i < len; i++)
+        row[i] = (uint8_t)(row[i] + ((row[i - bpp] + prev[i]) >> 1));
+}
+
+void decodePaeth(uint8_t* row, const uint8_t* prev, size_t len, unsigned bpp)
+{
+#ifdef PDFMM_PREDICTOR_SSE2
+    switch (bpp)
+    {
+        case 3:
+            decodePaethSSE2<3>(row, prev, len);
+            return;
+        case 4:
+            decodePaethSSE2<4>(row, prev, len);
+            return;
+        case 6:
+            decodePaethSSE2<6>(row, prev, len);
+            return;
+        case 8:
+            decodePaethSSE2<8>(row, prev, len);
+            return;
+        default:
+            break;
+    }
+#endif
+    size_t i = 0;
+    // With no left pixel the predictor is always the upper one
+    for (; i < bpp && i < len; i++)
+        row[i] = (uint8_t)(row[i] + prev[i]);
+
+    for (; i < len; i++)
+        row[i] = (uint8_t)(row[i] + paethPredictor(row[i - bpp], prev[i], prev[i - bpp]));
+}
+
+uint8_t paethPredictor(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return (uint8_t)a;
+    else if (pb <= pc)
+        return (uint8_t)b;
+    else
+        return (uint8_t)c;
+}
@@ -0,0 +1,48 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2022 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PREDICTOR_UTILS_H
+#define PREDICTOR_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utls
+{
+    /** PNG row filter types, as specified by the tag byte of each row
+     */
+    enum class PngFilterType : uint8_t
+    {
+        None = 0,
+        Sub,
+        Up,
+        Average,
+        Paeth,
+    };
+
+    /** Reverse a PNG row filter in place
+     * \param type the filter type of the row. Unknown types
+     *     are handled as PngFilterType::None
+     * \param row the filtered row, replaced with the reconstructed one
+     * \param prev the previous reconstructed row, all zeros for the first row
+     * \param len the length of the rows in bytes
+     * \param bpp the count of bytes per complete pixel, rounded up to 1
+     *
+     * Vectorized kernels are used when available, selected at runtime
+     */
+    void DecodePngRow(PngFilterType type, uint8_t* row, const uint8_t* prev,
+        size_t len, unsigned bpp);
+
+    /** Reverse the TIFF predictor 2 (horizontal differencing) in place
+     * \param row the row with the differenced samples, replaced with the reconstructed one
+     * \param columns the count of pixels in the row
+     * \param colors the count of color components per pixel
+     * \param bitsPerComponent one of 1, 2, 4, 8 or 16
+     */
+    void DecodeTiffRow(uint8_t* row, unsigned columns, unsigned colors,
+        unsigned bitsPerComponent);
+}
+
+#endif // PREDICTOR_UTILS_H
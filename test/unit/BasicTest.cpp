@@ -11,6 +11,28 @@
 using namespace std;
 using namespace mm;
 
+namespace mm
+{
+    class PdfIndirectObjectListTest
+    {
+    public:
+        static void PushObject(PdfIndirectObjectList& objects, unique_ptr<PdfObject> obj)
+        {
+            objects.PushObject(obj.release());
+        }
+
+        static void AddFreeObject(PdfIndirectObjectList& objects, const PdfReference& ref)
+        {
+            objects.AddFreeObject(ref);
+        }
+
+        static int32_t SafeAddFreeObject(PdfIndirectObjectList& objects, const PdfReference& ref)
+        {
+            return objects.SafeAddFreeObject(ref);
+        }
+    };
+}
+
 /** This class tests the basic integer and other types PoDoFo uses
  *  to make sure they satisfy its requirements for behaviour, size, etc.
  */
@@ -33,3 +55,92 @@ TEST_CASE("ErrorFilePath")
         REQUIRE(fs::u8path(path) == fs::u8path("base") / "PdfVariant.cpp");
     }
 }
+
+TEST_CASE("testIndirectObjectList")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    size_t initialSize = objects.GetSize();
+
+    auto& obj1 = objects.CreateObject(PdfName("Obj1"));
+    auto& obj2 = objects.CreateObject(PdfName("Obj2"));
+    auto& obj3 = objects.CreateObject(PdfName("Obj3"));
+    auto ref2 = obj2.GetIndirectReference();
+    REQUIRE(objects.GetSize() == initialSize + 3);
+    REQUIRE(objects.GetObject(obj1.GetIndirectReference()) == &obj1);
+    REQUIRE(objects.GetObject(ref2) == &obj2);
+    REQUIRE(objects.GetObject(PdfReference(ref2.ObjectNumber(), ref2.GenerationNumber() + 1)) == nullptr);
+    REQUIRE(objects.GetObject(PdfReference(obj3.GetIndirectReference().ObjectNumber() + 100, 0)) == nullptr);
+
+    // Removing an object leaves a hole that must be skipped
+    auto removed = objects.RemoveObject(ref2);
+    REQUIRE(removed.get() == &obj2);
+    REQUIRE(objects.GetObject(ref2) == nullptr);
+    REQUIRE(objects.GetSize() == initialSize + 2);
+
+    // Iteration is ordered by reference and skips free slots
+    vector<PdfReference> refs;
+    for (auto obj : objects)
+        refs.push_back(obj->GetIndirectReference());
+    REQUIRE(refs.size() == objects.GetSize());
+    REQUIRE(std::is_sorted(refs.begin(), refs.end()));
+    REQUIRE(std::find(refs.begin(), refs.end(), ref2) == refs.end());
+
+    vector<PdfReference> reverseRefs;
+    for (auto it = objects.rbegin(); it != objects.rend(); it++)
+        reverseRefs.push_back((*it)->GetIndirectReference());
+    REQUIRE(std::equal(refs.rbegin(), refs.rend(), reverseRefs.begin(), reverseRefs.end()));
+
+    // The free object number is reused with an incremented generation
+    auto& obj4 = objects.CreateObject(PdfName("Obj4"));
+    REQUIRE(obj4.GetIndirectReference() == PdfReference(ref2.ObjectNumber(), ref2.GenerationNumber() + 1));
+    REQUIRE(objects.GetObject(ref2) == nullptr);
+    REQUIRE(objects.GetObject(obj4.GetIndirectReference()) == &obj4);
+}
+
+TEST_CASE("testIndirectObjectListGenerations")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+
+    // Removing and creating objects reuses the object number
+    // with increasing generation numbers
+    auto refA = objects.CreateObject(PdfName("A")).GetIndirectReference();
+    auto objA = objects.RemoveObject(refA);
+    auto& objB = objects.CreateObject(PdfName("B"));
+    auto refB = objB.GetIndirectReference();
+    REQUIRE(refB == PdfReference(refA.ObjectNumber(), refA.GenerationNumber() + 1));
+    size_t size = objects.GetSize();
+
+    // An older generation doesn't replace the existing object
+    PdfIndirectObjectListTest::PushObject(objects, std::move(objA));
+    REQUIRE(objects.GetSize() == size);
+    REQUIRE(objects.GetObject(refA) == nullptr);
+    REQUIRE(objects.GetObject(refB) == &objB);
+
+    // A newer generation replaces it
+    auto removedB = objects.RemoveObject(refB);
+    auto refC = objects.CreateObject(PdfName("C")).GetIndirectReference();
+    REQUIRE(refC == PdfReference(refB.ObjectNumber(), refB.GenerationNumber() + 1));
+    auto objC = objects.RemoveObject(refC);
+    PdfIndirectObjectListTest::PushObject(objects, std::move(removedB));
+    PdfIndirectObjectListTest::PushObject(objects, std::move(objC));
+    REQUIRE(objects.GetSize() == size);
+    REQUIRE(objects.GetObject(refB) == nullptr);
+    REQUIRE(objects.MustGetObject(refC).GetName() == "C");
+
+    // Free objects are kept ordered, whatever the insertion order
+    PdfIndirectObjectListTest::AddFreeObject(objects, PdfReference(60, 0));
+    PdfIndirectObjectListTest::AddFreeObject(objects, PdfReference(70, 0));
+    PdfIndirectObjectListTest::AddFreeObject(objects, PdfReference(65, 0));
+    PdfIndirectObjectListTest::AddFreeObject(objects, PdfReference(70, 0));
+    auto& freeObjects = objects.GetFreeObjects();
+    REQUIRE(std::is_sorted(freeObjects.begin(), freeObjects.end()));
+    REQUIRE(std::adjacent_find(freeObjects.begin(), freeObjects.end()) == freeObjects.end());
+    REQUIRE(std::find(freeObjects.begin(), freeObjects.end(), PdfReference(65, 0)) != freeObjects.end());
+
+    // Object numbers that reached the maximum generation are not reused
+    REQUIRE(PdfIndirectObjectListTest::SafeAddFreeObject(objects, PdfReference(80, 65534)) == -1);
+    REQUIRE(std::none_of(freeObjects.begin(), freeObjects.end(),
+        [](const PdfReference& ref) { return ref.ObjectNumber() == 80; }));
+}
@@ -35,3 +35,84 @@ TEST_CASE("testSaveIncremental")
     doc.SaveUpdate(testPath);
     doc.Load(testPath);
 }
+
+TEST_CASE("testSaveToLoadedPath")
+{
+    auto testPath = TestUtils::GetTestOutputFilePath("testSaveToLoadedPath.pdf");
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetOrCreateStream().SetData("Test stream data"sv);
+        doc.GetCatalog().GetDictionary().AddKey("TestStream", obj.GetIndirectReference());
+        doc.Save(testPath);
+    }
+
+    {
+        PdfMemDocument doc;
+        doc.Load(testPath);
+        doc.Save(testPath);
+    }
+
+    {
+        // The data borrowed from the mapped file is copied before truncating it
+        PdfMemDocument doc;
+        doc.LoadFromDevice(std::make_shared<MappedFileStreamDevice>(testPath));
+        doc.Save(testPath);
+        auto& obj = doc.GetCatalog().GetDictionary().MustFindKey("TestStream");
+        REQUIRE(obj.MustGetStream().GetCopy() == "Test stream data");
+    }
+
+    PdfMemDocument doc;
+    doc.Load(testPath);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+    auto& obj = doc.GetCatalog().GetDictionary().MustFindKey("TestStream");
+    REQUIRE(obj.MustGetStream().GetCopy() == "Test stream data");
+}
+
+TEST_CASE("testMappedFileDevice")
+{
+    auto testPath = TestUtils::GetTestOutputFilePath("testMappedFileDevice.pdf");
+    {
+        PdfMemDocument doc;
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetOrCreateStream().SetData("Test stream data"sv);
+        doc.GetCatalog().GetDictionary().AddKey("TestStream", obj.GetIndirectReference());
+        doc.Save(testPath);
+    }
+
+    charbuff expected;
+    utls::ReadTo(expected, testPath);
+
+    MappedFileStreamDevice device(testPath);
+    REQUIRE(device.GetLength() == expected.size());
+
+    bufferview span;
+    REQUIRE(device.TryGetSpan(span));
+    REQUIRE(span == expected);
+
+    charbuff read(expected.size());
+    device.Read(read.data(), read.size());
+    REQUIRE(read == expected);
+    REQUIRE(device.Eof());
+
+    // Stream data is borrowed from the mapped file when loading on demand
+    PdfMemDocument doc;
+    doc.LoadFromDevice(std::make_shared<MappedFileStreamDevice>(testPath));
+    auto& obj = doc.GetCatalog().GetDictionary().MustFindKey("TestStream");
+    auto& provider = dynamic_cast<const PdfMemoryObjectStream&>(std::as_const(obj).MustGetStream().GetProvider());
+    REQUIRE(provider.IsBorrowed());
+    REQUIRE(obj.MustGetStream().GetCopy() == "Test stream data");
+    charbuff raw(provider.GetView());
+    REQUIRE(provider.IsBorrowed());
+
+    // Getting the buffer copies borrowed data
+    REQUIRE(provider.GetBuffer() == raw);
+    REQUIRE(!provider.IsBorrowed());
+
+    // Copies always own the data
+    PdfObject copy(obj);
+    auto& copyProvider = dynamic_cast<const PdfMemoryObjectStream&>(std::as_const(copy).MustGetStream().GetProvider());
+    REQUIRE(!copyProvider.IsBorrowed());
+    REQUIRE(copy.MustGetStream().GetCopy() == "Test stream data");
+}
@@ -0,0 +1,294 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <PdfTest.h>
+
+#include <map>
+
+using namespace std;
+using namespace mm;
+
+namespace
+{
+    struct NameComparator
+    {
+        using is_transparent = std::true_type;
+        bool operator()(const PdfName& lhs, const PdfName& rhs) const
+        {
+            return lhs < rhs;
+        }
+        bool operator()(const PdfName& lhs, const string_view& rhs) const
+        {
+            return lhs.GetRawData() < rhs;
+        }
+        bool operator()(const string_view& lhs, const PdfName& rhs) const
+        {
+            return lhs < rhs.GetRawData();
+        }
+    };
+}
+
+static vector<string> getTestKeys(unsigned count);
+static string generateDocumentWithFonts(unsigned pageCount);
+
+TEST_CASE("testDictionaryOrder")
+{
+    PdfDictionary dict;
+    dict.AddKey("Subtype", PdfName("Type1"));
+    dict.AddKey("Type", PdfName("Font"));
+    dict.AddKey("BaseFont", PdfName("Helvetica"));
+    dict.AddKey("FirstChar", static_cast<int64_t>(32));
+    dict.AddKey("LastChar", static_cast<int64_t>(255));
+    dict.AddKey("Encoding", PdfName("WinAnsiEncoding"));
+    REQUIRE(dict.GetSize() == 6);
+
+    vector<string> keys;
+    for (auto& pair : dict)
+        keys.push_back(pair.first.GetString());
+    REQUIRE(keys == vector<string>{ "BaseFont", "Encoding", "FirstChar", "LastChar", "Subtype", "Type" });
+
+    // Replacing a key keeps the size
+    dict.AddKey("FirstChar", static_cast<int64_t>(0));
+    REQUIRE(dict.GetSize() == 6);
+    REQUIRE(dict.MustGetKey("FirstChar").GetNumber() == 0);
+
+    REQUIRE(dict.RemoveKey("Encoding"));
+    REQUIRE(!dict.RemoveKey("Encoding"));
+    REQUIRE(!dict.HasKey("Encoding"));
+    REQUIRE(dict.GetKey("Encoding") == nullptr);
+    REQUIRE(dict.GetSize() == 5);
+
+    PdfObject obj(std::move(dict));
+    REQUIRE(obj.GetDictionary().GetSize() == 5);
+    REQUIRE(obj.GetDictionary().MustGetKey("BaseFont").GetName() == "Helvetica");
+
+    auto& copy = obj.GetDictionary();
+    REQUIRE(obj.GetDictionary().MustFindKey("Type").GetName() == "Font");
+    for (auto& pair : copy)
+        REQUIRE(pair.second.GetParent() == &copy);
+
+    obj.GetDictionary().Clear();
+    REQUIRE(obj.GetDictionary().GetSize() == 0);
+    REQUIRE(obj.GetDictionary().begin() == obj.GetDictionary().end());
+}
+
+TEST_CASE("testDictionaryValueStability")
+{
+    // Values must not be relocated when the dictionary grows,
+    // when other keys are removed or when it's moved
+    auto keys = getTestKeys(100);
+    PdfDictionary dict;
+    vector<PdfObject*> values;
+    for (unsigned i = 0; i < keys.size(); i++)
+        values.push_back(&dict.AddKey(PdfName(keys[i]), static_cast<int64_t>(i)));
+
+    REQUIRE(dict.GetSize() == keys.size());
+    for (unsigned i = 0; i < keys.size(); i++)
+    {
+        REQUIRE(dict.GetKey(keys[i]) == values[i]);
+        REQUIRE(values[i]->GetNumber() == (int64_t)i);
+    }
+
+    for (unsigned i = 0; i < keys.size(); i += 2)
+        REQUIRE(dict.RemoveKey(keys[i]));
+
+    // Removed slots are reused by new keys
+    dict.AddKey("NewKey", PdfObject());
+    REQUIRE(dict.GetSize() == keys.size() / 2 + 1);
+    for (unsigned i = 1; i < keys.size(); i += 2)
+    {
+        REQUIRE(dict.GetKey(keys[i]) == values[i]);
+        REQUIRE(values[i]->GetNumber() == (int64_t)i);
+    }
+
+    vector<string> iteratedKeys;
+    for (auto& pair : std::as_const(dict))
+        iteratedKeys.push_back(pair.first.GetString());
+    REQUIRE(std::is_sorted(iteratedKeys.begin(), iteratedKeys.end()));
+
+    // Copies are deep and compare equal
+    PdfDictionary copy(dict);
+    REQUIRE(copy == dict);
+    REQUIRE(copy.GetKey(keys[1]) != dict.GetKey(keys[1]));
+    copy.AddKey("NewKey", static_cast<int64_t>(1));
+    REQUIRE(!(copy == dict));
+
+    auto copyValue = copy.GetKey(keys[1]);
+    PdfDictionary moved(std::move(copy));
+    REQUIRE(moved.GetSize() == dict.GetSize());
+    REQUIRE(moved.MustGetKey("NewKey").GetNumber() == 1);
+    REQUIRE(moved.GetKey(keys[1]) == copyValue);
+    for (auto& pair : moved)
+        REQUIRE(pair.second.GetParent() == &moved);
+}
+
+TEST_CASE("testDictionaryLarge")
+{
+    // Large dictionaries switch to a tree index
+    auto keys = getTestKeys(5000);
+    PdfDictionary dict;
+    vector<PdfObject*> values;
+    for (unsigned i = 0; i < keys.size(); i++)
+        values.push_back(&dict.AddKey(PdfName(keys[i]), static_cast<int64_t>(i)));
+
+    REQUIRE(dict.GetSize() == keys.size());
+    for (unsigned i = 0; i < keys.size(); i++)
+        REQUIRE(dict.GetKey(keys[i]) == values[i]);
+
+    vector<string> iteratedKeys;
+    for (auto& pair : dict)
+        iteratedKeys.push_back(pair.first.GetString());
+    REQUIRE(iteratedKeys.size() == keys.size());
+    REQUIRE(std::is_sorted(iteratedKeys.begin(), iteratedKeys.end()));
+
+    vector<string> reverseKeys;
+    for (auto it = dict.end(); it != dict.begin(); )
+        reverseKeys.push_back((--it)->first.GetString());
+    REQUIRE(std::equal(iteratedKeys.rbegin(), iteratedKeys.rend(), reverseKeys.begin(), reverseKeys.end()));
+
+    // Remove all the keys but the last ones: the remaining
+    // values must not be relocated
+    unsigned keptCount = PdfDictionaryMap::MaxFlatIndexSize / 2;
+    for (unsigned i = 0; i < keys.size() - keptCount; i++)
+        REQUIRE(dict.RemoveKey(keys[i]));
+
+    REQUIRE(dict.GetSize() == keptCount);
+    PdfDictionary flatDict;
+    for (unsigned i = (unsigned)keys.size() - keptCount; i < keys.size(); i++)
+    {
+        REQUIRE(dict.GetKey(keys[i]) == values[i]);
+        flatDict.AddKey(PdfName(keys[i]), static_cast<int64_t>(i));
+    }
+
+    // Dictionaries compare equal whatever their index kind
+    REQUIRE(dict == flatDict);
+
+    // Removed slots are reused
+    for (unsigned i = 0; i < keys.size() - keptCount; i++)
+        dict.AddKey(PdfName(keys[i]), static_cast<int64_t>(i));
+    REQUIRE(dict.GetSize() == keys.size());
+
+    PdfDictionary copy(dict);
+    REQUIRE(copy == dict);
+
+    PdfDictionary moved(std::move(copy));
+    REQUIRE(moved == dict);
+    for (auto& pair : moved)
+        REQUIRE(pair.second.GetParent() == &moved);
+    for (unsigned i = 0; i < keys.size(); i++)
+        REQUIRE(moved.MustGetKey(keys[i]).GetNumber() == (int64_t)i);
+
+    moved.Clear();
+    REQUIRE(moved.GetSize() == 0);
+    REQUIRE(moved.begin() == moved.end());
+}
+
+TEST_CASE("testDictionaryBenchmark", "[.][benchmark]")
+{
+    // Typical font dictionary keys, looked up by name
+    static const string_view lookupKeys[] = { "Type", "Subtype", "BaseFont", "FirstChar",
+        "LastChar", "Widths", "FontDescriptor", "Encoding", "ToUnicode", "Missing" };
+    vector<PdfName> names;
+    for (auto key : lookupKeys)
+        names.push_back(PdfName(key));
+
+    // Compare with the std::map based storage previously used
+    using StdDictionaryMap = map<PdfName, PdfObject, NameComparator>;
+    PdfDictionaryMap dictMap;
+    StdDictionaryMap stdMap;
+    for (unsigned i = 0; i < names.size() - 1; i++)
+    {
+        dictMap.try_emplace(names[i], static_cast<int64_t>(i));
+        stdMap.try_emplace(names[i], static_cast<int64_t>(i));
+    }
+
+    BENCHMARK("PdfDictionaryMap build")
+    {
+        PdfDictionaryMap newMap;
+        for (unsigned i = 0; i < names.size() - 1; i++)
+            newMap.try_emplace(names[i], static_cast<int64_t>(i));
+        return newMap.size();
+    };
+
+    BENCHMARK("std::map build")
+    {
+        StdDictionaryMap newMap;
+        for (unsigned i = 0; i < names.size() - 1; i++)
+            newMap.try_emplace(names[i], static_cast<int64_t>(i));
+        return newMap.size();
+    };
+
+    BENCHMARK("PdfDictionaryMap lookup")
+    {
+        unsigned found = 0;
+        for (auto key : lookupKeys)
+            found += dictMap.find(key) != dictMap.end();
+        return found;
+    };
+
+    BENCHMARK("std::map lookup")
+    {
+        unsigned found = 0;
+        for (auto key : lookupKeys)
+            found += stdMap.find(key) != stdMap.end();
+        return found;
+    };
+
+    string buffer = generateDocumentWithFonts(500);
+    BENCHMARK("Parse and walk document")
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        unsigned found = 0;
+        auto& pages = doc.GetPages();
+        for (unsigned i = 0; i < pages.GetCount(); i++)
+        {
+            auto& fonts = pages.GetPageAt(i).GetDictionary()
+                .MustFindKey("Resources").GetDictionary().MustFindKey("Font").GetDictionary();
+            for (auto& pair : fonts.GetIndirectIterator())
+                found += pair.second->GetDictionary().HasKey("BaseFont");
+        }
+        return found;
+    };
+}
+
+vector<string> getTestKeys(unsigned count)
+{
+    // Keys are generated in non sorted order
+    vector<string> ret;
+    for (unsigned i = 0; i < count; i++)
+        ret.push_back("Key" + std::to_string((i * 37) % count));
+
+    return ret;
+}
+
+string generateDocumentWithFonts(unsigned pageCount)
+{
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto& font = doc.GetObjects().CreateDictionaryObject("Font");
+        auto& fontDict = font.GetDictionary();
+        fontDict.AddKey("Subtype", PdfName("Type1"));
+        fontDict.AddKey("BaseFont", PdfName("Helvetica"));
+        fontDict.AddKey("Encoding", PdfName("WinAnsiEncoding"));
+        fontDict.AddKey("FirstChar", static_cast<int64_t>(32));
+        fontDict.AddKey("LastChar", static_cast<int64_t>(255));
+
+        PdfDictionary fonts;
+        fonts.AddKey("F1", font.GetIndirectReference());
+        PdfDictionary resources;
+        resources.AddKey("Font", fonts);
+        page.GetDictionary().AddKey("Resources", resources);
+    }
+
+    string ret;
+    StringStreamDevice device(ret);
+    doc.Save(device);
+    return ret;
+}
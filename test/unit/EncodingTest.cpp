@@ -177,10 +177,10 @@ TEST_CASE("testDifferencesEncoding")
     REQUIRE(unicode == "BAABI");
 }
 
-// FIX-ME: This test passes but it's garbage and very slow
+// FIX-ME: This test passes but it's garbage
 // Fix it the whole thing by handling properly the Adobe Glyph List
 // in PdfDifferenceEncoding (or better a new separate function)
-TEST_CASE("testUnicodeNames", "[.]")
+TEST_CASE("testUnicodeNames")
 {
     // List of items which are defined twice and cause
     // other ids to be returned than those which where send in
@@ -253,6 +253,68 @@ TEST_CASE("testUnicodeNames", "[.]")
     REQUIRE(codeCount == 65421);
 }
 
+TEST_CASE("testDifferencesBenchmark", "[.][benchmark]")
+{
+    // Create a document with many Type1 and Type3 fonts with
+    // a /Differences array remapping all the codes
+    charbuff docbuff;
+    {
+        PdfMemDocument doc;
+        auto& fonts = doc.GetCatalog().GetDictionary().AddKey("Fonts", PdfArray()).GetArray();
+        for (unsigned i = 0; i < 500; i++)
+        {
+            PdfDifferenceList differences;
+            for (unsigned code = 32; code < 256; code++)
+                differences.AddDifference((unsigned char)code, (char32_t)(0x100 + (i * 7 + code) % 0x200));
+
+            PdfArray differencesArr;
+            differences.ToArray(differencesArr);
+            auto& font = doc.GetObjects().CreateDictionaryObject("Font");
+            auto& dict = font.GetDictionary();
+            auto& encoding = dict.AddKey("Encoding", PdfDictionary()).GetDictionary();
+            encoding.AddKey("BaseEncoding", PdfName("WinAnsiEncoding"));
+            encoding.AddKey("Differences", differencesArr);
+            if (i % 2 == 0)
+            {
+                dict.AddKey(PdfName::KeySubtype, PdfName("Type1"));
+                dict.AddKey("BaseFont", PdfName("Helvetica"));
+            }
+            else
+            {
+                dict.AddKey(PdfName::KeySubtype, PdfName("Type3"));
+                PdfArray bbox;
+                PdfRect(0, 0, 1000, 1000).ToArray(bbox);
+                dict.AddKey("FontBBox", bbox);
+                PdfArray matrix;
+                for (double value : { 0.001, 0.0, 0.0, 0.001, 0.0, 0.0 })
+                    matrix.Add(value);
+                dict.AddKey("FontMatrix", matrix);
+                dict.AddKey("CharProcs", PdfDictionary());
+            }
+
+            fonts.Add(font.GetIndirectReference());
+        }
+
+        BufferStreamDevice device(docbuff);
+        doc.Save(device);
+    }
+
+    BENCHMARK("Load fonts with differences")
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(docbuff);
+        size_t count = 0;
+        for (auto font : doc.GetCatalog().GetDictionary().MustFindKey("Fonts").GetArray().GetIndirectIterator())
+        {
+            unique_ptr<PdfFont> loaded;
+            REQUIRE(PdfFont::TryCreateFromObject(*font, loaded));
+            count += loaded->GetEncoding().GetEncodingMap().GetLimits().LastChar.Code;
+        }
+
+        return count;
+    };
+}
+
 TEST_CASE("testGetCharCode")
 {
     auto winAnsiEncoding = PdfEncodingFactory::CreateWinAnsiEncoding();
@@ -337,6 +399,252 @@ TEST_CASE("testToUnicodeParse")
     }
 }
 
+TEST_CASE("testCharCodeMap")
+{
+    PdfCharCodeMap map;
+    map.PushMapping({ 0x20, 1 }, U' ');
+    map.PushRangeMapping({ 0x0100, 2 }, 0x100, U'\x4E00');
+    map.PushMapping({ 0x0150, 2 }, U'\x2603');     // Split the range
+    map.PushRangeMapping({ 0x01F0, 2 }, 0x20, U'A'); // Trim the range
+    char32_t ligature[] = { U'f', U'f', U'i' };
+    map.PushMapping({ 0x0300, 2 }, codepointview(ligature));
+    map.PushMapping({ 0x123456, 3 }, U'Z');
+    map.PushMapping({ 0x20, 1 }, U'_');             // Replace the mapping
+    REQUIRE(map.GetSize() == 1 + 0x100 + 0x10 + 1 + 1);
+
+    vector<codepoint> codePoints;
+    REQUIRE(map.TryGetCodePoints({ 0x20, 1 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'_' });
+    REQUIRE(map.TryGetCodePoints({ 0x0100, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'\x4E00' });
+    REQUIRE(map.TryGetCodePoints({ 0x014F, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'\x4E4F' });
+    REQUIRE(map.TryGetCodePoints({ 0x0150, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'\x2603' });
+    REQUIRE(map.TryGetCodePoints({ 0x0151, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'\x4E51' });
+    REQUIRE(map.TryGetCodePoints({ 0x01EF, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'\x4EEF' });
+    REQUIRE(map.TryGetCodePoints({ 0x01F1, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'B' });
+    REQUIRE(map.TryGetCodePoints({ 0x0300, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'f', U'f', U'i' });
+    REQUIRE(map.TryGetCodePoints({ 0x123456, 3 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'Z' });
+    REQUIRE(!map.TryGetCodePoints({ 0x0210, 2 }, codePoints));
+    REQUIRE(codePoints.size() == 0);
+
+    auto& limits = map.GetLimits();
+    REQUIRE(limits.MinCodeSize == 1);
+    REQUIRE(limits.MaxCodeSize == 3);
+    REQUIRE(limits.FirstChar.Code == 0x20);
+    REQUIRE(limits.LastChar.Code == 0x123456);
+
+    // Iteration is in code order
+    unsigned count = 0;
+    unsigned prev = 0;
+    for (auto& pair : map)
+    {
+        if (count != 0)
+            REQUIRE(pair.first.Code > prev);
+
+        REQUIRE(map.TryGetCodePoints(pair.first, codePoints));
+        REQUIRE(vector<codepoint>(pair.second.begin(), pair.second.end()) == codePoints);
+        prev = pair.first.Code;
+        count++;
+    }
+    REQUIRE(count == map.GetSize());
+    REQUIRE(map.begin()->first == PdfCharCode(0x20, 1));
+
+    // The mappings can be iterated also without copying the code points
+    auto mapIt = map.begin();
+    for (auto& pair : map.GetMappings())
+    {
+        REQUIRE(pair.first == mapIt->first);
+        REQUIRE(vector<codepoint>(pair.second.begin(), pair.second.end()) == mapIt->second);
+        mapIt++;
+    }
+    REQUIRE(mapIt == map.end());
+    static_assert(std::is_same_v<PdfCharCodeMap::iterator::value_type,
+        pair<const PdfCharCode, vector<codepoint>>>);
+    static_assert(std::is_same_v<std::iterator_traits<PdfCharCodeMap::iterator>::difference_type, std::ptrdiff_t>);
+
+    // Reverse lookups
+    PdfCharCode code;
+    REQUIRE(map.TryGetCharCode(U'\x4E51', code));
+    REQUIRE(code == PdfCharCode(0x0151, 2));
+    REQUIRE(!map.TryGetCharCode(U'\x4E50', code));
+    string_view str = u8"ffi\u2603";
+    auto it = str.begin();
+    REQUIRE(map.TryGetNextCharCode(it, str.end(), code));
+    REQUIRE(code == PdfCharCode(0x0300, 2));
+    REQUIRE(map.TryGetNextCharCode(it, str.end(), code));
+    REQUIRE(code == PdfCharCode(0x0150, 2));
+    REQUIRE(it == str.end());
+
+    PdfCharCodeMap moved(std::move(map));
+    REQUIRE(moved.GetSize() == 1 + 0x100 + 0x10 + 1 + 1);
+    REQUIRE(moved.TryGetCodePoints({ 0x0300, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'f', U'f', U'i' });
+}
+
+TEST_CASE("testCharCodeMapMixedCodeSizes")
+{
+    // Code units with the same code and different code space sizes are distinct
+    PdfCharCodeMap map;
+    map.PushMapping({ 0x41, 1 }, U'A');
+    char32_t ligature[] = { U'f', U'i' };
+    map.PushMapping({ 0x0041, 2 }, codepointview(ligature));
+    map.PushRangeMapping({ 0x0040, 2 }, 4, U'W');
+    REQUIRE(map.GetSize() == 5);
+
+    vector<codepoint> codePoints;
+    REQUIRE(map.TryGetCodePoints({ 0x41, 1 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'A' });
+    REQUIRE(map.TryGetCodePoints({ 0x0041, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'X' });
+    REQUIRE(!map.TryGetCodePoints({ 0x40, 1 }, codePoints));
+    REQUIRE(!map.TryGetCodePoints({ 0x41, 3 }, codePoints));
+
+    // Iteration is by code space size
+    vector<PdfCharCode> codes;
+    for (auto& pair : map)
+        codes.push_back(pair.first);
+    REQUIRE(codes == vector<PdfCharCode>{ { 0x41, 1 }, { 0x40, 2 }, { 0x41, 2 }, { 0x42, 2 }, { 0x43, 2 } });
+
+    // Replacing multiple code points mappings compacts the pool
+    for (unsigned i = 0; i < 100; i++)
+        map.PushMapping({ 0x0100, 2 }, codepointview(ligature));
+    REQUIRE(map.TryGetCodePoints({ 0x0100, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'f', U'i' });
+
+    // A mixed 1/2 bytes CMap: 2 bytes codes start with 0x00
+    string_view toUnicode =
+        "2 begincodespacerange\n<01> <FF>\n<0000> <00FF>\nendcodespacerange\n"
+        "2 beginbfchar\n<41> <0041>\n<0041> <0058>\nendbfchar\n";
+    PdfIndirectObjectList objects;
+    auto& toUnicodeObj = objects.CreateDictionaryObject();
+    toUnicodeObj.GetOrCreateStream().SetData(toUnicode);
+    auto encoding = PdfCMapEncoding::CreateFromObject(toUnicodeObj);
+    string_view encoded = "\x41\x00\x41\x41"sv;
+    auto it = encoded.begin();
+    vector<char32_t> decoded;
+    while (it != encoded.end())
+    {
+        REQUIRE(encoding->TryGetNextCodePoints(it, encoded.end(), codePoints));
+        decoded.insert(decoded.end(), codePoints.begin(), codePoints.end());
+    }
+    REQUIRE(decoded == vector<char32_t>{ U'A', U'X', U'A' });
+}
+
+TEST_CASE("testToUnicodeBenchmark", "[.][benchmark]")
+{
+    // Create a CJK like ToUnicode CMap with many single
+    // code mappings and sequential ranges
+    string toUnicode = "/CIDInit /ProcSet findresource begin\n"
+        "1 begincodespacerange\n<0000> <FFFF>\nendcodespacerange\n";
+    string temp;
+    for (unsigned block = 0; block < 200; block++)
+    {
+        toUnicode.append("100 beginbfchar\n");
+        for (unsigned i = 0; i < 100; i++)
+        {
+            unsigned code = block * 100 + i;
+            utls::FormatTo(temp, "<{:04X}> <{:04X}>\n", code, 0x4E00 + (code * 7) % 0x5000);
+            toUnicode.append(temp);
+        }
+        toUnicode.append("endbfchar\n");
+    }
+
+    toUnicode.append("100 beginbfrange\n");
+    for (unsigned i = 0; i < 100; i++)
+    {
+        unsigned code = 0x8000 + i * 0x100;
+        utls::FormatTo(temp, "<{:04X}> <{:04X}> <{:04X}>\n", code, code + 0xFF, 0xAC00 + i * 0x10);
+        toUnicode.append(temp);
+    }
+    toUnicode.append("endbfrange\n");
+
+    PdfIndirectObjectList objects;
+    auto& toUnicodeObj = objects.CreateDictionaryObject();
+    toUnicodeObj.GetOrCreateStream().SetData(toUnicode);
+
+    charbuff encoded;
+    for (unsigned i = 0; i < 10000; i++)
+    {
+        unsigned code = (i * 37) % 20000;
+        if (i % 2 == 0)
+            code = 0x8000 + (i * 53) % 0x6400;
+
+        encoded.push_back((char)(code >> 8));
+        encoded.push_back((char)(code & 0xFF));
+    }
+
+    BENCHMARK("Parse ToUnicode CMap")
+    {
+        return PdfCMapEncoding::CreateFromObject(toUnicodeObj)->GetLimits().LastChar.Code;
+    };
+
+    PdfEncoding encoding(std::make_shared<PdfIdentityEncoding>(2), PdfCMapEncoding::CreateFromObject(toUnicodeObj));
+    BENCHMARK("Extract text with ToUnicode CMap")
+    {
+        return encoding.ConvertToUtf8(PdfString::FromRaw(encoded)).size();
+    };
+}
+
+TEST_CASE("testCMapCache")
+{
+    string_view toUnicode =
+        "1 begincodespacerange\n<00> <FF>\nendcodespacerange\n"
+        "1 beginbfrange\n<20> <7E> <0041>\nendbfrange\n";
+
+    // Create two documents with a font that
+    // embeds the same /ToUnicode CMap
+    auto createFont = [&](PdfMemDocument& doc) -> PdfObject&
+    {
+        auto& font = doc.GetObjects().CreateDictionaryObject("Font");
+        auto& dict = font.GetDictionary();
+        dict.AddKey(PdfName::KeySubtype, PdfName("Type1"));
+        dict.AddKey("BaseFont", PdfName("Helvetica"));
+        dict.AddKey("Encoding", PdfName("WinAnsiEncoding"));
+        auto& toUnicodeObj = doc.GetObjects().CreateDictionaryObject();
+        toUnicodeObj.GetOrCreateStream().SetData(toUnicode);
+        dict.AddKeyIndirect("ToUnicode", toUnicodeObj);
+        return font;
+    };
+
+    PdfMemDocument doc1;
+    PdfMemDocument doc2;
+    auto& fontObj1 = createFont(doc1);
+    auto& fontObj2 = createFont(doc2);
+
+    PdfCMapCache::SetMaxSize(16);
+    PdfCMapCache::Clear();
+    PdfCMapCache::ResetStats();
+
+    unique_ptr<PdfFont> font1;
+    unique_ptr<PdfFont> font2;
+    REQUIRE(PdfFont::TryCreateFromObject(fontObj1, font1));
+    REQUIRE(PdfFont::TryCreateFromObject(fontObj2, font2));
+    auto stats = PdfCMapCache::GetStats();
+    REQUIRE(stats.Misses == 1);
+    REQUIRE(stats.Hits == 1);
+    REQUIRE(stats.EntryCount == 1);
+    REQUIRE(&font1->GetEncoding().GetToUnicodeMap() == &font2->GetEncoding().GetToUnicodeMap());
+    REQUIRE(font2->GetEncoding().ConvertToUtf8(PdfString::FromRaw("!\""sv)) == "BC");
+
+    // Disabling the cache evicts the entries
+    PdfCMapCache::SetMaxSize(0);
+    stats = PdfCMapCache::GetStats();
+    REQUIRE(stats.EntryCount == 0);
+    REQUIRE(stats.Evictions == 1);
+
+    unique_ptr<PdfFont> font3;
+    REQUIRE(PdfFont::TryCreateFromObject(fontObj1, font3));
+    REQUIRE(&font1->GetEncoding().GetToUnicodeMap() != &font3->GetEncoding().GetToUnicodeMap());
+    REQUIRE(PdfCMapCache::GetStats().Misses == 1);
+}
+
 void outofRangeHelper(PdfEncoding& encoding)
 {
     (void)encoding.GetCodePoint(encoding.GetFirstChar());
@@ -12,6 +12,13 @@ using namespace std;
 using namespace mm;
 
 static void testFilter(PdfFilterType filterType, const bufferview& buffer);
+static void testPredictor(int predictor, unsigned columns, unsigned colors, unsigned bpc);
+static charbuff encodePng(const charbuff& data, unsigned rowLength, unsigned bpp);
+static charbuff encodeTiff(const charbuff& data, unsigned rowLength, unsigned columns, unsigned colors, unsigned bpc);
+static unsigned getSample(const charbuff& data, size_t offset, size_t index, unsigned bpc);
+static void setSample(charbuff& data, size_t offset, size_t index, unsigned bpc, unsigned value);
+static charbuff getContentStreamData(unsigned operatorCount);
+static charbuff getImageData(unsigned width, unsigned height);
 
 static string_view s_testBuffer1 = "Man is distinguished, not only by his reason, but by this singular passion from other animals, which is a lust of the mind, that by a perseverance of delight in the continued and indefatigable generation of knowledge, exceeds the short vehemence of any carnal pleasure.";
 
@@ -33,6 +40,315 @@ TEST_CASE("testFilters")
     }
 }
 
+TEST_CASE("testFlateCompressionLevels")
+{
+    auto data = getContentStreamData(5000);
+    charbuff fastest;
+    charbuff best;
+    for (int level = -1; level <= 9; level++)
+    {
+        INFO(utls::Format("Compression level {}", level));
+        charbuff encoded;
+        charbuff decoded;
+        auto filter = PdfFilterFactory::Create(PdfFilterType::FlateDecode, static_cast<PdfCompressionLevel>(level));
+        filter->EncodeTo(encoded, data);
+        filter->DecodeTo(decoded, encoded);
+        REQUIRE(decoded == data);
+        if (level == 0)
+            REQUIRE(encoded.size() > data.size());
+        else if (level == 1)
+            fastest = encoded;
+        else if (level == 9)
+            best = encoded;
+    }
+
+    REQUIRE(best.size() < fastest.size());
+
+    // The level set on a stream takes precedence over the save options
+    auto save = [&](PdfSaveOptions opts, PdfCompressionLevel streamLevel) {
+        PdfMemDocument doc;
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        auto& stream = obj.GetOrCreateStream();
+        stream.SetCompressionLevel(streamLevel);
+        stream.SetData(data, true);
+        doc.GetCatalog().GetDictionary().AddKey("TestStream", obj.GetIndirectReference());
+
+        charbuff buffer;
+        BufferStreamDevice device(buffer);
+        doc.Save(device, opts);
+
+        PdfMemDocument loaded;
+        loaded.LoadFromBuffer(buffer);
+        auto& loadedStream = loaded.GetCatalog().GetDictionary().MustFindKey("TestStream").MustGetStream();
+        REQUIRE(loadedStream.GetCopy() == data);
+        return loadedStream.GetLength();
+    };
+
+    REQUIRE(save(PdfSaveOptions::FlateBestSpeed, PdfCompressionLevel::Default) == fastest.size());
+    REQUIRE(save(PdfSaveOptions::FlateBestCompression, PdfCompressionLevel::Default) == best.size());
+    REQUIRE(save(PdfSaveOptions::FlateBestCompression, PdfCompressionLevel::BestSpeed) == fastest.size());
+    REQUIRE(save(PdfSaveOptions::None, PdfCompressionLevel::NoCompression) > data.size());
+
+    // Data flate encoded while written to the stream
+    PdfMemDocument doc;
+    auto& stream = doc.GetObjects().CreateDictionaryObject().GetOrCreateStream();
+    stream.SetCompressionLevel(PdfCompressionLevel::BestCompression);
+    stream.SetData(data);
+    REQUIRE(stream.GetLength() == best.size());
+    REQUIRE(stream.GetCopy() == data);
+}
+
+TEST_CASE("testFlateDecodeHighRatio")
+{
+    // Highly compressible data exceeds the initial
+    // buffer size of whole buffer decoding
+    charbuff data;
+    data.resize(4 * 1024 * 1024);
+    charbuff encoded;
+    charbuff decoded;
+    auto filter = PdfFilterFactory::Create(PdfFilterType::FlateDecode);
+    filter->EncodeTo(encoded, data);
+    REQUIRE(encoded.size() * 100 < data.size());
+    filter->DecodeTo(decoded, encoded);
+    REQUIRE(decoded == data);
+}
+
+TEST_CASE("testFlateDecodeBigStream")
+{
+    // Big encoded streams are not collected in memory to be
+    // decoded as a whole buffer, also when fed in blocks
+    charbuff data(6 * 1024 * 1024);
+    uint32_t seed = 12345;
+    for (auto& ch : data)
+    {
+        seed = seed * 1103515245 + 12345;
+        ch = (char)(seed >> 16);
+    }
+
+    charbuff encoded;
+    charbuff decoded;
+    auto filter = PdfFilterFactory::Create(PdfFilterType::FlateDecode);
+    filter->EncodeTo(encoded, data);
+    REQUIRE(encoded.size() > 4 * 1024 * 1024);
+    filter->DecodeTo(decoded, encoded);
+    REQUIRE(decoded == data);
+
+    decoded.clear();
+    StringStreamDevice device(decoded);
+    filter->BeginDecode(device);
+    for (size_t i = 0; i < encoded.size(); i += 1024 * 1024)
+        filter->DecodeBlock(bufferview(encoded.data() + i, std::min<size_t>(1024 * 1024, encoded.size() - i)));
+    filter->EndDecode();
+    REQUIRE(decoded == data);
+}
+
+TEST_CASE("testStreamWholeBufferDecode")
+{
+    auto data = getContentStreamData(2000);
+    auto getStreamedCopy = [](PdfObjectStream& stream) {
+        charbuff ret;
+        BufferStreamDevice device(ret);
+        auto input = stream.GetInputStream();
+        input.CopyTo(device);
+        return ret;
+    };
+
+    PdfMemDocument doc;
+    auto& obj = doc.GetObjects().CreateDictionaryObject();
+    auto& stream = obj.GetOrCreateStream();
+    stream.SetData(data, { PdfFilterType::ASCIIHexDecode, PdfFilterType::FlateDecode });
+    REQUIRE(stream.GetCopy() == data);
+    REQUIRE(getStreamedCopy(stream) == data);
+
+    charbuff copy(string_view("Previous content"));
+    stream.CopyTo(copy);
+    REQUIRE(copy == data);
+
+    // Bogus /DL values are only a size hint
+    obj.GetDictionary().AddKey("DL", static_cast<int64_t>(1));
+    REQUIRE(stream.GetCopy() == data);
+    obj.GetDictionary().AddKey("DL", static_cast<int64_t>(1) << 50);
+    REQUIRE(stream.GetCopy() == data);
+
+    // Decode parameters are applied to the relative filter
+    charbuff predicted;
+    for (size_t i = 0; i < data.size(); i += 100)
+    {
+        predicted.push_back('\0');
+        predicted.append(data.substr(i, 100));
+    }
+    predicted.append(100 - data.size() % 100, ' ');
+
+    PdfDictionary decodeParms;
+    decodeParms.AddKey("Predictor", static_cast<int64_t>(10));
+    decodeParms.AddKey("Columns", static_cast<int64_t>(100));
+    PdfArray decodeParmsArr;
+    decodeParmsArr.Add(PdfObject::Null);
+    decodeParmsArr.Add(decodeParms);
+    stream.SetData(predicted, { PdfFilterType::ASCIIHexDecode, PdfFilterType::FlateDecode });
+    obj.GetDictionary().RemoveKey("DL");
+    obj.GetDictionary().AddKey("DecodeParms", decodeParmsArr);
+    auto expected = data + string(100 - data.size() % 100, ' ');
+    REQUIRE(stream.GetCopy() == expected);
+    REQUIRE(getStreamedCopy(stream) == expected);
+
+    // Media filters are not expanded
+    stream.SetData(data, { PdfFilterType::FlateDecode });
+    auto flateEncoded = stream.GetCopy(true);
+    obj.GetDictionary().RemoveKey("DecodeParms");
+    stream.SetData(flateEncoded, true);
+    PdfArray filters;
+    filters.Add(PdfName("FlateDecode"));
+    filters.Add(PdfName("DCTDecode"));
+    obj.GetDictionary().AddKey(PdfName::KeyFilter, filters);
+    doc.GetCatalog().GetDictionary().AddKey("TestStream", obj.GetIndirectReference());
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoFlateCompress);
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    auto& loadedObj = loaded.GetCatalog().GetDictionary().MustFindKey("TestStream");
+    ASSERT_THROW_WITH_ERROR_CODE(loadedObj.MustGetStream().GetCopy(), PdfErrorCode::UnsupportedFilter);
+    REQUIRE(loadedObj.MustGetStream().GetCopySafe() == data);
+}
+
+TEST_CASE("testDecodedStreamCache")
+{
+    auto data1 = getContentStreamData(1000);
+    auto data2 = getContentStreamData(1500);
+    PdfMemDocument doc;
+    auto& cache = doc.GetDecodedStreamCache();
+    REQUIRE(!cache.IsEnabled());
+
+    auto& obj1 = doc.GetObjects().CreateDictionaryObject();
+    auto& stream1 = obj1.GetOrCreateStream();
+    stream1.SetData(data1);
+    auto& stream2 = doc.GetObjects().CreateDictionaryObject().GetOrCreateStream();
+    stream2.SetData(data2);
+
+    // A disabled cache is not even looked up
+    REQUIRE(stream1.GetCopy() == data1);
+    REQUIRE(cache.GetStats().Misses == 0);
+
+    cache.SetBudget(2 * data2.size() + 4);
+    REQUIRE(stream1.GetCopy() == data1);
+    REQUIRE(stream1.GetCopy() == data1);
+    REQUIRE(stream2.GetCopy() == data2);
+    auto stats = cache.GetStats();
+    REQUIRE(stats.Hits == 1);
+    REQUIRE(stats.Misses == 2);
+    REQUIRE(stats.Evictions == 0);
+    REQUIRE(stats.EntryCount == 2);
+    REQUIRE(stats.Size == data1.size() + data2.size());
+
+    // Streaming copies are served by the cache as well
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    stream1.CopyTo(device);
+    REQUIRE(buffer == data1);
+    REQUIRE(cache.GetStats().Hits == 2);
+
+    // Raw copies bypass the cache
+    (void)stream1.GetCopy(true);
+    REQUIRE(cache.GetStats().Hits == 2);
+    REQUIRE(cache.GetStats().Misses == 2);
+
+    // Modifying the data invalidates the entry
+    stream1.SetData(data2);
+    REQUIRE(cache.GetStats().EntryCount == 1);
+    REQUIRE(stream1.GetCopy() == data2);
+    REQUIRE(cache.GetStats().Misses == 3);
+    {
+        auto output = stream2.GetOutputStream(true);
+        output.Write("q Q\n");
+    }
+    REQUIRE(stream2.GetCopy() == data2 + "q Q\n");
+    REQUIRE(cache.GetStats().Misses == 4);
+
+    // The least recently used entry is evicted
+    cache.ResetStats();
+    cache.SetBudget(data2.size() + 4);
+    stats = cache.GetStats();
+    REQUIRE(stats.Evictions == 1);
+    REQUIRE(stats.EntryCount == 1);
+    REQUIRE(stream2.GetCopy() == data2 + "q Q\n");
+    REQUIRE(cache.GetStats().Hits == 1);
+    REQUIRE(stream1.GetCopy() == data2);
+    stats = cache.GetStats();
+    REQUIRE(stats.Misses == 1);
+    REQUIRE(stats.Evictions == 2);
+    REQUIRE(stats.Size == data2.size());
+
+    // Removed objects are dropped
+    doc.GetObjects().RemoveObject(obj1.GetIndirectReference());
+    REQUIRE(cache.GetStats().EntryCount == 0);
+
+    cache.SetBudget(0);
+    REQUIRE(!cache.IsEnabled());
+}
+
+TEST_CASE("testFilterBenchmark", "[.][benchmark]")
+{
+    auto contents = getContentStreamData(100000);
+    auto image = getImageData(1024, 1024);
+    for (auto level : { PdfCompressionLevel::BestSpeed, PdfCompressionLevel::Default, PdfCompressionLevel::BestCompression })
+    {
+        auto filter = PdfFilterFactory::Create(PdfFilterType::FlateDecode, level);
+        charbuff encodedContents;
+        charbuff encodedImage;
+        filter->EncodeTo(encodedContents, contents);
+        filter->EncodeTo(encodedImage, image);
+        WARN(utls::Format("Level {}: content stream {} -> {} bytes, image {} -> {} bytes", (int)level,
+            contents.size(), encodedContents.size(), image.size(), encodedImage.size()));
+
+        BENCHMARK(utls::Format("Flate encode content stream, level {}", (int)level))
+        {
+            charbuff encoded;
+            filter->EncodeTo(encoded, contents);
+            return encoded.size();
+        };
+
+        BENCHMARK(utls::Format("Flate encode image, level {}", (int)level))
+        {
+            charbuff encoded;
+            filter->EncodeTo(encoded, image);
+            return encoded.size();
+        };
+
+        BENCHMARK(utls::Format("Flate decode content stream, level {}", (int)level))
+        {
+            charbuff decoded;
+            filter->DecodeTo(decoded, encodedContents);
+            return decoded.size();
+        };
+
+        BENCHMARK(utls::Format("Flate decode image, level {}", (int)level))
+        {
+            charbuff decoded;
+            filter->DecodeTo(decoded, encodedImage);
+            return decoded.size();
+        };
+    }
+
+    PdfMemDocument doc;
+    auto& stream = doc.GetObjects().CreateDictionaryObject().GetOrCreateStream();
+    stream.SetData(contents);
+    BENCHMARK("Stream whole buffer decode")
+    {
+        return stream.GetCopy().size();
+    };
+
+    BENCHMARK("Stream chunked decode")
+    {
+        charbuff decoded;
+        BufferStreamDevice device(decoded);
+        auto input = stream.GetInputStream();
+        input.CopyTo(device);
+        return decoded.size();
+    };
+}
+
 TEST_CASE("testCCITT")
 {
     unique_ptr<PdfFilter> filter = PdfFilterFactory::Create(PdfFilterType::CCITTFaxDecode);
@@ -40,6 +356,165 @@ TEST_CASE("testCCITT")
         INFO("!!! ePdfFilter_CCITTFaxDecode not implemented skipping test!");
 }
 
+TEST_CASE("testPredictors")
+{
+    // Png predictors, with all bytes per pixel handled by dedicated kernels
+    testPredictor(15, 1001, 1, 8);
+    testPredictor(15, 1001, 3, 8);
+    testPredictor(15, 1001, 4, 8);
+    testPredictor(15, 1001, 3, 16);
+    testPredictor(15, 1001, 4, 16);
+    testPredictor(15, 1001, 5, 8);
+    testPredictor(15, 1001, 1, 1);
+    testPredictor(15, 1001, 2, 4);
+
+    // Tiff predictor
+    testPredictor(2, 1001, 1, 1);
+    testPredictor(2, 1001, 3, 2);
+    testPredictor(2, 1001, 2, 4);
+    testPredictor(2, 1001, 3, 8);
+    testPredictor(2, 1001, 3, 16);
+
+    PdfDictionary decodeParms;
+    decodeParms.AddKey("Predictor", static_cast<int64_t>(2));
+    decodeParms.AddKey("BitsPerComponent", static_cast<int64_t>(3));
+    charbuff decoded;
+    auto filter = PdfFilterFactory::Create(PdfFilterType::FlateDecode);
+    ASSERT_THROW_WITH_ERROR_CODE(filter->DecodeTo(decoded, "", &decodeParms), PdfErrorCode::InvalidPredictor);
+}
+
+void testPredictor(int predictor, unsigned columns, unsigned colors, unsigned bpc)
+{
+    INFO(utls::Format("Predictor {}, Colors {}, BitsPerComponent {}", predictor, colors, bpc));
+    unsigned rowLength = (columns * colors * bpc + 7) / 8;
+    unsigned rowCount = 37;
+
+    // Deterministic pseudo random data, with rows padded to whole bytes
+    charbuff data((size_t)rowLength * rowCount);
+    uint32_t seed = 12345;
+    for (auto& ch : data)
+    {
+        seed = seed * 1103515245 + 12345;
+        ch = (char)(seed >> 16);
+    }
+
+    unsigned padding = rowLength * 8 - columns * colors * bpc;
+    for (unsigned i = 0; i < rowCount; i++)
+        data[(size_t)(i + 1) * rowLength - 1] &= (char)(0xFF << padding);
+
+    charbuff predicted;
+    if (predictor == 2)
+        predicted = encodeTiff(data, rowLength, columns, colors, bpc);
+    else
+        predicted = encodePng(data, rowLength, std::max(1u, (colors * bpc + 7) / 8));
+
+    PdfDictionary decodeParms;
+    decodeParms.AddKey("Predictor", static_cast<int64_t>(predictor));
+    decodeParms.AddKey("Colors", static_cast<int64_t>(colors));
+    decodeParms.AddKey("BitsPerComponent", static_cast<int64_t>(bpc));
+    decodeParms.AddKey("Columns", static_cast<int64_t>(columns));
+
+    charbuff encoded;
+    charbuff decoded;
+    auto filter = PdfFilterFactory::Create(PdfFilterType::FlateDecode);
+    filter->EncodeTo(encoded, predicted);
+    filter->DecodeTo(decoded, encoded, &decodeParms);
+    REQUIRE(decoded == data);
+}
+
+charbuff encodePng(const charbuff& data, unsigned rowLength, unsigned bpp)
+{
+    charbuff ret;
+    size_t rowCount = data.size() / rowLength;
+    for (size_t i = 0; i < rowCount; i++)
+    {
+        // Cycle through all the filter types
+        unsigned type = (unsigned)(i % 5);
+        ret.push_back((char)type);
+        auto row = reinterpret_cast<const uint8_t*>(data.data()) + i * rowLength;
+        auto prev = i == 0 ? nullptr : row - rowLength;
+        for (size_t j = 0; j < rowLength; j++)
+        {
+            int a = j < bpp ? 0 : row[j - bpp];
+            int b = prev == nullptr ? 0 : prev[j];
+            int c = j < bpp || prev == nullptr ? 0 : prev[j - bpp];
+            int predicted;
+            switch (type)
+            {
+                case 1:
+                    predicted = a;
+                    break;
+                case 2:
+                    predicted = b;
+                    break;
+                case 3:
+                    predicted = (a + b) / 2;
+                    break;
+                case 4:
+                {
+                    int p = a + b - c;
+                    int pa = std::abs(p - a);
+                    int pb = std::abs(p - b);
+                    int pc = std::abs(p - c);
+                    predicted = pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+                    break;
+                }
+                default:
+                    predicted = 0;
+                    break;
+            }
+
+            ret.push_back((char)(row[j] - predicted));
+        }
+    }
+
+    return ret;
+}
+
+charbuff encodeTiff(const charbuff& data, unsigned rowLength, unsigned columns, unsigned colors, unsigned bpc)
+{
+    charbuff ret = data;
+    size_t rowCount = data.size() / rowLength;
+    unsigned mask = (1u << bpc) - 1;
+    for (size_t i = 0; i < rowCount; i++)
+    {
+        size_t offset = i * rowLength;
+        for (size_t j = colors; j < (size_t)columns * colors; j++)
+        {
+            unsigned diff = getSample(data, offset, j, bpc) - getSample(data, offset, j - colors, bpc);
+            setSample(ret, offset, j, bpc, diff & mask);
+        }
+    }
+
+    return ret;
+}
+
+unsigned getSample(const charbuff& data, size_t offset, size_t index, unsigned bpc)
+{
+    auto bytes = reinterpret_cast<const uint8_t*>(data.data()) + offset;
+    if (bpc == 16)
+        return (unsigned)bytes[index * 2] << 8 | bytes[index * 2 + 1];
+
+    size_t bit = index * bpc;
+    return (bytes[bit / 8] >> (8 - bpc - bit % 8)) & ((1u << bpc) - 1);
+}
+
+void setSample(charbuff& data, size_t offset, size_t index, unsigned bpc, unsigned value)
+{
+    auto bytes = reinterpret_cast<uint8_t*>(data.data()) + offset;
+    if (bpc == 16)
+    {
+        bytes[index * 2] = (uint8_t)(value >> 8);
+        bytes[index * 2 + 1] = (uint8_t)value;
+        return;
+    }
+
+    size_t bit = index * bpc;
+    unsigned shift = (unsigned)(8 - bpc - bit % 8);
+    unsigned mask = ((1u << bpc) - 1) << shift;
+    bytes[bit / 8] = (uint8_t)((bytes[bit / 8] & ~mask) | (value << shift));
+}
+
 void testFilter(PdfFilterType filterType, const bufferview& view)
 {
     charbuff encoded;
@@ -99,3 +574,52 @@ void testFilter(PdfFilterType filterType, const bufferview& view)
 
     INFO("\t-> Test succeeded!");
 }
+
+charbuff getContentStreamData(unsigned operatorCount)
+{
+    // Text and path drawing operators, as typically found in page contents
+    charbuff ret;
+    for (unsigned i = 0; i < operatorCount; i++)
+    {
+        switch (i % 4)
+        {
+            case 0:
+                ret.append(utls::Format("BT /F{} 12 Tf {} {} Td (Line number {}) Tj ET\n",
+                    i % 3, 72 + i % 50, 700 - i % 600, i));
+                break;
+            case 1:
+                ret.append(utls::Format("{} {} m {} {} l S\n", i % 600, i % 800, (i * 7) % 600, (i * 13) % 800));
+                break;
+            case 2:
+                ret.append(utls::Format("q {} 0 0 {} {} {} cm /Im{} Do Q\n", 100 + i % 10, 50 + i % 20, i % 500, i % 700, i % 5));
+                break;
+            default:
+                ret.append(utls::Format("{} {} {} rg {} {} {} {} re f\n", (i % 10) / 10.0, (i % 7) / 7.0,
+                    (i % 3) / 3.0, i % 400, i % 600, 10 + i % 90, 10 + i % 40));
+                break;
+        }
+    }
+
+    return ret;
+}
+
+charbuff getImageData(unsigned width, unsigned height)
+{
+    // RGB gradients with some noise, resembling a photo
+    charbuff ret((size_t)width * height * 3);
+    uint32_t seed = 12345;
+    size_t offset = 0;
+    for (unsigned i = 0; i < height; i++)
+    {
+        for (unsigned j = 0; j < width; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            unsigned noise = (seed >> 16) % 8;
+            ret[offset++] = (char)((i + noise) % 256);
+            ret[offset++] = (char)((j + noise) % 256);
+            ret[offset++] = (char)((i + j) / 2 % 256);
+        }
+    }
+
+    return ret;
+}
@@ -13,6 +13,138 @@
 using namespace std;
 using namespace mm;
 
+static void testGlyphWidths(const PdfFontMetrics& metrics);
+
+TEST_CASE("testGlyphWidths")
+{
+    // DejaVu Sans has a hmtx table, which is read in bulk
+    string fontData;
+    TestUtils::ReadTestInputFileTo(fontData, "Fonts/DejaVuSans.ttf");
+    auto metrics = PdfFontMetricsFreetype::FromBuffer(std::make_shared<charbuff>(fontData));
+    testGlyphWidths(*metrics);
+
+    PdfMemDocument doc;
+    PdfTextState state;
+    state.Font = doc.GetFonts().GetFont(metrics->GetOrLoadFace());
+    state.FontSize = 10;
+    double expected = 0;
+    for (char32_t codePoint : U"Hello"sv)
+    {
+        unsigned gid;
+        REQUIRE(metrics->TryGetGID(codePoint, gid));
+        expected += metrics->GetGlyphWidth(gid) * state.FontSize;
+    }
+
+    REQUIRE(expected > 0);
+    ASSERT_EQUAL(expected, state.Font->GetStringLength("Hello"sv, state));
+
+    // Standard14 font files are bare CFF fonts, which are loaded lazily
+    auto std14Metrics = PdfFontMetricsStandard14::Create(PdfStandard14FontType::Helvetica);
+    metrics = PdfFontMetricsFreetype::FromBuffer(std::make_shared<charbuff>(std14Metrics->GetOrLoadFontFileData()));
+    testGlyphWidths(*metrics);
+}
+
+TEST_CASE("testTextLayout")
+{
+    PdfMemDocument doc;
+    PdfTextState state;
+    state.Font = doc.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica);
+    state.FontSize = 10;
+    auto& font = *state.Font;
+
+    string_view strs[] = { "aaa bbb", "ccc", "" };
+    double lengths[3];
+    REQUIRE(font.TryGetStringLengths(strs, state, lengths));
+    for (unsigned i = 0; i < 3; i++)
+        REQUIRE(lengths[i] == font.GetStringLength(strs[i], state));
+
+    // Wrap at spaces, skipping them
+    PdfTextLayout layout;
+    REQUIRE(font.TryLayoutText("aaa bbb  ccc", state, lengths[0] + 1, layout));
+    REQUIRE(layout.Advances.size() == 12);
+    REQUIRE(layout.Lines.size() == 2);
+    REQUIRE(layout.Lines[0].Offset == 0);
+    REQUIRE(layout.Lines[0].Length == 7);
+    REQUIRE(layout.Lines[0].GlyphCount == 7);
+    ASSERT_EQUAL(lengths[0], layout.Lines[0].Width);
+    REQUIRE(layout.Lines[1].Offset == 9);
+    REQUIRE(layout.Lines[1].Length == 3);
+    REQUIRE(layout.Lines[1].GlyphIndex == 9);
+    ASSERT_EQUAL(lengths[1], layout.Lines[1].Width);
+    REQUIRE(layout.Positions[9] == 0);
+    REQUIRE(layout.Positions[10] == layout.Advances[9]);
+    REQUIRE(layout.Offsets[11] == 11);
+
+    // Wrap at spaces, beginning the next line with them
+    REQUIRE(font.TryLayoutText("aaa bbb  ccc", state, lengths[0] + 1, layout, false));
+    REQUIRE(layout.Lines.size() == 2);
+    REQUIRE(layout.Lines[0].Length == 7);
+    REQUIRE(layout.Lines[1].Offset == 7);
+    REQUIRE(layout.Lines[1].Length == 5);
+
+    // Break words longer than a line
+    REQUIRE(font.TryLayoutText("ccccccccc", state, lengths[1] + 1, layout));
+    REQUIRE(layout.Lines.size() == 3);
+    REQUIRE(layout.Lines[1].Offset == 3);
+    REQUIRE(layout.Lines[2].GlyphIndex == 6);
+
+    // Break only at new lines, also consecutive
+    REQUIRE(font.TryLayoutText("aaa bbb\r\nccc\n\naaa", state, 0, layout));
+    REQUIRE(layout.Advances.size() == 13);
+    REQUIRE(layout.Lines.size() == 4);
+    REQUIRE(layout.Lines[0].Length == 7);
+    REQUIRE(layout.Lines[1].Offset == 9);
+    REQUIRE(layout.Lines[2].Length == 0);
+    REQUIRE(layout.Lines[2].GlyphIndex == 10);
+    REQUIRE(layout.Lines[3].Offset == 14);
+    ASSERT_EQUAL(font.GetStringLength("aaa"sv, state), layout.Lines[3].Width);
+}
+
+TEST_CASE("testTextLayoutBenchmark", "[.][benchmark]")
+{
+    PdfMemDocument doc;
+    PdfTextState state;
+    state.Font = doc.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica);
+    state.FontSize = 10;
+    string_view str = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+        "tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam";
+
+    PdfTextLayout layout;
+    BENCHMARK("Layout 10000 paragraphs")
+    {
+        size_t count = 0;
+        for (unsigned i = 0; i < 10000; i++)
+        {
+            (void)state.Font->TryLayoutText(str, state, 100, layout);
+            count += layout.Lines.size();
+        }
+
+        return count;
+    };
+}
+
+TEST_CASE("testGlyphWidthBenchmark", "[.][benchmark]")
+{
+    string fontData;
+    TestUtils::ReadTestInputFileTo(fontData, "Fonts/DejaVuSans.ttf");
+    auto face = CreateFreeTypeFace(fontData);
+    PdfMemDocument doc;
+    PdfTextState state;
+    state.Font = doc.GetFonts().GetFont(face);
+    state.FontSize = 10;
+    FT_Done_Face(face);
+
+    string_view str = "The quick brown fox jumps over the lazy dog";
+    BENCHMARK("Measure 10000 strings")
+    {
+        double length = 0;
+        for (unsigned i = 0; i < 10000; i++)
+            length += state.Font->GetStringLength(str, state);
+
+        return length;
+    };
+}
+
 #ifdef PDFMM_HAVE_FONTCONFIG
 
 #include <fontconfig/fontconfig.h>
@@ -148,3 +280,27 @@ bool getFontInfo(FcPattern* pFont, string& fontFamily, string& fontPath,
 }
 
 #endif // PDFMM_HAVE_FONTCONFIG
+
+void testGlyphWidths(const PdfFontMetrics& metrics)
+{
+    // Compare the widths with the advances of the loaded glyphs,
+    // also querying glyphs out of range
+    auto face = metrics.GetOrLoadFace();
+    unsigned glyphCount = metrics.GetGlyphCount();
+    REQUIRE(glyphCount != 0);
+    for (unsigned gid = 0; gid < glyphCount + 2; gid++)
+    {
+        double width;
+        bool success = metrics.TryGetGlyphWidth(gid, width);
+        if (FT_Load_Glyph(face, gid, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP) == 0)
+        {
+            REQUIRE(success);
+            REQUIRE(width == face->glyph->metrics.horiAdvance / (double)face->units_per_EM);
+        }
+        else
+        {
+            REQUIRE(!success);
+            REQUIRE(width == -1);
+        }
+    }
+}
@@ -101,6 +101,34 @@ TEST_CASE("testFromEscaped")
     TestFromEscape("Length#20With#20Spaces", "Length With Spaces");
 }
 
+TEST_CASE("testInternedNames")
+{
+    // Well-known names share the same storage
+    auto type = PdfName::FromEscaped("Type");
+    REQUIRE(type == PdfName::KeyType);
+    REQUIRE(type.GetRawData().data() == PdfName::KeyType.GetRawData().data());
+    REQUIRE(PdfName("Length").GetRawData().data() == PdfName::KeyLength.GetRawData().data());
+    REQUIRE(PdfName::FromRaw("Subtype"sv).GetRawData().data() == PdfName::KeySubtype.GetRawData().data());
+    REQUIRE(PdfName::FromEscaped("Fil#74er").GetRawData().data() == PdfName::KeyFilter.GetRawData().data());
+    REQUIRE(PdfName().GetRawData().data() == PdfName::KeyNull.GetRawData().data());
+    REQUIRE(!(type < PdfName::KeyType));
+    REQUIRE(!(PdfName::KeyType < type));
+
+    // Other names are still allocated separately
+    PdfName name1("NotAWellKnownName");
+    PdfName name2("NotAWellKnownName");
+    REQUIRE(name1 == name2);
+    REQUIRE(name1.GetRawData().data() != name2.GetRawData().data());
+    REQUIRE(PdfName::KeyLength < name1);
+    REQUIRE(name1 < PdfName::KeyType);
+
+    PdfVariant variant;
+    PdfTokenizer tokenizer;
+    SpanStreamDevice device("/Type"sv);
+    REQUIRE(tokenizer.TryReadNextVariant(device, variant));
+    REQUIRE(variant.GetName().GetRawData().data() == PdfName::KeyType.GetRawData().data());
+}
+
 //
 // Test encoding of names.
 // pszString : internal representation, ie unencoded name
@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <PdfTest.h>
+
+using namespace std;
+using namespace mm;
+
+static bool tryGetPdfOperatorLinear(const string_view& opstr, PdfOperator& op);
+
+TEST_CASE("testOperatorLookup")
+{
+    for (unsigned i = (unsigned)PdfOperator::w; i <= (unsigned)PdfOperator::EX; i++)
+    {
+        auto expected = (PdfOperator)i;
+        auto name = GetPdfOperatorName(expected);
+        REQUIRE(name.length() != 0);
+        INFO(name);
+
+        PdfOperator op;
+        REQUIRE(TryGetPdfOperator(name, op));
+        REQUIRE(op == expected);
+
+        int count;
+        REQUIRE(TryGetOperandCount(op, count));
+    }
+
+    REQUIRE(GetPdfOperator("Tj") == PdfOperator::Tj);
+    REQUIRE(GetPdfOperator("'") == PdfOperator::Quote);
+    REQUIRE(GetPdfOperator("\"") == PdfOperator::DoubleQuote);
+    REQUIRE(GetPdfOperator("T*") == PdfOperator::T_Star);
+    REQUIRE(GetPdfOperator("scn") == PdfOperator::scn);
+    REQUIRE(GetOperandCount(PdfOperator::cm) == 6);
+    REQUIRE(GetOperandCount(PdfOperator::DoubleQuote) == 3);
+    REQUIRE(GetOperandCount(PdfOperator::SCN) == -1);
+    REQUIRE(GetOperandCount(PdfOperator::EX) == 0);
+    REQUIRE(GetPdfOperatorName(PdfOperator::BDC) == "BDC");
+
+    PdfOperator op;
+    for (auto opstr : { ""sv, "x"sv, "Tx"sv, "tj"sv, "BTX"sv, "scnn"sv, "T"sv, "EMCX"sv })
+    {
+        REQUIRE(!TryGetPdfOperator(opstr, op));
+        REQUIRE(op == PdfOperator::Unknown);
+    }
+
+    int count;
+    REQUIRE(!TryGetOperandCount(PdfOperator::Unknown, count));
+    ASSERT_THROW_WITH_ERROR_CODE(GetPdfOperator("Tx"), PdfErrorCode::InvalidName);
+}
+
+TEST_CASE("testOperatorBenchmark", "[.][benchmark]")
+{
+    // Operator frequency similar to a text heavy content stream
+    vector<string_view> operators = { "BT", "Tf", "Tm", "TJ", "Tj", "Td", "ET", "q", "cm",
+        "re", "W", "n", "Do", "Q", "rg", "RG", "g", "w", "m", "l", "S", "f", "TJ", "Tj",
+        "T*", "TD", "Tc", "Tw", "BDC", "EMC", "gs", "scn", "unknown" };
+
+    BENCHMARK("Switch lookup")
+    {
+        unsigned found = 0;
+        PdfOperator op;
+        for (auto opstr : operators)
+            found += TryGetPdfOperator(opstr, op);
+        return found;
+    };
+
+    BENCHMARK("Linear lookup")
+    {
+        unsigned found = 0;
+        PdfOperator op;
+        for (auto opstr : operators)
+            found += tryGetPdfOperatorLinear(opstr, op);
+        return found;
+    };
+}
+
+// Reference implementation, equivalent to the previous chain of comparisons
+bool tryGetPdfOperatorLinear(const string_view& opstr, PdfOperator& op)
+{
+    static vector<string> names;
+    if (names.empty())
+    {
+        for (unsigned i = (unsigned)PdfOperator::w; i <= (unsigned)PdfOperator::EX; i++)
+            names.push_back((string)GetPdfOperatorName((PdfOperator)i));
+    }
+
+    for (unsigned i = 0; i < names.size(); i++)
+    {
+        if (opstr == names[i])
+        {
+            op = (PdfOperator)(i + (unsigned)PdfOperator::w);
+            return true;
+        }
+    }
+
+    op = PdfOperator::Unknown;
+    return false;
+}
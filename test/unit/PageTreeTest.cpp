@@ -190,6 +190,173 @@ TEST_CASE("testDeleteAll")
     testDeleteAll(doc);
 }
 
+TEST_CASE("testPageIterator")
+{
+    PdfMemDocument doc;
+    PdfPageTest::CreateTestTreeCustom(doc);
+    auto& pages = doc.GetPages();
+
+    // Cache a page, the iterator must return the same instance
+    auto& cachedPage = pages.GetPageAt(42);
+
+    unsigned i = 0;
+    for (auto& page : pages)
+    {
+        REQUIRE(isPageNumber(page, i));
+        REQUIRE(page.GetIndex() == i);
+        if (i == 42)
+            REQUIRE(&page == &cachedPage);
+        i++;
+    }
+    REQUIRE(i == TEST_NUM_PAGES);
+
+    // Random access after the iteration must be consistent
+    for (unsigned j = TEST_NUM_PAGES; j > 0; j--)
+        REQUIRE(isPageNumber(pages.GetPageAt(j - 1), j - 1));
+
+    auto& constPages = const_cast<const PdfPageCollection&>(pages);
+    auto it = constPages.begin();
+    auto copy = it++;
+    REQUIRE(isPageNumber(const_cast<PdfPage&>(*copy), 0));
+    REQUIRE(isPageNumber(const_cast<PdfPage&>(*it), 1));
+    REQUIRE(copy != it);
+    REQUIRE(++copy == it);
+
+    {
+        PdfMemDocument emptyDoc;
+        REQUIRE(emptyDoc.GetPages().begin() == emptyDoc.GetPages().end());
+    }
+
+    {
+        PdfMemDocument cyclicDoc;
+        createCyclicTree(cyclicDoc, true);
+        ASSERT_THROW_WITH_ERROR_CODE(cyclicDoc.GetPages().begin(), PdfErrorCode::PageNotFound);
+    }
+}
+
+TEST_CASE("testInheritedResources")
+{
+    PdfMemDocument doc;
+    auto pages = PdfPageTest::CreateSamplePages(doc, 2);
+    auto nodes = createNodes(doc, 2);
+    auto& root = doc.GetPages().GetObject();
+
+    // tree layout:
+    //
+    //    root (/Resources 1)
+    //    +-- node0 (/Resources 2)
+    //        +-- node1
+    //            +-- page0
+    //            \-- page1
+    appendChildNode(root, *nodes[0]);
+    appendChildNode(*nodes[0], *nodes[1]);
+    appendChildNode(*nodes[1], pages[0]->GetObject());
+    appendChildNode(*nodes[1], pages[1]->GetObject());
+
+    pages[0]->GetObject().GetDictionary().RemoveKey("Resources");
+    pages[1]->GetObject().GetDictionary().RemoveKey("Resources");
+    auto& rootResources = doc.GetObjects().CreateDictionaryObject();
+    auto& nodeResources = doc.GetObjects().CreateDictionaryObject();
+    root.GetDictionary().AddKey("Resources", rootResources.GetIndirectReference());
+    nodes[0]->GetDictionary().AddKey("Resources", nodeResources.GetIndirectReference());
+
+    // The nearest parent defining resources takes precedence
+    unsigned count = 0;
+    for (auto& page : doc.GetPages())
+    {
+        REQUIRE(page.GetResources() != nullptr);
+        REQUIRE(&page.GetResources()->GetObject() == &nodeResources);
+        count++;
+    }
+    REQUIRE(count == 2);
+
+    auto& page = doc.GetPages().GetPageAt(1);
+    REQUIRE(page.GetResources() != nullptr);
+    REQUIRE(&page.GetResources()->GetObject() == &nodeResources);
+}
+
+TEST_CASE("testKidsPageCountsInvalidation")
+{
+    PdfMemDocument doc;
+    auto pages = PdfPageTest::CreateSamplePages(doc, 4);
+    auto nodes = createNodes(doc, 2);
+    auto& root = doc.GetPages().GetObject();
+
+    // tree layout:
+    //
+    //    root
+    //    +-- node0
+    //    |   +-- page0
+    //    |   \-- page1
+    //    \-- node1
+    //        +-- page2
+    //        \-- page3
+    appendChildNode(root, *nodes[0]);
+    appendChildNode(root, *nodes[1]);
+    appendChildNode(*nodes[0], pages[0]->GetObject());
+    appendChildNode(*nodes[0], pages[1]->GetObject());
+    appendChildNode(*nodes[1], pages[2]->GetObject());
+    appendChildNode(*nodes[1], pages[3]->GetObject());
+
+    // Random access caches the kids page counts of the nodes
+    auto& pageCollection = doc.GetPages();
+    for (unsigned i = 0; i < 4; i++)
+        REQUIRE(isPageNumber(pageCollection.GetPageAt(i), i));
+
+    // Inserting in node0 changes the counts of the root and node0
+    auto& newPage = pageCollection.CreatePageAt(1, PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    newPage.GetObject().GetDictionary().AddKey(TEST_PAGE_KEY, static_cast<int64_t>(10));
+    REQUIRE(pageCollection.GetCount() == 5);
+    vector<unsigned> expected = { 0, 10, 1, 2, 3 };
+    for (unsigned i = 0; i < expected.size(); i++)
+        REQUIRE(isPageNumber(pageCollection.GetPageAt(i), expected[i]));
+
+    // Removing all the pages of node0 removes the node too
+    auto node0Ref = nodes[0]->GetIndirectReference();
+    for (unsigned i = 0; i < 3; i++)
+        pageCollection.RemovePageAt(0);
+
+    REQUIRE(doc.GetObjects().GetObject(node0Ref) == nullptr);
+    REQUIRE(pageCollection.GetCount() == 2);
+    REQUIRE(isPageNumber(pageCollection.GetPageAt(0), 2));
+    REQUIRE(isPageNumber(pageCollection.GetPageAt(1), 3));
+}
+
+TEST_CASE("testKidsPageCountsDirectEdit")
+{
+    PdfMemDocument doc;
+    auto pages = PdfPageTest::CreateSamplePages(doc, 4);
+    auto nodes = createNodes(doc, 2);
+    auto& root = doc.GetPages().GetObject();
+    appendChildNode(root, *nodes[0]);
+    appendChildNode(root, *nodes[1]);
+    appendChildNode(*nodes[0], pages[0]->GetObject());
+    appendChildNode(*nodes[0], pages[1]->GetObject());
+    appendChildNode(*nodes[1], pages[2]->GetObject());
+    appendChildNode(*nodes[1], pages[3]->GetObject());
+
+    // Cache the kids page counts of the root and node1
+    auto& pageCollection = doc.GetPages();
+    REQUIRE(isPageNumber(pageCollection.GetPageAt(3), 3));
+
+    // Move page1 from node0 to node1 editing /Kids and /Count directly:
+    // the root /Kids size and /Count stay the same
+    auto& page1 = pages[1]->GetObject();
+    PdfArray kids0;
+    kids0.Add(pages[0]->GetObject().GetIndirectReference());
+    nodes[0]->GetDictionary().AddKey("Kids", kids0);
+    nodes[0]->GetDictionary().AddKey("Count", static_cast<int64_t>(1));
+    PdfArray kids1;
+    for (unsigned i = 1; i < 4; i++)
+        kids1.Add(pages[i]->GetObject().GetIndirectReference());
+    nodes[1]->GetDictionary().AddKey("Kids", kids1);
+    nodes[1]->GetDictionary().AddKey("Count", static_cast<int64_t>(3));
+    page1.GetDictionary().AddKey("Parent", nodes[1]->GetIndirectReference());
+
+    REQUIRE(isPageNumber(pageCollection.GetPageAt(1), 1));
+    REQUIRE(isPageNumber(pageCollection.GetPageAt(2), 2));
+}
+
 void testGetPages(PdfMemDocument& doc)
 {
     for (unsigned i = 0; i < TEST_NUM_PAGES; i++)
@@ -39,6 +39,35 @@ TEST_CASE("testAppend")
     REQUIRE(out == "q\nBT (Hello) Tj ET\nQ\nq\n1 1 1 rg\nQ\n");
 }
 
+TEST_CASE("testMultiLineText")
+{
+    PdfMemDocument doc;
+    auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    PdfTextState state;
+    state.Font = doc.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica);
+    state.FontSize = 10;
+    painter.GetTextState().SetFont(*state.Font, state.FontSize);
+    double width = state.Font->GetStringLength("Hello world"sv, state);
+    painter.DrawMultiLineText("Hello world hello\nagain", 0, 0, width + 1, 100);
+    painter.FinishDrawing();
+
+    PdfCanvasInputDevice input(doc.GetPages().GetPageAt(0));
+    string out;
+    StringStreamDevice output(out);
+    input.CopyTo(output);
+
+    // Codes are assigned to the glyphs in order of use
+    INFO(out);
+    auto first = out.find("<0001020203040503060207> Tj");  // Hello world
+    auto second = out.find("<0801020203> Tj");             // hello
+    auto third = out.find("<090A090B0C> Tj");              // again
+    REQUIRE(third != string::npos);
+    REQUIRE(first < second);
+    REQUIRE(second < third);
+}
+
 void CompareStreamContent(PdfObjectStream& stream, const string_view& expected)
 {
     charbuff buffer;
@@ -21,6 +21,7 @@
 #include <limits>
 
 #include <sstream>
+#include <thread>
 
 #include <PdfTest.h>
 
@@ -31,6 +32,8 @@ static string generateXRefEntries(size_t count);
 static bool canOutOfMemoryKillUnitTests();
 static void testReadXRefSubsection();
 static size_t getStackOverflowDepth();
+static string generateDocumentWithStreams(unsigned objectCount, PdfSaveOptions opts = PdfSaveOptions::None);
+static void checkSameObjects(const PdfIndirectObjectList& objects1, const PdfIndirectObjectList& objects2);
 
 // this value is from Table C.1 in Appendix C.2 Architectural Limits in PDF 32000-1:2008
 // on 32-bit systems sizeof(PdfParser::TXRefEntry)=16 => max size of m_offsets=16*8,388,607 = 134 MB
@@ -89,6 +92,20 @@ namespace mm
         string m_buffer;
         shared_ptr<InputStreamDevice> m_device;
     };
+
+    // Minimal document used to parse objects without load on demand
+    class PdfParserTestDocument : public PdfDocument
+    {
+    public:
+        PdfParserTestDocument()
+            : PdfDocument(true) { }
+
+        const PdfEncrypt* GetEncrypt() const override { return nullptr; }
+
+    protected:
+        PdfVersion GetPdfVersion() const override { return PdfVersionDefault; }
+        void SetPdfVersion(PdfVersion version) override { (void)version; }
+    };
 }
 
 TEST_CASE("TestMaxObjectCount")
@@ -1804,6 +1821,255 @@ TEST_CASE("testReadObjects")
     }
 }
 
+TEST_CASE("testReadObjectsParallel")
+{
+    auto docbuff = generateDocumentWithStreams(500);
+
+    PdfParserTestDocument serialDoc;
+    auto& serialObjects = serialDoc.GetObjects();
+    PdfParser serialParser(serialObjects);
+    SpanStreamDevice serialDevice(docbuff);
+    serialParser.Parse(serialDevice, false);
+
+    PdfParserTestDocument parallelDoc;
+    auto& parallelObjects = parallelDoc.GetObjects();
+    PdfParser parallelParser(parallelObjects);
+    parallelParser.SetLoadThreadCount(4);
+    SpanStreamDevice parallelDevice(docbuff);
+    parallelParser.Parse(parallelDevice, false);
+
+    REQUIRE(serialObjects.GetSize() > 500);
+    checkSameObjects(serialObjects, parallelObjects);
+}
+
+TEST_CASE("testReadObjectsParallelObjectStreams")
+{
+    // Compressed objects are read from object streams
+    // referenced by type 2 entries of a XRef stream
+    auto docbuff = generateDocumentWithStreams(500, PdfSaveOptions::ObjectStreams);
+    REQUIRE(docbuff.find("/ObjStm") != string::npos);
+    REQUIRE(docbuff.find("/XRef") != string::npos);
+
+    PdfParserTestDocument serialDoc;
+    auto& serialObjects = serialDoc.GetObjects();
+    PdfParser serialParser(serialObjects);
+    SpanStreamDevice serialDevice(docbuff);
+    serialParser.Parse(serialDevice, false);
+
+    for (unsigned threadCount : { 2, 4, 7 })
+    {
+        PdfParserTestDocument parallelDoc;
+        auto& parallelObjects = parallelDoc.GetObjects();
+        PdfParser parallelParser(parallelObjects);
+        parallelParser.SetLoadThreadCount(threadCount);
+        SpanStreamDevice parallelDevice(docbuff);
+        parallelParser.Parse(parallelDevice, false);
+
+        // The concurrent read mode used by the workers is reset
+        REQUIRE(!parallelDoc.IsConcurrentReadMode());
+        REQUIRE(serialObjects.GetSize() > 500);
+        checkSameObjects(serialObjects, parallelObjects);
+    }
+}
+
+TEST_CASE("testConcurrentRead")
+{
+    auto docbuff = generateDocumentWithStreams(500);
+
+    PdfMemDocument serialDoc;
+    serialDoc.LoadFromBuffer(docbuff);
+    vector<string> expected;
+    for (auto obj : serialDoc.GetObjects())
+    {
+        string str;
+        obj->GetVariant().ToString(str);
+        if (obj->HasStream())
+            str.append(obj->MustGetStream().GetCopy());
+
+        expected.push_back(str);
+    }
+
+    for (bool concurrentRead : { false, true })
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(docbuff);
+        doc.SetConcurrentReadMode(concurrentRead);
+        REQUIRE(doc.IsConcurrentReadMode() == concurrentRead);
+
+        // Read all the objects from multiple threads, each
+        // one starting from a different object
+        constexpr unsigned ThreadCount = 4;
+        vector<const PdfObject*> objects(doc.GetObjects().begin(), doc.GetObjects().end());
+        vector<vector<string>> results(ThreadCount, vector<string>(objects.size()));
+        vector<thread> threads;
+        for (unsigned i = 0; i < ThreadCount; i++)
+        {
+            threads.emplace_back([&, i]() {
+                for (size_t j = 0; j < objects.size(); j++)
+                {
+                    size_t index = (j + objects.size() * i / ThreadCount) % objects.size();
+                    auto& str = results[i][index];
+                    objects[index]->GetVariant().ToString(str);
+                    if (objects[index]->HasStream())
+                        str.append(objects[index]->MustGetStream().GetCopy());
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        for (unsigned i = 0; i < ThreadCount; i++)
+            REQUIRE(results[i] == expected);
+    }
+}
+
+TEST_CASE("testObjectMemoryBudget")
+{
+    auto docbuff = generateDocumentWithStreams(500);
+    auto toString = [](const PdfObject& obj) {
+        string str;
+        obj.GetVariant().ToString(str);
+        if (obj.HasStream())
+            str.append(obj.MustGetStream().GetCopy());
+        return str;
+    };
+
+    PdfMemDocument expectedDoc;
+    expectedDoc.LoadFromBuffer(docbuff);
+    vector<string> expected;
+    for (auto obj : expectedDoc.GetObjects())
+        expected.push_back(toString(*obj));
+
+    // Load from a device not backed by memory, so the
+    // stream data is copied instead of being borrowed
+    constexpr size_t Budget = 1024;
+    istringstream input(docbuff);
+    PdfMemDocument doc;
+    doc.LoadFromDevice(std::make_shared<StandardStreamDevice>(input));
+    doc.SetObjectMemoryBudget(Budget);
+    REQUIRE(doc.GetObjectMemoryBudget() == Budget);
+
+    vector<PdfObject*> objects(doc.GetObjects().begin(), doc.GetObjects().end());
+    PdfObject* streamObj = nullptr;
+    PdfObject* pinnedObj = nullptr;
+    PdfObject* lastStreamObj = nullptr;
+    unsigned streamCount = 0;
+    for (auto obj : objects)
+    {
+        if (!obj->HasStream())
+            continue;
+
+        streamCount++;
+        lastStreamObj = obj;
+        if (streamObj == nullptr)
+            streamObj = obj;
+        else if (pinnedObj == nullptr)
+            pinnedObj = obj;
+    }
+
+    REQUIRE(streamObj != nullptr);
+    REQUIRE(pinnedObj != nullptr);
+    size_t streamIndex = (size_t)(std::find(objects.begin(), objects.end(), streamObj) - objects.begin());
+
+    // Make a stream object dirty, it must be never freed
+    auto& dirtyObj = *streamObj;
+    dirtyObj.GetDictionary().AddKey("Dirty", true);
+    expected[streamIndex] = toString(dirtyObj);
+
+    // References to the dictionaries and the streams stay valid
+    // while the stream data is released and loaded again
+    auto& stream = lastStreamObj->MustGetStream();
+    auto& dict = lastStreamObj->GetDictionary();
+    string expectedData = stream.GetCopy();
+
+    // The data of pinned streams is kept in memory
+    PdfIndirectObjectList::MemoryPin pin(*pinnedObj);
+    (void)pinnedObj->MustGetStream();
+
+    for (unsigned i = 0; i < 2; i++)
+    {
+        for (size_t j = 0; j < objects.size(); j++)
+            REQUIRE(toString(*objects[j]) == expected[j]);
+
+        unsigned freedCount = 0;
+        for (auto obj : objects)
+        {
+            // Only stream data is released
+            REQUIRE(obj->IsDelayedLoadDone());
+            if (!obj->IsDelayedLoadStreamDone())
+                freedCount++;
+        }
+
+        REQUIRE(freedCount > streamCount / 2);
+        REQUIRE(doc.GetLoadedObjectMemory() < 2 * Budget);
+        REQUIRE(pinnedObj->IsDelayedLoadStreamDone());
+        REQUIRE(dirtyObj.IsDelayedLoadStreamDone());
+        REQUIRE(stream.GetCopy() == expectedData);
+        REQUIRE(dict.HasKey(PdfName::KeyLength));
+    }
+
+    REQUIRE(dirtyObj.GetDictionary().HasKey("Dirty"));
+
+    doc.SetObjectMemoryBudget(0);
+    REQUIRE(doc.GetLoadedObjectMemory() == 0);
+    for (size_t j = 0; j < objects.size(); j++)
+        REQUIRE(toString(*objects[j]) == expected[j]);
+}
+
+TEST_CASE("testRemoveParsedObject")
+{
+    auto docbuff = generateDocumentWithStreams(500);
+    auto toString = [](const PdfObject& obj) {
+        string str;
+        obj.GetVariant().ToString(str);
+        if (obj.HasStream())
+            str.append(obj.MustGetStream().GetCopy());
+        return str;
+    };
+
+    PdfMemDocument expectedDoc;
+    expectedDoc.LoadFromBuffer(docbuff);
+    vector<string> expected;
+    for (auto obj : expectedDoc.GetObjects())
+        expected.push_back(toString(*obj));
+
+    unique_ptr<PdfObject> removed;
+    string removedExpected;
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(docbuff);
+
+        vector<const PdfObject*> objects(doc.GetObjects().begin(), doc.GetObjects().end());
+        REQUIRE(objects.size() == expected.size());
+        for (size_t i = 0; i < objects.size(); i++)
+            REQUIRE(toString(*objects[i]) == expected[i]);
+
+        // Parsed objects are returned as they are when
+        // removed, and can outlive the document
+        auto streamObj = *std::find_if(objects.begin() + objects.size() / 2, objects.end(),
+            [](const PdfObject* obj) { return obj->HasStream(); });
+        auto offset = dynamic_cast<const PdfParserObject&>(*streamObj).GetOffset();
+        removedExpected = toString(*streamObj);
+        removed = doc.GetObjects().RemoveObject(streamObj->GetIndirectReference());
+        REQUIRE(removed.get() == streamObj);
+        REQUIRE(dynamic_cast<PdfParserObject&>(*removed).GetOffset() == offset);
+        REQUIRE(toString(*removed) == removedExpected);
+
+        // The stream must refer to the removed object
+        removed->MustGetStream().SetData("12345"sv, PdfFilterList());
+        REQUIRE(!removed->GetDictionary().HasKey(PdfName::KeyFilter));
+        REQUIRE(removed->MustGetStream().GetCopy() == "12345");
+        removedExpected.clear();
+        removed->GetVariant().ToString(removedExpected);
+    }
+
+    string removedStr;
+    removed->GetVariant().ToString(removedStr);
+    REQUIRE(removedStr == removedExpected);
+    removed.reset();
+}
+
 TEST_CASE("testIsPdfFile")
 {
     try
@@ -1983,6 +2249,409 @@ TEST_CASE("testSaveIncrementalRoundTrip")
     }
 }
 
+TEST_CASE("testSaveObjectStreams")
+{
+    constexpr unsigned OBJECT_COUNT = 250;
+    auto fillDocument = [](PdfMemDocument& doc, unsigned count, const string_view& prefix) {
+        auto& arr = doc.GetCatalog().GetDictionary().AddKey("TestObjects", PdfArray()).GetArray();
+        for (unsigned i = 0; i < count; i++)
+        {
+            auto& obj = doc.GetObjects().CreateDictionaryObject("TestObject");
+            obj.GetDictionary().AddKey("Value", PdfString(utls::Format("{} {}", prefix, i)));
+            arr.Add(obj.GetIndirectReference());
+        }
+    };
+    auto checkDocument = [](PdfMemDocument& doc, unsigned count, const string_view& prefix) {
+        auto& arr = doc.GetCatalog().GetDictionary().MustFindKey("TestObjects").GetArray();
+        REQUIRE(arr.size() == count);
+        for (unsigned i = 0; i < count; i++)
+        {
+            auto& obj = doc.GetObjects().MustGetObject(arr[i].GetReference());
+            REQUIRE(obj.GetDictionary().MustFindKey("Value").GetString().GetString()
+                == utls::Format("{} {}", prefix, i));
+        }
+    };
+
+    charbuff plainBuffer;
+    charbuff compressedBuffer;
+    {
+        PdfMemDocument doc;
+        fillDocument(doc, OBJECT_COUNT, "Value");
+        BufferStreamDevice plainDevice(plainBuffer);
+        doc.Save(plainDevice);
+
+        doc.SetObjectStreamGroupSize(40);
+        BufferStreamDevice compressedDevice(compressedBuffer);
+        doc.Save(compressedDevice, PdfSaveOptions::ObjectStreams);
+
+        // Object streams are not retained by the document after a full save
+        unsigned objStmCount = 0;
+        for (auto obj : doc.GetObjects())
+        {
+            if (obj->GetDictionary().FindKeyAs<PdfName>(PdfName::KeyType) == "ObjStm")
+                objStmCount++;
+        }
+        REQUIRE(objStmCount == 0);
+    }
+
+    REQUIRE(compressedBuffer.size() < plainBuffer.size());
+
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(compressedBuffer);
+        REQUIRE(doc.GetMetadata().GetPdfVersion() >= PdfVersion::V1_5);
+        checkDocument(doc, OBJECT_COUNT, "Value");
+
+        // All the 250 objects plus catalog, pages and info
+        // dictionaries fit in at least 7 object streams
+        unsigned objStmCount = 0;
+        for (auto obj : doc.GetObjects())
+        {
+            if (obj->IsDictionary() && obj->GetDictionary().FindKeyAs<PdfName>(PdfName::KeyType) == "ObjStm")
+            {
+                REQUIRE(obj->GetDictionary().MustFindKey("N").GetNumber() <= 40);
+                objStmCount++;
+            }
+        }
+        REQUIRE(objStmCount >= 7);
+
+        // Incremental update with object streams
+        fillDocument(doc, OBJECT_COUNT, "Update1");
+        BufferStreamDevice device(compressedBuffer);
+        doc.SaveUpdate(device, PdfSaveOptions::ObjectStreams);
+    }
+
+    {
+        // Update again on top of the existing update
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(compressedBuffer);
+        checkDocument(doc, OBJECT_COUNT, "Update1");
+
+        auto& arr = doc.GetCatalog().GetDictionary().MustFindKey("TestObjects").GetArray();
+        doc.GetObjects().MustGetObject(arr[0].GetReference()).GetDictionary()
+            .AddKey("Value", PdfString("Update2 0"));
+        BufferStreamDevice device(compressedBuffer);
+        doc.SaveUpdate(device, PdfSaveOptions::ObjectStreams);
+    }
+
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(compressedBuffer);
+        auto& arr = doc.GetCatalog().GetDictionary().MustFindKey("TestObjects").GetArray();
+        REQUIRE(doc.GetObjects().MustGetObject(arr[0].GetReference()).GetDictionary()
+            .MustFindKey("Value").GetString().GetString() == "Update2 0");
+        for (unsigned i = 1; i < OBJECT_COUNT; i++)
+        {
+            REQUIRE(doc.GetObjects().MustGetObject(arr[i].GetReference()).GetDictionary()
+                .MustFindKey("Value").GetString().GetString() == utls::Format("Update1 {}", i));
+        }
+    }
+
+    {
+        // Strings in object streams are encrypted along with the stream
+        PdfMemDocument doc;
+        fillDocument(doc, OBJECT_COUNT, "Secret");
+        doc.SetEncrypted("user", "owner", PdfPermissions::Default, PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+        charbuff buffer;
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::ObjectStreams);
+        REQUIRE(buffer.find("Secret") == string::npos);
+
+        PdfMemDocument encrypted;
+        encrypted.LoadFromBuffer(buffer, "user");
+        checkDocument(encrypted, OBJECT_COUNT, "Secret");
+    }
+}
+
+TEST_CASE("testSaveObjectStreamsSize")
+{
+    auto getSize = [](const charbuff& buffer) {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        return doc.GetTrailer().GetDictionary().MustFindKey("Size").GetNumber();
+    };
+
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < 5; i++)
+        doc.GetObjects().CreateDictionaryObject("TestObject");
+
+    // The object stream numbers of a full save are reused by the next one
+    charbuff buffer1;
+    BufferStreamDevice device1(buffer1);
+    doc.Save(device1, PdfSaveOptions::ObjectStreams);
+    charbuff buffer2;
+    BufferStreamDevice device2(buffer2);
+    doc.Save(device2, PdfSaveOptions::ObjectStreams);
+    REQUIRE(getSize(buffer1) == getSize(buffer2));
+}
+
+TEST_CASE("testSaveLinearized")
+{
+    constexpr unsigned PAGE_COUNT = 4;
+    auto fillDocument = [](PdfMemDocument& doc) {
+        // A font shared by all pages, a font shared by the pages
+        // after the first one and an image private to the last page
+        auto& allPagesFont = doc.GetObjects().CreateDictionaryObject("Font");
+        auto& otherPagesFont = doc.GetObjects().CreateDictionaryObject("Font");
+        auto& image = doc.GetObjects().CreateDictionaryObject("XObject");
+        image.GetOrCreateStream().SetData("Image data");
+        for (unsigned i = 0; i < PAGE_COUNT; i++)
+        {
+            auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            auto& contents = doc.GetObjects().CreateDictionaryObject();
+            contents.GetOrCreateStream().SetData(utls::Format("BT (Page {}) Tj ET", i));
+            page.GetDictionary().AddKey("Contents", contents.GetIndirectReference());
+
+            PdfDictionary fonts;
+            fonts.AddKey("F1", allPagesFont.GetIndirectReference());
+            if (i != 0)
+                fonts.AddKey("F2", otherPagesFont.GetIndirectReference());
+
+            PdfDictionary resources;
+            resources.AddKey("Font", fonts);
+            if (i == PAGE_COUNT - 1)
+            {
+                PdfDictionary xobjects;
+                xobjects.AddKey("Im1", image.GetIndirectReference());
+                resources.AddKey("XObject", xobjects);
+            }
+            page.GetDictionary().AddKey("Resources", resources);
+        }
+
+        // Inherited page attribute
+        doc.GetPages().GetObject().GetDictionary().AddKey("Rotate", static_cast<int64_t>(90));
+        doc.GetOrCreateOutlines().CreateRoot("Chapter 1")->CreateNext("Chapter 2", std::make_shared<PdfDestination>(doc.GetPages().GetPageAt(1)));
+    };
+
+    auto findObjectOffset = [](const charbuff& buffer, const PdfReference& ref) {
+        auto offset = buffer.find(utls::Format("\n{} 0 obj", ref.ObjectNumber()));
+        REQUIRE(offset != string::npos);
+        return offset + 1;
+    };
+
+    auto checkDocument = [&](const charbuff& buffer, const string_view& password) {
+        REQUIRE(buffer.find("/Linearized") < 1024);
+
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer, password);
+        REQUIRE(doc.GetPages().GetCount() == PAGE_COUNT);
+        for (unsigned i = 0; i < PAGE_COUNT; i++)
+        {
+            auto& page = doc.GetPages().GetPageAt(i);
+            auto data = page.GetDictionary().MustFindKey("Contents").MustGetStream().GetCopy();
+            REQUIRE(string_view(data.data(), data.size()) == utls::Format("BT (Page {}) Tj ET", i));
+
+            // Inherited attributes are written in the pages
+            REQUIRE(page.GetDictionary().MustFindKey("Rotate").GetNumber() == 90);
+        }
+        REQUIRE(!doc.GetPages().GetObject().GetDictionary().HasKey("Rotate"));
+
+        const PdfObject* linearized = nullptr;
+        for (auto obj : doc.GetObjects())
+        {
+            if (obj->IsDictionary() && obj->GetDictionary().HasKey("Linearized"))
+                linearized = obj;
+        }
+        REQUIRE(linearized != nullptr);
+        auto& dict = linearized->GetDictionary();
+        REQUIRE((size_t)dict.MustFindKey("L").GetNumber() == buffer.size());
+        REQUIRE(dict.MustFindKey("N").GetNumber() == PAGE_COUNT);
+        REQUIRE(dict.MustFindKey("O").GetNumber() == doc.GetPages().GetPageAt(0).GetObject().GetIndirectReference().ObjectNumber());
+        REQUIRE(buffer.substr((size_t)dict.MustFindKey("T").GetNumber(), 21) == "\n0000000000 65535 f \n");
+
+        // The first page ends where the second begins
+        size_t endFirstPage = (size_t)dict.MustFindKey("E").GetNumber();
+        REQUIRE(findObjectOffset(buffer, doc.GetPages().GetPageAt(1).GetObject().GetIndirectReference()) == endFirstPage);
+
+        // Decode the page offset hint table, see ISO 32000-1:2008 F.4.1
+        auto& hintArr = dict.MustFindKey("H").GetArray();
+        size_t hintOffset = (size_t)hintArr[0].GetNumber();
+        size_t hintLength = (size_t)hintArr[1].GetNumber();
+        unsigned hintNum;
+        REQUIRE(sscanf(buffer.data() + hintOffset, "%u 0 obj", &hintNum) == 1);
+        auto hintData = doc.GetObjects().MustGetObject(PdfReference(hintNum, 0)).MustGetStream().GetCopy();
+        size_t bitPos = 0;
+        auto readBits = [&](unsigned count) {
+            uint64_t ret = 0;
+            for (unsigned i = 0; i < count; i++, bitPos++)
+                ret = (ret << 1) | (((uint8_t)hintData[bitPos / 8] >> (7 - bitPos % 8)) & 1);
+            return ret;
+        };
+        auto align = [&]() { bitPos = (bitPos + 7) / 8 * 8; };
+
+        uint64_t minObjectCount = readBits(32);
+        uint64_t firstPageOffset = readBits(32);
+        unsigned objectCountBits = (unsigned)readBits(16);
+        uint64_t minPageLength = readBits(32);
+        unsigned pageLengthBits = (unsigned)readBits(16);
+        readBits(32 + 16 + 32 + 16 + 16 + 16 + 16 + 16);
+        REQUIRE(firstPageOffset == hintOffset);
+        vector<uint64_t> objectCounts;
+        for (unsigned i = 0; i < PAGE_COUNT; i++)
+            objectCounts.push_back(minObjectCount + readBits(objectCountBits));
+        align();
+        vector<uint64_t> pageLengths;
+        for (unsigned i = 0; i < PAGE_COUNT; i++)
+            pageLengths.push_back(minPageLength + readBits(pageLengthBits));
+
+        // Page offsets in the hint tables disregard the hint stream
+        REQUIRE(hintOffset + hintLength + pageLengths[0] == endFirstPage);
+        uint64_t pageOffset = firstPageOffset;
+        for (unsigned i = 0; i < PAGE_COUNT; i++)
+        {
+            auto& ref = doc.GetPages().GetPageAt(i).GetObject().GetIndirectReference();
+            size_t offset = findObjectOffset(buffer, ref);
+            REQUIRE(offset - hintLength == pageOffset);
+            pageOffset += pageLengths[i];
+        }
+
+        // The last page has its contents and the private image
+        REQUIRE(objectCounts[PAGE_COUNT - 1] == 3);
+        REQUIRE(objectCounts[1] == 2);
+    };
+
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        fillDocument(doc);
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptionsLinearize);
+    }
+    checkDocument(buffer, { });
+
+    {
+        // Linearization is not compatible with incremental updates
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        BufferStreamDevice device(buffer);
+        ASSERT_THROW_WITH_ERROR_CODE(doc.SaveUpdate(device, PdfSaveOptionsLinearize), PdfErrorCode::NotImplemented);
+    }
+
+    {
+        PdfMemDocument doc;
+        fillDocument(doc);
+        doc.SetEncrypted("user", "owner", PdfPermissions::Default, PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+        buffer.clear();
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptionsLinearize);
+    }
+    REQUIRE(buffer.find("Page 1") == string::npos);
+    checkDocument(buffer, "user");
+}
+
+TEST_CASE("testSaveParallelCompression")
+{
+    // Streams of widely varying sizes, including empty ones
+    // and a metadata stream, which must not be compressed
+    auto fillDocument = [](PdfMemDocument& doc) {
+        auto& arr = doc.GetCatalog().GetDictionary().AddKey("TestStreams", PdfArray()).GetArray();
+        for (unsigned i = 0; i < 300; i++)
+        {
+            string data;
+            for (unsigned j = 0; j < (i * 7919) % 20000; j++)
+                data.push_back((char)('a' + (j * j + i) % 23));
+
+            auto& obj = doc.GetObjects().CreateDictionaryObject();
+            obj.GetOrCreateStream().SetData(data, true);
+            arr.Add(obj.GetIndirectReference());
+        }
+
+        auto& metadata = doc.GetObjects().CreateDictionaryObject("Metadata");
+        metadata.GetOrCreateStream().SetData("<x:xmpmeta></x:xmpmeta>", true);
+        doc.GetCatalog().GetDictionary().AddKey("Metadata", metadata.GetIndirectReference());
+
+        // Make the output independent of the time of creation
+        doc.GetMetadata().SetCreationDate(PdfDate::Parse("D:20220101000000Z"));
+        doc.GetMetadata().SetModifyDate(PdfDate::Parse("D:20220101000000Z"));
+    };
+
+    auto save = [&](unsigned threadCount, PdfSaveOptions opts) {
+        PdfMemDocument doc;
+        fillDocument(doc);
+        doc.SetCompressionThreadCount(threadCount);
+        charbuff buffer;
+        BufferStreamDevice device(buffer);
+        doc.Save(device, opts | PdfSaveOptions::NoModifyDateUpdate);
+        return buffer;
+    };
+
+    auto serial = save(1, PdfSaveOptions::None);
+    REQUIRE(serial.find("<x:xmpmeta></x:xmpmeta>") != string::npos);
+    REQUIRE(save(4, PdfSaveOptions::None) == serial);
+    REQUIRE(save(0, PdfSaveOptions::None) == serial);
+    REQUIRE(save(4, PdfSaveOptions::ObjectStreams) == save(1, PdfSaveOptions::ObjectStreams));
+
+    {
+        // Compressed streams are moved in the document objects as with serial writing
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(serial);
+        auto& arr = doc.GetCatalog().GetDictionary().MustFindKey("TestStreams").GetArray();
+        for (unsigned i = 0; i < 300; i++)
+        {
+            auto& stream = doc.GetObjects().MustGetObject(arr[i].GetReference()).MustGetStream();
+            REQUIRE(stream.GetFilters().size() == 1);
+            REQUIRE(stream.GetCopy().size() == (i * 7919) % 20000);
+        }
+
+        // Incremental update with new uncompressed streams
+        auto update = serial;
+        for (unsigned threadCount : { 1u, 4u })
+        {
+            PdfMemDocument updated;
+            updated.LoadFromBuffer(serial);
+            updated.SetCompressionThreadCount(threadCount);
+            for (unsigned i = 0; i < 50; i++)
+            {
+                auto& obj = updated.GetObjects().MustGetObject(
+                    updated.GetCatalog().GetDictionary().MustFindKey("TestStreams").GetArray()[i * 3].GetReference());
+                obj.GetOrCreateStream().SetData(utls::Format("Updated stream {} {}", i, string(i * 100, 'x')), true);
+            }
+
+            charbuff buffer = serial;
+            BufferStreamDevice device(buffer);
+            device.Seek(0, SeekDirection::End);
+            updated.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+            if (threadCount == 1)
+                update = buffer;
+            else
+                REQUIRE(buffer == update);
+        }
+    }
+
+    {
+        // Unfiltered streams loaded from the source device, with a memory
+        // budget that releases stream data while the streams are compressed
+        PdfMemDocument doc;
+        auto& arr = doc.GetCatalog().GetDictionary().AddKey("TestStreams", PdfArray()).GetArray();
+        for (unsigned i = 0; i < 400; i++)
+        {
+            auto& obj = doc.GetObjects().CreateDictionaryObject();
+            obj.GetOrCreateStream().SetData(utls::Format("Stream {} {}", i, string(i * 10, 'x')), true);
+            arr.Add(obj.GetIndirectReference());
+        }
+
+        string source;
+        StringStreamDevice sourceDevice(source);
+        doc.Save(sourceDevice, PdfSaveOptions::NoFlateCompress);
+
+        auto save = [&](unsigned threadCount, size_t budget) {
+            istringstream input(source);
+            PdfMemDocument doc;
+            doc.LoadFromDevice(std::make_shared<StandardStreamDevice>(input));
+            doc.SetObjectMemoryBudget(budget);
+            doc.SetCompressionThreadCount(threadCount);
+            charbuff buffer;
+            BufferStreamDevice device(buffer);
+            doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+            return buffer;
+        };
+
+        auto expected = save(1, 0);
+        REQUIRE(save(1, 2000) == expected);
+        REQUIRE(save(4, 2000) == expected);
+    }
+}
+
 // CVE-2018-8002, CVE-2021-30470
 TEST_CASE("testNestedArrays")
 {
@@ -2804,3 +3473,44 @@ size_t getStackOverflowDepth()
 
     return overflowDepth;
 }
+
+string generateDocumentWithStreams(unsigned objectCount, PdfSaveOptions opts)
+{
+    PdfMemDocument doc;
+    PdfArray arr;
+    for (unsigned i = 0; i < objectCount; i++)
+    {
+        auto& obj = doc.GetObjects().CreateDictionaryObject("Test");
+        arr.Add(obj.GetIndirectReference());
+        obj.GetDictionary().AddKey("Index", (int64_t)i);
+        obj.GetDictionary().AddKey("Name", PdfString(utls::Format("Object {}", i)));
+        if (i % 3 == 0)
+            obj.GetOrCreateStream().SetData(utls::Format("Stream data for object {}", i));
+    }
+
+    // Make the objects reachable from the catalog
+    doc.GetCatalog().GetDictionary().AddKey("TestObjects", arr);
+
+    string ret;
+    StringStreamDevice device(ret);
+    doc.SetObjectStreamGroupSize(40);
+    doc.Save(device, opts);
+    return ret;
+}
+
+void checkSameObjects(const PdfIndirectObjectList& objects1, const PdfIndirectObjectList& objects2)
+{
+    REQUIRE(objects1.GetSize() == objects2.GetSize());
+    auto it1 = objects1.begin();
+    auto it2 = objects2.begin();
+    for (; it1 != objects1.end(); it1++, it2++)
+    {
+        auto& obj1 = **it1;
+        auto& obj2 = **it2;
+        REQUIRE(obj1.GetIndirectReference() == obj2.GetIndirectReference());
+        REQUIRE(obj1.GetVariant() == obj2.GetVariant());
+        REQUIRE(obj1.HasStream() == obj2.HasStream());
+        if (obj1.HasStream())
+            REQUIRE(obj1.MustGetStream().GetCopy(true) == obj2.MustGetStream().GetCopy(true));
+    }
+}
@@ -172,3 +172,132 @@ void TestWriteEscapeSequences(const string_view& str, const string_view& expecte
 
     REQUIRE(expected == ret);
 }
+
+TEST_CASE("testBorrowedStrings")
+{
+    charbuff buffer;
+    PdfReference ref;
+    {
+        PdfMemDocument doc;
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        auto& dict = obj.GetDictionary();
+        dict.AddKey("Plain", PdfString("Hello world"));
+        dict.AddKey("Balanced", PdfString("a(b)c"));
+        dict.AddKey("Escaped", PdfString("a(b"));
+        dict.AddKey("Hex", PdfString::FromRaw(bufferview("AB", 2)));
+        dict.AddKey("OddHex", PdfString::FromRaw(bufferview("CD", 2)));
+        ref = obj.GetIndirectReference();
+        doc.GetCatalog().GetDictionary().AddKey("Test", ref);
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    // Make a hex string with an odd count of digits and unescape
+    // the balanced parenthesis, keeping the offsets
+    size_t pos = buffer.find("<4344>");
+    REQUIRE(pos != string::npos);
+    buffer.replace(pos, 6, "<43 4>");
+    pos = buffer.find("(a\\(b\\)c)");
+    REQUIRE(pos != string::npos);
+    buffer.replace(pos, 9, "(a(b)c)  ");
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& dict = doc.GetObjects().MustGetObject(ref).GetDictionary();
+    auto& plain = dict.MustFindKey("Plain").GetString();
+    REQUIRE(plain.GetState() == PdfStringState::RawBuffer);
+
+    // Strings without escape sequences reference the source
+    // buffer, until they are accessed or copied
+    pos = buffer.find("(Hello world)");
+    REQUIRE(pos != string::npos);
+    buffer[pos + 1] = 'J';
+    PdfString copy = plain;
+    buffer[pos + 1] = 'H';
+    REQUIRE(copy.GetString() == "Jello world");
+    REQUIRE(plain.GetString() == "Jello world");
+
+    REQUIRE(dict.MustFindKey("Balanced").GetString().GetString() == "a(b)c");
+    REQUIRE(dict.MustFindKey("Escaped").GetString().GetString() == "a(b");
+    REQUIRE(dict.MustFindKey("Hex").GetString().GetRawData() == "AB");
+    REQUIRE(dict.MustFindKey("Hex").GetString().IsHex());
+    REQUIRE(dict.MustFindKey("OddHex").GetString().GetRawData() == "C@");
+
+    // Borrowed strings are escaped when written
+    charbuff output;
+    BufferStreamDevice device(output);
+    doc.Save(device);
+    REQUIRE(output.find("(Jello world)") != string::npos);
+    REQUIRE(output.find("(a\\(b\\)c)") != string::npos);
+}
+
+TEST_CASE("testBorrowedStringsOfRemovedObjects")
+{
+    charbuff buffer;
+    PdfReference ref;
+    {
+        PdfMemDocument doc;
+        auto& obj = doc.GetObjects().CreateArrayObject();
+        auto& arr = obj.GetArray();
+        arr.Add(PdfString("Hello world"));
+        PdfDictionary dict;
+        dict.AddKey("Nested", PdfString("Nested string"));
+        arr.Add(dict);
+        ref = obj.GetIndirectReference();
+        doc.GetCatalog().GetDictionary().AddKey("Test", ref);
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    unique_ptr<PdfObject> removed;
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        removed = doc.GetObjects().RemoveObject(ref);
+    }
+
+    // The strings are copied when the object leaves the document
+    std::fill(buffer.begin(), buffer.end(), 'X');
+    auto& arr = removed->GetArray();
+    REQUIRE(arr[0].GetString().GetString() == "Hello world");
+    REQUIRE(arr[1].GetDictionary().MustFindKey("Nested").GetString().GetString() == "Nested string");
+}
+
+TEST_CASE("testBorrowedStringsMoved")
+{
+    charbuff buffer;
+    PdfReference ref;
+    {
+        PdfMemDocument doc;
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetDictionary().AddKey("Moved", PdfString("Hello world"));
+        ref = obj.GetIndirectReference();
+        doc.GetCatalog().GetDictionary().AddKey("Test", ref);
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfString moved;
+    PdfString assigned;
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        auto& dict = doc.GetObjects().MustGetObject(ref).GetDictionary();
+        auto& str = const_cast<PdfString&>(dict.MustFindKey("Moved").GetString());
+
+        // The loaded string still references the source buffer
+        size_t pos = buffer.find("(Hello world)");
+        REQUIRE(pos != string::npos);
+        buffer[pos + 1] = 'J';
+        PdfString tmp(std::move(str));
+        assigned = std::move(tmp);
+        moved = std::move(str);
+    }
+
+    // The moved strings don't reference the source buffer
+    std::fill(buffer.begin(), buffer.end(), 'X');
+    buffer.clear();
+    buffer.shrink_to_fit();
+    REQUIRE(moved.GetString() == "Jello world");
+    REQUIRE(assigned.GetString() == "Jello world");
+}
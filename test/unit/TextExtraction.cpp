@@ -32,3 +32,61 @@ TEST_CASE("TextExtraction1")
     ASSERT_EQUAL(entries[3].X, 29.000000232);
     ASSERT_EQUAL(entries[3].Y, 664.872605318981);
 }
+
+TEST_CASE("TextExtractionMultiThreaded")
+{
+    constexpr unsigned PageCount = 40;
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            PdfPainter painter;
+            painter.SetCanvas(page);
+            painter.GetTextState().SetFont(*font, 12);
+            for (unsigned j = 0; j < 10; j++)
+                painter.DrawText(utls::Format("Page {} line {}", i + 1, j + 1), 100, 700 - j * 20.0);
+            painter.FinishDrawing();
+        }
+
+        StringStreamDevice stream(buffer);
+        doc.Save(stream);
+    }
+
+    // Extract from freshly loaded documents, so objects
+    // and fonts are lazily loaded concurrently
+    vector<vector<PdfTextEntry>> expected(PageCount);
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        for (unsigned i = 0; i < PageCount; i++)
+            doc.GetPages().GetPageAt(i).ExtractTextTo(expected[i]);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto pages = doc.ExtractText(0, PageCount, { }, { }, 4);
+    REQUIRE(pages.size() == PageCount);
+    for (unsigned i = 0; i < PageCount; i++)
+    {
+        REQUIRE(pages[i].size() == 10);
+        REQUIRE(pages[i][0].Text == utls::Format("Page {} line 1", i + 1));
+        REQUIRE(pages[i].size() == expected[i].size());
+        for (unsigned j = 0; j < pages[i].size(); j++)
+        {
+            REQUIRE(pages[i][j].Text == expected[i][j].Text);
+            REQUIRE(pages[i][j].Page == expected[i][j].Page);
+            REQUIRE(pages[i][j].X == expected[i][j].X);
+            REQUIRE(pages[i][j].Y == expected[i][j].Y);
+        }
+    }
+
+    // Partial range
+    pages = doc.ExtractText(10, 5);
+    REQUIRE(pages.size() == 5);
+    REQUIRE(pages[0][0].Text == "Page 11 line 1");
+
+    ASSERT_THROW_WITH_ERROR_CODE(doc.ExtractText(PageCount - 1, 2), PdfErrorCode::PageNotFound);
+}
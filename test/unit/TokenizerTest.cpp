@@ -14,6 +14,7 @@ using namespace mm;
 static void Test(const string_view& buffer, PdfDataType dataType, string_view expected = { });
 static void TestStream(const string_view& buffer, const char* tokens[]);
 static void TestStreamIsNextToken(const string_view& buffer, const char* tokens[]);
+static void TestSameTokens(const string_view& buffer);
 
 TEST_CASE("testArrays")
 {
@@ -171,6 +172,19 @@ TEST_CASE("testComments")
     TestStreamIsNextToken(pszBuffer, pszTokens);
 }
 
+TEST_CASE("testSpanTokens")
+{
+    // Tokens read directly from the device span
+    // must match the ones read through the buffer
+    TestSameTokens("613 0 obj<< /Length 141 /Filter [ /ASCII85Decode /FlateDecode ] >>endobj");
+    TestSameTokens("613 0 obj\n% A comment\n<</Key(Value)/Key2<AB>>>endobj");
+    TestSameTokens("[1 2.5 -3]{/Proc}token%comment\ntoken2%comment");
+    TestSameTokens("  \r\n\t <");
+    TestSameTokens("  >");
+    TestSameTokens("%only a comment");
+    TestSameTokens(string(5000, 'A') + " B");
+}
+
 TEST_CASE("testLocale")
 {
     // Test with a locale thate uses "," instead of "." for doubles 
@@ -230,3 +244,35 @@ void TestStreamIsNextToken(const string_view& buffer, const char* tokens[])
     while (tokens[i] != nullptr)
         REQUIRE(tokenizer.IsNextToken(device, tokens[i++]));
 }
+
+void TestSameTokens(const string_view& buffer)
+{
+    INFO(utls::Format("Testing with value: {}", buffer));
+
+    SpanStreamDevice spanDevice(buffer);
+    bufferview span;
+    REQUIRE(spanDevice.TryGetSpan(span));
+
+    istringstream stream((string)buffer);
+    StandardStreamDevice streamDevice(stream);
+    REQUIRE(!streamDevice.TryGetSpan(span));
+
+    PdfTokenizer spanTokenizer;
+    PdfTokenizer streamTokenizer;
+    string_view spanToken;
+    string_view streamToken;
+    PdfTokenType spanTokenType;
+    PdfTokenType streamTokenType;
+    while (true)
+    {
+        bool gotSpanToken = spanTokenizer.TryReadNextToken(spanDevice, spanToken, spanTokenType);
+        bool gotStreamToken = streamTokenizer.TryReadNextToken(streamDevice, streamToken, streamTokenType);
+        REQUIRE(gotSpanToken == gotStreamToken);
+        if (!gotSpanToken)
+            break;
+
+        REQUIRE(spanToken == streamToken);
+        REQUIRE(spanTokenType == streamTokenType);
+        REQUIRE(spanDevice.GetPosition() == streamDevice.GetPosition());
+    }
+}
@@ -169,6 +169,36 @@ TEST_CASE("testIsDirtyFalse")
     TestObjectsDirty(objBool, objNum, objReal, objStr, objRef, objArray, objDict, objStream, objVariant, false);
 }
 
+TEST_CASE("testDirectObjectDocument")
+{
+    // Direct objects don't carry the indirect object state
+    REQUIRE(sizeof(PdfObject) <= sizeof(void*) + sizeof(PdfVariant) + 2 * sizeof(void*));
+
+    PdfMemDocument doc;
+    auto& obj = doc.GetObjects().CreateDictionaryObject();
+    auto& dict = obj.GetDictionary();
+    dict.AddKey("Array", PdfArray());
+    auto& arr = dict.MustFindKey("Array").GetArray();
+    arr.Add(PdfObject(static_cast<int64_t>(1)));
+    arr.Add(PdfDictionary());
+    auto& nested = arr[1];
+    REQUIRE(!nested.IsIndirect());
+    REQUIRE(nested.GetIndirectReference() == PdfReference());
+    REQUIRE(nested.GetDocument() == &doc);
+    REQUIRE(arr[0].GetDocument() == &doc);
+
+    // Direct objects with streams get the document from their parent
+    nested.GetOrCreateStream().SetData("Test"sv);
+    REQUIRE(nested.GetDocument() == &doc);
+    REQUIRE(nested.MustGetStream().GetCopy() == "Test");
+
+    // Detached copies don't belong to any document
+    PdfObject copy(nested);
+    REQUIRE(copy.GetDocument() == nullptr);
+    REQUIRE(copy.MustGetStream().GetCopy() == "Test");
+    REQUIRE(!copy.IsDirty());
+}
+
 void TestObjectsDirty(
     const PdfObject& objBool,
     const PdfObject& objNum,